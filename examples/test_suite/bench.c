@@ -0,0 +1,278 @@
+/**
+ * @file bench.c
+ * @brief Throughput and latency benchmarks
+ *
+ * Measures memory bandwidth, register/CSR latency, step rate and connect
+ * time at several SWCLK frequencies. Every result is one line:
+ *
+ *   BENCH:<freq_khz>:<name>:<value>:<unit>
+ *
+ * between BENCH_BEGIN and BENCH_END. A measurement that fails prints
+ * BENCH_FAIL:<freq_khz>:<name>:<error> instead. run_tests.py --bench
+ * collects these lines and compares them against a stored baseline.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "test_framework.h"
+#include "pico2-swd-riscv/rp2350.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+// SWCLK frequencies to measure at (kHz)
+static const uint32_t bench_freqs[] = {1000, 4000, 10000, 20000};
+
+// Target SRAM used for the transfers and the step loop
+#define BENCH_BUF_ADDR  0x20060000
+#define BENCH_CODE_ADDR 0x20077800
+
+#define BENCH_BLOCK_WORDS 4096   // 16 KB per block transfer
+#define BENCH_WORD_OPS    256    // Single-word transfers per measurement
+#define BENCH_REG_OPS     200    // Register/CSR accesses per measurement
+#define BENCH_STEPS       200
+
+#define CSR_MSCRATCH 0x340       // Not held by the register cache
+
+static uint32_t bench_block[BENCH_BLOCK_WORDS];
+
+//==============================================================================
+// Reporting
+//==============================================================================
+
+static void bench_report(uint32_t freq_khz, const char *name, uint32_t value,
+                         const char *unit) {
+    printf("BENCH:%lu:%s:%lu:%s\n", (unsigned long)freq_khz, name,
+           (unsigned long)value, unit);
+}
+
+static void bench_fail(uint32_t freq_khz, const char *name, swd_error_t err) {
+    printf("BENCH_FAIL:%lu:%s:%s\n", (unsigned long)freq_khz, name, swd_error_string(err));
+}
+
+// KB/s for bytes moved in us microseconds
+static uint32_t kb_per_s(uint64_t bytes, uint64_t us) {
+    return us ? (uint32_t)((bytes * 1000000u) / (us * 1024u)) : 0;
+}
+
+// Mean latency in nanoseconds
+static uint32_t ns_per_op(uint64_t us, uint32_t ops) {
+    return (uint32_t)((us * 1000u) / ops);
+}
+
+//==============================================================================
+// Memory Throughput
+//==============================================================================
+
+static void bench_mem32(swd_target_t *target, uint32_t freq) {
+    swd_error_t err = SWD_OK;
+
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_WORD_OPS && err == SWD_OK; i++) {
+        err = rp2350_write_mem32(target, BENCH_BUF_ADDR + i * 4, i);
+    }
+    uint64_t us = time_us_64() - start;
+    if (err != SWD_OK) {
+        bench_fail(freq, "mem32_write", err);
+    } else {
+        bench_report(freq, "mem32_write", kb_per_s(BENCH_WORD_OPS * 4, us), "KB/s");
+    }
+
+    err = SWD_OK;
+    start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_WORD_OPS && err == SWD_OK; i++) {
+        swd_result_t result = rp2350_read_mem32(target, BENCH_BUF_ADDR + i * 4);
+        err = result.error;
+    }
+    us = time_us_64() - start;
+    if (err != SWD_OK) {
+        bench_fail(freq, "mem32_read", err);
+    } else {
+        bench_report(freq, "mem32_read", kb_per_s(BENCH_WORD_OPS * 4, us), "KB/s");
+    }
+}
+
+static void bench_block_transfer(swd_target_t *target, uint32_t freq) {
+    for (uint32_t i = 0; i < BENCH_BLOCK_WORDS; i++) {
+        bench_block[i] = i * 0x9E3779B9u;
+    }
+
+    uint64_t start = time_us_64();
+    swd_error_t err = rp2350_write_mem_block(target, BENCH_BUF_ADDR, bench_block,
+                                             BENCH_BLOCK_WORDS);
+    uint64_t us = time_us_64() - start;
+    if (err != SWD_OK) {
+        bench_fail(freq, "block_write", err);
+    } else {
+        bench_report(freq, "block_write", kb_per_s(BENCH_BLOCK_WORDS * 4, us), "KB/s");
+    }
+
+    start = time_us_64();
+    err = rp2350_read_mem_block(target, BENCH_BUF_ADDR, bench_block, BENCH_BLOCK_WORDS);
+    us = time_us_64() - start;
+    if (err != SWD_OK) {
+        bench_fail(freq, "block_read", err);
+        return;
+    }
+    bench_report(freq, "block_read", kb_per_s(BENCH_BLOCK_WORDS * 4, us), "KB/s");
+
+    // A fast read that returns junk is not a result
+    for (uint32_t i = 0; i < BENCH_BLOCK_WORDS; i++) {
+        if (bench_block[i] != i * 0x9E3779B9u) {
+            bench_fail(freq, "block_verify", SWD_ERROR_VERIFY);
+            return;
+        }
+    }
+}
+
+//==============================================================================
+// Register Latency
+//==============================================================================
+
+static void bench_registers(swd_target_t *target, uint32_t freq) {
+    swd_error_t err = SWD_OK;
+
+    // Invalidating first makes every read go to the hart
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_REG_OPS && err == SWD_OK; i++) {
+        rp2350_invalidate_cache(target, 0);
+        err = rp2350_read_reg(target, 0, 5).error;
+    }
+    uint64_t us = time_us_64() - start;
+    if (err != SWD_OK) {
+        bench_fail(freq, "reg_read", err);
+    } else {
+        bench_report(freq, "reg_read", ns_per_op(us, BENCH_REG_OPS), "ns");
+    }
+
+    uint32_t regs[32];
+    err = SWD_OK;
+    start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_REG_OPS && err == SWD_OK; i++) {
+        rp2350_invalidate_cache(target, 0);
+        err = rp2350_read_all_regs(target, 0, regs);
+    }
+    us = time_us_64() - start;
+    if (err != SWD_OK) {
+        bench_fail(freq, "all_regs_read", err);
+    } else {
+        bench_report(freq, "all_regs_read", ns_per_op(us, BENCH_REG_OPS), "ns");
+    }
+
+    err = SWD_OK;
+    start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_REG_OPS && err == SWD_OK; i++) {
+        err = rp2350_read_csr(target, 0, CSR_MSCRATCH).error;
+    }
+    us = time_us_64() - start;
+    if (err != SWD_OK) {
+        bench_fail(freq, "csr_read", err);
+    } else {
+        bench_report(freq, "csr_read", ns_per_op(us, BENCH_REG_OPS), "ns");
+    }
+}
+
+static void bench_step(swd_target_t *target, uint32_t freq) {
+    // j . : every step lands on the same instruction
+    swd_error_t err = rp2350_write_mem32(target, BENCH_CODE_ADDR, 0x0000006F);
+    if (err == SWD_OK) {
+        err = rp2350_write_pc(target, 0, BENCH_CODE_ADDR);
+    }
+
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_STEPS && err == SWD_OK; i++) {
+        err = rp2350_step(target, 0);
+    }
+    uint64_t us = time_us_64() - start;
+
+    if (err != SWD_OK) {
+        bench_fail(freq, "step", err);
+    } else {
+        bench_report(freq, "step", us ? (uint32_t)(BENCH_STEPS * 1000000ull / us) : 0,
+                     "steps/s");
+    }
+}
+
+//==============================================================================
+// Connect Time
+//==============================================================================
+
+/**
+ * @brief Disconnect, then connect and initialize again
+ *
+ * Leaves the target connected and initialized, as test_setup() expects.
+ */
+static swd_error_t bench_reconnect(swd_target_t *target, uint64_t *us) {
+    swd_disconnect(target);
+
+    uint64_t start = time_us_64();
+    swd_error_t err = swd_connect(target);
+    if (err == SWD_OK) {
+        err = rp2350_init(target);
+    }
+    *us = time_us_64() - start;
+    return err;
+}
+
+static swd_error_t bench_connect(swd_target_t *target, uint32_t freq) {
+    uint64_t us;
+    swd_error_t err = bench_reconnect(target, &us);
+    if (err != SWD_OK) {
+        bench_fail(freq, "connect", err);
+        return err;
+    }
+    bench_report(freq, "connect", (uint32_t)us, "us");
+    return SWD_OK;
+}
+
+//==============================================================================
+// Runner
+//==============================================================================
+
+void bench_run_all(swd_target_t *target) {
+    printf("BENCH_BEGIN\n");
+
+    uint32_t restore_khz = 0;
+    swd_error_t err = test_setup();
+    if (err != SWD_OK) {
+        printf("# Setup failed: %s\n", swd_error_string(err));
+    } else {
+        restore_khz = swd_get_frequency(target);
+    }
+
+    for (uint i = 0; err == SWD_OK && i < sizeof(bench_freqs) / sizeof(bench_freqs[0]); i++) {
+        uint32_t freq = bench_freqs[i];
+
+        printf("# SWCLK %lu kHz\n", (unsigned long)freq);
+        err = swd_set_frequency(target, freq);
+        if (err == SWD_OK) {
+            err = bench_connect(target, freq);
+        }
+        if (err != SWD_OK) {
+            // Too fast for this wiring; the remaining frequencies are faster
+            printf("# Stopping at %lu kHz: %s\n", (unsigned long)freq, swd_error_string(err));
+            break;
+        }
+        bench_report(freq, "freq_actual", swd_get_frequency(target), "kHz");
+
+        rp2350_halt(target, 0);
+        rp2350_halt(target, 1);
+
+        bench_mem32(target, freq);
+        bench_block_transfer(target, freq);
+        bench_registers(target, freq);
+        bench_step(target, freq);
+    }
+
+    // Back to the configured clock, connected and initialized for later tests
+    if (restore_khz) {
+        uint64_t us;
+        swd_set_frequency(target, restore_khz);
+        if (bench_reconnect(target, &us) != SWD_OK) {
+            printf("# Reconnect at %lu kHz failed\n", (unsigned long)restore_khz);
+        }
+        test_cleanup();
+    }
+
+    printf("BENCH_END\n");
+}
@@ -142,6 +142,9 @@ static void handle_command(char *cmd) {
     else if (strcmp(cmd, CMD_TEST_ALL) == 0) {
         run_all_tests();
     }
+    else if (strcmp(cmd, CMD_BENCH_ALL) == 0) {
+        bench_run_all(g_target);
+    }
     else if (strcmp(cmd, CMD_DISCONNECT) == 0) {
         printf("# Disconnecting...\n");
         test_final_cleanup();
@@ -151,6 +154,7 @@ static void handle_command(char *cmd) {
         printf("# Available commands:\n");
         printf("#   READY       - Check if test suite is ready\n");
         printf("#   TEST_ALL    - Run all tests\n");
+        printf("#   BENCH_ALL   - Run throughput/latency benchmarks\n");
         printf("#   DISCONNECT  - Disconnect from target\n");
         printf("#   HELP        - Show this help message\n");
     }
@@ -184,6 +188,7 @@ int main() {
     config.pin_swdio = SWDIO_PIN;
     config.freq_khz = 1000;  // 1 MHz
     config.enable_caching = true;
+    config.use_dma = true;
 
     g_target = swd_target_create(&config);
     if (!g_target) {
@@ -3,16 +3,23 @@
 Simple test runner for pico2-swd-riscv test suite.
 
 Connects to serial port, sends TEST_ALL command, and logs all output.
+With --bench it sends BENCH_ALL instead, and can save the results as a
+baseline or compare them against one.
 
 Usage:
     python3 run_tests.py [serial_port] [output_file]
+    python3 run_tests.py --bench [--save-baseline F | --baseline F] [serial_port]
 
 Examples:
     python3 run_tests.py                          # Auto-detect port
     python3 run_tests.py /dev/ttyACM0             # Specific port
     python3 run_tests.py /dev/ttyACM0 results.txt # Save to file
+    python3 run_tests.py --bench --save-baseline baseline.json
+    python3 run_tests.py --bench --baseline baseline.json --tolerance 5
 """
 
+import argparse
+import json
 import sys
 import time
 import serial
@@ -22,6 +29,12 @@ from datetime import datetime
 BAUD_RATE = 115200
 TIMEOUT = 1  # seconds
 
+# Units where a larger value is better; for the rest (ns, us) smaller is
+HIGHER_IS_BETTER = {"KB/s", "steps/s"}
+
+# Exit code when a benchmark is worse than the baseline
+EXIT_REGRESSION = 2
+
 
 def find_pico_port():
     """Try to auto-detect Pico USB serial port"""
@@ -34,15 +47,106 @@ def find_pico_port():
     return None
 
 
+def parse_bench_line(line, results, failures):
+    """Record a BENCH:freq:name:value:unit or BENCH_FAIL:freq:name:error line"""
+    fields = line.split(":")
+    if fields[0] == "BENCH" and len(fields) == 5:
+        key = f"{fields[1]}:{fields[2]}"
+        results[key] = {"value": int(fields[3]), "unit": fields[4]}
+    elif fields[0] == "BENCH_FAIL" and len(fields) >= 4:
+        failures[f"{fields[1]}:{fields[2]}"] = ":".join(fields[3:])
+
+
+def compare_bench(results, baseline, tolerance):
+    """Return (key, old, new, why) for results worse than baseline"""
+    regressions = []
+    for key, base in sorted(baseline.items()):
+        cur = results.get(key)
+        # Missing keys are reported separately; 'freq_actual' is informational
+        if cur is None or key.endswith(":freq_actual"):
+            continue
+        old = f"{base['value']} {base['unit']}"
+        new = f"{cur['value']} {cur['unit']}"
+        if base["unit"] != cur["unit"]:
+            regressions.append((key, old, new, "unit changed"))
+            continue
+        higher_is_better = base["unit"] in HIGHER_IS_BETTER
+        if base["value"] == 0:
+            # No percentage from 0; only a cost that appeared is worse
+            if not higher_is_better and cur["value"] > 0:
+                regressions.append((key, old, new, "was 0"))
+            continue
+        change = (cur["value"] - base["value"]) * 100.0 / base["value"]
+        worse = -change if higher_is_better else change
+        if worse > tolerance:
+            regressions.append((key, old, new, f"{change:+.1f}%"))
+    return regressions
+
+
+def report_bench(results, failures, complete, args):
+    """Save or check the baseline; returns the exit code"""
+    print(f"\n{len(results)} benchmark results, {len(failures)} failed")
+    for key, err in sorted(failures.items()):
+        print(f"  FAILED {key}: {err}")
+
+    # A truncated run must not become (or be judged against) a baseline
+    if not complete:
+        print("ERROR: BENCH_END not received; benchmark run incomplete")
+        if args.save_baseline:
+            print(f"Baseline not saved to {args.save_baseline}")
+        return 1
+
+    if args.save_baseline:
+        with open(args.save_baseline, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+        print(f"Baseline saved to {args.save_baseline}")
+
+    if not args.baseline:
+        return 0
+
+    try:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    except Exception as e:
+        print(f"ERROR: Failed to load baseline: {e}")
+        return 1
+
+    missing = sorted(k for k in baseline if k not in results)
+    regressions = compare_bench(results, baseline, args.tolerance)
+
+    for key in missing:
+        print(f"  MISSING {key} (in baseline, not measured)")
+    for key, old, new, why in regressions:
+        print(f"  REGRESSION {key}: {old} -> {new} ({why})")
+
+    if regressions or missing:
+        print(f"BENCHMARK REGRESSIONS: {len(regressions)} worse than "
+              f"{args.tolerance:g}%, {len(missing)} missing")
+        return EXIT_REGRESSION
+
+    print(f"No regressions against {args.baseline} (tolerance {args.tolerance:g}%)")
+    return 0
+
+
 def main():
     # Parse command line
-    port = None
-    output_file = None
-
-    if len(sys.argv) > 1:
-        port = sys.argv[1]
-    if len(sys.argv) > 2:
-        output_file = sys.argv[2]
+    parser = argparse.ArgumentParser(description="pico2-swd-riscv test suite runner")
+    parser.add_argument("port", nargs="?", help="Serial port (auto-detected if omitted)")
+    parser.add_argument("output_file", nargs="?", help="Save output to this file")
+    parser.add_argument("--bench", action="store_true",
+                        help="Run BENCH_ALL instead of TEST_ALL")
+    parser.add_argument("--baseline", help="Compare benchmarks against this JSON file")
+    parser.add_argument("--save-baseline", help="Store benchmark results as a JSON baseline")
+    parser.add_argument("--tolerance", type=float, default=10.0,
+                        help="Allowed slowdown in percent before flagging (default: 10)")
+    args = parser.parse_args()
+
+    port = args.port
+    output_file = args.output_file
+    command = "BENCH_ALL" if args.bench else "TEST_ALL"
+    bench_results = {}
+    bench_failures = {}
+    bench_complete = False
 
     # Auto-detect port if not specified
     if not port:
@@ -90,18 +194,19 @@ def main():
         # Flush any pending data
         ser.reset_input_buffer()
 
-        # Send TEST_ALL command
-        print("Sending TEST_ALL command...\n")
+        # Send TEST_ALL (or BENCH_ALL) command
+        print(f"Sending {command} command...\n")
         print("=" * 70)
-        ser.write(b"TEST_ALL\n")
+        ser.write(command.encode() + b"\n")
         ser.flush()
 
         # Read and print all output
         line_buffer = ""
         timeout_count = 0
         max_timeouts = 20  # Exit after 2 seconds of no data
+        done = False
 
-        while True:
+        while not done:
             if ser.in_waiting > 0:
                 # Reset timeout counter when we receive data
                 timeout_count = 0
@@ -123,6 +228,13 @@ def main():
                         output.write(line + '\n')
                         output.flush()
 
+                    if line.startswith("BENCH"):
+                        parse_bench_line(line, bench_results, bench_failures)
+                    if line == "BENCH_END":
+                        bench_complete = True
+                        done = True
+                        break
+
                     # Check for test completion
                     if "TEST SUMMARY" in line or "ALL TESTS PASSED" in line or "SOME TESTS FAILED" in line:
                         # Continue reading for a bit more to catch final output
@@ -164,6 +276,8 @@ def main():
             output.close()
             print(f"\nResults saved to {output_file}")
 
+    if args.bench:
+        return report_bench(bench_results, bench_failures, bench_complete, args)
     return 0
 
 
@@ -2,7 +2,9 @@
  * @file test_api_coverage.c
  * @brief Tests for API functions not covered by other test files
  *
- * Covers: DAP layer utilities, connection state queries, resource management
+ * Covers: DAP layer utilities, connection state queries, resource management,
+ *         transaction batching, polling policy, SWCLK autotune, fast attach,
+ *         memory cache, byte transfers
  *
  * Copyright (c) 2025
  * SPDX-License-Identifier: MIT
@@ -11,6 +13,10 @@
 #include "test_framework.h"
 #include "pico2-swd-riscv/rp2350.h"
 #include "pico2-swd-riscv/dap.h"
+#include "pico2-swd-riscv/gang.h"
+#include "pico2-swd-riscv/worker.h"
+#include "pico2-swd-riscv/async.h"
+#include "pico/stdlib.h"
 #include <stdio.h>
 
 //==============================================================================
@@ -208,6 +214,1040 @@ static bool test_dap_read_ap(swd_target_t *target) {
     return true;
 }
 
+//==============================================================================
+// Test 9: SWD Transaction Batch
+//==============================================================================
+
+static bool test_swd_batch(swd_target_t *target) {
+    printf("# Testing swd_batch_*()...\n");
+
+    swd_result_t idcode = swd_read_idcode(target);
+    swd_result_t idr = dap_read_ap(target, AP_RISCV, AP_IDR);
+    if (idcode.error != SWD_OK || idr.error != SWD_OK) {
+        test_send_response(RESP_FAIL, "Reference reads failed");
+        return false;
+    }
+
+    // DP reads, then an AP read collected through RDBUFF
+    uint32_t batch_idcode = 0, ctrl_stat = 0, batch_idr = 0;
+    uint32_t select = (AP_RISCV << 12) | (0xD << 8) | (((AP_IDR >> 4) & 0xF) << 4) | 1;
+
+    swd_error_t err = swd_batch_begin(target);
+    if (err == SWD_OK) err = swd_batch_queue_read(target, false, DP_IDCODE, &batch_idcode);
+    if (err == SWD_OK) err = swd_batch_queue_read(target, false, DP_CTRL_STAT, &ctrl_stat);
+    if (err == SWD_OK) err = swd_batch_queue_write(target, false, DP_SELECT, select);
+    if (err == SWD_OK) err = swd_batch_queue_read(target, true, AP_IDR, NULL);
+    if (err == SWD_OK) err = swd_batch_queue_read(target, false, DP_RDBUFF, &batch_idr);
+    swd_error_t exec_err = swd_batch_execute(target);
+    if (err == SWD_OK) err = exec_err;
+
+    if (err != SWD_OK) {
+        printf("# Batch failed: %s (%s)\n", swd_error_string(err),
+               swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Batch execution failed");
+        return false;
+    }
+
+    printf("# IDCODE: 0x%08lx, CTRL/STAT: 0x%08lx, AP IDR: 0x%08lx\n",
+           (unsigned long)batch_idcode, (unsigned long)ctrl_stat,
+           (unsigned long)batch_idr);
+
+    if (batch_idcode != idcode.value || batch_idr != idr.value) {
+        test_send_response(RESP_FAIL, "Batched values do not match single reads");
+        return false;
+    }
+
+    // Nested begin must be rejected
+    if (swd_batch_begin(target) != SWD_OK) {
+        test_send_response(RESP_FAIL, "Could not reopen batch");
+        return false;
+    }
+    err = swd_batch_begin(target);
+    swd_batch_execute(target);
+    if (err != SWD_ERROR_INVALID_STATE) {
+        test_send_response(RESP_FAIL, "Nested batch was accepted");
+        return false;
+    }
+
+    // The DAP layer must still work after SELECT was changed behind its back
+    idr = dap_read_ap(target, AP_RISCV, AP_IDR);
+    if (idr.error != SWD_OK || idr.value != batch_idr) {
+        test_send_response(RESP_FAIL, "AP access broken after batch");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 10: DMCONTROL/TAR Shadow Invalidation
+//==============================================================================
+
+static bool test_shadow_invalidation(swd_target_t *target) {
+    printf("# Testing TAR/DMCONTROL shadows...\n");
+
+    rp2350_halt(target, 0);
+    rp2350_halt(target, 1);
+
+    uint32_t h0_value = 0x13572468;
+    uint32_t h1_value = 0x86427531;
+    if (rp2350_write_reg(target, 0, 5, h0_value) != SWD_OK ||
+        rp2350_write_reg(target, 1, 5, h1_value) != SWD_OK) {
+        test_send_response(RESP_FAIL, "Failed to write x5");
+        return false;
+    }
+
+    // Leave hart 0 selected, then select hart 1 behind the library's back
+    swd_result_t r = rp2350_read_reg(target, 0, 5);
+    swd_error_t err = dap_write_mem32(target, 0x40, (1u << 16) | 1u);
+    if (r.error != SWD_OK || err != SWD_OK) {
+        test_send_response(RESP_FAIL, "Setup access failed");
+        return false;
+    }
+
+    // A stale DMCONTROL shadow would read hart 1's x5 here
+    rp2350_invalidate_cache(target, 0);
+    r = rp2350_read_reg(target, 0, 5);
+    printf("# hart0 x5 after external select: 0x%08lx\n", (unsigned long)r.value);
+
+    rp2350_resume(target, 0);
+    rp2350_resume(target, 1);
+
+    if (r.error != SWD_OK || r.value != h0_value) {
+        test_send_response(RESP_FAIL, "Read the wrong hart after external DMCONTROL write");
+        return false;
+    }
+
+    // Repeated reads of one address reuse TAR and must stay correct
+    swd_result_t a = dap_read_mem32(target, 0x44);
+    swd_result_t b = dap_read_mem32(target, 0x44);
+    if (a.error != SWD_OK || b.error != SWD_OK ||
+        (a.value & 0xFF) != (b.value & 0xFF)) {
+        test_send_response(RESP_FAIL, "Repeated DMSTATUS reads disagree");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 11: Bulk GPR Round Trip
+//==============================================================================
+
+static bool test_bulk_gpr_round_trip(swd_target_t *target) {
+    printf("# Testing rp2350_read_all_regs/rp2350_write_all_regs...\n");
+
+    rp2350_halt(target, 0);
+
+    // Bypass the cache so every read goes to the hart
+    rp2350_enable_cache(target, false);
+
+    uint32_t saved[32], pattern[32], readback[32];
+    swd_error_t err = rp2350_read_all_regs(target, 0, saved);
+    if (err != SWD_OK) {
+        printf("# Initial bulk read failed: %s\n", swd_get_last_error_detail(target));
+        rp2350_enable_cache(target, true);
+        rp2350_resume(target, 0);
+        test_send_response(RESP_FAIL, "Initial bulk read failed");
+        return false;
+    }
+
+    for (int i = 0; i < 32; i++) {
+        pattern[i] = 0xB0000000u | ((uint32_t)i << 8) | (uint32_t)i;
+    }
+
+    swd_error_t write_err = rp2350_write_all_regs(target, 0, pattern);
+    swd_error_t read_err = rp2350_read_all_regs(target, 0, readback);
+
+    // Single-register reads must agree with the bulk path
+    swd_result_t x17 = rp2350_read_reg(target, 0, 17);
+
+    rp2350_write_all_regs(target, 0, saved);
+    rp2350_enable_cache(target, true);
+    rp2350_resume(target, 0);
+
+    if (write_err != SWD_OK) {
+        printf("# Bulk write failed: %s\n", swd_error_string(write_err));
+        test_send_response(RESP_FAIL, "Bulk write failed");
+        return false;
+    }
+
+    if (read_err != SWD_OK) {
+        printf("# Bulk read-back failed: %s\n", swd_error_string(read_err));
+        test_send_response(RESP_FAIL, "Bulk read-back failed");
+        return false;
+    }
+
+    for (int i = 0; i < 32; i++) {
+        uint32_t expected = i == 0 ? 0 : pattern[i];
+        if (readback[i] != expected) {
+            printf("# x%d: got 0x%08lx, expected 0x%08lx\n", i,
+                   (unsigned long)readback[i], (unsigned long)expected);
+            test_send_response(RESP_FAIL, "Bulk read-back mismatch");
+            return false;
+        }
+    }
+
+    if (x17.error != SWD_OK || x17.value != pattern[17]) {
+        printf("# x17 single read: 0x%08lx (%s)\n", (unsigned long)x17.value,
+               swd_error_string(x17.error));
+        test_send_response(RESP_FAIL, "Single read disagrees with bulk write");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 12: CSR List Read and s0 Scratch Handling
+//==============================================================================
+
+static bool test_csr_batch(swd_target_t *target) {
+    printf("# Testing rp2350_read_csrs() and s0 preservation...\n");
+
+    rp2350_halt(target, 0);
+
+    const uint32_t s0_value = 0x5A5A0008;
+    swd_error_t err = rp2350_write_reg(target, 0, 8, s0_value);
+
+    // misa, mhartid, dpc, mscratch
+    const uint16_t csrs[] = {0x301, 0xF14, 0x7B1, 0x340};
+    uint32_t values[4] = {0};
+    if (err == SWD_OK) {
+        err = rp2350_write_csr(target, 0, 0x340, 0xC5C5C5C5);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_read_csrs(target, 0, csrs, values, 4);
+    }
+
+    swd_result_t misa = rp2350_read_csr(target, 0, 0x301);
+    swd_result_t pc = rp2350_read_pc(target, 0);
+    swd_result_t s0 = rp2350_read_reg(target, 0, 8);
+
+    // Bulk reads must also report the program's s0
+    uint32_t regs[32] = {0};
+    rp2350_invalidate_cache(target, 0);
+    swd_error_t bulk = rp2350_read_all_regs(target, 0, regs);
+
+    // Resume writes s0 back before the hart runs
+    rp2350_resume(target, 0);
+
+    printf("# misa=0x%08lx mhartid=%lu dpc=0x%08lx mscratch=0x%08lx\n",
+           (unsigned long)values[0], (unsigned long)values[1],
+           (unsigned long)values[2], (unsigned long)values[3]);
+
+    if (err != SWD_OK || misa.error != SWD_OK || pc.error != SWD_OK) {
+        printf("# CSR access failed: %s\n", swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "CSR access failed");
+        return false;
+    }
+
+    if (values[0] != misa.value || values[1] != 0 || values[2] != pc.value) {
+        printf("# Single reads: misa=0x%08lx dpc=0x%08lx\n",
+               (unsigned long)misa.value, (unsigned long)pc.value);
+        test_send_response(RESP_FAIL, "CSR list disagrees with single reads");
+        return false;
+    }
+
+    if (values[3] != 0xC5C5C5C5) {
+        printf("# mscratch should read back 0xc5c5c5c5\n");
+        test_send_response(RESP_FAIL, "mscratch write not visible");
+        return false;
+    }
+
+    if (s0.error != SWD_OK || s0.value != s0_value) {
+        printf("# s0 = 0x%08lx, expected 0x%08lx\n", (unsigned long)s0.value,
+               (unsigned long)s0_value);
+        test_send_response(RESP_FAIL, "s0 not preserved while borrowed");
+        return false;
+    }
+
+    if (bulk != SWD_OK || regs[8] != s0_value) {
+        printf("# Bulk s0 = 0x%08lx (%s)\n", (unsigned long)regs[8], swd_error_string(bulk));
+        test_send_response(RESP_FAIL, "Bulk read exposed scratch s0");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 13: Polling Policy and Wait Counters
+//==============================================================================
+
+static bool test_poll_policy(swd_target_t *target) {
+    printf("# Testing swd_set_poll_policy() and wait counters...\n");
+
+    swd_poll_policy_t defaults = swd_config_default().poll;
+    swd_poll_policy_t bad = defaults;
+    bad.timeout_us = 0;
+    if (swd_set_poll_policy(target, &bad) != SWD_ERROR_INVALID_PARAM) {
+        printf("# A policy without a deadline should be refused\n");
+        swd_set_poll_policy(target, &defaults);
+        test_send_response(RESP_FAIL, "Zero deadline accepted");
+        return false;
+    }
+
+    // Pure spinning with a short deadline still has to work
+    swd_poll_policy_t spin = { .spin_polls = 1000, .backoff_min_us = 0,
+                               .backoff_max_us = 0, .timeout_us = 50000 };
+    swd_error_t err = swd_set_poll_policy(target, &spin);
+    if (err != SWD_OK) {
+        printf("# Failed to set spinning policy: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Policy rejected");
+        return false;
+    }
+
+    swd_reset_wait_stats(target);
+
+    rp2350_halt(target, 0);
+    swd_result_t x1 = rp2350_read_reg(target, 0, 1);
+    rp2350_invalidate_cache(target, 0);
+    err = rp2350_resume(target, 0);
+
+    swd_wait_stats_t halt, abstract;
+    swd_get_wait_stats(target, SWD_WAIT_HALT, &halt);
+    swd_get_wait_stats(target, SWD_WAIT_ABSTRACT, &abstract);
+    swd_set_poll_policy(target, &defaults);
+
+    printf("# halt: %lu waits, %lu polls (max %lu); abstract: %lu waits, %lu polls (max %lu)\n",
+           (unsigned long)halt.waits, (unsigned long)halt.polls, (unsigned long)halt.max_polls,
+           (unsigned long)abstract.waits, (unsigned long)abstract.polls,
+           (unsigned long)abstract.max_polls);
+
+    if (x1.error != SWD_OK || err != SWD_OK) {
+        printf("# %s\n", swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Halt/read/resume failed with spinning policy");
+        return false;
+    }
+
+    if (halt.waits < 1 || abstract.waits < 1 || halt.timeouts || abstract.timeouts) {
+        printf("# Expected halt and abstract waits without timeouts\n");
+        test_send_response(RESP_FAIL, "Wait counters not updated");
+        return false;
+    }
+
+    if (halt.polls < halt.waits || halt.max_polls == 0) {
+        printf("# Every wait should poll at least once\n");
+        test_send_response(RESP_FAIL, "Poll counts inconsistent");
+        return false;
+    }
+
+    swd_wait_stats_t bogus;
+    if (swd_get_wait_stats(target, SWD_WAIT_COUNT, &bogus) != SWD_ERROR_INVALID_PARAM) {
+        printf("# SWD_WAIT_COUNT should be refused\n");
+        test_send_response(RESP_FAIL, "Invalid wait kind accepted");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 14: SWCLK Autotune
+//==============================================================================
+
+static bool test_autotune_frequency(swd_target_t *target) {
+    printf("# Testing swd_autotune_frequency()...\n");
+
+    uint32_t start_khz = swd_get_frequency(target);
+    uint32_t chosen_khz = 0;
+
+    if (swd_autotune_frequency(target, start_khz - 1, &chosen_khz) != SWD_ERROR_INVALID_PARAM) {
+        printf("# A limit below %lu kHz should be refused\n", (unsigned long)start_khz);
+        swd_set_frequency(target, start_khz);
+        test_send_response(RESP_FAIL, "Limit below current frequency accepted");
+        return false;
+    }
+
+    swd_error_t err = swd_autotune_frequency(target, start_khz * 8, &chosen_khz);
+    printf("# Autotune from %lu kHz: %s, chose %lu kHz\n", (unsigned long)start_khz,
+           swd_error_string(err), (unsigned long)chosen_khz);
+
+    if (err != SWD_OK) {
+        swd_set_frequency(target, start_khz);
+        test_send_response(RESP_FAIL, "Autotune failed");
+        return false;
+    }
+
+    if (chosen_khz < start_khz || chosen_khz > start_khz * 8 ||
+        swd_get_frequency(target) != chosen_khz) {
+        printf("# Running at %lu kHz\n", (unsigned long)swd_get_frequency(target));
+        swd_set_frequency(target, start_khz);
+        test_send_response(RESP_FAIL, "Chosen frequency out of range");
+        return false;
+    }
+
+    // The chosen speed has to carry real traffic
+    swd_result_t idcode = dap_read_dp(target, DP_IDCODE);
+    swd_error_t werr = rp2350_write_mem32(target, 0x20010800, 0x600DF00D);
+    swd_result_t readback = rp2350_read_mem32(target, 0x20010800);
+    swd_set_frequency(target, start_khz);
+
+    if (idcode.error != SWD_OK || werr != SWD_OK || readback.error != SWD_OK ||
+        readback.value != 0x600DF00D) {
+        printf("# Traffic at %lu kHz: %s\n", (unsigned long)chosen_khz,
+               swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Memory access failed at tuned frequency");
+        return false;
+    }
+
+    test_send_value(chosen_khz);
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 15: Shared PIO Program
+//==============================================================================
+
+static bool test_shared_pio_program(swd_target_t *target) {
+    printf("# Testing PIO program sharing across targets...\n");
+
+    swd_resource_info_t before = swd_get_resource_usage();
+
+    // Extra targets on unused pins; they are never connected
+    swd_config_t config = swd_config_default();
+    config.pin_swclk = 26;
+    config.pin_swdio = 27;
+
+    swd_target_t *extra[7] = {NULL};
+    uint created = 0;
+    while (created < 7 && (extra[created] = swd_target_create(&config)) != NULL) {
+        created++;
+    }
+
+    swd_resource_info_t during = swd_get_resource_usage();
+    printf("# %lu extra targets, programs loaded %lu -> %lu\n", (unsigned long)created,
+           (unsigned long)before.programs_loaded, (unsigned long)during.programs_loaded);
+
+    for (uint i = 0; i < created; i++) {
+        swd_target_destroy(extra[i]);
+    }
+
+    swd_resource_info_t after = swd_get_resource_usage();
+
+    if (before.programs_loaded == 0) {
+        printf("# The suite's target should hold a loaded program\n");
+        test_send_response(RESP_FAIL, "Connected target holds no program");
+        return false;
+    }
+
+    if (created == 0) {
+        printf("# swd_target_create() failed on pins 26/27\n");
+        test_send_response(RESP_FAIL, "No extra target could be created");
+        return false;
+    }
+
+    // One program per PIO block, however many SMs are in use
+    if (during.programs_loaded > 2) {
+        printf("# Expected at most one program per PIO block\n");
+        test_send_response(RESP_FAIL, "Targets on one block did not share the program");
+        return false;
+    }
+
+    if (after.programs_loaded != before.programs_loaded ||
+        after.active_targets != before.active_targets) {
+        printf("# After destroy: %lu programs, %lu targets\n",
+               (unsigned long)after.programs_loaded, (unsigned long)after.active_targets);
+        test_send_response(RESP_FAIL, "Resources not released");
+        return false;
+    }
+
+    swd_result_t idcode = dap_read_dp(target, DP_IDCODE);
+    if (idcode.error != SWD_OK) {
+        printf("# IDCODE read failed: %s\n", swd_error_string(idcode.error));
+        test_send_response(RESP_FAIL, "Connected target disturbed");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 16: Gang Upload and Verify
+//==============================================================================
+
+static bool test_gang_upload(swd_target_t *target) {
+    printf("# Testing gang upload with one target dropping out...\n");
+
+    // Second member is never connected, so it must fail and be skipped
+    swd_config_t config = swd_config_default();
+    config.pin_swclk = 26;
+    config.pin_swdio = 27;
+    swd_target_t *idle = swd_target_create(&config);
+    if (!idle) {
+        test_send_response(RESP_FAIL, "Could not create second target");
+        return false;
+    }
+
+    // Spans several gang chunks, with a partial one at the end
+    const uint32_t addr = 0x20077000;
+    static uint32_t image[130];
+    for (uint i = 0; i < 130; i++) {
+        image[i] = 0x9E3779B9u * (i + 1);
+    }
+
+    swd_target_t *gang[2] = {target, idle};
+    swd_error_t results[2] = {SWD_OK, SWD_OK};
+
+    swd_gang_rp2350_init(gang, 2, results);
+    swd_gang_upload(gang, 2, addr, image, 130, results);
+    swd_gang_verify(gang, 2, addr, image, 130, results);
+    printf("# Results: %s, %s\n", swd_error_string(results[0]), swd_error_string(results[1]));
+
+    // A wrong expected image must be caught
+    swd_error_t mismatch[1] = {SWD_OK};
+    image[129] ^= 1;
+    swd_gang_verify(gang, 1, addr, image, 130, mismatch);
+    swd_target_destroy(idle);
+
+    if (results[0] != SWD_OK) {
+        printf("# %s\n", swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Gang upload failed on the connected target");
+        return false;
+    }
+
+    if (results[1] != SWD_ERROR_NOT_CONNECTED) {
+        printf("# Second target should report SWD_ERROR_NOT_CONNECTED\n");
+        test_send_response(RESP_FAIL, "Unconnected target was not reported");
+        return false;
+    }
+
+    if (mismatch[0] != SWD_ERROR_VERIFY) {
+        printf("# Verify against a changed image: %s\n", swd_error_string(mismatch[0]));
+        test_send_response(RESP_FAIL, "Verify missed a mismatch");
+        return false;
+    }
+
+    swd_result_t word = rp2350_read_mem32(target, addr + 4 * 64);
+    if (word.error != SWD_OK || word.value != 0x9E3779B9u * 65) {
+        printf("# Word 64: 0x%08lx, expected 0x%08lx\n", (unsigned long)word.value,
+               (unsigned long)(0x9E3779B9u * 65));
+        test_send_response(RESP_FAIL, "Single-target read disagrees with gang upload");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 17: core1 Worker
+//==============================================================================
+
+static swd_error_t worker_read_idcode(swd_target_t *target, void *arg) {
+    swd_result_t result = swd_read_idcode(target);
+    *(uint32_t *)arg = result.value;
+    return result.error;
+}
+
+static bool test_worker(swd_target_t *target) {
+    printf("# Testing core1 worker request ring...\n");
+
+    swd_result_t direct = swd_read_idcode(target);
+    if (swd_worker_start() != SWD_OK) {
+        test_send_response(RESP_FAIL, "Worker did not start");
+        return false;
+    }
+
+    // One more job than the queue holds: the last must be refused, since
+    // none of the completions have been polled yet
+    uint32_t idcodes[SWD_WORKER_QUEUE_DEPTH] = {0};
+    uint32_t ids[SWD_WORKER_QUEUE_DEPTH];
+    bool queued = true;
+    for (uint i = 0; i < SWD_WORKER_QUEUE_DEPTH; i++) {
+        queued &= swd_worker_submit(target, worker_read_idcode, &idcodes[i], &ids[i]) == SWD_OK;
+    }
+    uint32_t extra = 0;
+    swd_error_t full = swd_worker_submit(target, worker_read_idcode, &extra, NULL);
+
+    uint received = 0;
+    bool in_order = true, all_ok = true;
+    uint64_t deadline = time_us_64() + 1000000;
+    while (received < SWD_WORKER_QUEUE_DEPTH && time_us_64() < deadline) {
+        swd_completion_t done;
+        if (swd_worker_poll(&done)) {
+            in_order &= (done.id == ids[received]) && (done.arg == &idcodes[received]);
+            all_ok &= (done.error == SWD_OK);
+            received++;
+        }
+    }
+    swd_worker_stop();
+
+    bool match = true;
+    for (uint i = 0; i < received; i++) {
+        match &= (idcodes[i] == direct.value);
+    }
+
+    if (!queued) {
+        printf("# Expected %u jobs to fit the queue\n", SWD_WORKER_QUEUE_DEPTH);
+        test_send_response(RESP_FAIL, "Submit refused before the queue was full");
+        return false;
+    }
+
+    if (full != SWD_ERROR_RESOURCE_BUSY) {
+        printf("# Extra submit returned %s\n", swd_error_string(full));
+        test_send_response(RESP_FAIL, "Full queue accepted another job");
+        return false;
+    }
+
+    if (received != SWD_WORKER_QUEUE_DEPTH) {
+        printf("# Received %u of %u completions\n", received, SWD_WORKER_QUEUE_DEPTH);
+        test_send_response(RESP_FAIL, "Completions missing");
+        return false;
+    }
+
+    if (!in_order || !all_ok || !match) {
+        printf("# in_order=%d all_ok=%d match=%d\n", in_order, all_ok, match);
+        test_send_response(RESP_FAIL, "Completions wrong or out of order");
+        return false;
+    }
+
+    if (swd_worker_is_running() || swd_worker_pending() != 0) {
+        printf("# Worker still running or holding jobs after stop\n");
+        test_send_response(RESP_FAIL, "Worker did not stop cleanly");
+        return false;
+    }
+
+    swd_result_t after = swd_read_idcode(target);
+    if (after.error != SWD_OK || after.value != direct.value) {
+        printf("# IDCODE after stop: 0x%08lx (%s)\n", (unsigned long)after.value,
+               swd_error_string(after.error));
+        test_send_response(RESP_FAIL, "Target unusable from core0 after stop");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 18: Async Block Transfers
+//==============================================================================
+
+typedef struct {
+    uint calls;
+    swd_async_handle_t order[SWD_ASYNC_MAX_INFLIGHT];
+    swd_error_t results[SWD_ASYNC_MAX_INFLIGHT];
+} async_log_t;
+
+static void async_logger(swd_target_t *target, swd_async_handle_t handle,
+                         swd_error_t result, void *ctx) {
+    async_log_t *log = ctx;
+    if (log->calls < SWD_ASYNC_MAX_INFLIGHT) {
+        log->order[log->calls] = handle;
+        log->results[log->calls] = result;
+    }
+    log->calls++;
+}
+
+static bool test_async_block(swd_target_t *target) {
+    printf("# Testing async block transfers...\n");
+
+    const uint32_t addr = 0x20077000;
+    static uint32_t out[100], back[100], spare[4];
+    for (uint i = 0; i < 100; i++) {
+        out[i] = 0xA5000000u | (i * 0x01010101u & 0x00FFFFFFu);
+        back[i] = 0;
+    }
+
+    // Write, read back, one to cancel, and one to fill the queue
+    async_log_t log = {0};
+    swd_async_handle_t h[4];
+    bool queued = true;
+    queued &= rp2350_write_mem_block_async(target, addr, out, 100, async_logger, &log, &h[0]) == SWD_OK;
+    queued &= rp2350_read_mem_block_async(target, addr, back, 100, async_logger, &log, &h[1]) == SWD_OK;
+    queued &= rp2350_read_mem_block_async(target, addr, spare, 4, async_logger, &log, &h[2]) == SWD_OK;
+    queued &= rp2350_read_mem_block_async(target, addr, spare, 4, async_logger, &log, &h[3]) == SWD_OK;
+    swd_error_t full = rp2350_read_mem_block_async(target, addr, spare, 4, NULL, NULL, NULL);
+    swd_error_t cancel = swd_async_cancel(target, h[2]);
+
+    uint polls = 0;
+    swd_error_t read_result = swd_wait(target, h[1]);
+    while (swd_poll(target) > 0) {
+        polls++;
+    }
+    printf("# %u callbacks, %u extra polls\n", log.calls, polls);
+
+    bool match = true;
+    for (uint i = 0; i < 100; i++) {
+        match &= (back[i] == out[i]);
+    }
+
+    if (!queued || cancel != SWD_OK) {
+        printf("# Cancel returned %s\n", swd_error_string(cancel));
+        test_send_response(RESP_FAIL, "Submission or cancel failed");
+        return false;
+    }
+
+    if (full != SWD_ERROR_RESOURCE_BUSY) {
+        printf("# Fifth submit returned %s\n", swd_error_string(full));
+        test_send_response(RESP_FAIL, "In-flight limit not enforced");
+        return false;
+    }
+
+    if (log.calls != 4 || read_result != SWD_OK) {
+        printf("# Read-back wait returned %s\n", swd_error_string(read_result));
+        test_send_response(RESP_FAIL, "Wrong number of completions");
+        return false;
+    }
+
+    if (log.order[0] != h[2] || log.results[0] != SWD_ERROR_CANCELLED) {
+        printf("# First completion: handle %lu, %s\n", (unsigned long)log.order[0],
+               swd_error_string(log.results[0]));
+        test_send_response(RESP_FAIL, "Cancelled request did not complete first");
+        return false;
+    }
+
+    if (log.order[1] != h[0] || log.order[2] != h[1] || log.order[3] != h[3] ||
+        log.results[1] != SWD_OK || log.results[2] != SWD_OK || log.results[3] != SWD_OK) {
+        printf("# Expected write, read-back, then the last read, all SWD_OK\n");
+        test_send_response(RESP_FAIL, "Completions out of order or failed");
+        return false;
+    }
+
+    if (!match) {
+        printf("# Read-back differs from the written block\n");
+        test_send_response(RESP_FAIL, "Read back data does not match");
+        return false;
+    }
+
+    if (swd_wait(target, h[1]) != SWD_ERROR_INVALID_PARAM) {
+        printf("# swd_wait() on a finished request should be refused\n");
+        test_send_response(RESP_FAIL, "Completed handle still waitable");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 19: Fast Attach and Warm Reconnect
+//==============================================================================
+
+static bool test_fast_attach(swd_target_t *target) {
+    printf("# Testing fast attach and warm reconnect...\n");
+
+    // Hand the suite's pins (see main.c) to a fast-attach target; the suite
+    // target comes back last
+    swd_config_t config = swd_config_default();
+    config.pin_swclk = 2;
+    config.pin_swdio = 3;
+    config.fast_attach = true;
+
+    swd_disconnect(target);
+    swd_target_t *fast = swd_target_create(&config);
+
+    bool cold_ok = false, warm_ok = false, still_halted = false;
+    uint64_t cold_us = 0, warm_us = 0;
+    if (fast) {
+        uint64_t start = time_us_64();
+        cold_ok = swd_connect(fast) == SWD_OK && rp2350_init(fast) == SWD_OK;
+        cold_us = time_us_64() - start;
+
+        if (cold_ok && rp2350_halt(fast, 0) == SWD_OK) {
+            swd_disconnect(fast);
+
+            // DP is still powered and the DM active: both steps are skipped
+            start = time_us_64();
+            warm_ok = swd_connect(fast) == SWD_OK && rp2350_init(fast) == SWD_OK;
+            warm_us = time_us_64() - start;
+            still_halted = warm_ok && rp2350_is_halted(fast, 0);
+        }
+
+        swd_disconnect(fast);
+        swd_target_destroy(fast);
+    }
+    printf("# Cold attach %llu us, warm %llu us\n",
+           (unsigned long long)cold_us, (unsigned long long)warm_us);
+
+    // Restore the suite's connection, resetting the DM as a cold attach does
+    bool restored = swd_connect(target) == SWD_OK && rp2350_init(target) == SWD_OK;
+
+    if (!fast) {
+        printf("# swd_target_create() failed on the suite's pins\n");
+        test_send_response(RESP_FAIL, "Could not create fast-attach target");
+        return false;
+    }
+
+    if (!cold_ok) {
+        printf("# Cold attach through the fast path failed\n");
+        test_send_response(RESP_FAIL, "Fast cold attach failed");
+        return false;
+    }
+
+    if (!warm_ok) {
+        printf("# Connect or init failed with the DP still powered\n");
+        test_send_response(RESP_FAIL, "Warm reconnect failed");
+        return false;
+    }
+
+    if (!still_halted) {
+        printf("# Hart 0 should still be halted after a warm reconnect\n");
+        test_send_response(RESP_FAIL, "Warm reconnect lost the hart's halt state");
+        return false;
+    }
+
+    if (warm_us >= cold_us) {
+        printf("# Warm attach took at least as long as cold\n");
+        test_send_response(RESP_FAIL, "Warm reconnect was not faster");
+        return false;
+    }
+
+    if (!restored) {
+        printf("# Suite target connect/init failed\n");
+        test_send_response(RESP_FAIL, "Suite target did not reconnect");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 20: Memory Cache
+//==============================================================================
+
+static bool test_mem_cache(swd_target_t *target) {
+    printf("# Testing host-side memory cache...\n");
+
+    const uint32_t addr = 0x20077100;
+    const uint32_t scratch = 0x400d800c;   // WATCHDOG SCRATCH0: not cached
+    uint32_t saved_scratch = rp2350_read_mem32(target, scratch).value;
+    rp2350_write_mem32(target, addr, 0x11111111);
+
+    // Both harts are halted by test_setup(), so the cache is in use
+    rp2350_enable_mem_cache(target, true);
+    for (uint i = 0; i < 4; i++) {
+        rp2350_write_mem8(target, addr + i, (uint8_t)(0xA0 + i));
+    }
+    uint32_t combined = rp2350_read_mem32(target, addr).value;
+    rp2350_write_mem32(target, scratch, 0x5A5A0001);
+
+    // Dropping the cache loses the byte writes but not the peripheral write
+    rp2350_invalidate_mem_cache(target);
+    uint32_t discarded = rp2350_read_mem32(target, addr).value;
+    uint32_t passed = rp2350_read_mem32(target, scratch).value;
+
+    // Written back by a flush, and ahead of a block read that bypasses the cache
+    rp2350_write_mem16(target, addr, 0xBEEF);
+    swd_error_t flush = rp2350_flush_mem_cache(target);
+    rp2350_invalidate_mem_cache(target);
+    uint32_t flushed = rp2350_read_mem32(target, addr).value;
+    rp2350_write_mem16(target, addr + 2, 0xCAFE);
+    uint32_t block = 0;
+    rp2350_read_mem_block(target, addr, &block, 1);
+
+    swd_error_t disable = rp2350_enable_mem_cache(target, false);
+    rp2350_write_mem32(target, scratch, saved_scratch);
+    printf("# combined=0x%08lx discarded=0x%08lx flushed=0x%08lx block=0x%08lx\n",
+           (unsigned long)combined, (unsigned long)discarded,
+           (unsigned long)flushed, (unsigned long)block);
+
+    if (combined != 0xA3A2A1A0) {
+        printf("# Combined word should be 0xa3a2a1a0\n");
+        test_send_response(RESP_FAIL, "Byte writes not combined in the line");
+        return false;
+    }
+
+    if (discarded != 0x11111111) {
+        printf("# Target word should still be 0x11111111 after invalidate\n");
+        test_send_response(RESP_FAIL, "Cached writes reached the target before a flush");
+        return false;
+    }
+
+    if (passed != 0x5A5A0001) {
+        printf("# SCRATCH0 read 0x%08lx after invalidate\n", (unsigned long)passed);
+        test_send_response(RESP_FAIL, "Peripheral write was cached");
+        return false;
+    }
+
+    if (flush != SWD_OK || flushed != 0x1111BEEF) {
+        printf("# Flush returned %s\n", swd_error_string(flush));
+        test_send_response(RESP_FAIL, "Flush did not write the dirty word");
+        return false;
+    }
+
+    if (block != 0xCAFEBEEF) {
+        printf("# Block read should see the cached halfword write\n");
+        test_send_response(RESP_FAIL, "Block read missed a cached write");
+        return false;
+    }
+
+    if (disable != SWD_OK) {
+        printf("# Disable returned %s\n", swd_error_string(disable));
+        test_send_response(RESP_FAIL, "Disable failed");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 21: Byte-Granular Transfers
+//==============================================================================
+
+static bool test_byte_transfers(swd_target_t *target) {
+    printf("# Testing byte-granular reads and writes...\n");
+
+    const uint32_t addr = 0x20077200;
+    uint32_t fill[8];
+    for (uint i = 0; i < 8; i++) {
+        fill[i] = 0xEEEEEEEE;
+    }
+    rp2350_write_mem_block(target, addr, fill, 8);
+
+    // Odd address, odd length and a misaligned host buffer: head, body, tail
+    static uint8_t src[32], dst[32];
+    for (uint i = 0; i < 32; i++) {
+        src[i] = (uint8_t)(0x30 + i);
+        dst[i] = 0;
+    }
+    swd_error_t write = rp2350_write_bytes(target, addr + 1, &src[1], 21);
+    swd_error_t read = rp2350_read_bytes(target, addr + 3, &dst[1], 17);
+
+    uint32_t words[8] = {0};
+    rp2350_read_mem_block(target, addr, words, 8);
+    const uint8_t *bytes = (const uint8_t *)words;
+
+    bool untouched = (bytes[0] == 0xEE);
+    for (uint i = 22; i < 32; i++) {
+        untouched &= (bytes[i] == 0xEE);
+    }
+    bool written = true;
+    for (uint i = 1; i < 22; i++) {
+        written &= (bytes[i] == src[i]);
+    }
+    bool readback = true;
+    for (uint i = 0; i < 17; i++) {
+        readback &= (dst[1 + i] == src[3 + i]);
+    }
+
+    swd_result_t half = rp2350_read_mem16(target, addr + 2);
+
+    if (write != SWD_OK || read != SWD_OK) {
+        printf("# write: %s, read: %s\n", swd_error_string(write), swd_error_string(read));
+        test_send_response(RESP_FAIL, "Byte transfer failed");
+        return false;
+    }
+
+    if (!untouched) {
+        printf("# Bytes 0 and 22-31 should still be 0xee\n");
+        test_send_response(RESP_FAIL, "Bytes outside the range were modified");
+        return false;
+    }
+
+    if (!written) {
+        printf("# Bytes 1-21 differ from the source\n");
+        test_send_response(RESP_FAIL, "Written bytes do not match");
+        return false;
+    }
+
+    if (!readback) {
+        printf("# Bytes read from offset 3 differ from the source\n");
+        test_send_response(RESP_FAIL, "Read bytes do not match");
+        return false;
+    }
+
+    uint32_t expected_half = (uint32_t)(src[2] | (src[3] << 8));
+    if (half.error != SWD_OK || half.value != expected_half) {
+        printf("# Halfword: 0x%04lx, expected 0x%04lx\n", (unsigned long)half.value,
+               (unsigned long)expected_half);
+        test_send_response(RESP_FAIL, "Halfword read does not match");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 22: Protocol Statistics
+//==============================================================================
+
+static bool test_protocol_stats(swd_target_t *target) {
+    printf("# Testing swd_get_stats()...\n");
+
+    swd_stats_t stats;
+#if !PICO2_SWD_STATS
+    // Built without collection: the query must say so
+    if (swd_get_stats(target, &stats) != SWD_ERROR_INVALID_CONFIG) {
+        test_send_response(RESP_FAIL, "Stats reported without PICO2_SWD_STATS");
+        return false;
+    }
+    printf("# Built without PICO2_SWD_STATS\n");
+#else
+    const uint32_t addr = 0x20077300;
+    uint32_t block[32];
+
+    swd_reset_stats(target);
+    for (uint i = 0; i < 4; i++) {
+        rp2350_write_mem32(target, addr + i * 4, i);
+    }
+    swd_error_t err = rp2350_read_mem_block(target, addr, block, 32);
+    swd_get_stats(target, &stats);
+
+    const swd_latency_stats_t *rd = &stats.latency[SWD_LATENCY_MEM_READ];
+    const swd_latency_stats_t *wr = &stats.latency[SWD_LATENCY_MEM_WRITE];
+    uint32_t bucketed = 0;
+    for (uint b = 0; b < SWD_LATENCY_BUCKETS; b++) {
+        bucketed += rd->buckets[b];
+    }
+
+    printf("# %lu transactions, %lu WAIT, %lu select hits, %lu TAR hits\n",
+           (unsigned long)stats.transactions, (unsigned long)stats.ack_wait,
+           (unsigned long)stats.select_hits, (unsigned long)stats.tar_hits);
+    printf("# read %llu / wrote %llu bytes; block chunk %lu-%lu us\n",
+           (unsigned long long)stats.bytes_read, (unsigned long long)stats.bytes_written,
+           (unsigned long)rd->min_us, (unsigned long)rd->max_us);
+
+    if (err != SWD_OK) {
+        printf("# Block read: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Block read failed");
+        return false;
+    }
+
+    if (stats.bytes_written != 16 || stats.bytes_read != 128) {
+        printf("# Expected 16 bytes written and 128 read\n");
+        test_send_response(RESP_FAIL, "Byte counts wrong");
+        return false;
+    }
+
+    if (wr->count != 4 || rd->count != 1 || bucketed != 1) {
+        printf("# write samples %lu, read samples %lu, bucketed %lu\n",
+               (unsigned long)wr->count, (unsigned long)rd->count, (unsigned long)bucketed);
+        test_send_response(RESP_FAIL, "Latency samples wrong");
+        return false;
+    }
+
+    if (stats.transactions < 32 || rd->min_us > rd->max_us) {
+        printf("# Expected at least 32 transactions and min <= max\n");
+        test_send_response(RESP_FAIL, "Transaction counters inconsistent");
+        return false;
+    }
+
+    swd_reset_stats(target);
+    swd_get_stats(target, &stats);
+    if (stats.transactions != 0 || stats.latency[SWD_LATENCY_MEM_READ].count != 0) {
+        printf("# %lu transactions left after reset\n", (unsigned long)stats.transactions);
+        test_send_response(RESP_FAIL, "Reset left counters");
+        return false;
+    }
+#endif
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
 //==============================================================================
 // Test Array
 //==============================================================================
@@ -221,6 +1261,20 @@ test_case_t api_coverage_tests[] = {
     {"Hart Halted State Query", test_rp2350_is_halted, false, false},
     {"DAP Clear Errors", test_dap_clear_errors, false, false},
     {"DAP Read AP Register", test_dap_read_ap, false, false},
+    {"SWD Transaction Batch", test_swd_batch, false, false},
+    {"DMCONTROL/TAR Shadow Invalidation", test_shadow_invalidation, false, false},
+    {"Bulk GPR Round Trip", test_bulk_gpr_round_trip, false, false},
+    {"CSR List Read", test_csr_batch, false, false},
+    {"Polling Policy and Wait Counters", test_poll_policy, false, false},
+    {"SWCLK Autotune", test_autotune_frequency, false, false},
+    {"Shared PIO Program", test_shared_pio_program, false, false},
+    {"Gang Upload and Verify", test_gang_upload, false, false},
+    {"core1 Worker", test_worker, false, false},
+    {"Async Block Transfers", test_async_block, false, false},
+    {"Fast Attach and Warm Reconnect", test_fast_attach, false, false},
+    {"Memory Cache", test_mem_cache, false, false},
+    {"Byte-Granular Transfers", test_byte_transfers, false, false},
+    {"Protocol Statistics", test_protocol_stats, false, false},
 };
 
 const uint32_t api_coverage_test_count = sizeof(api_coverage_tests) / sizeof(api_coverage_tests[0]);
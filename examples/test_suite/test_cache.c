@@ -2,7 +2,8 @@
  * @file test_cache.c
  * @brief Tests for register cache management functions
  *
- * Covers: rp2350_enable_cache, rp2350_invalidate_cache
+ * Covers: rp2350_enable_cache, rp2350_invalidate_cache, write-back of
+ *         held register and CSR writes
  *
  * Copyright (c) 2025
  * SPDX-License-Identifier: MIT
@@ -10,8 +11,15 @@
 
 #include "test_framework.h"
 #include "pico2-swd-riscv/rp2350.h"
+#include "pico/stdlib.h"
 #include <stdio.h>
 
+// SRAM for the write-back test's code
+#define CODE_BASE 0x20077000
+
+#define CSR_DCSR     0x7b0
+#define DCSR_EBREAKM (1u << 15)
+
 //==============================================================================
 // Test 1: Cache Enable/Disable
 //==============================================================================
@@ -268,6 +276,73 @@ static bool test_cache_behavior_on_resume(swd_target_t *target) {
     return true;
 }
 
+//==============================================================================
+// Test 5: Write-Back of Held Register Writes
+//==============================================================================
+
+static bool test_cache_write_back(swd_target_t *target) {
+    printf("# Testing write-back register cache...\n");
+
+    rp2350_halt(target, 0);
+    rp2350_enable_cache(target, true);
+
+    // add x5, x6, x7; ebreak (back into debug mode with dcsr.ebreakm)
+    rp2350_write_mem32(target, CODE_BASE, 0x007302B3);
+    rp2350_write_mem32(target, CODE_BASE + 4, 0x00100073);
+
+    swd_result_t dcsr = rp2350_read_csr(target, 0, CSR_DCSR);
+
+    // All held in the cache until the resume
+    rp2350_write_csr(target, 0, CSR_DCSR, dcsr.value | DCSR_EBREAKM);
+    rp2350_write_pc(target, 0, CODE_BASE);
+    rp2350_write_reg(target, 0, 6, 1000);
+    rp2350_write_reg(target, 0, 7, 234);
+
+    swd_result_t pc = rp2350_read_pc(target, 0);
+    swd_result_t x7 = rp2350_read_reg(target, 0, 7);
+    if (pc.value != CODE_BASE || x7.value != 234) {
+        printf("# Read back pc = 0x%08lx, x7 = %lu\n", (unsigned long)pc.value,
+               (unsigned long)x7.value);
+        test_send_response(RESP_FAIL, "Held writes not visible to reads");
+        return false;
+    }
+
+    swd_error_t err = rp2350_resume(target, 0);
+    if (err != SWD_OK) {
+        printf("# Failed to resume: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Resume (write-back) failed");
+        return false;
+    }
+
+    sleep_ms(1);
+    err = rp2350_halt(target, 0);
+    swd_result_t x5 = rp2350_read_reg(target, 0, 5);
+    pc = rp2350_read_pc(target, 0);
+    printf("# x5 = %lu, pc = 0x%08lx\n", (unsigned long)x5.value, (unsigned long)pc.value);
+    if (err != SWD_OK || x5.value != 1234 || pc.value != CODE_BASE + 4) {
+        test_send_response(RESP_FAIL, "Hart did not run with the written registers");
+        return false;
+    }
+
+    // A held write survives turning the cache off
+    rp2350_write_csr(target, 0, CSR_DCSR, dcsr.value);
+    rp2350_write_reg(target, 0, 9, 0x5A5A5A5A);
+    rp2350_enable_cache(target, false);
+    swd_result_t x9 = rp2350_read_reg(target, 0, 9);
+    swd_result_t dcsr_after = rp2350_read_csr(target, 0, CSR_DCSR);
+    rp2350_enable_cache(target, true);
+
+    if (x9.value != 0x5A5A5A5A || dcsr_after.value != dcsr.value) {
+        printf("# x9 = 0x%08lx, dcsr = 0x%08lx after disabling the cache\n",
+               (unsigned long)x9.value, (unsigned long)dcsr_after.value);
+        test_send_response(RESP_FAIL, "Held writes lost when disabling the cache");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
 //==============================================================================
 // Test Array
 //==============================================================================
@@ -277,6 +352,7 @@ test_case_t cache_tests[] = {
     {"Cache Invalidation (Single Hart)", test_cache_invalidate_single_hart, false, false},
     {"Cache Isolation Between Harts", test_cache_isolation_between_harts, false, false},
     {"Cache Behavior on Resume", test_cache_behavior_on_resume, false, false},
+    {"Write-Back Register Cache", test_cache_write_back, false, false},
 };
 
 const uint32_t cache_test_count = sizeof(cache_tests) / sizeof(cache_tests[0]);
@@ -2,20 +2,30 @@
  * @file test_code_exec.c
  * @brief Tests for code execution functions
  *
- * Covers: rp2350_execute_code, rp2350_execute_progbuf
+ * Covers: rp2350_execute_code, rp2350_execute_progbuf, rp2350_upload_image,
+ *         rp2350_call, rp2350_flash_program, rp2350_profile_run,
+ *         rp2350_set_breakpoint, rp2350_run_until, rp2350_sync_image
  *
  * Copyright (c) 2025
  * SPDX-License-Identifier: MIT
  */
 
 #include "test_framework.h"
+#include "pico2-swd-riscv/flash.h"
+#include "pico2-swd-riscv/profile.h"
 #include "pico2-swd-riscv/rp2350.h"
+#include "pico/stdlib.h"
 #include <stdio.h>
+#include <string.h>
 
 // Test address in SRAM
 #define CODE_BASE 0x20077000
 #define DATA_BASE 0x20078000
 
+// Scratch flash: the last 64 KB of a 4 MB part
+#define FLASH_TEST_OFFSET 0x3F0000
+#define XIP_BASE          0x10000000
+
 //==============================================================================
 // Test 1: Execute Simple Addition Code
 //==============================================================================
@@ -336,6 +346,458 @@ static bool test_execute_code_with_loop(swd_target_t *target) {
     return true;
 }
 
+//==============================================================================
+// Test 6: Upload Verification Modes
+//==============================================================================
+
+static bool test_upload_verify_modes(swd_target_t *target) {
+    printf("# Testing upload verification modes...\n");
+
+    static uint32_t image[1024];
+    for (uint i = 0; i < 1024; i++) {
+        image[i] = 0x85EBCA6Bu * (i + 7);
+    }
+
+    // Words just past the image hold the CRC routine during the check
+    const uint32_t after = DATA_BASE + sizeof(image);
+    rp2350_write_mem32(target, after, 0x600DF00D);
+
+    static const char *names[] = {"none", "readback", "crc"};
+    swd_error_t results[3];
+    uint64_t elapsed[3];
+    for (uint mode = 0; mode < 3; mode++) {
+        uint64_t start = time_us_64();
+        results[mode] = rp2350_upload_image(target, 0, DATA_BASE, image, 1024,
+                                            (rp2350_verify_t)mode);
+        elapsed[mode] = time_us_64() - start;
+        printf("# %s: %s in %llu us\n", names[mode], swd_error_string(results[mode]),
+               (unsigned long long)elapsed[mode]);
+    }
+
+    if (results[0] != SWD_OK || results[1] != SWD_OK || results[2] != SWD_OK) {
+        printf("# %s\n", swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Upload failed");
+        return false;
+    }
+
+    swd_result_t last = rp2350_read_mem32(target, DATA_BASE + 4 * 1023);
+    if (last.error != SWD_OK || last.value != image[1023]) {
+        printf("# Last word: 0x%08lx, expected 0x%08lx\n", (unsigned long)last.value,
+               (unsigned long)image[1023]);
+        test_send_response(RESP_FAIL, "Image not in memory");
+        return false;
+    }
+
+    swd_result_t guard = rp2350_read_mem32(target, after);
+    if (guard.error != SWD_OK || guard.value != 0x600DF00D) {
+        printf("# Word after the image: 0x%08lx\n", (unsigned long)guard.value);
+        test_send_response(RESP_FAIL, "Memory after the image not restored");
+        return false;
+    }
+
+    if (elapsed[2] >= elapsed[1]) {
+        printf("# crc %llu us, readback %llu us\n", (unsigned long long)elapsed[2],
+               (unsigned long long)elapsed[1]);
+        test_send_response(RESP_FAIL, "CRC verification was not faster than readback");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 7: Target Function Call
+//==============================================================================
+
+static bool test_target_call(swd_target_t *target) {
+    printf("# Testing rp2350_call()...\n");
+
+    const uint32_t function[] = {
+        0x00B50533,  // add a0, a0, a1
+        0x00008067,  // ret
+    };
+    const uint32_t trap = CODE_BASE + 0x100;
+    rp2350_upload_code(target, CODE_BASE, function, 2);
+    rp2350_write_mem32(target, trap, 0xA5A5A5A5);
+
+    swd_result_t pc_before = rp2350_read_pc(target, 0);
+    swd_result_t a0_before = rp2350_read_reg(target, 0, 10);
+
+    const uint32_t args[2] = {40, 2};
+    swd_result_t sum = rp2350_call(target, 0, CODE_BASE, args, 2, trap, 100);
+    printf("# Returned %lu (%s)\n", (unsigned long)sum.value, swd_error_string(sum.error));
+
+    if (sum.error != SWD_OK || sum.value != 42) {
+        printf("# Expected 40 + 2 = 42\n");
+        test_send_response(RESP_FAIL, "Wrong return value");
+        return false;
+    }
+
+    if (!rp2350_is_halted(target, 0)) {
+        printf("# Hart 0 should be halted again after rp2350_call()\n");
+        test_send_response(RESP_FAIL, "Hart not halted after the call");
+        return false;
+    }
+
+    swd_result_t pc_after = rp2350_read_pc(target, 0);
+    swd_result_t a0_after = rp2350_read_reg(target, 0, 10);
+    if (pc_after.value != pc_before.value || a0_after.value != a0_before.value) {
+        printf("# pc 0x%08lx -> 0x%08lx, a0 0x%08lx -> 0x%08lx\n",
+               (unsigned long)pc_before.value, (unsigned long)pc_after.value,
+               (unsigned long)a0_before.value, (unsigned long)a0_after.value);
+        test_send_response(RESP_FAIL, "PC or a0 not restored");
+        return false;
+    }
+
+    swd_result_t trap_word = rp2350_read_mem32(target, trap);
+    if (trap_word.value != 0xA5A5A5A5) {
+        printf("# Trap word: 0x%08lx\n", (unsigned long)trap_word.value);
+        test_send_response(RESP_FAIL, "Trap word not restored");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 8: Flash Programming
+//==============================================================================
+
+// Two and a half sectors, so the last one is padded
+static uint8_t flash_image[RP2350_FLASH_SECTOR_SIZE * 5 / 2];
+
+/**
+ * @brief Program flash_image and check the sector counts, failing the test if not
+ */
+static bool flash_and_count(swd_target_t *target, uint32_t expect_written,
+                            uint32_t expect_skipped) {
+    rp2350_flash_stats_t stats;
+    swd_error_t err = rp2350_flash_program(target, 0, DATA_BASE, FLASH_TEST_OFFSET,
+                                           flash_image, sizeof(flash_image),
+                                           NULL, NULL, &stats);
+    printf("# %s: %lu written, %lu skipped\n", swd_error_string(err),
+           (unsigned long)stats.sectors_written, (unsigned long)stats.sectors_skipped);
+
+    if (err != SWD_OK) {
+        printf("# %s\n", swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Flash programming failed");
+        return false;
+    }
+
+    if (stats.sectors_written != expect_written || stats.sectors_skipped != expect_skipped) {
+        printf("# Expected %lu written, %lu skipped\n", (unsigned long)expect_written,
+               (unsigned long)expect_skipped);
+        test_send_response(RESP_FAIL, "Unexpected sector counts");
+        return false;
+    }
+    return true;
+}
+
+static bool test_flash_program(swd_target_t *target) {
+    printf("# Testing rp2350_flash_program()...\n");
+
+    rp2350_halt(target, 0);
+    rp2350_halt(target, 1);
+
+    uint32_t seed = time_us_32();
+    for (uint32_t i = 0; i < sizeof(flash_image); i++) {
+        seed = (seed * 1103515245) + 12345;
+        flash_image[i] = seed >> 24;
+    }
+
+    swd_result_t pc_before = rp2350_read_pc(target, 0);
+
+    // A fresh image, the same again, then one changed byte
+    if (!flash_and_count(target, 3, 0) || !flash_and_count(target, 0, 3)) {
+        return false;
+    }
+
+    flash_image[RP2350_FLASH_SECTOR_SIZE + 100] ^= 0xFF;
+    if (!flash_and_count(target, 1, 2)) {
+        return false;
+    }
+
+    uint8_t readback[64];
+    uint32_t tail = sizeof(flash_image) - 32;
+    rp2350_read_bytes(target, XIP_BASE + FLASH_TEST_OFFSET + tail, readback, 64);
+    for (uint i = 0; i < 64; i++) {
+        uint8_t expected = i < 32 ? flash_image[tail + i] : 0xFF;
+        if (readback[i] != expected) {
+            printf("# Byte %lu past offset 0x%lx: 0x%02x, expected 0x%02x\n",
+                   (unsigned long)i, (unsigned long)tail, readback[i], expected);
+            test_send_response(RESP_FAIL, "Flash contents wrong around the end of the image");
+            return false;
+        }
+    }
+
+    swd_result_t pc_after = rp2350_read_pc(target, 0);
+    if (pc_after.value != pc_before.value) {
+        printf("# PC 0x%08lx, expected 0x%08lx\n", (unsigned long)pc_after.value,
+               (unsigned long)pc_before.value);
+        test_send_response(RESP_FAIL, "PC not restored");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 9: PC Sampling Profiler
+//==============================================================================
+
+static bool test_pc_profiler(swd_target_t *target) {
+    printf("# Testing PC sampling profiler...\n");
+
+    // Spins while s0 == s1; a sample that failed to restore s0 would send
+    // the hart to the 'j .' after the loop
+    const uint32_t program[] = {
+        0x12300413,  // li   s0, 0x123
+        0x12300493,  // li   s1, 0x123
+        0x00150513,  // loop: addi a0, a0, 1
+        0xFE940EE3,  //       beq  s0, s1, loop
+        0x0000006F,  // j .
+    };
+
+    swd_error_t err = rp2350_execute_code(target, 0, CODE_BASE, program, 5);
+    if (err != SWD_OK) {
+        printf("# Failed to execute code: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Execution failed");
+        return false;
+    }
+
+    // One 4-byte bucket each for the loop's two instructions and the 'j .'
+    rp2350_profile_t prof;
+    err = rp2350_profile_init(&prof, CODE_BASE + 8, CODE_BASE + 20, 4);
+    if (err == SWD_OK) {
+        err = rp2350_profile_run(target, &prof, RP2350_PROFILE_HART0, 500, 200);
+    }
+
+    printf("# %lu samples (%lu outside, %lu missed), window max %lu us, mean %lu us\n",
+           (unsigned long)prof.samples, (unsigned long)prof.outside,
+           (unsigned long)prof.missed, (unsigned long)prof.max_window_us,
+           (unsigned long)(prof.samples ? prof.total_window_us / prof.samples : 0));
+
+    // The histogram is freed before the checks, which return early
+    uint32_t loop[3] = {0};
+    for (uint i = 0; i < 3 && prof.buckets; i++) {
+        loop[i] = prof.buckets[i];
+    }
+    rp2350_profile_free(&prof);
+
+    if (err != SWD_OK) {
+        printf("# Profiling failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Profiling failed");
+        return false;
+    }
+
+    if (prof.samples < 50 || prof.hart_samples[0] != prof.samples) {
+        printf("# Expected at least 50 samples, all from hart 0\n");
+        test_send_response(RESP_FAIL, "Too few samples");
+        return false;
+    }
+
+    if (loop[2] != 0 || loop[0] + loop[1] + prof.outside != prof.samples) {
+        printf("# %lu samples landed on the 'j .' after the loop\n", (unsigned long)loop[2]);
+        test_send_response(RESP_FAIL, "Hart left the loop (s0 not restored?)");
+        return false;
+    }
+
+    if (loop[0] == 0 || loop[1] == 0) {
+        printf("# Loop buckets: %lu, %lu\n", (unsigned long)loop[0], (unsigned long)loop[1]);
+        test_send_response(RESP_FAIL, "Samples did not cover the loop");
+        return false;
+    }
+
+    // Still looping with its registers intact
+    rp2350_halt(target, 0);
+    swd_result_t s0 = rp2350_read_reg(target, 0, 8);
+    swd_result_t pc = rp2350_read_pc(target, 0);
+    if (s0.value != 0x123 || pc.value < CODE_BASE + 8 || pc.value >= CODE_BASE + 16) {
+        printf("# s0 = 0x%08lx, pc = 0x%08lx\n", (unsigned long)s0.value,
+               (unsigned long)pc.value);
+        test_send_response(RESP_FAIL, "Hart state disturbed by sampling");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 10: Breakpoints and Run Until
+//==============================================================================
+
+static bool test_breakpoints(swd_target_t *target) {
+    printf("# Testing hardware breakpoints...\n");
+
+    // Counts t0 up to t1, then bumps t2 once and parks
+    const uint32_t program[] = {
+        0x00128293,  // loop: addi t0, t0, 1
+        0xFE629EE3,  //       bne  t0, t1, loop
+        0x00138393,  // done: addi t2, t2, 1
+        0x0000006F,  // j .
+    };
+
+    rp2350_halt(target, 0);
+    swd_error_t err = rp2350_clear_triggers(target, 0);
+    swd_result_t count = rp2350_trigger_count(target, 0);
+    if (err != SWD_OK || count.error != SWD_OK || count.value == 0) {
+        printf("# Trigger probe: %s, %lu triggers\n", swd_error_string(err),
+               (unsigned long)count.value);
+        test_send_response(RESP_FAIL, "No triggers found");
+        return false;
+    }
+    printf("# %lu triggers on hart 0\n", (unsigned long)count.value);
+
+    err = rp2350_upload_code(target, CODE_BASE, program, 4);
+    if (err == SWD_OK) err = rp2350_write_reg(target, 0, 5, 0);
+    if (err == SWD_OK) err = rp2350_write_reg(target, 0, 6, 100000);
+    if (err == SWD_OK) err = rp2350_write_reg(target, 0, 7, 0);
+    if (err == SWD_OK) err = rp2350_write_pc(target, 0, CODE_BASE);
+    if (err != SWD_OK) {
+        test_send_response(RESP_FAIL, "Failed to set up program");
+        return false;
+    }
+
+    // 200k instructions at full speed, far beyond what stepping could reach
+    uint64_t start = time_us_64();
+    err = rp2350_run_until(target, 0, CODE_BASE + 8, 1000);
+    uint64_t us = time_us_64() - start;
+    swd_result_t t0 = rp2350_read_reg(target, 0, 5);
+    swd_result_t t2 = rp2350_read_reg(target, 0, 7);
+    printf("# run_until: %s after %lu us, t0=%lu\n", swd_error_string(err),
+           (unsigned long)us, (unsigned long)t0.value);
+    if (err != SWD_OK || t0.value != 100000 || t2.value != 0) {
+        test_send_response(RESP_FAIL, "run_until did not stop at the target");
+        return false;
+    }
+
+    // A breakpoint on the branch stops once per pass; resume steps over it
+    err = rp2350_write_reg(target, 0, 5, 0);
+    if (err == SWD_OK) err = rp2350_write_pc(target, 0, CODE_BASE);
+    swd_result_t bp = rp2350_set_breakpoint(target, 0, CODE_BASE + 4);
+    if (err != SWD_OK || bp.error != SWD_OK) {
+        test_send_response(RESP_FAIL, "Failed to set breakpoint");
+        return false;
+    }
+
+    for (uint32_t pass = 1; pass <= 3; pass++) {
+        err = rp2350_resume(target, 0);
+        if (err == SWD_OK) {
+            err = rp2350_wait_halt(target, 0, 100);
+        }
+        if (err != SWD_OK) {
+            rp2350_halt(target, 0);
+        }
+        swd_result_t pc = rp2350_read_pc(target, 0);
+        t0 = rp2350_read_reg(target, 0, 5);
+        if (err != SWD_OK || pc.value != CODE_BASE + 4 || t0.value != pass) {
+            printf("# Pass %lu: %s, pc=0x%08lx t0=%lu\n", (unsigned long)pass,
+                   swd_error_string(err), (unsigned long)pc.value, (unsigned long)t0.value);
+            rp2350_clear_triggers(target, 0);
+            test_send_response(RESP_FAIL, "Breakpoint did not stop each pass");
+            return false;
+        }
+    }
+
+    err = rp2350_clear_trigger(target, 0, bp.value);
+    if (err != SWD_OK) {
+        test_send_response(RESP_FAIL, "Failed to clear breakpoint");
+        return false;
+    }
+
+    // Hazard3 triggers are execute-only; either answer is fine, but it must be clean
+    swd_result_t wp = rp2350_set_watchpoint(target, 0, DATA_BASE, RP2350_WATCH_STORE);
+    printf("# Store watchpoint: %s\n", swd_error_string(wp.error));
+    if (wp.error == SWD_OK) {
+        rp2350_clear_trigger(target, 0, wp.value);
+    } else if (wp.error != SWD_ERROR_INVALID_CONFIG) {
+        test_send_response(RESP_FAIL, "Watchpoint setup failed");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 11: Incremental Image Sync
+//==============================================================================
+
+#define SYNC_WORDS (8 * RP2350_SYNC_PAGE_WORDS + 40)    // Short last page
+
+static bool sync_and_count(swd_target_t *target, const uint32_t *image,
+                           uint32_t expect_pages) {
+    uint64_t start = time_us_64();
+    swd_result_t result = rp2350_sync_image(target, 0, DATA_BASE, image, SYNC_WORDS);
+    printf("# Sync: %s, %lu pages in %llu us (expected %lu)\n", swd_error_string(result.error),
+           (unsigned long)result.value, (unsigned long long)(time_us_64() - start),
+           (unsigned long)expect_pages);
+    return result.error == SWD_OK && result.value == expect_pages;
+}
+
+static bool test_sync_image(swd_target_t *target) {
+    printf("# Testing rp2350_sync_image()...\n");
+
+    static uint32_t image[SYNC_WORDS];
+    static uint32_t readback[SYNC_WORDS];
+    for (uint i = 0; i < SYNC_WORDS; i++) {
+        image[i] = 0x9E3779B1u * (i + 3);
+    }
+
+    const uint32_t after = DATA_BASE + sizeof(image);
+    swd_error_t err = rp2350_upload_image(target, 0, DATA_BASE, image, SYNC_WORDS,
+                                          RP2350_VERIFY_NONE);
+    if (err == SWD_OK) {
+        err = rp2350_write_mem32(target, after, 0x600DF00D);
+    }
+    if (err != SWD_OK) {
+        test_send_response(RESP_FAIL, "Initial upload failed");
+        return false;
+    }
+
+    if (!sync_and_count(target, image, 0)) {
+        test_send_response(RESP_FAIL, "Unchanged image uploaded pages");
+        return false;
+    }
+
+    // One word in page 3 and one in the short last page
+    image[3 * RP2350_SYNC_PAGE_WORDS + 17] ^= 1;
+    image[SYNC_WORDS - 1] ^= 0x80000000;
+    if (!sync_and_count(target, image, 2)) {
+        test_send_response(RESP_FAIL, "Changed pages not uploaded exactly");
+        return false;
+    }
+
+    // A change on the target side is found the same way
+    err = rp2350_write_mem32(target, DATA_BASE + 8, 0);
+    if (err != SWD_OK || !sync_and_count(target, image, 1)) {
+        printf("# Target-side write: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Target-side change not repaired");
+        return false;
+    }
+
+    err = rp2350_read_mem_block(target, DATA_BASE, readback, SYNC_WORDS);
+    if (err != SWD_OK || memcmp(readback, image, sizeof(image)) != 0) {
+        printf("# Read-back: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Target memory differs from the image");
+        return false;
+    }
+
+    swd_result_t guard = rp2350_read_mem32(target, after);
+    if (guard.error != SWD_OK || guard.value != 0x600DF00D) {
+        printf("# Word after the image: 0x%08lx\n", (unsigned long)guard.value);
+        test_send_response(RESP_FAIL, "Memory after the image not restored");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
 //==============================================================================
 // Test Array
 //==============================================================================
@@ -346,6 +808,12 @@ test_case_t code_exec_tests[] = {
     {"Execute Code on Hart 1", test_execute_code_on_hart1, false, false},
     {"Execute Program Buffer", test_execute_progbuf, false, false},
     {"Execute Code with Loop", test_execute_code_with_loop, false, false},
+    {"Upload Verification Modes", test_upload_verify_modes, false, false},
+    {"Target Function Call", test_target_call, false, false},
+    {"Flash Programming", test_flash_program, false, false},
+    {"PC Sampling Profiler", test_pc_profiler, false, false},
+    {"Breakpoints and Run Until", test_breakpoints, false, false},
+    {"Incremental Image Sync", test_sync_image, false, false},
 };
 
 const uint32_t code_exec_test_count = sizeof(code_exec_tests) / sizeof(code_exec_tests[0]);
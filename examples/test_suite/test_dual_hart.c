@@ -329,6 +329,77 @@ static bool test_rapid_hart_switching(swd_target_t *target) {
     return true;
 }
 
+//==============================================================================
+// Test 28: Simultaneous Halt and Resume
+//==============================================================================
+
+#define GROUP_CODE_BASE 0x20077000
+
+static bool test_group_halt_resume(swd_target_t *target) {
+    printf("# Testing simultaneous halt/resume of both harts...\n");
+
+    // Both harts count loop iterations in t0
+    const uint32_t program[] = {
+        0x00128293,  // loop: addi t0, t0, 1
+        0xFFDFF06F,  //       j    loop
+    };
+
+    swd_error_t err = rp2350_halt_harts(target, RP2350_HARTS_ALL);
+    if (err == SWD_OK) {
+        err = rp2350_upload_code(target, GROUP_CODE_BASE, program, 2);
+    }
+    for (uint8_t h = 0; h < 2 && err == SWD_OK; h++) {
+        err = rp2350_write_reg(target, h, 5, 0);
+        if (err == SWD_OK) {
+            err = rp2350_write_pc(target, h, GROUP_CODE_BASE);
+        }
+    }
+    if (err != SWD_OK) {
+        printf("# Setup failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Setup failed");
+        return false;
+    }
+
+    uint64_t start = time_us_64();
+    err = rp2350_resume_harts(target, RP2350_HARTS_ALL);
+    uint64_t resume_us = time_us_64() - start;
+    if (err != SWD_OK || rp2350_is_halted(target, 0) || rp2350_is_halted(target, 1)) {
+        printf("# Resume failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Group resume failed");
+        return false;
+    }
+
+    sleep_ms(10);
+
+    start = time_us_64();
+    err = rp2350_halt_harts(target, RP2350_HARTS_ALL);
+    uint64_t halt_us = time_us_64() - start;
+    if (err != SWD_OK || !rp2350_is_halted(target, 0) || !rp2350_is_halted(target, 1)) {
+        printf("# Halt failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Group halt failed");
+        return false;
+    }
+
+    // Started and stopped together: the counts differ only by bus contention
+    swd_result_t c0 = rp2350_read_reg(target, 0, 5);
+    swd_result_t c1 = rp2350_read_reg(target, 1, 5);
+    uint32_t skew = c0.value > c1.value ? c0.value - c1.value : c1.value - c0.value;
+    printf("# resume %lu us, halt %lu us, counts %lu / %lu\n", (unsigned long)resume_us,
+           (unsigned long)halt_us, (unsigned long)c0.value, (unsigned long)c1.value);
+
+    if (c0.error != SWD_OK || c1.error != SWD_OK || c0.value == 0 || c1.value == 0) {
+        test_send_response(RESP_FAIL, "Harts did not run");
+        return false;
+    }
+    if (skew > c0.value / 10) {
+        test_send_response(RESP_FAIL, "Harts did not run for the same time");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
 //==============================================================================
 // Test Suite Definition
 //==============================================================================
@@ -340,6 +411,7 @@ test_case_t dual_hart_tests[] = {
     { "TEST 25: Hart 1 Reset", test_hart1_reset, false, false },
     { "TEST 26: Single-Step Both Harts", test_single_step_both_harts, false, false },
     { "TEST 27: Rapid Hart Switching", test_rapid_hart_switching, false, false },
+    { "TEST 28: Simultaneous Halt/Resume", test_group_halt_resume, false, false },
 };
 
 const uint32_t dual_hart_test_count = sizeof(dual_hart_tests) / sizeof(dual_hart_tests[0]);
@@ -38,6 +38,7 @@
 #define CMD_CLEAR_BP "CLEAR_BP"
 #define CMD_CLEAR_ALL_BP "CLEAR_ALL_BP"
 #define CMD_TEST_ALL "TEST_ALL"
+#define CMD_BENCH_ALL "BENCH_ALL"
 #define CMD_DISCONNECT "DISCONNECT"
 
 // Responses
@@ -173,4 +174,18 @@ extern const uint32_t cache_test_count;
 extern test_case_t code_exec_tests[];
 extern const uint32_t code_exec_test_count;
 
+//==============================================================================
+// Benchmarks (bench.c)
+//==============================================================================
+
+/**
+ * @brief Run every benchmark at each SWCLK frequency and print the results
+ *
+ * Connects through test_setup() and leaves the target connected at its
+ * configured frequency.
+ *
+ * @param target The SWD target to measure
+ */
+void bench_run_all(swd_target_t *target);
+
 #endif // TEST_FRAMEWORK_H
@@ -3,7 +3,8 @@
  * @brief Tests for 8/16-bit memory operations and block transfers
  *
  * Covers: rp2350_read/write_mem8/16, rp2350_read/write_mem_block,
- *         dap_read_mem32, dap_write_mem32
+ *         dap_read_mem32, dap_write_mem32, dap_read/write_mem_block,
+ *         rp2350_rtt_*, rp2350_dump
  *
  * Copyright (c) 2025
  * SPDX-License-Identifier: MIT
@@ -12,7 +13,10 @@
 #include "test_framework.h"
 #include "pico2-swd-riscv/rp2350.h"
 #include "pico2-swd-riscv/dap.h"
+#include "pico2-swd-riscv/dump.h"
+#include "pico2-swd-riscv/rtt.h"
 #include <stdio.h>
+#include <string.h>
 
 // Test address in SRAM
 #define TEST_ADDR 0x20077000
@@ -329,6 +333,445 @@ static bool test_dap_dm_register_access(swd_target_t *target) {
     return true;
 }
 
+//==============================================================================
+// Test 6: Large Block Round Trip
+//==============================================================================
+
+// Crosses an SBA chunk and several implicit batch flushes (and DMA runs)
+#define LARGE_BLOCK_WORDS 300
+
+static bool test_rp2350_large_block(swd_target_t *target) {
+    printf("# Testing %d-word block write/read...\n", LARGE_BLOCK_WORDS);
+
+    static uint32_t write_buffer[LARGE_BLOCK_WORDS];
+    static uint32_t read_buffer[LARGE_BLOCK_WORDS];
+    for (uint32_t i = 0; i < LARGE_BLOCK_WORDS; i++) {
+        write_buffer[i] = (i * 0x9E3779B9) ^ 0x5A5A0000;
+        read_buffer[i] = 0;
+    }
+
+    swd_error_t err = rp2350_write_mem_block(target, TEST_ADDR, write_buffer, LARGE_BLOCK_WORDS);
+    if (err != SWD_OK) {
+        printf("# Block write failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Block write failed");
+        return false;
+    }
+
+    err = rp2350_read_mem_block(target, TEST_ADDR, read_buffer, LARGE_BLOCK_WORDS);
+    if (err != SWD_OK) {
+        printf("# Block read failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Block read failed");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < LARGE_BLOCK_WORDS; i++) {
+        if (read_buffer[i] != write_buffer[i]) {
+            printf("# Word %lu mismatch: got 0x%08lx, expected 0x%08lx\n",
+                   (unsigned long)i, (unsigned long)read_buffer[i], (unsigned long)write_buffer[i]);
+            test_send_response(RESP_FAIL, "Data mismatch");
+            return false;
+        }
+    }
+
+    // Spot-check against single-word reads
+    for (uint32_t i = 0; i < LARGE_BLOCK_WORDS; i += 97) {
+        swd_result_t result = rp2350_read_mem32(target, TEST_ADDR + (i * 4));
+        if (result.error != SWD_OK || result.value != write_buffer[i]) {
+            printf("# Single read of word %lu disagrees\n", (unsigned long)i);
+            test_send_response(RESP_FAIL, "Single read mismatch");
+            return false;
+        }
+    }
+
+    printf("# Large block round trip successful\n");
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 7: DAP Block Access (MEM-AP auto-increment)
+//==============================================================================
+
+static bool test_dap_mem_block(swd_target_t *target) {
+    printf("# Testing dap_read_mem_block/dap_write_mem_block on PROGBUF...\n");
+
+    rp2350_halt(target, 0);
+
+    uint32_t values[2] = {0x13579BDF, 0x2468ACE0};
+    swd_error_t err = dap_write_mem_block(target, DM_PROGBUF0, values, 2);
+    if (err != SWD_OK) {
+        printf("# Block write failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Block write failed");
+        return false;
+    }
+
+    // Single-word reads must still see a non-incrementing TAR
+    for (int i = 0; i < 2; i++) {
+        swd_result_t result = dap_read_mem32(target, DM_PROGBUF0 + (i * 4));
+        if (result.error != SWD_OK || result.value != values[i]) {
+            printf("# PROGBUF%d: got 0x%08lx, expected 0x%08lx\n",
+                   i, (unsigned long)result.value, (unsigned long)values[i]);
+            test_send_response(RESP_FAIL, "Single read after block write mismatch");
+            return false;
+        }
+    }
+
+    uint32_t readback[2] = {0, 0};
+    err = dap_read_mem_block(target, DM_PROGBUF0, readback, 2);
+    if (err != SWD_OK) {
+        printf("# Block read failed: %s\n", swd_error_string(err));
+        test_send_response(RESP_FAIL, "Block read failed");
+        return false;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (readback[i] != values[i]) {
+            printf("# PROGBUF%d block read: got 0x%08lx, expected 0x%08lx\n",
+                   i, (unsigned long)readback[i], (unsigned long)values[i]);
+            test_send_response(RESP_FAIL, "Block read mismatch");
+            return false;
+        }
+    }
+
+    // Misaligned start must be rejected
+    if (dap_read_mem_block(target, DM_PROGBUF0 + 2, readback, 1) != SWD_ERROR_ALIGNMENT) {
+        test_send_response(RESP_FAIL, "Misaligned block read accepted");
+        return false;
+    }
+
+    printf("# DAP block access successful\n");
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 8: Posted Writes
+//==============================================================================
+
+static bool test_posted_writes(swd_target_t *target) {
+    printf("# Testing posted-write mode...\n");
+
+    dap_set_posted_writes(target, true);
+
+    // Unconfirmed writes, then one CTRL/STAT check
+    for (uint32_t i = 0; i < 16; i++) {
+        swd_error_t err = rp2350_write_mem32(target, TEST_ADDR + (i * 4), 0xC0DE0000 | i);
+        if (err != SWD_OK) {
+            dap_set_posted_writes(target, false);
+            printf("# Posted write %lu failed: %s\n", (unsigned long)i, swd_error_string(err));
+            test_send_response(RESP_FAIL, "Posted write failed");
+            return false;
+        }
+    }
+
+    swd_error_t err = dap_sync_posted(target);
+    if (err != SWD_OK) {
+        dap_set_posted_writes(target, false);
+        printf("# Sync failed: %s (%s)\n", swd_error_string(err),
+               swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Posted write sync failed");
+        return false;
+    }
+
+    // DM register writes are posted too; the read-back confirms them
+    err = dap_write_mem32(target, DM_PROGBUF0, 0x00100073);
+    swd_result_t progbuf = dap_read_mem32(target, DM_PROGBUF0);
+    dap_set_posted_writes(target, false);
+
+    if (err != SWD_OK || progbuf.error != SWD_OK || progbuf.value != 0x00100073) {
+        test_send_response(RESP_FAIL, "Posted DM register write not visible");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < 16; i++) {
+        swd_result_t result = rp2350_read_mem32(target, TEST_ADDR + (i * 4));
+        if (result.error != SWD_OK || result.value != (0xC0DE0000 | i)) {
+            printf("# Word %lu: got 0x%08lx\n", (unsigned long)i, (unsigned long)result.value);
+            test_send_response(RESP_FAIL, "Posted write data mismatch");
+            return false;
+        }
+    }
+
+    printf("# Posted writes successful\n");
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 9: RTT Channels
+//==============================================================================
+
+#define RTT_CB_ADDR   0x20076040
+#define RTT_UP_ADDR   0x20076100
+#define RTT_DOWN_ADDR 0x20076200
+#define RTT_NAME_ADDR 0x20076300
+#define RTT_UP_SIZE   64
+#define RTT_DOWN_SIZE 32
+
+// Descriptor word offsets within the control block
+#define RTT_UP_WROFF   (RTT_CB_ADDR + 24 + 12)
+#define RTT_UP_RDOFF   (RTT_CB_ADDR + 24 + 16)
+#define RTT_DOWN_WROFF (RTT_CB_ADDR + 48 + 12)
+
+static uint32_t rtt_accept_three(uint32_t channel, const uint8_t *data, uint32_t len,
+                                 void *ctx) {
+    *(uint32_t *)ctx += len;
+    return 3;
+}
+
+static bool rtt_up_matches(const uint8_t *data, uint32_t from, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (data[i] != (((from + i) % RTT_UP_SIZE) ^ 0x5A)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool test_rtt_channels(swd_target_t *target) {
+    printf("# Testing RTT ring buffers...\n");
+
+    // Control block as the firmware would lay it out: 1 up, 1 down
+    static const uint8_t id[16] = "SEGGER RTT";
+    const uint32_t header[2 + 12] = {
+        1, 1,
+        RTT_NAME_ADDR, RTT_UP_ADDR, RTT_UP_SIZE, 10, 50, RP2350_RTT_MODE_SKIP,
+        0, RTT_DOWN_ADDR, RTT_DOWN_SIZE, 0, 0, 0,
+    };
+    uint8_t ring[RTT_UP_SIZE];
+    for (uint32_t i = 0; i < RTT_UP_SIZE; i++) {
+        ring[i] = i ^ 0x5A;
+    }
+
+    // Clear the scan window so a stale block cannot be found first
+    uint32_t zero[64] = {0};
+    swd_error_t err = rp2350_write_mem_block(target, 0x20076000, zero, 64);
+    if (err == SWD_OK) {
+        err = rp2350_write_bytes(target, RTT_CB_ADDR, id, sizeof(id));
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_mem_block(target, RTT_CB_ADDR + 16, header, 14);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_bytes(target, RTT_UP_ADDR, ring, sizeof(ring));
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_bytes(target, RTT_NAME_ADDR, (const uint8_t *)"Terminal", 9);
+    }
+    if (err != SWD_OK) {
+        test_send_response(RESP_FAIL, "Failed to build control block");
+        return false;
+    }
+
+    rp2350_rtt_t rtt;
+    err = rp2350_rtt_find(target, &rtt, 0x20076000, 0x400);
+    if (err != SWD_OK) {
+        printf("# Find failed: %s (%s)\n", swd_error_string(err),
+               swd_get_last_error_detail(target));
+        test_send_response(RESP_FAIL, "Control block not found");
+        return false;
+    }
+    printf("# Found at 0x%08lx, up[0] \"%s\"\n", (unsigned long)rtt.cb_addr, rtt.up[0].name);
+    if (rtt.cb_addr != RTT_CB_ADDR || rtt.num_up != 1 || rtt.num_down != 1 ||
+        rtt.up[0].size != RTT_UP_SIZE || strcmp(rtt.up[0].name, "Terminal") != 0) {
+        test_send_response(RESP_FAIL, "Control block parsed wrong");
+        return false;
+    }
+
+    // 24 bytes pending, wrapping at the end of the ring; take 16 then the rest
+    uint8_t buf[64];
+    uint32_t got = 0;
+    err = rp2350_rtt_read(target, &rtt, 0, buf, 16, &got);
+    if (err != SWD_OK || got != 16 || !rtt_up_matches(buf, 50, 16)) {
+        printf("# First read: %s, %lu bytes\n", swd_error_string(err), (unsigned long)got);
+        test_send_response(RESP_FAIL, "Wrapped ring read wrong");
+        return false;
+    }
+    err = rp2350_rtt_read(target, &rtt, 0, buf, sizeof(buf), &got);
+    swd_result_t rd = rp2350_read_mem32(target, RTT_UP_RDOFF);
+    if (err != SWD_OK || got != 8 || !rtt_up_matches(buf, 2, 8) || rd.value != 10) {
+        printf("# Second read: %lu bytes, RdOff %lu\n", (unsigned long)got,
+               (unsigned long)rd.value);
+        test_send_response(RESP_FAIL, "Ring remainder read wrong");
+        return false;
+    }
+    err = rp2350_rtt_read(target, &rtt, 0, buf, sizeof(buf), &got);
+    if (err != SWD_OK || got != 0) {
+        test_send_response(RESP_FAIL, "Empty ring returned data");
+        return false;
+    }
+
+    // A handler that keeps up with only 3 bytes leaves the rest in the ring
+    uint32_t offered = 0;
+    err = rp2350_write_mem32(target, RTT_UP_WROFF, 20);
+    if (err == SWD_OK) {
+        err = rp2350_rtt_poll(target, &rtt, buf, sizeof(buf), rtt_accept_three, &offered);
+    }
+    rd = rp2350_read_mem32(target, RTT_UP_RDOFF);
+    if (err != SWD_OK || offered != 10 || rd.value != 13) {
+        printf("# Poll: offered %lu, RdOff %lu\n", (unsigned long)offered,
+               (unsigned long)rd.value);
+        test_send_response(RESP_FAIL, "Poll back-pressure wrong");
+        return false;
+    }
+
+    // Down ring takes size - 1 bytes, then refuses more until the target reads
+    uint32_t written = 0;
+    err = rp2350_rtt_write(target, &rtt, 0, ring, 40, &written);
+    swd_result_t wr = rp2350_read_mem32(target, RTT_DOWN_WROFF);
+    if (err != SWD_OK || written != RTT_DOWN_SIZE - 1 || wr.value != RTT_DOWN_SIZE - 1) {
+        printf("# Down write: %lu bytes, WrOff %lu\n", (unsigned long)written,
+               (unsigned long)wr.value);
+        test_send_response(RESP_FAIL, "Down ring write wrong");
+        return false;
+    }
+    err = rp2350_read_bytes(target, RTT_DOWN_ADDR, buf, RTT_DOWN_SIZE - 1);
+    if (err != SWD_OK || memcmp(buf, ring, RTT_DOWN_SIZE - 1) != 0) {
+        test_send_response(RESP_FAIL, "Down ring data mismatch");
+        return false;
+    }
+    err = rp2350_rtt_write(target, &rtt, 0, ring, 1, &written);
+    if (err != SWD_OK || written != 0 || rtt.down_full != 2) {
+        test_send_response(RESP_FAIL, "Full down ring accepted data");
+        return false;
+    }
+
+    printf("# RTT channels successful\n");
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test 10: Streamed Dump
+//==============================================================================
+
+#define DUMP_WORDS     256
+#define DUMP_BUF_WORDS 24       // Small enough to split runs across chunks
+
+typedef struct {
+    uint32_t out[DUMP_WORDS];
+    uint32_t words;             // Decoded so far
+    bool bad;                   // Malformed record or overflow
+} dump_check_t;
+
+static swd_error_t dump_decode(const uint8_t *data, uint32_t len, void *ctx) {
+    dump_check_t *check = ctx;
+    const uint32_t *rec = (const uint32_t *)data;
+    uint32_t n = len / 4;
+
+    for (uint32_t i = 0; i < n;) {
+        uint32_t kind = rec[i] >> RP2350_DUMP_KIND_SHIFT;
+        uint32_t words = rec[i] & RP2350_DUMP_COUNT_MASK;
+        i++;
+        if (check->words + words > DUMP_WORDS ||
+            (kind == RP2350_DUMP_LITERAL && i + words > n)) {
+            check->bad = true;
+            return SWD_ERROR_VERIFY;
+        }
+        for (uint32_t j = 0; j < words; j++) {
+            if (kind == RP2350_DUMP_LITERAL) {
+                check->out[check->words++] = rec[i++];
+            } else {
+                check->out[check->words++] = kind == RP2350_DUMP_ONES ? 0xFFFFFFFF : 0;
+            }
+        }
+    }
+    return SWD_OK;
+}
+
+static swd_error_t dump_copy(const uint8_t *data, uint32_t len, void *ctx) {
+    dump_check_t *check = ctx;
+    if (check->words + (len / 4) > DUMP_WORDS) {
+        check->bad = true;
+        return SWD_ERROR_VERIFY;
+    }
+    memcpy(&check->out[check->words], data, len);
+    check->words += len / 4;
+    return SWD_OK;
+}
+
+static swd_error_t dump_refuse(const uint8_t *data, uint32_t len, void *ctx) {
+    (*(uint32_t *)ctx)++;
+    return SWD_ERROR_CANCELLED;
+}
+
+static bool test_streamed_dump(swd_target_t *target) {
+    printf("# Testing streamed dump...\n");
+
+    // Literals, a zero run across a chunk boundary, an erased run, short runs
+    static uint32_t image[DUMP_WORDS];
+    for (uint32_t i = 0; i < DUMP_WORDS; i++) {
+        if (i >= 16 && i < 80) {
+            image[i] = 0;
+        } else if (i >= 100 && i < 200) {
+            image[i] = 0xFFFFFFFF;
+        } else if (i >= 210 && i < 212) {
+            image[i] = 0;
+        } else {
+            image[i] = 0xD0000000 | (i * 0x01010101u);
+        }
+    }
+
+    swd_error_t err = rp2350_write_mem_block(target, TEST_ADDR, image, DUMP_WORDS);
+    if (err != SWD_OK) {
+        test_send_response(RESP_FAIL, "Failed to write dump image");
+        return false;
+    }
+
+    static uint32_t ping[DUMP_BUF_WORDS], pong[DUMP_BUF_WORDS];
+    static dump_check_t check;
+    rp2350_dump_stats_t stats;
+
+    memset(&check, 0, sizeof(check));
+    err = rp2350_dump(target, TEST_ADDR, DUMP_WORDS, ping, pong, DUMP_BUF_WORDS, 0,
+                      dump_copy, &check, &stats);
+    if (err != SWD_OK || check.bad || check.words != DUMP_WORDS ||
+        memcmp(check.out, image, sizeof(image)) != 0 ||
+        stats.bytes_sent != DUMP_WORDS * 4 ||
+        stats.chunks != (DUMP_WORDS + DUMP_BUF_WORDS - 1) / DUMP_BUF_WORDS) {
+        printf("# Raw dump: %s, %lu words, %lu chunks\n", swd_error_string(err),
+               (unsigned long)check.words, (unsigned long)stats.chunks);
+        test_send_response(RESP_FAIL, "Raw dump mismatch");
+        return false;
+    }
+
+    memset(&check, 0, sizeof(check));
+    err = rp2350_dump(target, TEST_ADDR, DUMP_WORDS, ping, pong, DUMP_BUF_WORDS,
+                      RP2350_DUMP_RLE, dump_decode, &check, &stats);
+    printf("# RLE: %lu bytes read, %lu sent in %lu chunks\n",
+           (unsigned long)stats.bytes_read, (unsigned long)stats.bytes_sent,
+           (unsigned long)stats.chunks);
+    if (err != SWD_OK || check.bad || check.words != DUMP_WORDS ||
+        memcmp(check.out, image, sizeof(image)) != 0) {
+        test_send_response(RESP_FAIL, "RLE dump does not decode to the image");
+        return false;
+    }
+    if (stats.bytes_read != DUMP_WORDS * 4 || stats.bytes_sent >= stats.bytes_read / 2) {
+        test_send_response(RESP_FAIL, "RLE did not collapse the runs");
+        return false;
+    }
+
+    // A sink error stops the dump after the first chunk
+    uint32_t calls = 0;
+    err = rp2350_dump(target, TEST_ADDR, DUMP_WORDS, ping, pong, DUMP_BUF_WORDS, 0,
+                      dump_refuse, &calls, NULL);
+    if (err != SWD_ERROR_CANCELLED || calls != 1) {
+        test_send_response(RESP_FAIL, "Sink error did not stop the dump");
+        return false;
+    }
+
+    // Blocking calls work again once the dump has returned
+    swd_result_t word = rp2350_read_mem32(target, TEST_ADDR);
+    if (word.error != SWD_OK || word.value != image[0]) {
+        test_send_response(RESP_FAIL, "Target unusable after stopped dump");
+        return false;
+    }
+
+    printf("# Streamed dump successful\n");
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
 //==============================================================================
 // Test Array
 //==============================================================================
@@ -339,6 +782,11 @@ test_case_t memory_ops_tests[] = {
     {"RP2350 Block Memory Read", test_rp2350_read_mem_block, false, false},
     {"RP2350 Block Memory Write", test_rp2350_write_mem_block, false, false},
     {"DAP DM Register Access", test_dap_dm_register_access, false, false},
+    {"RP2350 Large Block Round Trip", test_rp2350_large_block, false, false},
+    {"DAP Block Access", test_dap_mem_block, false, false},
+    {"Posted Writes", test_posted_writes, false, false},
+    {"RTT Channels", test_rtt_channels, false, false},
+    {"Streamed Dump", test_streamed_dump, false, false},
 };
 
 const uint32_t memory_ops_test_count = sizeof(memory_ops_tests) / sizeof(memory_ops_tests[0]);
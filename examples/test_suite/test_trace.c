@@ -9,6 +9,7 @@
 #include "test_framework.h"
 #include "pico2-swd-riscv/rp2350.h"
 #include <stdio.h>
+#include <string.h>
 #include "pico/stdlib.h"
 
 //==============================================================================
@@ -549,6 +550,185 @@ static bool test_trace_hart1(swd_target_t *target) {
     }
 }
 
+//==============================================================================
+// Test: Streamed Trace into a Ring Buffer
+//==============================================================================
+
+static bool test_trace_stream(swd_target_t *target) {
+    printf("# Testing streamed trace into a ring buffer...\n");
+
+    rp2350_halt(target, 0);
+
+    uint32_t program[] = {
+        0x00128293,  // addi x5, x5, 1
+        0x00230313,  // addi x6, x6, 2
+        0x00338393,  // addi x7, x7, 3
+        0x0000006f,  // j 0
+    };
+
+    uint32_t program_addr = 0x20010400;
+
+    for (uint i = 0; i < sizeof(program)/sizeof(program[0]); i++) {
+        rp2350_write_mem32(target, program_addr + (i * 4), program[i]);
+    }
+
+    // Disable interrupts
+    swd_result_t mstatus_read = rp2350_read_csr(target, 0, 0x300);
+    if (mstatus_read.error == SWD_OK) {
+        rp2350_write_csr(target, 0, 0x300, mstatus_read.value & ~(1 << 3));
+    }
+
+    rp2350_write_pc(target, 0, program_addr);
+    rp2350_write_reg(target, 0, 5, 0);
+    rp2350_write_reg(target, 0, 6, 0);
+    rp2350_write_reg(target, 0, 7, 0);
+
+    // Ring smaller than the request: the trace must stop when it fills
+    trace_entry_t entries[6];
+    trace_ring_t ring = { .entries = entries, .capacity = 6, .overwrite = false };
+
+    int result = rp2350_trace_stream(target, 0, 100, &ring);
+    printf("# Streamed %d instructions\n", result);
+
+    if (result != 6) {
+        printf("# Expected 6 instructions (ring capacity), got %d\n", result);
+        test_send_response(RESP_FAIL, "Streamed trace count mismatch");
+        return false;
+    }
+
+    // PCs walk the three addis, then sit on the jump
+    for (uint i = 0; i < 6; i++) {
+        trace_entry_t entry;
+        uint32_t expected_pc = program_addr + ((i < 3 ? i : 3) * 4);
+
+        if (!rp2350_trace_ring_pop(&ring, &entry)) {
+            test_send_response(RESP_FAIL, "Ring ran out of entries");
+            return false;
+        }
+
+        printf("# [%u] PC=0x%08lx INST=0x%08lx\n", i,
+               (unsigned long)entry.pc, (unsigned long)entry.instruction);
+
+        if (entry.pc != expected_pc || entry.instruction != program[(expected_pc - program_addr) / 4]) {
+            printf("# Expected PC=0x%08lx\n", (unsigned long)expected_pc);
+            test_send_response(RESP_FAIL, "Streamed trace PC mismatch");
+            return false;
+        }
+    }
+
+    // Registers must be intact after the held-s0 stepping
+    swd_result_t x5 = rp2350_read_reg(target, 0, 5);
+    swd_result_t x7 = rp2350_read_reg(target, 0, 7);
+    swd_result_t dcsr = rp2350_read_csr(target, 0, 0x7b0);
+
+    if (x5.value != 1 || x7.value != 3) {
+        printf("# x5=%lu x7=%lu (expected 1 and 3)\n",
+               (unsigned long)x5.value, (unsigned long)x7.value);
+        test_send_response(RESP_FAIL, "Register state wrong after streamed trace");
+        return false;
+    }
+
+    if (dcsr.error != SWD_OK || (dcsr.value & (1 << 2))) {
+        test_send_response(RESP_FAIL, "DCSR.step left set");
+        return false;
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
+//==============================================================================
+// Test: Compact Trace with Fetch Cache
+//==============================================================================
+
+#define COMPACT_STEPS 30
+
+static bool test_trace_compact(swd_target_t *target) {
+    printf("# Testing compact delta-encoded trace...\n");
+
+    rp2350_halt(target, 0);
+
+    uint32_t program[] = {
+        0x00128293,  // loop: addi x5, x5, 1
+        0x00230313,  //       addi x6, x6, 2
+        0xff9ff06f,  //       j    loop
+    };
+
+    uint32_t program_addr = 0x20010400;
+
+    for (uint i = 0; i < sizeof(program)/sizeof(program[0]); i++) {
+        rp2350_write_mem32(target, program_addr + (i * 4), program[i]);
+    }
+
+    // Disable interrupts
+    swd_result_t mstatus_read = rp2350_read_csr(target, 0, 0x300);
+    if (mstatus_read.error == SWD_OK) {
+        rp2350_write_csr(target, 0, 0x300, mstatus_read.value & ~(1 << 3));
+    }
+
+    static trace_delta_t records[COMPACT_STEPS];
+    static uint32_t values[COMPACT_STEPS];
+    const trace_regs_t modes[] = {TRACE_REGS_RD, TRACE_REGS_ALL};
+
+    for (uint m = 0; m < 2; m++) {
+        rp2350_write_pc(target, 0, program_addr);
+        rp2350_write_reg(target, 0, 5, 0);
+        rp2350_write_reg(target, 0, 6, 0);
+
+        trace_compact_t trace = {
+            .records = records, .record_capacity = COMPACT_STEPS,
+            .values = values, .value_capacity = COMPACT_STEPS,
+            .regs = modes[m],
+        };
+
+        int result = rp2350_trace_compact(target, 0, 0, &trace);
+        printf("# Mode %u: %d records, %lu values, %lu register reads, fetch %lu hit / %lu miss\n",
+               m, result, (unsigned long)trace.value_count, (unsigned long)trace.reg_reads,
+               (unsigned long)trace.fetch_hits, (unsigned long)trace.fetch_misses);
+
+        if (result != COMPACT_STEPS) {
+            test_send_response(RESP_FAIL, "Compact trace count mismatch");
+            return false;
+        }
+
+        // Each loop word is fetched over SBA once
+        if (trace.fetch_misses != 3 || trace.fetch_hits != COMPACT_STEPS - 3) {
+            test_send_response(RESP_FAIL, "Instruction fetch cache not used");
+            return false;
+        }
+
+        // Two of every three steps change one register
+        if (trace.value_count != 20) {
+            test_send_response(RESP_FAIL, "Unexpected number of register deltas");
+            return false;
+        }
+
+        // Replaying the deltas gives the hart's registers at the last record
+        uint32_t regs[32];
+        memcpy(regs, trace.initial_regs, sizeof(regs));
+        for (uint32_t i = 0; i < trace.record_count; i++) {
+            if (records[i].pc != program_addr + (i % 3) * 4) {
+                test_send_response(RESP_FAIL, "Compact trace PC mismatch");
+                return false;
+            }
+            rp2350_trace_apply(&trace, i, regs);
+        }
+
+        swd_result_t x5 = rp2350_read_reg(target, 0, 5);
+        swd_result_t x6 = rp2350_read_reg(target, 0, 6);
+        if (regs[5] != 10 || regs[6] != 20 || x5.value != regs[5] || x6.value != regs[6]) {
+            printf("# Replay x5=%lu x6=%lu, hart x5=%lu x6=%lu\n",
+                   (unsigned long)regs[5], (unsigned long)regs[6],
+                   (unsigned long)x5.value, (unsigned long)x6.value);
+            test_send_response(RESP_FAIL, "Replayed registers disagree with the hart");
+            return false;
+        }
+    }
+
+    test_send_response(RESP_PASS, NULL);
+    return true;
+}
+
 //==============================================================================
 // Test Suite Definition
 //==============================================================================
@@ -559,6 +739,8 @@ test_case_t trace_tests[] = {
     { "TRACE 3: Early Termination via Callback", test_trace_early_stop, false, false },
     { "TRACE 4: Loop Detection", test_trace_loop_detection, false, false },
     { "TRACE 5: Trace Hart 1", test_trace_hart1, false, false },
+    { "TRACE 6: Streamed Trace", test_trace_stream, false, false },
+    { "TRACE 7: Compact Trace", test_trace_compact, false, false },
 };
 
 const uint32_t trace_test_count = sizeof(trace_tests) / sizeof(trace_tests[0]);
@@ -0,0 +1,154 @@
+/**
+ * @file async.h
+ * @brief Non-blocking block transfers with completion callbacks
+ *
+ * Submission calls queue a transfer and return at once. The transfer then
+ * advances whenever swd_poll() is called: each call moves a bounded number
+ * of words through the PIO FIFOs (or checks the DMA channels) and returns,
+ * so the caller can service USB in between. Completion callbacks run from
+ * swd_poll() or swd_wait(), in submission order.
+ *
+ * Transfers are split into SBA chunks of one batch each; at most one chunk
+ * per target is on the wire at a time.
+ *
+ * @section usage Basic Usage
+ * @code
+ * static void on_read(swd_target_t *target, swd_async_handle_t handle,
+ *                     swd_error_t result, void *ctx) {
+ *     usb_send_reply(ctx, result);
+ * }
+ *
+ * rp2350_read_mem_block_async(target, addr, buf, words, on_read, req, NULL);
+ * while (swd_poll(target) > 0) {
+ *     usb_receive_next();      // Overlaps with the SWD transfer
+ * }
+ * @endcode
+ *
+ * While any request is in flight, the target belongs to the async engine:
+ * make no blocking calls on it until swd_poll() returns 0.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PICO2_SWD_RISCV_ASYNC_H
+#define PICO2_SWD_RISCV_ASYNC_H
+
+#include "pico2-swd-riscv/types.h"
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Requests that may be in flight per target
+#define SWD_ASYNC_MAX_INFLIGHT 4
+
+/// Identifies one request; never 0 for a submitted request
+typedef uint32_t swd_async_handle_t;
+
+/**
+ * @brief Completion callback
+ *
+ * Runs from swd_poll() or swd_wait() on the calling core. It may submit
+ * new requests, but swd_disconnect() and swd_target_destroy() are refused
+ * there.
+ *
+ * @param target Target the request ran on
+ * @param handle Request that finished
+ * @param result SWD_OK, the transfer's error, or SWD_ERROR_CANCELLED
+ * @param ctx Context given at submission
+ */
+typedef void (*swd_async_cb_t)(swd_target_t *target, swd_async_handle_t handle,
+                               swd_error_t result, void *ctx);
+
+//==============================================================================
+// Submission
+//==============================================================================
+
+/**
+ * @brief Queue a block read (see rp2350_read_mem_block())
+ *
+ * buffer must stay valid until the callback has run.
+ *
+ * @param target Initialized target
+ * @param addr Start address (must be word-aligned)
+ * @param buffer Destination for count words
+ * @param count Number of 32-bit words
+ * @param cb Completion callback (may be NULL)
+ * @param ctx Passed to cb
+ * @param handle Where to store the request handle (may be NULL)
+ * @return SWD_OK if queued, SWD_ERROR_RESOURCE_BUSY if
+ *         SWD_ASYNC_MAX_INFLIGHT requests are in flight, error code otherwise
+ */
+swd_error_t rp2350_read_mem_block_async(swd_target_t *target, uint32_t addr,
+                                        uint32_t *buffer, uint32_t count,
+                                        swd_async_cb_t cb, void *ctx,
+                                        swd_async_handle_t *handle);
+
+/**
+ * @brief Queue a block write (see rp2350_write_mem_block())
+ *
+ * buffer must stay valid until the callback has run.
+ *
+ * @param target Initialized target
+ * @param addr Start address (must be word-aligned)
+ * @param buffer Source of count words
+ * @param count Number of 32-bit words
+ * @param cb Completion callback (may be NULL)
+ * @param ctx Passed to cb
+ * @param handle Where to store the request handle (may be NULL)
+ * @return SWD_OK if queued, SWD_ERROR_RESOURCE_BUSY if
+ *         SWD_ASYNC_MAX_INFLIGHT requests are in flight, error code otherwise
+ */
+swd_error_t rp2350_write_mem_block_async(swd_target_t *target, uint32_t addr,
+                                         const uint32_t *buffer, uint32_t count,
+                                         swd_async_cb_t cb, void *ctx,
+                                         swd_async_handle_t *handle);
+
+//==============================================================================
+// Progress and Completion
+//==============================================================================
+
+/**
+ * @brief Advance the target's requests without blocking
+ *
+ * Moves a bounded slice of the current chunk and, when it finishes,
+ * starts the next one. Runs callbacks of requests that completed.
+ *
+ * @param target Target to service
+ * @return Requests still in flight
+ */
+uint swd_poll(swd_target_t *target);
+
+/**
+ * @brief Block until one request completes
+ *
+ * Earlier requests complete first, with their callbacks.
+ *
+ * @param target Target the request was submitted on
+ * @param handle Request to wait for
+ * @return The request's result, or SWD_ERROR_INVALID_PARAM if it is not
+ *         in flight (for example, it already completed)
+ */
+swd_error_t swd_wait(swd_target_t *target, swd_async_handle_t handle);
+
+/**
+ * @brief Cancel a request
+ *
+ * A request that has not started completes with SWD_ERROR_CANCELLED on
+ * the next swd_poll(). One that is transferring stops after the chunk on
+ * the wire, so part of the block may already have been transferred.
+ *
+ * @param target Target the request was submitted on
+ * @param handle Request to cancel
+ * @return SWD_OK if it will be cancelled, SWD_ERROR_INVALID_PARAM if it
+ *         is not in flight
+ */
+swd_error_t swd_async_cancel(swd_target_t *target, swd_async_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO2_SWD_RISCV_ASYNC_H
@@ -22,7 +22,8 @@ extern "C" {
 // DP Register Definitions
 //==============================================================================
 
-#define DP_IDCODE     0x0   ///< Identification Code Register
+#define DP_IDCODE     0x0   ///< Identification Code Register (read)
+#define DP_ABORT      0x0   ///< Abort Register (write, same address as IDCODE)
 #define DP_CTRL_STAT  0x4   ///< Control/Status Register
 #define DP_SELECT     0x8   ///< AP Select Register
 #define DP_RDBUFF     0xC   ///< Read Buffer
@@ -36,6 +37,10 @@ extern "C" {
 #define AP_DRW  0x0C   ///< Data Read/Write Register
 #define AP_IDR  0xFC   ///< Identification Register
 
+// CSW values for the RISC-V APB-AP
+#define AP_CSW_DEFAULT         0xA2000002  ///< 32-bit access, no address increment
+#define AP_CSW_ADDRINC_SINGLE  (1u << 4)   ///< AddrInc: TAR advances after each DRW access
+
 //==============================================================================
 // RP2350 AP Selection
 //==============================================================================
@@ -164,6 +169,37 @@ swd_result_t dap_read_mem32(swd_target_t *target, uint32_t addr);
  */
 swd_error_t dap_write_mem32(swd_target_t *target, uint32_t addr, uint32_t value);
 
+/**
+ * @brief Read consecutive 32-bit words using MEM-AP auto-increment
+ *
+ * Sets CSW.AddrInc for the duration of the transfer, so each word costs a
+ * single pipelined DRW read. TAR is rewritten at every 1 KB boundary
+ * (the auto-increment wrap limit). CSW is restored afterwards.
+ *
+ * @param target Target to read from
+ * @param addr Start address (must be 4-byte aligned)
+ * @param buffer Destination for count words
+ * @param count Number of words
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t dap_read_mem_block(swd_target_t *target, uint32_t addr,
+                               uint32_t *buffer, uint32_t count);
+
+/**
+ * @brief Write consecutive 32-bit words using MEM-AP auto-increment
+ *
+ * Counterpart of dap_read_mem_block(). Returns once the last write has
+ * completed.
+ *
+ * @param target Target to write to
+ * @param addr Start address (must be 4-byte aligned)
+ * @param buffer Source of count words
+ * @param count Number of words
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t dap_write_mem_block(swd_target_t *target, uint32_t addr,
+                                const uint32_t *buffer, uint32_t count);
+
 //==============================================================================
 // Error Management
 //==============================================================================
@@ -178,6 +214,39 @@ swd_error_t dap_write_mem32(swd_target_t *target, uint32_t addr, uint32_t value)
  */
 swd_error_t dap_clear_errors(swd_target_t *target);
 
+/**
+ * @brief Confirm memory writes posted since the last check
+ *
+ * With swd_config_t.posted_writes set, dap_write_mem32() returns as soon as
+ * the DRW write is acknowledged. This reads DP_CTRL_STAT once; if STICKYERR
+ * or WDATAERR is set, the flags are cleared with dap_clear_errors() and the
+ * error detail names the range of unconfirmed writes.
+ *
+ * It runs on its own when a batch closes (including the ones behind SBA
+ * block transfers), at the end of rp2350_write_mem_block() when it falls
+ * back to single writes, and when a later access gets a FAULT, which the
+ * AP answers once a flag is set. rp2350_write_mem32(), the 8/16-bit
+ * writes and DM register writes return without confirming, so a run of
+ * them with no read after it should end with this call.
+ *
+ * @param target Target to check
+ * @return SWD_OK if nothing is pending or all writes completed,
+ *         SWD_ERROR_FAULT if one of them failed
+ */
+swd_error_t dap_sync_posted(swd_target_t *target);
+
+/**
+ * @brief Enable or disable posted-write mode
+ *
+ * Overrides swd_config_t.posted_writes. Disabling confirms any writes
+ * still pending first.
+ *
+ * @param target Target to configure
+ * @param enable true to post writes, false to confirm each one
+ * @return Result of confirming pending writes when disabling, else SWD_OK
+ */
+swd_error_t dap_set_posted_writes(swd_target_t *target, bool enable);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,126 @@
+/**
+ * @file dump.h
+ * @brief Streamed memory dumps through two fixed buffers
+ *
+ * rp2350_dump() reads a region of any size through two caller-supplied
+ * buffers and hands each filled buffer straight to a sink, for example a
+ * TinyUSB CDC write. While the sink sends one buffer, the next chunk is
+ * already being read into the other as an async request, so the SWD
+ * transfer and the USB transfer overlap and nothing is copied on the way.
+ *
+ * @section usage Basic Usage
+ * @code
+ * static swd_error_t to_cdc(const uint8_t *data, uint32_t len, void *ctx) {
+ *     while (len > 0) {
+ *         uint32_t n = tud_cdc_write(data, len);
+ *         tud_cdc_write_flush();
+ *         tud_task();
+ *         swd_poll(ctx);           // Keeps the next chunk moving
+ *         data += n;
+ *         len -= n;
+ *     }
+ *     return SWD_OK;
+ * }
+ *
+ * static uint32_t ping[1024], pong[1024];
+ * rp2350_dump(target, 0x20000000, 0x82000 / 4, ping, pong, 1024,
+ *             RP2350_DUMP_RLE, to_cdc, target, NULL);
+ * @endcode
+ *
+ * @section rle Run-Length Format
+ * With RP2350_DUMP_RLE the sink receives records instead of raw words.
+ * Each record starts with a header word (little-endian, like the data):
+ *
+ *   bits 31:30  RP2350_DUMP_LITERAL, RP2350_DUMP_ZEROS or RP2350_DUMP_ONES
+ *   bits 29:0   word count
+ *
+ * A literal header is followed by that many data words. Zero and one
+ * records stand for that many 0x00000000 or 0xFFFFFFFF words and carry
+ * no data. Records never span sink calls.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PICO2_SWD_RISCV_DUMP_H
+#define PICO2_SWD_RISCV_DUMP_H
+
+#include "pico2-swd-riscv/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// rp2350_dump() flags
+#define RP2350_DUMP_RLE (1u << 0)   ///< Collapse runs of erased words (see @ref rle)
+
+/// Record kinds in a RP2350_DUMP_RLE stream (header bits 31:30)
+#define RP2350_DUMP_LITERAL 0u
+#define RP2350_DUMP_ZEROS   1u
+#define RP2350_DUMP_ONES    2u
+
+#define RP2350_DUMP_KIND_SHIFT 30
+#define RP2350_DUMP_COUNT_MASK 0x3FFFFFFFu
+
+/// Shortest run of 0x00000000 or 0xFFFFFFFF words written as a run record
+#define RP2350_DUMP_MIN_RUN 4
+
+/**
+ * @brief Consumer for rp2350_dump()
+ *
+ * data points into one of the dump buffers and is only valid until the
+ * sink returns; the buffer is refilled right after. The next chunk is
+ * being read meanwhile, so the sink must not use the target except to
+ * call swd_poll(), which a sink that waits for the host should do.
+ *
+ * @param data Raw words, or records with RP2350_DUMP_RLE
+ * @param len Number of bytes in data (a multiple of 4)
+ * @param ctx Context pointer given to rp2350_dump()
+ * @return SWD_OK to continue, any error to stop the dump with it
+ */
+typedef swd_error_t (*rp2350_dump_sink_t)(const uint8_t *data, uint32_t len, void *ctx);
+
+/**
+ * @brief What rp2350_dump() moved
+ */
+typedef struct {
+    uint32_t bytes_read;        ///< Read from the target
+    uint32_t bytes_sent;        ///< Passed to the sink
+    uint32_t chunks;            ///< Sink calls
+} rp2350_dump_stats_t;
+
+//==============================================================================
+// Streamed Dump
+//==============================================================================
+
+/**
+ * @brief Read a region and stream it to a sink
+ *
+ * Each chunk is read with rp2350_read_mem_block_async() into the buffer
+ * the sink is not holding. With RP2350_DUMP_RLE a chunk is one word
+ * shorter than the buffers and is encoded in place, so the output always
+ * fits.
+ *
+ * @param target Initialized target
+ * @param addr Start address (must be word-aligned)
+ * @param count Number of 32-bit words to dump
+ * @param buf_a First buffer of buf_words words
+ * @param buf_b Second buffer of buf_words words
+ * @param buf_words Size of each buffer (at least 2 with RP2350_DUMP_RLE)
+ * @param flags 0 or RP2350_DUMP_RLE
+ * @param sink Called once per chunk, in address order
+ * @param ctx Passed to sink
+ * @param stats Where to store transfer counts (may be NULL)
+ * @return SWD_OK on success, the sink's error if it stopped the dump,
+ *         error code otherwise
+ */
+swd_error_t rp2350_dump(swd_target_t *target, uint32_t addr, uint32_t count,
+                        uint32_t *buf_a, uint32_t *buf_b, uint32_t buf_words,
+                        uint32_t flags, rp2350_dump_sink_t sink, void *ctx,
+                        rp2350_dump_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO2_SWD_RISCV_DUMP_H
@@ -0,0 +1,100 @@
+/**
+ * @file flash.h
+ * @brief Flash programming through a resident on-target algorithm
+ *
+ * A small routine is loaded into a work area in target SRAM and started
+ * on one hart. It calls the bootrom flash functions itself and takes
+ * commands from a two-slot mailbox, each slot with its own sector buffer:
+ * while the hart erases and programs the sector in one slot, the host
+ * streams the next sector into the other over SBA. The hart is never
+ * halted between sectors.
+ *
+ * Before writing anything, the routine CRCs every target sector and
+ * sectors that already hold the image are skipped. Each programmed sector
+ * is CRCed again and compared against the image.
+ *
+ * @section usage Basic Usage
+ * @code
+ * rp2350_flash_stats_t stats;
+ * rp2350_halt(target, 0);
+ * rp2350_halt(target, 1);           // Nothing may run from flash meanwhile
+ * rp2350_flash_program(target, 0, 0x20070000, 0, image, image_len,
+ *                      NULL, NULL, &stats);
+ * @endcode
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PICO2_SWD_RISCV_FLASH_H
+#define PICO2_SWD_RISCV_FLASH_H
+
+#include "pico2-swd-riscv/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Erase granularity; flash offsets must be aligned to it
+#define RP2350_FLASH_SECTOR_SIZE 4096
+
+/// SRAM the engine occupies at work_addr (code, mailbox, stack, 2 buffers)
+#define RP2350_FLASH_WORK_SIZE 0x2800
+
+/**
+ * @brief Progress callback
+ *
+ * Called each time a sector is found to match or has been programmed.
+ *
+ * @param done Sectors finished so far
+ * @param total Sectors in the image
+ * @param ctx Context given to rp2350_flash_program()
+ */
+typedef void (*rp2350_flash_progress_t)(uint32_t done, uint32_t total, void *ctx);
+
+/**
+ * @brief What rp2350_flash_program() did
+ */
+typedef struct {
+    uint32_t sectors_written;   ///< Erased and programmed
+    uint32_t sectors_skipped;   ///< Already matched the image
+} rp2350_flash_stats_t;
+
+//==============================================================================
+// Flash Programming
+//==============================================================================
+
+/**
+ * @brief Write an image to flash
+ *
+ * Programs len bytes at flash offset offset. The rest of the last sector
+ * reads back as 0xFF afterwards.
+ *
+ * The hart runs the engine and is left halted, with its registers, PC,
+ * mstatus and DCSR restored; the work area is overwritten. The other hart
+ * must not execute from flash while this runs.
+ *
+ * @param target Initialized target
+ * @param hart_id Hart to run the engine (must be halted)
+ * @param work_addr SRAM for the engine, RP2350_FLASH_WORK_SIZE bytes
+ *                  (16-byte aligned)
+ * @param offset Flash offset (must be sector-aligned)
+ * @param data Image to write
+ * @param len Image length in bytes
+ * @param progress Progress callback (may be NULL)
+ * @param ctx Passed to progress
+ * @param stats Where to store sector counts (may be NULL)
+ * @return SWD_OK on success, SWD_ERROR_VERIFY if a programmed sector does
+ *         not read back, SWD_ERROR_TIMEOUT if the engine stops responding,
+ *         error code otherwise
+ */
+swd_error_t rp2350_flash_program(swd_target_t *target, uint8_t hart_id, uint32_t work_addr,
+                                 uint32_t offset, const uint8_t *data, uint32_t len,
+                                 rp2350_flash_progress_t progress, void *ctx,
+                                 rp2350_flash_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO2_SWD_RISCV_FLASH_H
@@ -0,0 +1,127 @@
+/**
+ * @file gang.h
+ * @brief Lockstep operations on several targets (gang programming)
+ *
+ * Each call runs the same step on up to SWD_GANG_MAX_TARGETS targets.
+ * Bulk transfers feed every target's PIO state machine round-robin, so all
+ * SWD links clock at once and a gang takes about as long as one target.
+ *
+ * Results are per target and carried from step to step: a target whose
+ * entry is not SWD_OK is skipped, so a board that fails drops out of the
+ * rest of the sequence while the others carry on.
+ *
+ * @section usage Basic Usage
+ * @code
+ * swd_target_t *targets[4];              // Created on separate pins
+ * swd_error_t results[4] = {SWD_OK};
+ *
+ * swd_gang_connect(targets, 4, results);
+ * swd_gang_rp2350_init(targets, 4, results);
+ * swd_gang_upload(targets, 4, 0x20000000, code, words, results);
+ * swd_gang_verify(targets, 4, 0x20000000, code, words, results);
+ * swd_gang_execute(targets, 4, 0, 0x20000000, results);
+ * @endcode
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PICO2_SWD_RISCV_GANG_H
+#define PICO2_SWD_RISCV_GANG_H
+
+#include "pico2-swd-riscv/types.h"
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Most targets in one gang (all eight state machines of pio0 and pio1)
+#define SWD_GANG_MAX_TARGETS 8
+
+//==============================================================================
+// Gang Operations
+//==============================================================================
+
+/**
+ * @brief Connect every target
+ *
+ * The connection sequence is dominated by per-target line resets and
+ * power-up handshakes, so targets are connected one after another.
+ *
+ * @param targets Targets to connect
+ * @param count Number of targets (1 to SWD_GANG_MAX_TARGETS)
+ * @param results Per-target results (in/out, see file description)
+ * @return SWD_OK if every target succeeded, first failing result otherwise
+ */
+swd_error_t swd_gang_connect(swd_target_t *const *targets, uint count, swd_error_t *results);
+
+/**
+ * @brief Initialize the RP2350 Debug Module of every target
+ *
+ * Targets go through the activation handshake together, so the 150 ms of
+ * settling delays are paid once for the whole gang.
+ *
+ * @param targets Connected targets
+ * @param count Number of targets (1 to SWD_GANG_MAX_TARGETS)
+ * @param results Per-target results (in/out)
+ * @return SWD_OK if every target succeeded, first failing result otherwise
+ */
+swd_error_t swd_gang_rp2350_init(swd_target_t *const *targets, uint count,
+                                 swd_error_t *results);
+
+/**
+ * @brief Write the same image to every target
+ *
+ * Unlike rp2350_upload_code(), nothing is read back; call swd_gang_verify().
+ *
+ * @param targets Initialized targets
+ * @param count Number of targets (1 to SWD_GANG_MAX_TARGETS)
+ * @param addr Target address (must be word-aligned)
+ * @param code Image to write
+ * @param word_count Number of 32-bit words
+ * @param results Per-target results (in/out)
+ * @return SWD_OK if every target succeeded, first failing result otherwise
+ */
+swd_error_t swd_gang_upload(swd_target_t *const *targets, uint count, uint32_t addr,
+                            const uint32_t *code, uint32_t word_count, swd_error_t *results);
+
+/**
+ * @brief Read the image back from every target and compare
+ *
+ * A mismatch sets the target's result to SWD_ERROR_VERIFY; its error
+ * detail names the first differing word.
+ *
+ * @param targets Initialized targets
+ * @param count Number of targets (1 to SWD_GANG_MAX_TARGETS)
+ * @param addr Target address (must be word-aligned)
+ * @param code Expected image
+ * @param word_count Number of 32-bit words
+ * @param results Per-target results (in/out)
+ * @return SWD_OK if every target matched, first failing result otherwise
+ */
+swd_error_t swd_gang_verify(swd_target_t *const *targets, uint count, uint32_t addr,
+                            const uint32_t *code, uint32_t word_count, swd_error_t *results);
+
+/**
+ * @brief Start every target's hart at entry_point
+ *
+ * Halts the hart if needed, sets and checks the PC, then resumes. Each
+ * phase runs across the whole gang before the next, so the harts start
+ * within a few transactions of each other.
+ *
+ * @param targets Initialized targets
+ * @param count Number of targets (1 to SWD_GANG_MAX_TARGETS)
+ * @param hart_id Hart to start (0 or 1)
+ * @param entry_point Address to start at (code already uploaded)
+ * @param results Per-target results (in/out)
+ * @return SWD_OK if every target started, first failing result otherwise
+ */
+swd_error_t swd_gang_execute(swd_target_t *const *targets, uint count, uint8_t hart_id,
+                             uint32_t entry_point, swd_error_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO2_SWD_RISCV_GANG_H
@@ -0,0 +1,118 @@
+/**
+ * @file profile.h
+ * @brief Statistical PC sampling of running harts
+ *
+ * The sampler briefly halts a hart, reads its PC and resumes it, at a
+ * fixed rate, and counts the PCs in a histogram of address buckets held in
+ * host RAM. Each sample is two streamed batches (rp2350_sample_pc()), so
+ * the hart is stopped for a few dozen SWD transactions. With both harts
+ * selected, samples alternate between them.
+ *
+ * @section usage Basic Usage
+ * @code
+ * rp2350_profile_t prof;
+ * rp2350_profile_init(&prof, 0x10000000, 0x10010000, 16);  // 16-byte buckets
+ * rp2350_profile_run(target, &prof, RP2350_PROFILE_HART0, 1000, 5000);
+ * for (uint32_t i = 0; i < prof.bucket_count; i++) {
+ *     if (prof.buckets[i]) {
+ *         printf("%08lx %lu\n", prof.base + (i << prof.bucket_shift), prof.buckets[i]);
+ *     }
+ * }
+ * rp2350_profile_free(&prof);
+ * @endcode
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PICO2_SWD_RISCV_PROFILE_H
+#define PICO2_SWD_RISCV_PROFILE_H
+
+#include "pico2-swd-riscv/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Hart selection for rp2350_profile_run()
+#define RP2350_PROFILE_HART0 (1u << 0)
+#define RP2350_PROFILE_HART1 (1u << 1)
+#define RP2350_PROFILE_BOTH  (RP2350_PROFILE_HART0 | RP2350_PROFILE_HART1)
+
+/**
+ * @brief PC histogram and sampler counters
+ *
+ * Bucket i counts PCs in [base + (i << bucket_shift), base + ((i + 1) << bucket_shift)).
+ * Counts accumulate over rp2350_profile_run() calls.
+ */
+typedef struct {
+    uint32_t base;              ///< Address of the first bucket
+    uint32_t bucket_shift;      ///< log2 of the bytes per bucket
+    uint32_t bucket_count;      ///< Entries in buckets
+    uint32_t *buckets;          ///< Samples per bucket
+    uint32_t samples;           ///< PCs recorded, in range or not
+    uint32_t outside;           ///< PCs outside the bucket range
+    uint32_t hart_samples[2];   ///< Samples per hart
+    uint32_t missed;            ///< Sample times skipped because sampling fell behind
+    uint32_t max_window_us;     ///< Longest single sample (halt to resume)
+    uint64_t total_window_us;   ///< Time spent in samples, for the mean
+} rp2350_profile_t;
+
+//==============================================================================
+// PC Sampling
+//==============================================================================
+
+/**
+ * @brief Allocate an empty histogram for [start, end)
+ *
+ * @param profile Profile to set up
+ * @param start Lowest address counted
+ * @param end One past the highest address counted (greater than start)
+ * @param bucket_bytes Bytes per bucket (power of two, at least 2)
+ * @return SWD_OK on success, SWD_ERROR_NO_MEMORY if the buckets cannot be
+ *         allocated, SWD_ERROR_INVALID_PARAM otherwise
+ */
+swd_error_t rp2350_profile_init(rp2350_profile_t *profile, uint32_t start, uint32_t end,
+                                uint32_t bucket_bytes);
+
+/**
+ * @brief Release the histogram allocated by rp2350_profile_init()
+ *
+ * @param profile Profile to free
+ */
+void rp2350_profile_free(rp2350_profile_t *profile);
+
+/**
+ * @brief Zero the histogram and counters, keeping the range
+ *
+ * @param profile Profile to clear
+ */
+void rp2350_profile_reset(rp2350_profile_t *profile);
+
+/**
+ * @brief Sample running harts for a while
+ *
+ * Samples are spaced 1/rate_hz apart, shared between the selected harts.
+ * When a sample runs past the next slot, the late slots are skipped and
+ * counted in missed rather than taken back to back.
+ *
+ * A hart that halts on its own (breakpoint, or halted by other code)
+ * drops out of the run and stays halted. Harts already halted at the start
+ * are not sampled.
+ *
+ * @param target Initialized target
+ * @param profile Histogram from rp2350_profile_init()
+ * @param harts RP2350_PROFILE_HART0, RP2350_PROFILE_HART1 or RP2350_PROFILE_BOTH
+ * @param rate_hz Samples per second (0 = as fast as possible)
+ * @param duration_ms How long to sample
+ * @return SWD_OK on success, SWD_ERROR_ALREADY_HALTED if a selected hart
+ *         was or became halted (samples taken are kept), error code otherwise
+ */
+swd_error_t rp2350_profile_run(swd_target_t *target, rp2350_profile_t *profile,
+                               uint32_t harts, uint32_t rate_hz, uint32_t duration_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO2_SWD_RISCV_PROFILE_H
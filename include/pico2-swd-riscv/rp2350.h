@@ -90,6 +90,9 @@ swd_error_t rp2350_resume(swd_target_t *target, uint8_t hart_id);
  * @brief Single-step the RISC-V hart
  *
  * Executes one instruction and halts. Hart must be halted before calling.
+ * Triggers on the instruction are disarmed for the step and re-armed
+ * after it. If the step fails and leaves the hart not known halted, they
+ * are released instead and the error detail lists them.
  *
  * @param target Target to step
  * @param hart_id Hart ID (0 or 1 for RP2350)
@@ -118,6 +121,60 @@ swd_error_t rp2350_reset(swd_target_t *target, uint8_t hart_id, bool halt_on_res
  */
 bool rp2350_is_halted(const swd_target_t *target, uint8_t hart_id);
 
+/// Hart masks for rp2350_halt_harts() / rp2350_resume_harts()
+#define RP2350_HART0     (1u << 0)
+#define RP2350_HART1     (1u << 1)
+#define RP2350_HARTS_ALL (RP2350_HART0 | RP2350_HART1)
+
+/**
+ * @brief Halt several harts at the same instant
+ *
+ * Selects the harts through the hart array mask (DMCONTROL.hasel and
+ * HAWINDOW) and sends one haltreq, so they stop in the same cycle and
+ * shared memory is seen consistently. One DMSTATUS.allhalted poll covers
+ * the group. Harts already halted are left out. Falls back to halting the
+ * harts one after another if the DM does not implement hasel.
+ *
+ * @param target Target to halt
+ * @param mask RP2350_HART0, RP2350_HART1 or RP2350_HARTS_ALL
+ * @return SWD_OK once every hart in mask is halted, error code otherwise
+ */
+swd_error_t rp2350_halt_harts(swd_target_t *target, uint32_t mask);
+
+/**
+ * @brief Resume several harts at the same instant
+ *
+ * Counterpart of rp2350_halt_harts(): pending register writes reach each
+ * hart and breakpoints on the current PCs are stepped over first, then one
+ * resumereq starts the group and DMSTATUS.allresumeack confirms it. Harts
+ * already running are left out.
+ *
+ * @param target Target to resume
+ * @param mask RP2350_HART0, RP2350_HART1 or RP2350_HARTS_ALL
+ * @return SWD_OK once every hart in mask has resumed, error code otherwise
+ */
+swd_error_t rp2350_resume_harts(swd_target_t *target, uint32_t mask);
+
+/**
+ * @brief Read the PC of a running hart with the shortest possible halt
+ *
+ * Two streamed batches: the first requests the halt and fetches DPC
+ * (through s0, like a CSR read), the second puts s0 back and resumes.
+ * Nothing waits in between unless the halt is unusually slow. Used by the
+ * PC sampler (profile.h).
+ *
+ * If the hart turns out to have halted on its own (a breakpoint, say), its
+ * PC is still returned, it is left halted and SWD_ERROR_ALREADY_HALTED is
+ * returned.
+ *
+ * @param target Target to sample
+ * @param hart_id Hart ID (0 or 1 for RP2350; must be running)
+ * @param pc Where to store the PC
+ * @return SWD_OK on success, SWD_ERROR_ALREADY_HALTED if the hart was
+ *         halted, error code otherwise
+ */
+swd_error_t rp2350_sample_pc(swd_target_t *target, uint8_t hart_id, uint32_t *pc);
+
 //==============================================================================
 // Register Access
 //==============================================================================
@@ -180,6 +237,11 @@ swd_error_t rp2350_write_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_
  * Much faster than calling rp2350_read_reg() 32 times.
  * Hart must be halted.
  *
+ * Issues a single abstract command and lets abstractauto re-run it on each
+ * DATA0 read, streamed as one batch. Falls back to per-register commands
+ * if the Debug Module lacks autoexecdata or aarpostincrement. Fills the
+ * register cache when caching is enabled.
+ *
  * @param target Target to read from
  * @param hart_id Hart ID (0 or 1 for RP2350)
  * @param regs Array to store 32 register values (x0-x31)
@@ -187,11 +249,28 @@ swd_error_t rp2350_write_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_
  */
 swd_error_t rp2350_read_all_regs(swd_target_t *target, uint8_t hart_id, uint32_t regs[32]);
 
+/**
+ * @brief Write all general purpose registers at once
+ *
+ * Counterpart of rp2350_read_all_regs(). regs[0] is ignored (x0 is
+ * hardwired to zero). Hart must be halted.
+ *
+ * @param target Target to write to
+ * @param hart_id Hart ID (0 or 1 for RP2350)
+ * @param regs 32 register values (x0-x31)
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_write_all_regs(swd_target_t *target, uint8_t hart_id, const uint32_t regs[32]);
+
 /**
  * @brief Read Control and Status Register
  *
  * Reads a RISC-V CSR by address. Hart must be halted.
  *
+ * CSRs are accessed through s0 and the program buffer. s0 is saved on the
+ * first CSR access after a halt and written back before the hart resumes
+ * or steps; rp2350_read_reg() returns the saved value meanwhile.
+ *
  * @param target Target to read from
  * @param hart_id Hart ID (0 or 1 for RP2350)
  * @param csr_addr CSR address (e.g., 0x300 for mstatus)
@@ -199,10 +278,28 @@ swd_error_t rp2350_read_all_regs(swd_target_t *target, uint8_t hart_id, uint32_t
  */
 swd_result_t rp2350_read_csr(swd_target_t *target, uint8_t hart_id, uint16_t csr_addr);
 
+/**
+ * @brief Read several CSRs in one call
+ *
+ * Costs one abstract command per CSR plus one, instead of two per CSR
+ * with rp2350_read_csr(). Hart must be halted.
+ *
+ * @param target Target to read from
+ * @param hart_id Hart ID (0 or 1 for RP2350)
+ * @param csr_addrs CSR addresses to read
+ * @param values Where to store the values (same order as csr_addrs)
+ * @param count Number of CSRs
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_read_csrs(swd_target_t *target, uint8_t hart_id,
+                             const uint16_t *csr_addrs, uint32_t *values, uint32_t count);
+
 /**
  * @brief Write Control and Status Register
  *
- * Writes a RISC-V CSR by address. Hart must be halted.
+ * Writes a RISC-V CSR by address. Hart must be halted. With caching on,
+ * writes to dpc, dcsr, mstatus, mtvec, mepc and mcause are held back (see
+ * rp2350_enable_cache()).
  *
  * @param target Target to write to
  * @param hart_id Hart ID (0 or 1 for RP2350)
@@ -220,7 +317,7 @@ swd_error_t rp2350_write_csr(swd_target_t *target, uint8_t hart_id, uint16_t csr
  * @brief Invalidate register cache for a specific hart
  *
  * Forces next register read to fetch from target instead of cache.
- * Useful after target has been running.
+ * Pending register writes are written to the hart first.
  *
  * @param target Target to invalidate cache for
  * @param hart_id Hart ID (0 or 1 for RP2350)
@@ -233,11 +330,60 @@ void rp2350_invalidate_cache(swd_target_t *target, uint8_t hart_id);
  * When enabled, register values are cached to avoid redundant reads.
  * Cache is automatically invalidated when hart resumes.
  *
+ * The cache is write-back. Writes to GPRs and to the cached CSRs (dpc,
+ * dcsr, mstatus, mtvec, mepc, mcause) only update the cache, and reads of
+ * them return the value written. Pending writes go to the hart together
+ * just before it resumes, steps, traces or runs the program buffer, and on
+ * rp2350_invalidate_cache(), swd_disconnect() or when caching is turned
+ * off. An error in one of those writes is returned by the call that
+ * flushes it. rp2350_reset() drops pending writes.
+ *
  * @param target Target to configure
  * @param enable true to enable caching, false to disable
  */
 void rp2350_enable_cache(swd_target_t *target, bool enable);
 
+/**
+ * @brief Enable or disable the host-side memory cache
+ *
+ * While every hart is halted, rp2350_read/write_mem8/16/32() go through
+ * 8 lines of 64 bytes. Lines are filled with one SBA block read, and
+ * writes stay in the line until it is written back, so byte and halfword
+ * writes to one line cost a single block write. Dirty lines are written
+ * back before any hart resumes, steps or resets, and the cache is then
+ * emptied.
+ *
+ * Only boot ROM, XIP flash and SRAM are cached; peripheral registers and
+ * all other addresses always go to the target. ROM and flash lines are
+ * read-only: writes there pass through and drop the line.
+ *
+ * Disabled by default. Disabling writes back dirty lines first.
+ *
+ * @param target Target to configure
+ * @param enable true to enable the memory cache, false to disable
+ * @return SWD_OK on success, error code if dirty lines could not be written
+ */
+swd_error_t rp2350_enable_mem_cache(swd_target_t *target, bool enable);
+
+/**
+ * @brief Write back dirty memory cache lines
+ *
+ * Lines stay cached. Needed only before the target's memory is changed by
+ * something other than this library while the harts are halted (for
+ * example DMA or another debugger).
+ *
+ * @param target Target to flush
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_flush_mem_cache(swd_target_t *target);
+
+/**
+ * @brief Discard the memory cache, including writes not yet written back
+ *
+ * @param target Target to invalidate
+ */
+void rp2350_invalidate_mem_cache(swd_target_t *target);
+
 //==============================================================================
 // Memory Access
 //==============================================================================
@@ -270,8 +416,9 @@ swd_error_t rp2350_write_mem32(swd_target_t *target, uint32_t addr, uint32_t val
 /**
  * @brief Read 16-bit halfword from memory
  *
- * Address must be 2-byte aligned. Implemented using read-modify-write
- * on aligned 32-bit word.
+ * Address must be 2-byte aligned. Uses a 16-bit SBA access when the DM
+ * supports one (sbaccess16), so neighbouring bytes are not read; otherwise
+ * the aligned 32-bit word is read.
  *
  * @param target Target to read from
  * @param addr Memory address (must be 2-byte aligned)
@@ -282,8 +429,9 @@ swd_result_t rp2350_read_mem16(swd_target_t *target, uint32_t addr);
 /**
  * @brief Write 16-bit halfword to memory
  *
- * Address must be 2-byte aligned. Implemented using read-modify-write
- * on aligned 32-bit word.
+ * Address must be 2-byte aligned. Uses a 16-bit SBA access when the DM
+ * supports one (sbaccess16); otherwise falls back to read-modify-write
+ * of the aligned 32-bit word.
  *
  * @param target Target to write to
  * @param addr Memory address (must be 2-byte aligned)
@@ -295,7 +443,8 @@ swd_error_t rp2350_write_mem16(swd_target_t *target, uint32_t addr, uint16_t val
 /**
  * @brief Read 8-bit byte from memory
  *
- * Implemented using read-modify-write on aligned 32-bit word.
+ * Uses an 8-bit SBA access when the DM supports one (sbaccess8);
+ * otherwise the aligned 32-bit word is read.
  *
  * @param target Target to read from
  * @param addr Memory address
@@ -306,7 +455,8 @@ swd_result_t rp2350_read_mem8(swd_target_t *target, uint32_t addr);
 /**
  * @brief Write 8-bit byte to memory
  *
- * Implemented using read-modify-write on aligned 32-bit word.
+ * Uses an 8-bit SBA access when the DM supports one (sbaccess8);
+ * otherwise falls back to read-modify-write of the aligned 32-bit word.
  *
  * @param target Target to write to
  * @param addr Memory address
@@ -343,6 +493,36 @@ swd_error_t rp2350_read_mem_block(swd_target_t *target, uint32_t addr,
 swd_error_t rp2350_write_mem_block(swd_target_t *target, uint32_t addr,
                                     const uint32_t *buffer, uint32_t count);
 
+/**
+ * @brief Read any number of bytes from any address
+ *
+ * Split into an unaligned head and tail of 8/16-bit accesses and a
+ * word-aligned body read as a block. buffer needs no alignment.
+ *
+ * @param target Target to read from
+ * @param addr Starting address
+ * @param buffer Buffer to store len bytes
+ * @param len Number of bytes to read
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_read_bytes(swd_target_t *target, uint32_t addr,
+                              uint8_t *buffer, uint32_t len);
+
+/**
+ * @brief Write any number of bytes to any address
+ *
+ * Split like rp2350_read_bytes(). With sbaccess8/16 no byte outside
+ * [addr, addr + len) is read or written.
+ *
+ * @param target Target to write to
+ * @param addr Starting address
+ * @param buffer Data to write
+ * @param len Number of bytes to write
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_write_bytes(swd_target_t *target, uint32_t addr,
+                               const uint8_t *buffer, uint32_t len);
+
 //==============================================================================
 // Program Buffer Execution
 //==============================================================================
@@ -386,11 +566,20 @@ swd_error_t rp2350_execute_progbuf(swd_target_t *target, uint8_t hart_id,
 // Code Execution
 //==============================================================================
 
+/**
+ * @brief How an upload is checked
+ */
+typedef enum {
+    RP2350_VERIFY_NONE = 0,   ///< Rely on the SBA status of the block write
+    RP2350_VERIFY_READBACK,   ///< Read the whole image back in one block pass
+    RP2350_VERIFY_CRC,        ///< CRC-32 computed by the halted hart; 4 bytes come back
+} rp2350_verify_t;
+
 /**
  * @brief Upload code to target memory
  *
- * Uploads RISC-V machine code to target memory using SBA.
- * Verifies each word after writing. Hart can remain running.
+ * Uploads RISC-V machine code to target memory using SBA, then reads it
+ * back to verify it (RP2350_VERIFY_READBACK). Hart can remain running.
  *
  * @param target Target to upload to
  * @param addr Destination address (must be 4-byte aligned)
@@ -401,6 +590,26 @@ swd_error_t rp2350_execute_progbuf(swd_target_t *target, uint8_t hart_id,
 swd_error_t rp2350_upload_code(swd_target_t *target, uint32_t addr,
                                 const uint32_t *code, uint32_t word_count);
 
+/**
+ * @brief Upload an image with a chosen verification
+ *
+ * The image is written with SBA block transfers and then checked in one
+ * pass. RP2350_VERIFY_CRC runs a 19-word CRC-32 routine on the hart, which
+ * must be halted; the routine and its return trap occupy the 80 bytes
+ * after the image, whose contents are saved and restored.
+ *
+ * @param target Target to upload to
+ * @param hart_id Hart that runs the CRC routine (unused by other modes)
+ * @param addr Destination address (must be 4-byte aligned)
+ * @param code Array of 32-bit words
+ * @param word_count Number of words to upload
+ * @param verify Verification mode
+ * @return SWD_OK on success, SWD_ERROR_VERIFY on mismatch, error code otherwise
+ */
+swd_error_t rp2350_upload_image(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                                const uint32_t *code, uint32_t word_count,
+                                rp2350_verify_t verify);
+
 /**
  * @brief Upload and execute code
  *
@@ -420,12 +629,197 @@ swd_error_t rp2350_upload_code(swd_target_t *target, uint32_t addr,
 swd_error_t rp2350_execute_code(swd_target_t *target, uint8_t hart_id, uint32_t entry_point,
                                  const uint32_t *code, uint32_t word_count);
 
+/**
+ * @brief Upload and execute code with a chosen verification
+ *
+ * As rp2350_execute_code(), but the hart is halted before the upload so
+ * that RP2350_VERIFY_CRC can use it.
+ *
+ * @param target Target to execute on
+ * @param hart_id Hart ID (0 or 1 for RP2350)
+ * @param entry_point Address to start execution (must be 4-byte aligned)
+ * @param code Array of 32-bit instruction words
+ * @param word_count Number of words in code
+ * @param verify Verification mode
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_execute_image(swd_target_t *target, uint8_t hart_id, uint32_t entry_point,
+                                 const uint32_t *code, uint32_t word_count,
+                                 rp2350_verify_t verify);
+
+/// Page size compared by rp2350_sync_image() (1 KB)
+#define RP2350_SYNC_PAGE_WORDS 256
+
+/**
+ * @brief Upload only the pages of an image that differ from target memory
+ *
+ * A 19-word routine on the hart hashes the target's copy in pages of
+ * RP2350_SYNC_PAGE_WORDS (the last page may be shorter), 64 pages per
+ * call, and the host compares each hash with its own hash of the image.
+ * Runs of differing pages are written through the block path, and the
+ * batch is hashed again to confirm them. The hart must be halted; the
+ * routine, its return trap and the hashes occupy up to 336 bytes after
+ * the image, whose contents are saved and restored.
+ *
+ * @param target Target to upload to
+ * @param hart_id Hart that runs the hash routine (must be halted)
+ * @param addr Destination address (must be 4-byte aligned)
+ * @param image Array of 32-bit words
+ * @param word_count Number of words in image
+ * @return Result containing the number of pages uploaded, SWD_ERROR_VERIFY
+ *         if a page still differs afterwards, or another error code
+ */
+swd_result_t rp2350_sync_image(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                               const uint32_t *image, uint32_t word_count);
+
 //==============================================================================
-// Instruction Tracing
+// Target Function Calls
+//==============================================================================
+
+/**
+ * @brief Call a function on a halted hart and wait for it to return
+ *
+ * Arguments go in a0-a7 and ra points at an ebreak written to trap_addr,
+ * so the function's return drops the hart back into debug mode. Interrupts
+ * are masked (mstatus.MIE) during the call. Afterwards the GPRs, PC,
+ * mstatus, DCSR and the word at trap_addr are restored, and the hart is
+ * left halted.
+ *
+ * The function runs on the hart's current stack.
+ *
+ * @param target Target to call on
+ * @param hart_id Hart to run the function (must be halted)
+ * @param func Function address
+ * @param args Argument values (may be NULL if nargs is 0)
+ * @param nargs Number of arguments (at most 8)
+ * @param trap_addr Word-aligned RAM address for the return trap
+ * @param timeout_ms How long the function may run
+ * @return Result containing the function's a0, or error (SWD_ERROR_TIMEOUT
+ *         if it did not return; the hart is halted again)
+ */
+swd_result_t rp2350_call(swd_target_t *target, uint8_t hart_id, uint32_t func,
+                         const uint32_t *args, uint8_t nargs, uint32_t trap_addr,
+                         uint32_t timeout_ms);
+
+//==============================================================================
+// Triggers
 //==============================================================================
 
-// Note: Hardware breakpoint support has been removed and will be
-// reimplemented in a future version with proper per-hart support.
+/**
+ * @brief Accesses matched by rp2350_set_watchpoint()
+ */
+typedef enum {
+    RP2350_WATCH_LOAD = 1,      ///< Loads from the address
+    RP2350_WATCH_STORE = 2,     ///< Stores to the address
+    RP2350_WATCH_ACCESS = 3,    ///< Either
+} rp2350_watch_t;
+
+/**
+ * @brief Number of hardware triggers on a hart
+ *
+ * Probed through tselect on first use and remembered until rp2350_init().
+ *
+ * @param target Target to query
+ * @param hart_id Hart ID (must be halted)
+ * @return Result containing the trigger count (0 if the hart has none)
+ */
+swd_result_t rp2350_trigger_count(swd_target_t *target, uint8_t hart_id);
+
+/**
+ * @brief Halt the hart when it is about to execute addr
+ *
+ * Takes a free trigger (mcontrol, execute, exact match) and arms it. The
+ * trigger is marked dmode = 1, so firmware cannot change it.
+ * rp2350_step() and rp2350_resume() step over a breakpoint on the current
+ * PC instead of stopping on it again.
+ *
+ * @param target Target to modify
+ * @param hart_id Hart ID (must be halted)
+ * @param addr Instruction address (2-byte aligned)
+ * @return Result containing the trigger index, SWD_ERROR_RESOURCE_BUSY if
+ *         every trigger is in use, or another error code
+ */
+swd_result_t rp2350_set_breakpoint(swd_target_t *target, uint8_t hart_id, uint32_t addr);
+
+/**
+ * @brief Halt the hart before a load or store to addr
+ *
+ * Matches accesses whose address equals addr exactly. The hart stops on
+ * the access instruction, before it runs. Not every trigger module can
+ * match data accesses (Hazard3 triggers are execute-only); the readback
+ * of tdata1 decides.
+ *
+ * @param target Target to modify
+ * @param hart_id Hart ID (must be halted)
+ * @param addr Data address
+ * @param kind Accesses to match
+ * @return Result containing the trigger index, SWD_ERROR_INVALID_CONFIG if
+ *         the trigger cannot match loads/stores, SWD_ERROR_RESOURCE_BUSY if
+ *         every trigger is in use, or another error code
+ */
+swd_result_t rp2350_set_watchpoint(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                                   rp2350_watch_t kind);
+
+/**
+ * @brief Disarm and release one trigger
+ *
+ * @param target Target to modify
+ * @param hart_id Hart ID (must be halted)
+ * @param index Index from rp2350_set_breakpoint() or rp2350_set_watchpoint()
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_clear_trigger(swd_target_t *target, uint8_t hart_id, uint32_t index);
+
+/**
+ * @brief Disarm every trigger on a hart
+ *
+ * Also clears triggers armed before the last rp2350_init(), which this
+ * library no longer tracks.
+ *
+ * @param target Target to modify
+ * @param hart_id Hart ID (must be halted)
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_clear_triggers(swd_target_t *target, uint8_t hart_id);
+
+/**
+ * @brief Wait for a running hart to halt on its own
+ *
+ * For a hart resumed with breakpoints or watchpoints armed. Reads
+ * DMSTATUS until the hart reports halted; the hart keeps running if it
+ * does not.
+ *
+ * @param target Target to poll
+ * @param hart_id Hart ID
+ * @param timeout_ms How long to wait
+ * @return SWD_OK once halted, SWD_ERROR_TIMEOUT, or another error code
+ */
+swd_error_t rp2350_wait_halt(swd_target_t *target, uint8_t hart_id, uint32_t timeout_ms);
+
+/**
+ * @brief Run a halted hart until it reaches addr
+ *
+ * Arms a temporary breakpoint, resumes the hart at full speed, and waits
+ * for it to halt. Returns at once if the PC is already addr. On timeout
+ * the hart is halted wherever it is. The temporary breakpoint is released
+ * in every case; other triggers stay armed. If an error leaves the hart
+ * running and it cannot be halted, the slot is freed but the breakpoint
+ * stays armed on the hart until rp2350_clear_triggers().
+ *
+ * @param target Target to run
+ * @param hart_id Hart ID (must be halted)
+ * @param addr Instruction address to stop at
+ * @param timeout_ms How long the hart may run
+ * @return SWD_OK when halted at addr, SWD_ERROR_ALREADY_HALTED if the hart
+ *         stopped elsewhere first (another trigger or ebreak),
+ *         SWD_ERROR_TIMEOUT, or another error code
+ */
+swd_error_t rp2350_run_until(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                             uint32_t timeout_ms);
+
+//==============================================================================
+// Instruction Tracing
+//==============================================================================
 
 /**
  * @brief Trace record for single instruction
@@ -456,7 +850,8 @@ typedef bool (*trace_callback_t)(const trace_record_t *record, void *user_data);
  * Uses DCSR.step mechanism for precise instruction-level control.
  *
  * Performance: ~15-20ms per instruction without register capture,
- * ~80ms per instruction with full register capture.
+ * ~80ms per instruction with full register capture. For long traces
+ * use rp2350_trace_stream().
  *
  * @param target Target to trace
  * @param hart_id Hart ID (0 or 1 for RP2350)
@@ -470,6 +865,142 @@ int rp2350_trace(swd_target_t *target, uint8_t hart_id, uint32_t max_instruction
                  trace_callback_t callback, void *user_data,
                  bool capture_regs);
 
+/**
+ * @brief Compact trace entry produced by rp2350_trace_stream()
+ */
+typedef struct {
+    uint32_t pc;          // Program counter
+    uint32_t instruction; // Instruction word at PC
+} trace_entry_t;
+
+/**
+ * @brief Caller-owned ring buffer of trace entries
+ *
+ * head and tail count entries since the ring was set up; the slot for an
+ * entry is its count modulo capacity. With overwrite false the trace only
+ * advances head, so another core may pop entries while it runs. With
+ * overwrite true the trace also advances tail to drop the oldest entry,
+ * so the ring must not be popped until rp2350_trace_stream() returns.
+ */
+typedef struct {
+    trace_entry_t *entries;  // Storage for capacity entries
+    uint32_t capacity;
+    volatile uint32_t head;  // Entries produced
+    volatile uint32_t tail;  // Entries consumed
+    bool overwrite;          // When full: true drops the oldest entry, false stops the trace
+    uint32_t dropped;        // Entries lost to overwrite
+} trace_ring_t;
+
+/**
+ * @brief High-rate trace into a ring buffer
+ *
+ * Same records as rp2350_trace() without register capture, but built for
+ * speed: DCSR.step is set once for the whole trace, each step (s0 restore,
+ * resume, halt check, DPC fetch) is one streamed batch, and halt polling
+ * never sleeps. Breakpoints and watchpoints are disarmed for the whole
+ * trace, so the trace runs through them. DCSR and the triggers are
+ * restored and the hart left halted afterwards.
+ *
+ * @param target Target to trace
+ * @param hart_id Hart ID (0 or 1 for RP2350)
+ * @param max_instructions Maximum instructions to trace (0 = until the ring fills)
+ * @param ring Ring buffer to fill (entries and capacity must be set)
+ * @return Number of instructions traced (>=0), or negative error code on failure
+ */
+int rp2350_trace_stream(swd_target_t *target, uint8_t hart_id, uint32_t max_instructions,
+                        trace_ring_t *ring);
+
+/**
+ * @brief Take the oldest entry out of a trace ring
+ *
+ * @param ring Ring filled by rp2350_trace_stream()
+ * @param entry Where to store the entry
+ * @return true if an entry was returned, false if the ring is empty
+ */
+bool rp2350_trace_ring_pop(trace_ring_t *ring, trace_entry_t *entry);
+
+/**
+ * @brief Register capture for rp2350_trace_compact()
+ */
+typedef enum {
+    TRACE_REGS_NONE = 0,  // PC and instruction only
+    TRACE_REGS_ALL,       // Read x1-x31 after every step, keep what changed
+    TRACE_REGS_RD,        // Read only the registers the stepped instruction can write
+} trace_regs_t;
+
+/**
+ * @brief One step of a compact trace
+ *
+ * Registers are as they were before the instruction at pc ran. Only the
+ * ones that differ from the previous record are stored: bit n of changed
+ * means xn's new value is in the trace's values[], in register order,
+ * starting at value_index. The first record has changed == 0; its
+ * registers are initial_regs.
+ */
+typedef struct {
+    uint32_t pc;          // Program counter
+    uint32_t instruction; // Instruction word at PC
+    uint32_t changed;     // Registers changed since the previous record
+    uint32_t value_index; // First of popcount(changed) entries in values[]
+} trace_delta_t;
+
+/**
+ * @brief Caller-owned storage and counters for rp2350_trace_compact()
+ *
+ * Set records, record_capacity, values, value_capacity and regs; the
+ * trace fills in the rest.
+ */
+typedef struct {
+    trace_delta_t *records;     // Storage for record_capacity records
+    uint32_t record_capacity;
+    uint32_t record_count;      // Records produced
+    uint32_t *values;           // Storage for changed register values
+    uint32_t value_capacity;
+    uint32_t value_count;       // Values produced
+    trace_regs_t regs;          // What to capture
+    uint32_t initial_regs[32];  // x0-x31 at the first record (regs != TRACE_REGS_NONE)
+    uint32_t fetch_hits;        // Instruction words served by the host fetch cache
+    uint32_t fetch_misses;      // Instruction words read over SBA
+    uint32_t reg_reads;         // Registers read from the hart
+} trace_compact_t;
+
+/**
+ * @brief Trace into delta-encoded records
+ *
+ * Steps like rp2350_trace_stream() (DCSR.step held, one batch per step,
+ * triggers disarmed until the trace ends).
+ * Instruction words come from a host-side cache keyed by address, so a
+ * loop body is read over SBA once; code must not change during the
+ * trace. With TRACE_REGS_RD, the registers read after each step are the
+ * ones its instruction can write (rd, x1 for compressed jumps, nothing
+ * for stores and branches; all of them for instructions not decoded,
+ * such as Zcmp push/pop). With dcsr.stepie clear (its reset value)
+ * interrupts stay masked while stepping, so nothing else writes them.
+ *
+ * A compressed instruction at a halfword boundary reads back with only
+ * its low 16 bits set.
+ *
+ * @param target Target to trace
+ * @param hart_id Hart ID (0 or 1 for RP2350)
+ * @param max_instructions Maximum instructions to trace (0 = until storage fills)
+ * @param trace Storage and settings
+ * @return Number of instructions traced (>=0), or negative error code on failure
+ */
+int rp2350_trace_compact(swd_target_t *target, uint8_t hart_id, uint32_t max_instructions,
+                         trace_compact_t *trace);
+
+/**
+ * @brief Apply one compact record to a register file
+ *
+ * Start from initial_regs and apply records 0, 1, 2, ... in order to get
+ * the registers at each step.
+ *
+ * @param trace Trace filled by rp2350_trace_compact()
+ * @param index Record to apply
+ * @param regs Register file to update
+ */
+void rp2350_trace_apply(const trace_compact_t *trace, uint32_t index, uint32_t regs[32]);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,208 @@
+/**
+ * @file rtt.h
+ * @brief SEGGER-RTT compatible ring buffers over SBA
+ *
+ * Firmware that links SEGGER RTT (or anything laying out the same control
+ * block) keeps "up" rings (target to host) and "down" rings (host to
+ * target) in its own RAM. System bus access reads and writes them while
+ * the harts keep running, so logs and telemetry stream out without a UART
+ * and without halting the CPU.
+ *
+ * Each poll reads the up descriptors in one block, then only the bytes
+ * between RdOff and WrOff of each ring (two block reads when the data
+ * wraps), and writes RdOff back.
+ *
+ * @section usage Basic Usage
+ * @code
+ * rp2350_rtt_t rtt;
+ * rp2350_rtt_find(target, &rtt, 0x20000000, 0x82000);
+ * rp2350_rtt_set_mode(target, &rtt, 0, RP2350_RTT_MODE_BLOCK);
+ *
+ * uint8_t buf[2048];
+ * uint32_t got;
+ * while (rp2350_rtt_read(target, &rtt, 0, buf, sizeof(buf), &got) == SWD_OK) {
+ *     fwrite(buf, 1, got, stdout);
+ * }
+ * @endcode
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PICO2_SWD_RISCV_RTT_H
+#define PICO2_SWD_RISCV_RTT_H
+
+#include "pico2-swd-riscv/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Channels tracked per direction; the target may declare more
+#define RP2350_RTT_MAX_CHANNELS 4
+
+/// Longest channel name kept, including the terminator
+#define RP2350_RTT_NAME_LEN 16
+
+/// Up-channel modes (low bits of the descriptor flags), applied by the target
+#define RP2350_RTT_MODE_SKIP  0u   ///< Drop a write that does not fit
+#define RP2350_RTT_MODE_TRIM  1u   ///< Write what fits, drop the rest
+#define RP2350_RTT_MODE_BLOCK 2u   ///< Wait for the host to make room
+#define RP2350_RTT_MODE_MASK  3u
+
+/**
+ * @brief One ring as last read from its descriptor
+ */
+typedef struct {
+    uint32_t desc_addr;                 ///< Target address of the descriptor
+    uint32_t buffer;                    ///< Ring address (pBuffer)
+    uint32_t size;                      ///< Ring size in bytes (0 = not configured)
+    uint32_t flags;                     ///< Mode flags
+    char name[RP2350_RTT_NAME_LEN];     ///< Channel name, "" if none
+} rp2350_rtt_channel_t;
+
+/**
+ * @brief Control block location, channels and transfer counters
+ */
+typedef struct {
+    uint32_t cb_addr;           ///< Target address of the control block
+    uint32_t max_up;            ///< Up channels declared by the target
+    uint32_t max_down;          ///< Down channels declared by the target
+    uint32_t num_up;            ///< Up channels tracked (at most RP2350_RTT_MAX_CHANNELS)
+    uint32_t num_down;          ///< Down channels tracked
+    rp2350_rtt_channel_t up[RP2350_RTT_MAX_CHANNELS];
+    rp2350_rtt_channel_t down[RP2350_RTT_MAX_CHANNELS];
+    uint64_t bytes_up;          ///< Bytes consumed from up channels
+    uint64_t bytes_down;        ///< Bytes written to down channels
+    uint32_t up_full;           ///< Reads that found an up ring full
+    uint32_t down_full;         ///< Writes cut short by a full down ring
+} rp2350_rtt_t;
+
+/**
+ * @brief Consumer for rp2350_rtt_poll()
+ *
+ * @param channel Up channel index
+ * @param data Bytes read from the ring
+ * @param len Number of bytes in data
+ * @param ctx Context pointer given to rp2350_rtt_poll()
+ * @return Bytes consumed (at most len); the rest stay in the ring
+ */
+typedef uint32_t (*rp2350_rtt_handler_t)(uint32_t channel, const uint8_t *data,
+                                         uint32_t len, void *ctx);
+
+//==============================================================================
+// Control Block
+//==============================================================================
+
+/**
+ * @brief Scan target RAM for the control block
+ *
+ * Looks for the "SEGGER RTT" ID at word-aligned addresses in
+ * [start, start + len), checks the channel counts that follow it and
+ * reads the channel descriptors and names.
+ *
+ * @param target Initialized target
+ * @param rtt Filled in on success
+ * @param start First address to search (4-byte aligned)
+ * @param len Bytes to search
+ * @return SWD_OK on success, SWD_ERROR_VERIFY if no valid control block
+ *         was found, error code otherwise
+ */
+swd_error_t rp2350_rtt_find(swd_target_t *target, rp2350_rtt_t *rtt,
+                            uint32_t start, uint32_t len);
+
+/**
+ * @brief Re-read all channel descriptors
+ *
+ * Picks up channels the firmware configured after the control block was
+ * found. Names are not re-read.
+ *
+ * @param target Initialized target
+ * @param rtt Control block from rp2350_rtt_find()
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_rtt_refresh(swd_target_t *target, rp2350_rtt_t *rtt);
+
+/**
+ * @brief Set the target-side mode of an up channel
+ *
+ * RP2350_RTT_MODE_BLOCK makes the firmware wait for the host when the
+ * ring is full, so nothing is lost at the cost of stalling the writer.
+ *
+ * @param target Initialized target
+ * @param rtt Control block from rp2350_rtt_find()
+ * @param channel Up channel index
+ * @param mode RP2350_RTT_MODE_SKIP, RP2350_RTT_MODE_TRIM or RP2350_RTT_MODE_BLOCK
+ * @return SWD_OK on success, error code otherwise
+ */
+swd_error_t rp2350_rtt_set_mode(swd_target_t *target, rp2350_rtt_t *rtt,
+                                uint32_t channel, uint32_t mode);
+
+//==============================================================================
+// Transfers
+//==============================================================================
+
+/**
+ * @brief Read pending bytes from one up channel
+ *
+ * Reads at most len bytes and advances the ring's RdOff past them. *got
+ * is 0 when the ring is empty.
+ *
+ * @param target Initialized target
+ * @param rtt Control block from rp2350_rtt_find()
+ * @param channel Up channel index
+ * @param buffer Destination
+ * @param len Size of buffer
+ * @param got Filled with the number of bytes read
+ * @return SWD_OK on success, SWD_ERROR_INVALID_STATE if the ring offsets
+ *         are out of range, error code otherwise
+ */
+swd_error_t rp2350_rtt_read(swd_target_t *target, rp2350_rtt_t *rtt, uint32_t channel,
+                            uint8_t *buffer, uint32_t len, uint32_t *got);
+
+/**
+ * @brief Drain every up channel through a handler
+ *
+ * Reads all up descriptors in one block, then for each ring holding data
+ * reads up to len bytes into buffer and passes them to handler. RdOff
+ * moves only past the bytes the handler consumed, so a consumer that
+ * falls behind leaves data in the ring and the target's mode decides what
+ * happens when it fills.
+ *
+ * @param target Initialized target
+ * @param rtt Control block from rp2350_rtt_find()
+ * @param buffer Scratch buffer for one ring's data
+ * @param len Size of buffer
+ * @param handler Called once per channel with data
+ * @param ctx Passed to handler
+ * @return SWD_OK on success, SWD_ERROR_INVALID_STATE if a ring's offsets
+ *         are out of range, error code otherwise
+ */
+swd_error_t rp2350_rtt_poll(swd_target_t *target, rp2350_rtt_t *rtt,
+                            uint8_t *buffer, uint32_t len,
+                            rp2350_rtt_handler_t handler, void *ctx);
+
+/**
+ * @brief Write bytes to a down channel
+ *
+ * Writes as much as fits in the free space of the ring and then publishes
+ * it by advancing WrOff. *written less than len means the ring is full;
+ * retry the rest once the firmware has read some.
+ *
+ * @param target Initialized target
+ * @param rtt Control block from rp2350_rtt_find()
+ * @param channel Down channel index
+ * @param data Bytes to send
+ * @param len Number of bytes in data
+ * @param written Filled with the number of bytes accepted
+ * @return SWD_OK on success, SWD_ERROR_INVALID_STATE if the ring offsets
+ *         are out of range, error code otherwise
+ */
+swd_error_t rp2350_rtt_write(swd_target_t *target, rp2350_rtt_t *rtt, uint32_t channel,
+                             const uint8_t *data, uint32_t len, uint32_t *written);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO2_SWD_RISCV_RTT_H
@@ -44,6 +44,12 @@ typedef struct {
     uint freq_khz;        ///< SWCLK frequency in kHz (default: 1000)
     bool enable_caching;  ///< Enable register caching (default: true)
     uint retry_count;     ///< Number of retries on WAIT ACK (default: 5)
+    bool use_dma;         ///< Stream bulk transfers with DMA (default: false)
+    bool posted_writes;   ///< Don't confirm each memory write (default: false)
+    bool fast_pio;        ///< 2 PIO cycles per SWCLK instead of 4 (default: false)
+    bool fractional_clkdiv;  ///< Fine SWCLK steps, with one sysclk of jitter (default: false)
+    bool fast_attach;     ///< Poll instead of fixed delays, reuse a live DP/DM (default: false)
+    swd_poll_policy_t poll;  ///< Wait loop timing (see swd_poll_policy_t)
 } swd_config_t;
 
 /**
@@ -53,6 +59,7 @@ typedef struct {
     bool pio0_sm_used[4];  ///< Which PIO0 state machines are in use
     bool pio1_sm_used[4];  ///< Which PIO1 state machines are in use
     uint active_targets;   ///< Number of active targets
+    uint programs_loaded;  ///< SWD PIO programs resident (shared by all targets on a block)
 } swd_resource_info_t;
 
 //==============================================================================
@@ -69,6 +76,11 @@ typedef struct {
  * - Frequency: 1000 kHz
  * - Caching: Enabled
  * - Retry count: 5
+ * - DMA: Disabled
+ * - Posted writes: Disabled
+ * - PIO program: 4 cycles per SWCLK, integer clock divider
+ * - Fast attach: Disabled
+ * - Polling: 2 spins, then 1 us doubling to 1 ms, 200 ms deadline
  *
  * @return Default configuration structure
  */
@@ -92,7 +104,8 @@ swd_resource_info_t swd_get_resource_usage(void);
  *
  * Allocates and initializes an SWD target with the given configuration.
  * If PIO/SM are set to auto, automatically allocates the next available
- * resources.
+ * resources. The SWD PIO program is loaded once per PIO block and shared
+ * by all targets on it, so all state machines can be used at once.
  *
  * @param config Configuration for the target
  * @return Pointer to target handle, or NULL on failure
@@ -105,7 +118,9 @@ swd_target_t* swd_target_create(const swd_config_t *config);
  * @brief Destroy an SWD target and free resources
  *
  * Disconnects from target if connected, frees all resources including
- * PIO program memory and state machine.
+ * the state machine. PIO program memory is freed with the last target
+ * using it on that block. Async requests are drained and cancelled first;
+ * called from an async callback, it does nothing.
  *
  * @param target Target to destroy (can be NULL)
  */
@@ -125,6 +140,10 @@ void swd_target_destroy(swd_target_t *target);
  * 4. Read and verify IDCODE
  * 5. Power up debug domains
  *
+ * With fast_attach, a DP that still answers in SWD mode skips steps 2-3,
+ * and one whose debug domains are still powered skips the power-up
+ * handshake. No fixed delays are used on that path.
+ *
  * @param target Target to connect to
  * @return SWD_OK on success, error code otherwise
  */
@@ -133,10 +152,17 @@ swd_error_t swd_connect(swd_target_t *target);
 /**
  * @brief Disconnect from target
  *
- * Powers down debug domains and releases GPIO pins.
+ * Powers down debug domains and releases GPIO pins. With fast_attach the
+ * debug domains and Debug Module are left running, so the next connect
+ * and rp2350_init() reuse them (warm reconnect) and halted harts stay
+ * halted.
+ *
+ * Async requests are handled before any other traffic: a chunk on the
+ * wire is drained, then every request completes with SWD_ERROR_CANCELLED.
  *
  * @param target Target to disconnect from
- * @return SWD_OK on success, error code otherwise
+ * @return SWD_OK on success, SWD_ERROR_RESOURCE_BUSY if called from an
+ *         async callback, error code otherwise
  */
 swd_error_t swd_disconnect(swd_target_t *target);
 
@@ -204,12 +230,33 @@ const char* swd_get_last_error_detail(const swd_target_t *target);
  * Changes the SWD clock frequency. Can be called while connected.
  * Useful for starting slow (100 kHz) and speeding up after connection.
  *
+ * The PIO clock divider is rounded so SWCLK never exceeds freq_khz. Above
+ * about clk_sys/16, integer divider steps get coarse; fast_pio and
+ * fractional_clkdiv in swd_config_t give finer steps.
+ *
  * @param target Target to configure
  * @param freq_khz Frequency in kHz (recommended: 100-2000)
  * @return SWD_OK on success, error code otherwise
  */
 swd_error_t swd_set_frequency(swd_target_t *target, uint32_t freq_khz);
 
+/**
+ * @brief Find the highest reliable SWCLK frequency
+ *
+ * Ramps SWCLK up in 25% steps from the current frequency, which must
+ * already work. Each step must pass repeated IDCODE reads and
+ * write/read-back of bit patterns through the RISC-V APB-AP TAR, as one
+ * streamed batch so parity and ACK errors show up. If a step fails, the
+ * link is recovered and SWCLK settles 25% below the last step that passed.
+ * If every step up to max_khz passes, max_khz is kept.
+ *
+ * @param target Connected target
+ * @param max_khz Highest frequency to try
+ * @param freq_khz Where to store the chosen frequency (may be NULL)
+ * @return SWD_OK with SWCLK set to the chosen frequency, error code otherwise
+ */
+swd_error_t swd_autotune_frequency(swd_target_t *target, uint32_t max_khz, uint32_t *freq_khz);
+
 /**
  * @brief Get current SWCLK frequency
  *
@@ -218,6 +265,123 @@ swd_error_t swd_set_frequency(swd_target_t *target, uint32_t freq_khz);
  */
 uint32_t swd_get_frequency(const swd_target_t *target);
 
+//==============================================================================
+// Polling Policy
+//==============================================================================
+
+/**
+ * @brief Change how wait loops poll the target
+ *
+ * Takes effect from the next wait. Can be called while connected.
+ *
+ * @param target Target to configure
+ * @param policy New policy (timeout_us must be non-zero)
+ * @return SWD_OK on success, SWD_ERROR_INVALID_PARAM otherwise
+ */
+swd_error_t swd_set_poll_policy(swd_target_t *target, const swd_poll_policy_t *policy);
+
+/**
+ * @brief Get poll counters for one kind of wait
+ *
+ * Only waits whose condition was not met on the first check are counted
+ * for SWD_WAIT_ACK, so transactions that never saw WAIT don't dilute it.
+ *
+ * @param target Target to query
+ * @param kind Which wait loop
+ * @param stats Where to store the counters
+ * @return SWD_OK on success, SWD_ERROR_INVALID_PARAM otherwise
+ */
+swd_error_t swd_get_wait_stats(const swd_target_t *target, swd_wait_t kind,
+                               swd_wait_stats_t *stats);
+
+/**
+ * @brief Zero all poll counters
+ *
+ * @param target Target to reset
+ */
+void swd_reset_wait_stats(swd_target_t *target);
+
+/**
+ * @brief Get protocol counters and latency histograms
+ *
+ * Collection is compiled in only when the library is built with the
+ * PICO2_SWD_STATS CMake option; otherwise nothing is counted and this
+ * fails. Latencies use the microsecond timer.
+ *
+ * @param target Target to query
+ * @param stats Where to store the counters
+ * @return SWD_OK on success, SWD_ERROR_INVALID_CONFIG if built without
+ *         PICO2_SWD_STATS, SWD_ERROR_INVALID_PARAM otherwise
+ */
+swd_error_t swd_get_stats(const swd_target_t *target, swd_stats_t *stats);
+
+/**
+ * @brief Zero the protocol counters and latency histograms
+ *
+ * @param target Target to reset
+ */
+void swd_reset_stats(swd_target_t *target);
+
+//==============================================================================
+// Transaction Batching
+//==============================================================================
+
+/**
+ * @brief Start queuing raw DP/AP transactions
+ *
+ * Queued transactions are streamed back-to-back through the PIO FIFOs
+ * instead of waiting for each ACK, which removes the per-transaction round
+ * trip through the CPU. Batches do not nest.
+ *
+ * Reads store their value only once swd_batch_execute() returns. As with
+ * single transactions, an AP read returns the result of the previous AP
+ * read; queue a DP_RDBUFF read to collect the last one.
+ *
+ * Queued SELECT, TAR and DRW writes invalidate the DAP layer's SELECT/TAR
+ * shadows and, where they may reach it, the RP2350 DMCONTROL shadow.
+ *
+ * @param target Target (PIO must be initialized)
+ * @return SWD_OK on success, SWD_ERROR_INVALID_STATE if a batch is open
+ */
+swd_error_t swd_batch_begin(swd_target_t *target);
+
+/**
+ * @brief Queue a DP or AP register read
+ *
+ * If the queue is full it is flushed first. After a failure, further
+ * transactions are dropped and the error is returned until execute.
+ *
+ * @param target Target with an open batch
+ * @param ap true for an AP register, false for a DP register
+ * @param reg Register address (bits [3:2] are used)
+ * @param value Where to store the result (may be NULL)
+ * @return SWD_OK if queued, error code otherwise
+ */
+swd_error_t swd_batch_queue_read(swd_target_t *target, bool ap, uint8_t reg, uint32_t *value);
+
+/**
+ * @brief Queue a DP or AP register write
+ *
+ * @param target Target with an open batch
+ * @param ap true for an AP register, false for a DP register
+ * @param reg Register address (bits [3:2] are used)
+ * @param value Value to write
+ * @return SWD_OK if queued, error code otherwise
+ */
+swd_error_t swd_batch_queue_write(swd_target_t *target, bool ap, uint8_t reg, uint32_t value);
+
+/**
+ * @brief Run the queued transactions and close the batch
+ *
+ * WAIT responses are retried from the transaction that stalled. On any
+ * other error the batch stops there; the error detail names the failing
+ * transaction index.
+ *
+ * @param target Target with an open batch
+ * @return SWD_OK if every transaction completed, first error otherwise
+ */
+swd_error_t swd_batch_execute(swd_target_t *target);
+
 #ifdef __cplusplus
 }
 #endif
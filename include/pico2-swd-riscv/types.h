@@ -47,6 +47,7 @@ typedef enum {
     SWD_ERROR_BUS,                 ///< System bus access error
     SWD_ERROR_ALIGNMENT,           ///< Memory address alignment error
     SWD_ERROR_VERIFY,              ///< Memory verification failed
+    SWD_ERROR_CANCELLED,           ///< Asynchronous request cancelled
 } swd_error_t;
 
 /**
@@ -73,6 +74,92 @@ typedef enum {
     SWD_SM_AUTO = 0xFF,   ///< Automatically select next available SM
 } swd_sm_mode_t;
 
+/**
+ * @brief How wait loops poll the target
+ *
+ * A wait re-checks its condition spin_polls times back to back, then
+ * sleeps between checks, starting at backoff_min_us and doubling up to
+ * backoff_max_us, until timeout_us has passed since the first failed
+ * check. WAIT ACK retries follow the same schedule but also stop after
+ * retry_count attempts.
+ */
+typedef struct {
+    uint32_t spin_polls;      ///< Checks before the first delay (default: 2)
+    uint32_t backoff_min_us;  ///< First delay in microseconds (default: 1)
+    uint32_t backoff_max_us;  ///< Longest delay in microseconds (default: 1000)
+    uint32_t timeout_us;      ///< Deadline for one wait in microseconds (default: 200000)
+} swd_poll_policy_t;
+
+/**
+ * @brief Wait loops tracked by swd_get_wait_stats()
+ */
+typedef enum {
+    SWD_WAIT_ACK = 0,     ///< Retrying a transaction after a WAIT ACK
+    SWD_WAIT_POWER,       ///< Debug/system power-up acknowledge
+    SWD_WAIT_ABSTRACT,    ///< RISC-V abstract command completion
+    SWD_WAIT_HALT,        ///< Hart halt or resume
+    SWD_WAIT_SBA,         ///< System bus access completion
+    SWD_WAIT_CALL,        ///< Function run by rp2350_call() returning
+    SWD_WAIT_COUNT
+} swd_wait_t;
+
+/**
+ * @brief Poll counters for one kind of wait
+ */
+typedef struct {
+    uint32_t waits;       ///< Waits completed or timed out
+    uint32_t polls;       ///< Condition checks across all waits
+    uint32_t max_polls;   ///< Most checks a single wait needed
+    uint32_t timeouts;    ///< Waits that gave up
+} swd_wait_stats_t;
+
+/**
+ * @brief Operations timed by the swd_get_stats() latency histograms
+ */
+typedef enum {
+    SWD_LATENCY_TRANSFER = 0, ///< One DP/AP transaction sent on its own
+    SWD_LATENCY_STREAM,       ///< One swd_run_ops() run of streamed transactions
+    SWD_LATENCY_ABSTRACT,     ///< Abstract command completion wait
+    SWD_LATENCY_MEM_READ,     ///< One memory read (word, narrow or block chunk)
+    SWD_LATENCY_MEM_WRITE,    ///< One memory write (word, narrow or block chunk)
+    SWD_LATENCY_COUNT
+} swd_latency_t;
+
+/// Histogram buckets: bucket 0 counts latencies under 1 us, bucket b counts
+/// [2^(b-1), 2^b) us, and the last bucket everything from 2^(b-1) us up
+#define SWD_LATENCY_BUCKETS 16
+
+/**
+ * @brief Latency distribution of one kind of operation
+ */
+typedef struct {
+    uint32_t count;       ///< Operations timed
+    uint32_t min_us;      ///< Fastest (0 if count is 0)
+    uint32_t max_us;      ///< Slowest
+    uint64_t total_us;    ///< Sum, for the mean
+    uint32_t buckets[SWD_LATENCY_BUCKETS];  ///< Log2 histogram in microseconds
+} swd_latency_stats_t;
+
+/**
+ * @brief Protocol counters kept when built with PICO2_SWD_STATS
+ */
+typedef struct {
+    uint32_t transactions;    ///< DP/AP transactions sent, including retries
+    uint32_t ack_wait;        ///< WAIT ACKs
+    uint32_t ack_fault;       ///< FAULT ACKs
+    uint32_t ack_error;       ///< Invalid ACKs (protocol errors)
+    uint32_t parity_errors;   ///< Read data with bad parity
+    uint32_t retries;         ///< Transactions re-sent after WAIT
+    uint32_t select_hits;     ///< AP bank selections skipped by the DP_SELECT shadow
+    uint32_t select_writes;   ///< DP_SELECT writes by AP bank selection
+    uint32_t tar_hits;        ///< DM accesses that reused the TAR shadow
+    uint32_t tar_writes;      ///< DM accesses that had to write TAR
+    uint32_t abstract_polls;  ///< ABSTRACTCS reads waiting for a command
+    uint64_t bytes_read;      ///< Target memory bytes read over the bus
+    uint64_t bytes_written;   ///< Target memory bytes written over the bus
+    swd_latency_stats_t latency[SWD_LATENCY_COUNT];
+} swd_stats_t;
+
 /**
  * @brief SWD ACK response values (internal use)
  */
@@ -0,0 +1,141 @@
+/**
+ * @file worker.h
+ * @brief Run SWD work on core1 behind a lock-free request ring
+ *
+ * Every library call blocks the calling core until the target answers. In
+ * probe firmware that core usually also services USB. With the worker
+ * running, core0 only submits jobs and collects completions; core1 does
+ * all the SWD traffic and waiting.
+ *
+ * Requests and completions travel through single-producer/single-consumer
+ * rings in shared memory, so neither core ever takes a lock. Completions
+ * come back in submission order.
+ *
+ * A target with use_dma installs its DMA_IRQ_0 handler on the core that
+ * called swd_connect(), normally core0, and only that core takes the
+ * completion IRQ. A job on core1 sleeps in WFE until the handler on core0
+ * signals it with SEV, so core0 must keep interrupts enabled while jobs
+ * on DMA targets run.
+ *
+ * @section usage Basic Usage
+ * @code
+ * static swd_error_t read_word(swd_target_t *target, void *arg) {
+ *     uint32_t *word = arg;
+ *     swd_result_t result = rp2350_read_mem32(target, *word);
+ *     *word = result.value;
+ *     return result.error;
+ * }
+ *
+ * swd_worker_start();
+ * uint32_t word = 0x20000000;
+ * swd_worker_submit(target, read_word, &word, NULL);
+ *
+ * swd_completion_t done;
+ * while (!swd_worker_poll(&done)) {
+ *     tud_task();              // USB keeps running meanwhile
+ * }
+ * @endcode
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PICO2_SWD_RISCV_WORKER_H
+#define PICO2_SWD_RISCV_WORKER_H
+
+#include "pico2-swd-riscv/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Requests that may be outstanding (submitted but not yet polled)
+#define SWD_WORKER_QUEUE_DEPTH 16
+
+/**
+ * @brief A job for the worker: any library calls on one target
+ *
+ * Runs on core1. The return value is passed back in the completion.
+ */
+typedef swd_error_t (*swd_worker_fn_t)(swd_target_t *target, void *arg);
+
+/**
+ * @brief Outcome of one job
+ */
+typedef struct {
+    uint32_t id;              ///< Value stored by swd_worker_submit()
+    swd_target_t *target;     ///< Target the job ran on
+    void *arg;                ///< Argument the job was given
+    swd_error_t error;        ///< What the job returned
+} swd_completion_t;
+
+//==============================================================================
+// Worker Control
+//==============================================================================
+
+/**
+ * @brief Launch the worker on core1
+ *
+ * Core1 must not be in use for anything else.
+ *
+ * @return SWD_OK on success, SWD_ERROR_INVALID_STATE if already running
+ */
+swd_error_t swd_worker_start(void);
+
+/**
+ * @brief Finish queued jobs, then stop core1
+ *
+ * Completions not yet polled stay available to swd_worker_poll().
+ */
+void swd_worker_stop(void);
+
+/**
+ * @brief Check whether the worker is running
+ *
+ * @return true between swd_worker_start() and swd_worker_stop()
+ */
+bool swd_worker_is_running(void);
+
+//==============================================================================
+// Requests and Completions (core0 only)
+//==============================================================================
+
+/**
+ * @brief Queue a job without waiting for it
+ *
+ * From submission until its completion is polled, the target belongs to
+ * the worker: core0 must not call the library on it, nor destroy it.
+ *
+ * @param target Target the job runs on
+ * @param fn Job to run on core1
+ * @param arg Passed to fn and returned in the completion
+ * @param id Where to store the job's id (may be NULL)
+ * @return SWD_OK if queued, SWD_ERROR_RESOURCE_BUSY if
+ *         SWD_WORKER_QUEUE_DEPTH jobs are outstanding,
+ *         SWD_ERROR_INVALID_STATE if the worker is not running
+ */
+swd_error_t swd_worker_submit(swd_target_t *target, swd_worker_fn_t fn, void *arg,
+                              uint32_t *id);
+
+/**
+ * @brief Collect the oldest completion, if any
+ *
+ * Never blocks.
+ *
+ * @param completion Where to store the completion
+ * @return true if a completion was returned
+ */
+bool swd_worker_poll(swd_completion_t *completion);
+
+/**
+ * @brief Number of jobs submitted whose completion has not been polled
+ *
+ * @return Outstanding job count
+ */
+uint32_t swd_worker_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO2_SWD_RISCV_WORKER_H
@@ -0,0 +1,302 @@
+/**
+ * @file async.c
+ * @brief Non-blocking block transfers driven by swd_poll()
+ *
+ * Each request is split into SBA chunks of SBA_BATCH_CHUNK_WORDS, the most
+ * that fit one batch. A chunk is queued with the same helpers as
+ * rp2350_read/write_mem_block(), started with swd_batch_start(), and
+ * advanced by swd_batch_poll() on every swd_poll() until it completes.
+ * Requests run one at a time, oldest first.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico2-swd-riscv/async.h"
+#include "pico2-swd-riscv/dap.h"
+#include "pico2-swd-riscv/rp2350.h"
+#include "pico2-swd-riscv/swd.h"
+#include "internal.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//==============================================================================
+// Request Queue
+//==============================================================================
+
+static swd_async_req_t *find_request(swd_target_t *target, swd_async_handle_t handle) {
+    swd_async_t *async = target ? target->async : NULL;
+    if (!async || handle == 0) {
+        return NULL;
+    }
+
+    for (uint i = 0; i < async->count; i++) {
+        if (async->queue[i].handle == handle) {
+            return &async->queue[i];
+        }
+    }
+    return NULL;
+}
+
+static swd_error_t async_submit(swd_target_t *target, bool write, uint32_t addr,
+                                uint32_t *buffer, uint32_t count, swd_async_cb_t cb,
+                                void *ctx, swd_async_handle_t *handle) {
+    if (!target || !buffer || count == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (addr & 0x3) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    if (!target->async) {
+        target->async = calloc(1, sizeof(swd_async_t));
+        if (!target->async) {
+            swd_set_error(target, SWD_ERROR_NO_MEMORY, "Failed to allocate async queue");
+            return SWD_ERROR_NO_MEMORY;
+        }
+    }
+
+    swd_async_t *async = target->async;
+    if (async->count == SWD_ASYNC_MAX_INFLIGHT) {
+        swd_set_error(target, SWD_ERROR_RESOURCE_BUSY, "%u async requests in flight",
+                     SWD_ASYNC_MAX_INFLIGHT);
+        return SWD_ERROR_RESOURCE_BUSY;
+    }
+
+    // Chunks bypass the memory cache, which no other call touches meanwhile
+    swd_error_t err = rp2350_mem_cache_sync(target, addr, count * 4, write);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    // 0 is reserved for "no request"
+    if (++async->next_handle == 0) {
+        async->next_handle = 1;
+    }
+
+    swd_async_req_t *req = &async->queue[async->count++];
+    memset(req, 0, sizeof(*req));
+    req->handle = async->next_handle;
+    req->write = write;
+    req->addr = addr;
+    req->buffer = buffer;
+    req->count = count;
+    req->cb = cb;
+    req->ctx = ctx;
+
+    if (handle) {
+        *handle = req->handle;
+    }
+    return SWD_OK;
+}
+
+/**
+ * @brief Remove queue[index] and run its callback
+ */
+static void async_complete(swd_target_t *target, uint index, swd_error_t result) {
+    swd_async_t *async = target->async;
+    swd_async_req_t req = async->queue[index];
+
+    memmove(&async->queue[index], &async->queue[index + 1],
+            (async->count - index - 1) * sizeof(swd_async_req_t));
+    async->count--;
+
+    if (req.handle == async->wait_handle) {
+        async->wait_result = result;
+        async->wait_handle = 0;
+    }
+
+    if (req.cb) {
+        bool outer = async->in_callback;
+        async->in_callback = true;
+        req.cb(target, req.handle, result, req.ctx);
+        async->in_callback = outer;
+    }
+}
+
+/**
+ * @brief Put the oldest request's next chunk on the wire
+ *
+ * Without SBA there is nothing to stream, so the chunk runs to completion
+ * here and async->running stays false.
+ */
+static swd_error_t async_start_chunk(swd_target_t *target, swd_async_req_t *req) {
+    uint32_t remaining = req->count - req->done;
+    uint32_t addr = req->addr + (req->done * 4);
+    uint32_t *buffer = &req->buffer[req->done];
+
+    req->chunk = remaining < SBA_BATCH_CHUNK_WORDS ? remaining : SBA_BATCH_CHUNK_WORDS;
+
+    if (!target->rp2350.sba_initialized) {
+        return req->write ? rp2350_write_mem_block(target, addr, buffer, req->chunk)
+                          : rp2350_read_mem_block(target, addr, buffer, req->chunk);
+    }
+
+    swd_error_t err = dap_select_ap_bank(target, AP_RISCV, 0);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = rp2350_sba_queue_chunk(target, req->write, addr, buffer, req->chunk, &req->sbcs);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = swd_batch_start(target);
+    if (err == SWD_OK) {
+        target->async->running = true;
+    }
+    return err;
+}
+
+//==============================================================================
+// Submission
+//==============================================================================
+
+swd_error_t rp2350_read_mem_block_async(swd_target_t *target, uint32_t addr,
+                                        uint32_t *buffer, uint32_t count,
+                                        swd_async_cb_t cb, void *ctx,
+                                        swd_async_handle_t *handle) {
+    return async_submit(target, false, addr, buffer, count, cb, ctx, handle);
+}
+
+swd_error_t rp2350_write_mem_block_async(swd_target_t *target, uint32_t addr,
+                                         const uint32_t *buffer, uint32_t count,
+                                         swd_async_cb_t cb, void *ctx,
+                                         swd_async_handle_t *handle) {
+    // Only ever read through: SBDATA0 writes take the words by value
+    return async_submit(target, true, addr, (uint32_t *)buffer, count, cb, ctx, handle);
+}
+
+//==============================================================================
+// Progress and Completion
+//==============================================================================
+
+uint swd_poll(swd_target_t *target) {
+    if (!target || !target->async) {
+        return 0;
+    }
+
+    swd_async_t *async = target->async;
+
+    // Cancelled requests that are not on the wire finish right away
+    for (uint i = 0; i < async->count;) {
+        if (async->queue[i].cancelled && !(i == 0 && async->running)) {
+            async_complete(target, i, SWD_ERROR_CANCELLED);
+        } else {
+            i++;
+        }
+    }
+
+    while (async->count > 0) {
+        swd_async_req_t *req = &async->queue[0];
+        swd_error_t err;
+
+        if (!async->running) {
+            err = async_start_chunk(target, req);
+            if (err != SWD_OK) {
+                async_complete(target, 0, err);
+                continue;
+            }
+            if (!async->running) {
+                // Ran synchronously; give the caller its turn
+                req->done += req->chunk;
+                if (req->done == req->count) {
+                    async_complete(target, 0, SWD_OK);
+                }
+                break;
+            }
+        }
+
+        if (!swd_batch_poll(target, &err)) {
+            break;  // Still on the wire
+        }
+        async->running = false;
+
+        if (err == SWD_OK) {
+            err = rp2350_sba_chunk_status(target, req->sbcs, req->addr + (req->done * 4));
+        }
+        if (err != SWD_OK) {
+            async_complete(target, 0, err);
+            continue;
+        }
+
+        if (req->write) {
+            SWD_STAT_ADD(target, bytes_written, req->chunk * 4);
+        } else {
+            SWD_STAT_ADD(target, bytes_read, req->chunk * 4);
+        }
+        req->done += req->chunk;
+        if (req->done == req->count) {
+            async_complete(target, 0, SWD_OK);
+        } else if (req->cancelled) {
+            async_complete(target, 0, SWD_ERROR_CANCELLED);
+        }
+    }
+
+    return async->count;
+}
+
+swd_error_t swd_wait(swd_target_t *target, swd_async_handle_t handle) {
+    if (!find_request(target, handle)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    swd_async_t *async = target->async;
+    async->wait_handle = handle;
+
+    // async_complete() clears wait_handle when the request finishes
+    while (async->wait_handle == handle) {
+        swd_poll(target);
+    }
+
+    return async->wait_result;
+}
+
+swd_error_t swd_async_cancel(swd_target_t *target, swd_async_handle_t handle) {
+    swd_async_req_t *req = find_request(target, handle);
+    if (!req) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    req->cancelled = true;
+    return SWD_OK;
+}
+
+swd_error_t swd_async_release(swd_target_t *target) {
+    swd_async_t *async = target->async;
+    if (!async) {
+        return SWD_OK;
+    }
+
+    // The queue is still being walked by the poll that runs the callback
+    if (async->in_callback) {
+        swd_set_error(target, SWD_ERROR_RESOURCE_BUSY,
+                     "Async requests cannot be released from a callback");
+        return SWD_ERROR_RESOURCE_BUSY;
+    }
+
+    // A chunk on the wire has to drain to keep the PIO in step
+    if (async->running) {
+        swd_error_t err;
+        while (!swd_batch_poll(target, &err)) {
+            tight_loop_contents();
+        }
+        async->running = false;
+    }
+
+    while (async->count > 0) {
+        async_complete(target, 0, SWD_ERROR_CANCELLED);
+    }
+
+    target->async = NULL;
+    free(async);
+    return SWD_OK;
+}
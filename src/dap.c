@@ -32,9 +32,12 @@ static swd_error_t select_ap_bank(swd_target_t *target, uint8_t apsel, uint8_t b
         target->dap.current_bank == bank &&
         target->dap.ctrlsel == true) {
         SWD_DEBUG("AP bank already selected (APSEL=%u, bank=%u)\n", apsel, bank);
+        SWD_STAT_INC(target, select_hits);
         return SWD_OK;
     }
 
+    SWD_STAT_INC(target, select_writes);
+
     // Build DP_SELECT value for RP2350
     uint32_t select_val = make_dp_select_rp2350(apsel, bank, true);
 
@@ -55,10 +58,121 @@ static swd_error_t select_ap_bank(swd_target_t *target, uint8_t apsel, uint8_t b
     return SWD_OK;
 }
 
+swd_error_t dap_select_ap_bank(swd_target_t *target, uint8_t apsel, uint8_t bank) {
+    swd_error_t err = select_ap_bank(target, apsel, bank);
+    if (err != SWD_OK || apsel != AP_RISCV || bank != 0 || !target->dap.csw_dirty) {
+        return err;
+    }
+
+    // A failed block could not put CSW back; every RISC-V AP access after
+    // this relies on single-word, non-incrementing CSW
+    err = swd_write_ap_raw(target, AP_CSW, AP_CSW_DEFAULT);
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "CSW restore after failed block failed");
+        return err;
+    }
+    target->dap.csw_dirty = false;
+    target->dap.tar_valid = false;
+    return SWD_OK;
+}
+
+//==============================================================================
+// Shadow Registers
+//==============================================================================
+
+void dap_invalidate_cache(swd_target_t *target) {
+    target->dap.current_apsel = 0xFF;
+    target->dap.current_bank = 0xFF;
+    target->dap.tar_valid = false;
+    rp2350_forget_dm_shadows(target);
+}
+
+static inline bool tar_matches(const swd_target_t *target, uint32_t addr) {
+    return target->dap.tar_valid && target->dap.tar_cache == addr;
+}
+
+// TAR writes a DM access can skip (0 or 1), counted in the stats
+static inline uint tar_skip(swd_target_t *target, uint32_t addr) {
+    if (tar_matches(target, addr)) {
+        SWD_STAT_INC(target, tar_hits);
+        return 1;
+    }
+    SWD_STAT_INC(target, tar_writes);
+    return 0;
+}
+
+static inline void tar_update(swd_target_t *target, uint32_t addr) {
+    target->dap.tar_cache = addr;
+    target->dap.tar_valid = true;
+}
+
+/**
+ * @brief Keep the TAR/DMCONTROL shadows in step with a raw AP access
+ *
+ * Only the RISC-V APB-AP is shadowed. DRW accesses may advance TAR if the
+ * caller enabled CSW.AddrInc, and a DRW write may hit a shadowed DM register.
+ */
+static void note_ap_access(swd_target_t *target, uint8_t apsel, uint8_t reg,
+                           uint32_t value, bool write) {
+    if (apsel != AP_RISCV) {
+        return;
+    }
+
+    if (((reg >> 4) & 0xF) != 0) {
+        // RP2350-specific banks include DM activation control
+        if (write) {
+            rp2350_forget_dm_shadows(target);
+        }
+        return;
+    }
+
+    switch (reg) {
+        case AP_TAR:
+            if (write) {
+                tar_update(target, value);
+            }
+            break;
+        case AP_DRW:
+            // A write through an unknown TAR may have hit a shadowed register
+            if (write && !target->dap.tar_valid) {
+                rp2350_forget_dm_shadows(target);
+            } else if (write) {
+                rp2350_note_dm_write(target, target->dap.tar_cache, 4);
+            }
+            target->dap.tar_valid = false;
+            break;
+        case AP_CSW:
+            if (write) {
+                target->dap.tar_valid = false;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
 //==============================================================================
 // Power Management
 //==============================================================================
 
+/**
+ * @brief Record the domains as powered and enable overrun detection
+ *
+ * Overrun detection lets transactions be streamed without waiting for
+ * each ACK (see swd_run_ops).
+ */
+static swd_error_t dap_powered(swd_target_t *target, uint32_t ctrl_stat) {
+    target->dap.powered = true;
+
+    swd_error_t err = swd_write_dp_raw(target, DP_CTRL_STAT, ctrl_stat | CTRL_STAT_ORUNDETECT);
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "Failed to enable overrun detection");
+        return err;
+    }
+    target->dap.orundetect = true;
+    return SWD_OK;
+}
+
 swd_error_t dap_power_up(swd_target_t *target) {
     if (!target) {
         return SWD_ERROR_INVALID_PARAM;
@@ -68,17 +182,36 @@ swd_error_t dap_power_up(swd_target_t *target) {
         return SWD_OK;  // Already powered
     }
 
+    // Request power-up: CDBGPWRUPREQ | CSYSPWRUPREQ
+    uint32_t ctrl_stat = (1 << 28) | (1 << 30);
+    swd_error_t err;
+
+    // Fast attach: domains left powered by an earlier session only need
+    // their sticky flags cleared
+    if (target->fast_attach) {
+        uint32_t status;
+        err = swd_read_dp_raw(target, DP_CTRL_STAT, &status);
+        if (err == SWD_OK && (status & CTRL_STAT_PWRUPACK) == CTRL_STAT_PWRUPACK) {
+            SWD_INFO("Debug domains already powered\n");
+            err = swd_write_dp_raw(target, DP_ABORT, ABORT_STKCMPCLR | ABORT_STKERRCLR |
+                                                     ABORT_WDERRCLR | ABORT_ORUNERRCLR);
+            if (err != SWD_OK) {
+                swd_set_error(target, err, "Failed to clear sticky errors");
+                return err;
+            }
+            return dap_powered(target, ctrl_stat);
+        }
+    }
+
     SWD_INFO("Powering up debug domains...\n");
 
     // Clear errors first
-    swd_error_t err = swd_write_dp_raw(target, DP_CTRL_STAT, 0);
+    err = swd_write_dp_raw(target, DP_CTRL_STAT, 0);
     if (err != SWD_OK) {
         swd_set_error(target, err, "Failed to clear DP_CTRL_STAT");
         return err;
     }
 
-    // Request power-up: CDBGPWRUPREQ | CSYSPWRUPREQ
-    uint32_t ctrl_stat = (1 << 28) | (1 << 30);
     err = swd_write_dp_raw(target, DP_CTRL_STAT, ctrl_stat);
     if (err != SWD_OK) {
         swd_set_error(target, err, "Failed to request power-up");
@@ -86,7 +219,9 @@ swd_error_t dap_power_up(swd_target_t *target) {
     }
 
     // Poll for ACK (bits 29 and 31)
-    for (int i = 0; i < 10; i++) {
+    swd_poll_t poll;
+    swd_poll_begin(target, &poll, SWD_WAIT_POWER);
+    do {
         uint32_t status;
         err = swd_read_dp_raw(target, DP_CTRL_STAT, &status);
         if (err != SWD_OK) {
@@ -98,14 +233,13 @@ swd_error_t dap_power_up(swd_target_t *target) {
         bool csyspwrupack = (status >> 31) & 1;
 
         if (cdbgpwrupack && csyspwrupack) {
+            swd_poll_end(target, &poll, true);
             SWD_INFO("Debug domains powered up\n");
-            target->dap.powered = true;
-            return SWD_OK;
+            return dap_powered(target, ctrl_stat);
         }
+    } while (swd_poll_again(target, &poll));
 
-        sleep_ms(20);
-    }
-
+    swd_poll_end(target, &poll, false);
     swd_set_error(target, SWD_ERROR_TIMEOUT, "Power-up timeout");
     return SWD_ERROR_TIMEOUT;
 }
@@ -124,6 +258,7 @@ swd_error_t dap_power_down(swd_target_t *target) {
     swd_error_t err = swd_write_dp_raw(target, DP_CTRL_STAT, 0);
     if (err == SWD_OK) {
         target->dap.powered = false;
+        target->dap.orundetect = false;
     }
 
     return err;
@@ -164,9 +299,25 @@ swd_error_t dap_write_dp(swd_target_t *target, uint8_t reg, uint32_t value) {
     swd_error_t err = swd_write_dp_raw(target, reg, value);
     if (err != SWD_OK) {
         swd_set_error(target, err, "DP write failed (reg=0x%02x, value=0x%08x)", reg, value);
+        return err;
     }
 
-    return err;
+    if (reg == DP_SELECT) {
+        // Keep the bank cache truthful for callers selecting by hand
+        if (((value >> 8) & 0xF) == 0xD) {
+            target->dap.current_apsel = (value >> 12) & 0xF;
+            target->dap.current_bank = (value >> 4) & 0xF;
+            target->dap.ctrlsel = value & 1;
+            target->dap.select_cache = value;
+        } else {
+            target->dap.current_apsel = 0xFF;
+            target->dap.current_bank = 0xFF;
+        }
+    } else if (reg == DP_ABORT && (value & ABORT_DAPABORT)) {
+        target->dap.tar_valid = false;
+    }
+
+    return SWD_OK;
 }
 
 //==============================================================================
@@ -182,30 +333,28 @@ swd_result_t dap_read_ap(swd_target_t *target, uint8_t apsel, uint8_t reg) {
 
     // Select appropriate bank
     uint8_t bank = (reg >> 4) & 0xF;
-    result.error = select_ap_bank(target, apsel, bank);
+    result.error = dap_select_ap_bank(target, apsel, bank);
     if (result.error != SWD_OK) {
         return result;
     }
 
-    // Read from AP
-    result.error = swd_read_ap_raw(target, reg, &result.value);
+    // AP read posts the access, RDBUFF returns its result
+    swd_op_t ops[] = {
+        swd_op_read(true, reg, NULL),
+        swd_op_read(false, DP_RDBUFF, &result.value),
+    };
+    uint failed;
+    result.error = swd_run_ops(target, ops, 2, &failed);
     if (result.error != SWD_OK) {
-        swd_set_error(target, result.error,
-                     "AP read failed (apsel=%u, reg=0x%02x)", apsel, reg);
+        swd_set_error(target, result.error, "%s failed (apsel=%u, reg=0x%02x)",
+                     failed == 0 ? "AP read" : "RDBUFF read", apsel, reg);
         return result;
     }
 
-    // Read RDBUFF to get actual value
-    uint32_t final_value;
-    result.error = swd_read_dp_raw(target, DP_RDBUFF, &final_value);
-    if (result.error == SWD_OK) {
-        result.value = final_value;
-        SWD_DEBUG("AP read: apsel=%u, reg=0x%02x, value=0x%08lx\n",
-                  apsel, reg, (unsigned long)result.value);
-    } else {
-        swd_set_error(target, result.error, "RDBUFF read failed");
-    }
+    note_ap_access(target, apsel, reg, 0, false);
 
+    SWD_DEBUG("AP read: apsel=%u, reg=0x%02x, value=0x%08lx\n",
+              apsel, reg, (unsigned long)result.value);
     return result;
 }
 
@@ -216,7 +365,7 @@ swd_error_t dap_write_ap(swd_target_t *target, uint8_t apsel, uint8_t reg, uint3
 
     // Select appropriate bank
     uint8_t bank = (reg >> 4) & 0xF;
-    swd_error_t err = select_ap_bank(target, apsel, bank);
+    swd_error_t err = dap_select_ap_bank(target, apsel, bank);
     if (err != SWD_OK) {
         return err;
     }
@@ -226,18 +375,33 @@ swd_error_t dap_write_ap(swd_target_t *target, uint8_t apsel, uint8_t reg, uint3
     // Write to AP
     err = swd_write_ap_raw(target, reg, value);
     if (err != SWD_OK) {
+        dap_invalidate_cache(target);
         swd_set_error(target, err,
                      "AP write failed (apsel=%u, reg=0x%02x, value=0x%08x)",
                      apsel, reg, value);
+        return err;
     }
 
-    return err;
+    note_ap_access(target, apsel, reg, value, true);
+    return SWD_OK;
 }
 
 //==============================================================================
 // Memory Access Through AP
 //==============================================================================
 
+/**
+ * @brief Attribute a FAULT to an earlier posted write, if there is one
+ *
+ * @return true if the error was reported against the posted writes
+ */
+static bool posted_fault(swd_target_t *target, swd_error_t err) {
+    if (err != SWD_ERROR_FAULT || target->dap.posted_count == 0) {
+        return false;
+    }
+    return dap_sync_posted(target) != SWD_OK;
+}
+
 swd_result_t dap_read_mem32(swd_target_t *target, uint32_t addr) {
     swd_result_t result = {.error = SWD_ERROR_NOT_CONNECTED, .value = 0};
 
@@ -253,27 +417,33 @@ swd_result_t dap_read_mem32(swd_target_t *target, uint32_t addr) {
 
     SWD_DEBUG("MEM read: addr=0x%08lx\n", (unsigned long)addr);
 
-    // Write address to TAR
-    result.error = dap_write_ap(target, AP_RISCV, AP_TAR, addr);
+    result.error = dap_select_ap_bank(target, AP_RISCV, 0);
     if (result.error != SWD_OK) {
         return result;
     }
 
-    // Read from DRW (triggers memory read)
-    result.error = swd_read_ap_raw(target, AP_DRW, &result.value);
+    // TAR write (skipped if TAR already holds addr), DRW read (triggers
+    // memory read), RDBUFF read (returns it), streamed as one pipeline
+    static const char *const step[] = {"TAR write", "DRW read", "RDBUFF read"};
+    swd_op_t ops[] = {
+        swd_op_write(true, AP_TAR, addr),
+        swd_op_read(true, AP_DRW, NULL),
+        swd_op_read(false, DP_RDBUFF, &result.value),
+    };
+    uint skip = tar_skip(target, addr);
+    uint failed;
+    result.error = swd_run_ops(target, ops + skip, 3 - skip, &failed);
     if (result.error != SWD_OK) {
-        swd_set_error(target, result.error, "DRW read failed");
+        if (posted_fault(target, result.error)) {
+            return result;
+        }
+        swd_set_error(target, result.error, "MEM read %s failed (addr=0x%08x)",
+                     step[failed + skip], addr);
         return result;
     }
+    tar_update(target, addr);
 
-    // Get value from RDBUFF
-    uint32_t value;
-    result.error = swd_read_dp_raw(target, DP_RDBUFF, &value);
-    if (result.error == SWD_OK) {
-        result.value = value;
-        SWD_DEBUG("MEM read: addr=0x%08lx -> 0x%08lx\n", (unsigned long)addr, (unsigned long)result.value);
-    }
-
+    SWD_DEBUG("MEM read: addr=0x%08lx -> 0x%08lx\n", (unsigned long)addr, (unsigned long)result.value);
     return result;
 }
 
@@ -290,29 +460,201 @@ swd_error_t dap_write_mem32(swd_target_t *target, uint32_t addr, uint32_t value)
 
     SWD_DEBUG("MEM write: addr=0x%08lx <- 0x%08lx\n", (unsigned long)addr, (unsigned long)value);
 
-    // Write address to TAR
-    swd_error_t err = dap_write_ap(target, AP_RISCV, AP_TAR, addr);
+    swd_error_t err = dap_select_ap_bank(target, AP_RISCV, 0);
     if (err != SWD_OK) {
         return err;
     }
 
-    // Write value to DRW (triggers memory write)
-    err = dap_write_ap(target, AP_RISCV, AP_DRW, value);
+    // The RP2350 layer shadows some DM registers; a write from elsewhere
+    // resets them (the RP2350 layer re-arms its shadow after the write)
+    rp2350_note_dm_write(target, addr, 4);
+
+    // TAR write (skipped if TAR already holds addr), DRW write (triggers
+    // memory write), RDBUFF read to make sure the posted write has completed.
+    // In posted mode the completion read is left to dap_sync_posted().
+    static const char *const step[] = {"TAR write", "DRW write", "completion"};
+    swd_op_t ops[] = {
+        swd_op_write(true, AP_TAR, addr),
+        swd_op_write(true, AP_DRW, value),
+        swd_op_read(false, DP_RDBUFF, NULL),
+    };
+    uint skip = tar_skip(target, addr);
+    uint count = target->dap.posted_writes ? 2 : 3;
+    uint failed;
+    err = swd_run_ops(target, ops + skip, count - skip, &failed);
     if (err != SWD_OK) {
-        swd_set_error(target, err, "DRW write failed");
+        if (posted_fault(target, err)) {
+            return err;
+        }
+        swd_set_error(target, err, "MEM write %s failed (addr=0x%08x)",
+                     step[failed + skip], addr);
         return err;
     }
+    tar_update(target, addr);
 
-    // Read RDBUFF to ensure write completes (AP writes are posted/pipelined)
-    swd_result_t dummy = dap_read_dp(target, DP_RDBUFF);
-    if (dummy.error != SWD_OK) {
-        swd_set_error(target, dummy.error, "Failed to complete write");
-        return dummy.error;
+    if (target->dap.posted_writes) {
+        if (target->dap.posted_count++ == 0) {
+            target->dap.posted_first = addr;
+        }
+        target->dap.posted_last = addr;
     }
 
     return SWD_OK;
 }
 
+//==============================================================================
+// Block Memory Access Through AP
+//==============================================================================
+
+// TAR auto-increment is only guaranteed within a 1 KB block
+#define TAR_WRAP_BYTES 1024
+
+// Ops buffered on the stack before they are streamed
+#define BLOCK_QUEUE_OPS 32
+
+typedef struct {
+    swd_op_t ops[BLOCK_QUEUE_OPS];
+    uint count;
+    swd_error_t error;
+} block_queue_t;
+
+static void block_flush(swd_target_t *target, block_queue_t *q) {
+    if (q->error == SWD_OK && q->count > 0) {
+        q->error = swd_run_ops(target, q->ops, q->count, NULL);
+    }
+    q->count = 0;
+}
+
+static void block_push(swd_target_t *target, block_queue_t *q, swd_op_t op) {
+    if (q->error != SWD_OK) return;
+    if (q->count == BLOCK_QUEUE_OPS) {
+        block_flush(target, q);
+    }
+    q->ops[q->count++] = op;
+}
+
+static inline uint32_t words_to_wrap(uint32_t addr, uint32_t remaining) {
+    uint32_t words = (TAR_WRAP_BYTES - (addr & (TAR_WRAP_BYTES - 1))) / 4;
+    return words < remaining ? words : remaining;
+}
+
+static swd_error_t block_begin(swd_target_t *target, uint32_t addr, const void *buffer) {
+    if (!target || !target->connected) {
+        return SWD_ERROR_NOT_CONNECTED;
+    }
+
+    if (!buffer) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (addr & 0x3) {
+        swd_set_error(target, SWD_ERROR_ALIGNMENT, "Address 0x%08x not 4-byte aligned", addr);
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    return dap_select_ap_bank(target, AP_RISCV, 0);
+}
+
+static swd_error_t block_end(swd_target_t *target, block_queue_t *q,
+                             const char *what, uint32_t addr) {
+    block_flush(target, q);
+
+    // TAR was left at the end of the block
+    target->dap.tar_valid = false;
+
+    if (q->error != SWD_OK) {
+        // Single-word accesses rely on a non-incrementing CSW. The AP
+        // answers FAULT while STICKYERR is set, so clear it first; if the
+        // restore still fails, the next RISC-V AP selection retries it.
+        swd_error_t err = dap_clear_errors(target);
+        if (err == SWD_OK) {
+            err = swd_write_ap_raw(target, AP_CSW, AP_CSW_DEFAULT);
+        }
+        target->dap.csw_dirty = (err != SWD_OK);
+        swd_set_error(target, q->error, "MEM block %s failed (addr=0x%08x)", what, addr);
+    }
+
+    return q->error;
+}
+
+swd_error_t dap_read_mem_block(swd_target_t *target, uint32_t addr,
+                               uint32_t *buffer, uint32_t count) {
+    swd_error_t err = block_begin(target, addr, buffer);
+    if (err != SWD_OK || count == 0) {
+        return err;
+    }
+
+    SWD_DEBUG("MEM block read: addr=0x%08lx, %lu words\n",
+              (unsigned long)addr, (unsigned long)count);
+
+    block_queue_t q = {.count = 0, .error = SWD_OK};
+    block_push(target, &q, swd_op_write(true, AP_CSW, AP_CSW_DEFAULT | AP_CSW_ADDRINC_SINGLE));
+
+    for (uint32_t done = 0; done < count; ) {
+        uint32_t seg_addr = addr + (done * 4);
+        uint32_t n = words_to_wrap(seg_addr, count - done);
+        uint32_t *seg = &buffer[done];
+
+        // Each DRW read returns the previous one's data; RDBUFF collects
+        // the last before TAR changes
+        block_push(target, &q, swd_op_write(true, AP_TAR, seg_addr));
+        block_push(target, &q, swd_op_read(true, AP_DRW, NULL));
+        for (uint32_t i = 1; i < n; i++) {
+            block_push(target, &q, swd_op_read(true, AP_DRW, &seg[i - 1]));
+        }
+        block_push(target, &q, swd_op_read(false, DP_RDBUFF, &seg[n - 1]));
+
+        done += n;
+    }
+
+    block_push(target, &q, swd_op_write(true, AP_CSW, AP_CSW_DEFAULT));
+    return block_end(target, &q, "read", addr);
+}
+
+swd_error_t dap_write_mem_block(swd_target_t *target, uint32_t addr,
+                                const uint32_t *buffer, uint32_t count) {
+    swd_error_t err = block_begin(target, addr, buffer);
+    if (err != SWD_OK || count == 0) {
+        return err;
+    }
+
+    SWD_DEBUG("MEM block write: addr=0x%08lx, %lu words\n",
+              (unsigned long)addr, (unsigned long)count);
+
+    rp2350_note_dm_write(target, addr, count * 4);
+
+    block_queue_t q = {.count = 0, .error = SWD_OK};
+    block_push(target, &q, swd_op_write(true, AP_CSW, AP_CSW_DEFAULT | AP_CSW_ADDRINC_SINGLE));
+
+    for (uint32_t done = 0; done < count; ) {
+        uint32_t seg_addr = addr + (done * 4);
+        uint32_t n = words_to_wrap(seg_addr, count - done);
+
+        block_push(target, &q, swd_op_write(true, AP_TAR, seg_addr));
+        for (uint32_t i = 0; i < n; i++) {
+            block_push(target, &q, swd_op_write(true, AP_DRW, buffer[done + i]));
+        }
+
+        done += n;
+    }
+
+    // CSW restore, then RDBUFF to wait for the posted writes (left to
+    // dap_sync_posted() in posted mode)
+    block_push(target, &q, swd_op_write(true, AP_CSW, AP_CSW_DEFAULT));
+    if (!target->dap.posted_writes) {
+        block_push(target, &q, swd_op_read(false, DP_RDBUFF, NULL));
+    }
+    err = block_end(target, &q, "write", addr);
+
+    if (err == SWD_OK && target->dap.posted_writes) {
+        if (target->dap.posted_count == 0) {
+            target->dap.posted_first = addr;
+        }
+        target->dap.posted_count += count;
+        target->dap.posted_last = addr + ((count - 1) * 4);
+    }
+    return err;
+}
 
 //==============================================================================
 // Error Management
@@ -325,13 +667,73 @@ swd_error_t dap_clear_errors(swd_target_t *target) {
 
     SWD_INFO("Clearing sticky error flags\n");
 
-    // Clear STICKYERR, WDATAERR, STICKYORUN, STICKYCMP
-    uint32_t clear_bits = (1 << 5) | (1 << 7) | (1 << 1) | (1 << 4);
+    // Sticky flags are cleared through ABORT on SW-DP; writing them to
+    // CTRL_STAT (the JTAG-DP method) would also drop the power-up requests
+    uint32_t clear_bits = ABORT_STKCMPCLR | ABORT_STKERRCLR | ABORT_WDERRCLR | ABORT_ORUNERRCLR;
 
-    swd_error_t err = swd_write_dp_raw(target, DP_CTRL_STAT, clear_bits);
+    swd_error_t err = swd_write_dp_raw(target, DP_ABORT, clear_bits);
     if (err != SWD_OK) {
         swd_set_error(target, err, "Failed to clear error flags");
     }
 
     return err;
 }
+
+swd_error_t dap_sync_posted(swd_target_t *target) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t count = target->dap.posted_count;
+    if (count == 0) {
+        return SWD_OK;
+    }
+    target->dap.posted_count = 0;
+
+    // CTRL_STAT is DP bank 0; clear DPBANKSEL (SELECT[3:0]) around the read.
+    // With an unknown SELECT, select bank 0 and leave the cache invalid.
+    uint32_t ctrl_stat = 0;
+    bool known = target->dap.current_apsel != 0xFF;
+    uint32_t select = known ? target->dap.select_cache : 0;
+    swd_op_t ops[] = {
+        swd_op_write(false, DP_SELECT, select & ~0xFu),
+        swd_op_read(false, DP_CTRL_STAT, &ctrl_stat),
+        swd_op_write(false, DP_SELECT, select),
+    };
+    swd_error_t err;
+    if (!known) {
+        err = swd_run_ops(target, ops, 2, NULL);
+    } else if (target->dap.ctrlsel) {
+        err = swd_run_ops(target, ops, 3, NULL);
+    } else {
+        err = swd_run_ops(target, &ops[1], 1, NULL);
+    }
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "CTRL/STAT read failed confirming %u posted writes", count);
+        return err;
+    }
+
+    if (!(ctrl_stat & (CTRL_STAT_STICKYERR | CTRL_STAT_WDATAERR))) {
+        return SWD_OK;
+    }
+
+    dap_clear_errors(target);
+    target->dap.tar_valid = false;
+    swd_set_error(target, SWD_ERROR_FAULT,
+                 "Posted write failed: one of %u writes 0x%08x..0x%08x (CTRL/STAT=0x%08x)",
+                 count, target->dap.posted_first, target->dap.posted_last, ctrl_stat);
+    return SWD_ERROR_FAULT;
+}
+
+swd_error_t dap_set_posted_writes(swd_target_t *target, bool enable) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    swd_error_t err = SWD_OK;
+    if (!enable) {
+        err = dap_sync_posted(target);
+    }
+    target->dap.posted_writes = enable;
+    return err;
+}
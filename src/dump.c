@@ -0,0 +1,204 @@
+/**
+ * @file dump.c
+ * @brief Streamed memory dumps through two fixed buffers
+ *
+ * The two buffers take turns. Chunk N+1 is submitted as an async read into
+ * one buffer, and chunk N, already in the other, is encoded and given to
+ * the sink. With use_dma the read runs while the sink does; in stream mode
+ * it advances whenever the sink calls swd_poll().
+ *
+ * With RP2350_DUMP_RLE each chunk is read to buffer word 1 and encoded
+ * towards word 0. A literal header can only open at the start or after a
+ * run record, both of which leave the write position behind the read
+ * position, so encoding in place never overtakes unread words.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico2-swd-riscv/dump.h"
+#include "pico2-swd-riscv/async.h"
+#include "pico2-swd-riscv/swd.h"
+#include "internal.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief One chunk read
+ */
+typedef struct {
+    uint32_t count;             ///< Words in the chunk
+    swd_async_handle_t handle;
+    swd_error_t result;
+    bool pending;               ///< Submitted, callback not run yet
+} dump_read_t;
+
+//==============================================================================
+// Chunk Reads
+//==============================================================================
+
+static void read_done(swd_target_t *target, swd_async_handle_t handle,
+                      swd_error_t result, void *ctx) {
+    dump_read_t *read = ctx;
+    read->result = result;
+    read->pending = false;
+}
+
+/**
+ * @brief Submit a chunk read and put its first batch on the wire
+ */
+static swd_error_t read_start(swd_target_t *target, dump_read_t *read, uint32_t addr,
+                              uint32_t *buffer, uint32_t count) {
+    read->count = count;
+    read->result = SWD_OK;
+    read->pending = true;
+
+    swd_error_t err = rp2350_read_mem_block_async(target, addr, buffer, count,
+                                                  read_done, read, &read->handle);
+    if (err != SWD_OK) {
+        read->pending = false;
+        return err;
+    }
+
+    swd_poll(target);
+    return SWD_OK;
+}
+
+static swd_error_t read_finish(swd_target_t *target, dump_read_t *read) {
+    while (read->pending) {
+        swd_poll(target);
+    }
+    return read->result;
+}
+
+//==============================================================================
+// Run-Length Encoding
+//==============================================================================
+
+static uint32_t rle_header(uint32_t kind, uint32_t count) {
+    return (kind << RP2350_DUMP_KIND_SHIFT) | count;
+}
+
+/**
+ * @brief Encode the words at buf[1..count] into buf[0..]
+ *
+ * @return Words of records written
+ */
+static uint32_t rle_encode(uint32_t *buf, uint32_t count) {
+    uint32_t end = count + 1;
+    uint32_t w = 0;
+    uint32_t r = 1;
+    uint32_t literal = 0;
+    bool open = false;
+
+    while (r < end) {
+        uint32_t value = buf[r];
+        uint32_t run = 1;
+        if (value == 0 || value == 0xFFFFFFFF) {
+            while (r + run < end && buf[r + run] == value) {
+                run++;
+            }
+        }
+
+        if (run >= RP2350_DUMP_MIN_RUN) {
+            if (open) {
+                buf[literal] = rle_header(RP2350_DUMP_LITERAL, w - literal - 1);
+                open = false;
+            }
+            buf[w++] = rle_header(value ? RP2350_DUMP_ONES : RP2350_DUMP_ZEROS, run);
+            r += run;
+        } else {
+            if (!open) {
+                literal = w++;
+                open = true;
+            }
+            while (run-- > 0) {
+                buf[w++] = buf[r++];
+            }
+        }
+    }
+
+    if (open) {
+        buf[literal] = rle_header(RP2350_DUMP_LITERAL, w - literal - 1);
+    }
+    return w;
+}
+
+//==============================================================================
+// Streamed Dump
+//==============================================================================
+
+swd_error_t rp2350_dump(swd_target_t *target, uint32_t addr, uint32_t count,
+                        uint32_t *buf_a, uint32_t *buf_b, uint32_t buf_words,
+                        uint32_t flags, rp2350_dump_sink_t sink, void *ctx,
+                        rp2350_dump_stats_t *stats) {
+    if (!target || !buf_a || !buf_b || !sink || count == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    bool rle = (flags & RP2350_DUMP_RLE) != 0;
+    uint32_t offset = rle ? 1 : 0;
+    if (buf_words <= offset || count > RP2350_DUMP_COUNT_MASK) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (addr & 0x3) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+
+    uint32_t chunk = buf_words - offset;
+    uint32_t *bufs[2] = {buf_a, buf_b};
+    dump_read_t reads[2] = {0};
+    uint32_t done = 0;
+    uint cur = 0;
+
+    swd_error_t err = read_start(target, &reads[0], addr, bufs[0] + offset,
+                                 count < chunk ? count : chunk);
+
+    while (err == SWD_OK && done < count) {
+        uint32_t words = reads[cur].count;
+        err = read_finish(target, &reads[cur]);
+        if (err != SWD_OK) {
+            break;
+        }
+        done += words;
+
+        // The next read overlaps with encoding and the sink
+        uint32_t remaining = count - done;
+        if (remaining > 0) {
+            err = read_start(target, &reads[cur ^ 1], addr + (done * 4),
+                             bufs[cur ^ 1] + offset, remaining < chunk ? remaining : chunk);
+            if (err != SWD_OK) {
+                break;
+            }
+        }
+
+        uint32_t out = rle ? rle_encode(bufs[cur], words) : words;
+        if (stats) {
+            stats->bytes_read += words * 4;
+            stats->bytes_sent += out * 4;
+            stats->chunks++;
+        }
+
+        err = sink((const uint8_t *)bufs[cur], out * 4, ctx);
+        cur ^= 1;
+    }
+
+    // A read still in flight after an error must finish before its buffer goes
+    for (uint i = 0; i < 2; i++) {
+        if (reads[i].pending) {
+            swd_async_cancel(target, reads[i].handle);
+            read_finish(target, &reads[i]);
+        }
+    }
+
+    if (err != SWD_OK) {
+        SWD_WARN("Dump stopped at 0x%08lx: %s\n", (unsigned long)(addr + (done * 4)),
+                 swd_error_string(err));
+    }
+    return err;
+}
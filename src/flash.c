@@ -0,0 +1,564 @@
+/**
+ * @file flash.c
+ * @brief Double-buffered flash programming through a resident algorithm
+ *
+ * The work area holds the routine, a mailbox, its stack and two sector
+ * buffers. Each mailbox slot is {state, op, offset, length, buffer,
+ * result}; the host fills a FREE or DONE slot and sets it READY last, the
+ * routine sets it DONE with the sector's CRC in result. The routine takes
+ * slots in turn, starting from slot 0, so the host submits in the same
+ * order and always has one slot to fill while the other is busy.
+ *
+ * The bootrom functions are looked up by calling the ROM table lookup on
+ * the hart, and their addresses handed to the routine in the mailbox.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico2-swd-riscv/flash.h"
+#include "pico2-swd-riscv/rp2350.h"
+#include "pico2-swd-riscv/swd.h"
+#include "internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//==============================================================================
+// Resident Algorithm
+//==============================================================================
+
+// Entered with a0 = mailbox. Calls connect_internal_flash, flash_exit_xip,
+// flash_flush_cache and flash_enter_cmd_xip once so XIP reads work, then
+// serves slots until OP_EXIT and returns. Programming a sector erases it,
+// programs it, re-enters XIP and CRCs the whole sector, like OP_CRC. CRCs
+// read through the uncached, untranslated XIP alias.
+static const uint32_t flash_routine[] = {
+    0xfe010113,  //   0: addi sp, sp, -32
+    0x00112e23,  //   4: sw   ra, 28(sp)
+    0x00812c23,  //   8: sw   s0, 24(sp)
+    0x01212a23,  //  12: sw   s2, 20(sp)
+    0x01312823,  //  16: sw   s3, 16(sp)
+    0x00050413,  //  20: mv   s0, a0
+    0x01840913,  //  24: addi s2, s0, 24      s2 = this slot, s3 = other
+    0x03040993,  //  28: addi s3, s0, 48
+    0x00042283,  //  32: lw   t0, 0(s0)
+    0x000280e7,  //  36: jalr t0
+    0x00442283,  //  40: lw   t0, 4(s0)
+    0x000280e7,  //  44: jalr t0
+    0x01042283,  //  48: lw   t0, 16(s0)
+    0x000280e7,  //  52: jalr t0
+    0x01442283,  //  56: lw   t0, 20(s0)
+    0x000280e7,  //  60: jalr t0
+    0x00092303,  //  64: lw   t1, 0(s2)       wait for READY
+    0x00100393,  //  68: li   t2, 1
+    0xfe731ce3,  //  72: bne  t1, t2, 64
+    0x0ff0000f,  //  76: fence
+    0x00492303,  //  80: lw   t1, 4(s2)
+    0x00300393,  //  84: li   t2, 3
+    0x0c730e63,  //  88: beq  t1, t2, 308     OP_EXIT
+    0x00200393,  //  92: li   t2, 2
+    0x04730c63,  //  96: beq  t1, t2, 184     OP_CRC
+    0x00042283,  // 100: lw   t0, 0(s0)
+    0x000280e7,  // 104: jalr t0
+    0x00442283,  // 108: lw   t0, 4(s0)
+    0x000280e7,  // 112: jalr t0
+    0x00892503,  // 116: lw   a0, 8(s2)
+    0x000015b7,  // 120: lui  a1, 1
+    0x00001637,  // 124: lui  a2, 1
+    0x02000693,  // 128: li   a3, 0x20
+    0x00842283,  // 132: lw   t0, 8(s0)
+    0x000280e7,  // 136: jalr t0              flash_range_erase(offset, 4096, 4096, 0x20)
+    0x00892503,  // 140: lw   a0, 8(s2)
+    0x01092583,  // 144: lw   a1, 16(s2)
+    0x00c92603,  // 148: lw   a2, 12(s2)
+    0x00c42283,  // 152: lw   t0, 12(s0)
+    0x000280e7,  // 156: jalr t0              flash_range_program(offset, buffer, length)
+    0x01042283,  // 160: lw   t0, 16(s0)
+    0x000280e7,  // 164: jalr t0
+    0x01442283,  // 168: lw   t0, 20(s0)
+    0x000280e7,  // 172: jalr t0
+    0x40000593,  // 176: li   a1, 1024         CRC the whole sector
+    0x00c0006f,  // 180: j    192
+    0x00c92583,  // 184: lw   a1, 12(s2)
+    0x0025d593,  // 188: srli a1, a1, 2
+    0x00892503,  // 192: lw   a0, 8(s2)
+    0x1c0002b7,  // 196: lui  t0, 0x1c000
+    0x00550533,  // 200: add  a0, a0, t0       untranslated XIP alias
+    0xedb88637,  // 204: lui  a2, 0xedb88
+    0x32060613,  // 208: addi a2, a2, 0x320   a2 = 0xEDB88320
+    0xfff00693,  // 212: li   a3, -1
+    0x02058c63,  // 216: beqz a1, 272
+    0x00052703,  // 220: lw   a4, 0(a0)
+    0x00e6c6b3,  // 224: xor  a3, a3, a4
+    0x02000793,  // 228: li   a5, 32
+    0x0016f293,  // 232: andi t0, a3, 1
+    0x0016d693,  // 236: srli a3, a3, 1
+    0x405002b3,  // 240: neg  t0, t0
+    0x00c2f2b3,  // 244: and  t0, t0, a2
+    0x0056c6b3,  // 248: xor  a3, a3, t0
+    0xfff78793,  // 252: addi a5, a5, -1
+    0xfe0794e3,  // 256: bnez a5, 232
+    0x00450513,  // 260: addi a0, a0, 4
+    0xfff58593,  // 264: addi a1, a1, -1
+    0xfcdff06f,  // 268: j    216
+    0xfff6c513,  // 272: not  a0, a3
+    0x00a92a23,  // 276: sw   a0, 20(s2)      result = crc
+    0x0ff0000f,  // 280: fence
+    0x00200313,  // 284: li   t1, 2
+    0x00692023,  // 288: sw   t1, 0(s2)       DONE; swap slots
+    0x00090293,  // 292: mv   t0, s2
+    0x00098913,  // 296: mv   s2, s3
+    0x00028993,  // 300: mv   s3, t0
+    0xf11ff06f,  // 304: j    64
+    0x0ff0000f,  // 308: fence
+    0x00200313,  // 312: li   t1, 2
+    0x00692023,  // 316: sw   t1, 0(s2)
+    0x01c12083,  // 320: lw   ra, 28(sp)
+    0x01812403,  // 324: lw   s0, 24(sp)
+    0x01412903,  // 328: lw   s2, 20(sp)
+    0x01012983,  // 332: lw   s3, 16(sp)
+    0x02010113,  // 336: addi sp, sp, 32
+    0x00008067,  // 340: ret
+};
+
+#define FLASH_ROUTINE_WORDS (sizeof(flash_routine) / sizeof(flash_routine[0]))
+
+// Work area layout
+#define WORK_MAILBOX   0x200
+#define WORK_TRAP      0x250
+#define WORK_STACK_TOP 0x800
+#define WORK_BUFFER(slot) (0x800 + ((slot) * RP2350_FLASH_SECTOR_SIZE))
+
+// Mailbox: bootrom function pointers, then the two slots
+#define MAILBOX_FUNCS  6
+#define MAILBOX_SLOT(slot) (24 + ((slot) * 24))
+#define SLOT_STATE     0
+#define SLOT_OP        4
+#define SLOT_RESULT    20
+#define SLOT_WORDS     6
+
+#define SLOT_FREE      0
+#define SLOT_READY     1
+#define SLOT_DONE      2
+
+#define OP_PROGRAM     1
+#define OP_CRC         2
+#define OP_EXIT        3
+
+// Bootrom: halfword pointer to the RISC-V ROM table lookup, and its flag
+// for RISC-V functions
+#define BOOTROM_TABLE_LOOKUP_ENTRY 0x7dfa
+#define RT_FLAG_FUNC_RISCV         0x0001
+#define ROM_TABLE_CODE(c1, c2)     ((uint32_t)(c1) | ((uint32_t)(c2) << 8))
+
+// Flash on one chip select
+#define FLASH_MAX_SIZE (16u * 1024 * 1024)
+
+#define FLASH_PAGE_SIZE 256
+
+#define FLASH_LOOKUP_TIMEOUT_MS 100
+#define FLASH_EXIT_TIMEOUT_MS   100
+
+// One sector erase and program, or a CRC through serial XIP, with margin
+// for slow parts
+#define FLASH_OP_TIMEOUT_MS     2000
+
+// In mailbox order
+static const uint32_t flash_func_codes[MAILBOX_FUNCS] = {
+    ROM_TABLE_CODE('I', 'F'),  // connect_internal_flash
+    ROM_TABLE_CODE('E', 'X'),  // flash_exit_xip
+    ROM_TABLE_CODE('R', 'E'),  // flash_range_erase
+    ROM_TABLE_CODE('R', 'P'),  // flash_range_program
+    ROM_TABLE_CODE('F', 'C'),  // flash_flush_cache
+    ROM_TABLE_CODE('C', 'X'),  // flash_enter_cmd_xip
+};
+
+typedef struct {
+    swd_target_t *target;
+    uint8_t hart_id;
+    uint32_t work;
+    uint next;                  // Slot the routine takes next
+    bool busy[2];
+    uint32_t sector[2];         // Image sector each busy slot holds
+
+    uint32_t offset;
+    const uint8_t *data;
+    uint32_t len;
+    uint32_t sectors;
+    uint32_t *dirty;            // Bitmap of sectors that need programming
+    uint32_t done;
+    rp2350_flash_progress_t progress;
+    void *ctx;
+    rp2350_flash_stats_t stats;
+} flash_job_t;
+
+//==============================================================================
+// Image Sectors
+//==============================================================================
+
+/**
+ * @brief CRC-32 of what a sector should hold: its image bytes, then 0xFF
+ */
+static uint32_t sector_crc(const flash_job_t *job, uint32_t sector) {
+    uint32_t start = sector * RP2350_FLASH_SECTOR_SIZE;
+    uint32_t n = job->len - start;
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < RP2350_FLASH_SECTOR_SIZE; i++) {
+        crc ^= i < n ? job->data[start + i] : 0xFF;
+        for (uint bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Copy a sector into a slot's buffer, padded to whole pages
+ */
+static swd_error_t stage_sector(flash_job_t *job, uint slot, uint32_t sector,
+                                uint32_t *length) {
+    uint32_t start = sector * RP2350_FLASH_SECTOR_SIZE;
+    uint32_t n = job->len - start;
+    if (n > RP2350_FLASH_SECTOR_SIZE) {
+        n = RP2350_FLASH_SECTOR_SIZE;
+    }
+    uint32_t buffer = job->work + WORK_BUFFER(slot);
+
+    swd_error_t err = rp2350_write_bytes(job->target, buffer, job->data + start, n);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    *length = (n + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1);
+    if (*length > n) {
+        uint8_t pad[FLASH_PAGE_SIZE];
+        memset(pad, 0xFF, sizeof(pad));
+        err = rp2350_write_bytes(job->target, buffer + n, pad, *length - n);
+    }
+    return err;
+}
+
+static void sector_finished(flash_job_t *job) {
+    job->done++;
+    if (job->progress) {
+        job->progress(job->done, job->sectors, job->ctx);
+    }
+}
+
+//==============================================================================
+// Mailbox
+//==============================================================================
+
+static uint32_t slot_addr(const flash_job_t *job, uint slot) {
+    return job->work + WORK_MAILBOX + MAILBOX_SLOT(slot);
+}
+
+/**
+ * @brief Hand the next slot to the routine
+ */
+static swd_error_t slot_submit(flash_job_t *job, uint32_t op, uint32_t sector,
+                               uint32_t length) {
+    uint slot = job->next;
+    uint32_t addr = slot_addr(job, slot);
+    const uint32_t desc[SLOT_WORDS - 1] = {
+        op,
+        job->offset + (sector * RP2350_FLASH_SECTOR_SIZE),
+        length,
+        job->work + WORK_BUFFER(slot),
+        0,
+    };
+
+    // SBA writes land in order, so the routine sees the fields before READY
+    swd_error_t err = rp2350_write_mem_block(job->target, addr + SLOT_OP, desc, SLOT_WORDS - 1);
+    if (err == SWD_OK) {
+        err = rp2350_write_mem32(job->target, addr + SLOT_STATE, SLOT_READY);
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    job->busy[slot] = true;
+    job->sector[slot] = sector;
+    job->next ^= 1;
+    return SWD_OK;
+}
+
+/**
+ * @brief Wait for the routine to finish a slot and fetch its CRC
+ */
+static swd_error_t slot_wait(flash_job_t *job, uint slot, uint32_t *crc) {
+    swd_target_t *target = job->target;
+    uint32_t addr = slot_addr(job, slot);
+
+    swd_poll_t poll;
+    swd_poll_begin(target, &poll, SWD_WAIT_CALL);
+    poll.timeout_us = FLASH_OP_TIMEOUT_MS * 1000;
+    do {
+        swd_result_t state = rp2350_read_mem32(target, addr + SLOT_STATE);
+        if (state.error != SWD_OK) {
+            return state.error;
+        }
+        if (state.value == SLOT_DONE) {
+            swd_poll_end(target, &poll, true);
+            swd_result_t result = rp2350_read_mem32(target, addr + SLOT_RESULT);
+            *crc = result.value;
+            job->busy[slot] = false;
+            return result.error;
+        }
+    } while (swd_poll_again(target, &poll));
+
+    swd_poll_end(target, &poll, false);
+    swd_set_error(target, SWD_ERROR_TIMEOUT,
+                 "Flash engine did not finish sector at 0x%08x within %u ms",
+                 job->offset + (job->sector[slot] * RP2350_FLASH_SECTOR_SIZE),
+                 FLASH_OP_TIMEOUT_MS);
+    return SWD_ERROR_TIMEOUT;
+}
+
+static bool sector_dirty(const flash_job_t *job, uint32_t sector) {
+    return (job->dirty[sector / 32] >> (sector % 32)) & 1;
+}
+
+/**
+ * @brief Run one op over the image's sectors, two slots in flight
+ *
+ * OP_CRC visits every sector and marks those that differ; OP_PROGRAM
+ * visits the marked ones, staging each into the free buffer while the
+ * routine works on the other.
+ */
+static swd_error_t flash_pass(flash_job_t *job, uint32_t op) {
+    uint32_t sector = 0;
+
+    for (;;) {
+        while (op == OP_PROGRAM && sector < job->sectors && !sector_dirty(job, sector)) {
+            sector++;
+        }
+
+        // Once out of sectors, drain both slots; the routine's next slot
+        // stays job->next
+        bool draining = sector == job->sectors;
+        uint slot = job->next;
+        if (draining && !job->busy[slot]) {
+            slot ^= 1;
+        }
+
+        if (job->busy[slot]) {
+            uint32_t crc;
+            swd_error_t err = slot_wait(job, slot, &crc);
+            if (err != SWD_OK) {
+                return err;
+            }
+
+            uint32_t held = job->sector[slot];
+            uint32_t expected = sector_crc(job, held);
+            if (op == OP_CRC && crc != expected) {
+                job->dirty[held / 32] |= 1u << (held % 32);
+            } else if (op == OP_CRC) {
+                job->stats.sectors_skipped++;
+                sector_finished(job);
+            } else if (crc != expected) {
+                swd_set_error(job->target, SWD_ERROR_VERIFY,
+                             "Flash sector at 0x%08x reads back CRC 0x%08x, expected 0x%08x",
+                             job->offset + (held * RP2350_FLASH_SECTOR_SIZE), crc, expected);
+                return SWD_ERROR_VERIFY;
+            } else {
+                job->stats.sectors_written++;
+                sector_finished(job);
+            }
+        }
+
+        if (draining) {
+            if (!job->busy[0] && !job->busy[1]) {
+                return SWD_OK;
+            }
+            continue;
+        }
+
+        uint32_t length = RP2350_FLASH_SECTOR_SIZE;
+        swd_error_t err = op == OP_PROGRAM ? stage_sector(job, slot, sector, &length) : SWD_OK;
+        if (err == SWD_OK) {
+            err = slot_submit(job, op, sector, length);
+        }
+        if (err != SWD_OK) {
+            return err;
+        }
+        sector++;
+    }
+}
+
+//==============================================================================
+// Engine Setup
+//==============================================================================
+
+/**
+ * @brief Look up the bootrom flash functions, into the mailbox's first words
+ */
+static swd_error_t lookup_flash_funcs(flash_job_t *job, uint32_t *funcs) {
+    swd_target_t *target = job->target;
+
+    swd_result_t lookup = rp2350_read_mem16(target, BOOTROM_TABLE_LOOKUP_ENTRY);
+    if (lookup.error != SWD_OK) {
+        return lookup.error;
+    }
+
+    for (uint i = 0; i < MAILBOX_FUNCS; i++) {
+        const uint32_t args[2] = {flash_func_codes[i], RT_FLAG_FUNC_RISCV};
+        rp2350_call_frame_t frame;
+        swd_error_t err = rp2350_call_enter(target, job->hart_id, lookup.value, args, 2,
+                                            job->work + WORK_TRAP,
+                                            job->work + WORK_STACK_TOP, &frame);
+        if (err != SWD_OK) {
+            return err;
+        }
+
+        err = rp2350_call_wait(target, job->hart_id, FLASH_LOOKUP_TIMEOUT_MS);
+        swd_result_t func = {.error = err, .value = 0};
+        if (err == SWD_OK) {
+            func = rp2350_read_reg(target, job->hart_id, 10);  // a0
+        }
+
+        err = rp2350_call_leave(target, job->hart_id, &frame);
+        if (func.error != SWD_OK) {
+            return func.error;
+        }
+        if (err != SWD_OK) {
+            return err;
+        }
+
+        if (func.value == 0) {
+            swd_set_error(target, SWD_ERROR_INVALID_STATE,
+                         "Bootrom has no flash function '%c%c'",
+                         flash_func_codes[i] & 0xFF, flash_func_codes[i] >> 8);
+            return SWD_ERROR_INVALID_STATE;
+        }
+        funcs[i] = func.value;
+    }
+    return SWD_OK;
+}
+
+/**
+ * @brief Look up the functions, load the routine and mailbox, start it
+ */
+static swd_error_t engine_start(flash_job_t *job, rp2350_call_frame_t *frame) {
+    uint32_t mailbox[MAILBOX_FUNCS + (2 * SLOT_WORDS)] = {0};  // Slots FREE
+
+    swd_error_t err = lookup_flash_funcs(job, mailbox);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = rp2350_upload_image(job->target, job->hart_id, job->work, flash_routine,
+                              FLASH_ROUTINE_WORDS, RP2350_VERIFY_READBACK);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = rp2350_write_mem_block(job->target, job->work + WORK_MAILBOX, mailbox,
+                                 sizeof(mailbox) / sizeof(mailbox[0]));
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    const uint32_t args[1] = {job->work + WORK_MAILBOX};
+    return rp2350_call_enter(job->target, job->hart_id, job->work, args, 1,
+                             job->work + WORK_TRAP, job->work + WORK_STACK_TOP, frame);
+}
+
+/**
+ * @brief Tell the routine to return and wait for it
+ */
+static swd_error_t engine_stop(flash_job_t *job) {
+    swd_error_t err = slot_submit(job, OP_EXIT, 0, 0);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = rp2350_call_wait(job->target, job->hart_id, FLASH_EXIT_TIMEOUT_MS);
+    if (err == SWD_ERROR_TIMEOUT) {
+        swd_set_error(job->target, err, "Flash engine did not exit within %u ms",
+                     FLASH_EXIT_TIMEOUT_MS);
+    }
+    return err;
+}
+
+//==============================================================================
+// Flash Programming
+//==============================================================================
+
+swd_error_t rp2350_flash_program(swd_target_t *target, uint8_t hart_id, uint32_t work_addr,
+                                 uint32_t offset, const uint8_t *data, uint32_t len,
+                                 rp2350_flash_progress_t progress, void *ctx,
+                                 rp2350_flash_stats_t *stats) {
+    if (!target || !data || len == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (offset >= FLASH_MAX_SIZE || len > FLASH_MAX_SIZE - offset) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM,
+                     "Flash range 0x%08x+%u exceeds %u MB", offset, len,
+                     FLASH_MAX_SIZE >> 20);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if ((offset % RP2350_FLASH_SECTOR_SIZE) || (work_addr & 0xF)) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    flash_job_t job = {
+        .target = target,
+        .hart_id = hart_id,
+        .work = work_addr,
+        .offset = offset,
+        .data = data,
+        .len = len,
+        .sectors = (len + RP2350_FLASH_SECTOR_SIZE - 1) / RP2350_FLASH_SECTOR_SIZE,
+        .progress = progress,
+        .ctx = ctx,
+    };
+
+    job.dirty = calloc((job.sectors + 31) / 32, sizeof(uint32_t));
+    if (!job.dirty) {
+        swd_set_error(target, SWD_ERROR_NO_MEMORY, "Failed to allocate sector map");
+        return SWD_ERROR_NO_MEMORY;
+    }
+
+    SWD_INFO("Flashing %lu bytes at offset 0x%08lx via hart%u...\n",
+             (unsigned long)len, (unsigned long)offset, hart_id);
+
+    rp2350_call_frame_t frame;
+    swd_error_t err = engine_start(&job, &frame);
+    if (err == SWD_OK) {
+        err = flash_pass(&job, OP_CRC);
+        if (err == SWD_OK) {
+            err = flash_pass(&job, OP_PROGRAM);
+        }
+        if (err == SWD_OK) {
+            err = engine_stop(&job);
+        }
+
+        // Halts the hart if the routine is still running
+        swd_error_t restore = rp2350_call_leave(target, hart_id, &frame);
+        if (err == SWD_OK) {
+            err = restore;
+        }
+    }
+
+    free(job.dirty);
+
+    if (stats) {
+        *stats = job.stats;
+    }
+
+    if (err == SWD_OK) {
+        SWD_INFO("Flash complete: %lu sectors written, %lu skipped\n",
+                 (unsigned long)job.stats.sectors_written,
+                 (unsigned long)job.stats.sectors_skipped);
+    }
+    return err;
+}
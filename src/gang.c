@@ -0,0 +1,157 @@
+/**
+ * @file gang.c
+ * @brief Lockstep operations on several targets
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico2-swd-riscv/gang.h"
+#include "pico2-swd-riscv/rp2350.h"
+#include "pico2-swd-riscv/swd.h"
+#include "internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool gang_valid(swd_target_t *const *targets, uint count, const swd_error_t *results) {
+    return targets && results && count > 0 && count <= SWD_GANG_MAX_TARGETS;
+}
+
+//==============================================================================
+// Gang Operations
+//==============================================================================
+
+swd_error_t swd_gang_connect(swd_target_t *const *targets, uint count, swd_error_t *results) {
+    if (!gang_valid(targets, count, results)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    for (uint i = 0; i < count; i++) {
+        if (results[i] == SWD_OK) {
+            results[i] = targets[i] ? swd_connect(targets[i]) : SWD_ERROR_INVALID_PARAM;
+        }
+    }
+
+    return swd_gang_first_error(results, count);
+}
+
+swd_error_t swd_gang_rp2350_init(swd_target_t *const *targets, uint count,
+                                 swd_error_t *results) {
+    if (!gang_valid(targets, count, results)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    return rp2350_gang_init(targets, count, results);
+}
+
+swd_error_t swd_gang_upload(swd_target_t *const *targets, uint count, uint32_t addr,
+                            const uint32_t *code, uint32_t word_count, swd_error_t *results) {
+    if (!gang_valid(targets, count, results) || !code || word_count == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    SWD_INFO("Gang uploading %lu words to 0x%08lx on %u targets...\n",
+             (unsigned long)word_count, (unsigned long)addr, count);
+
+    return rp2350_gang_write_mem_block(targets, count, addr, code, word_count, results);
+}
+
+swd_error_t swd_gang_verify(swd_target_t *const *targets, uint count, uint32_t addr,
+                            const uint32_t *code, uint32_t word_count, swd_error_t *results) {
+    if (!gang_valid(targets, count, results) || !code || word_count == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t *readback = malloc(count * SBA_BATCH_CHUNK_WORDS * sizeof(uint32_t));
+    if (!readback) {
+        return SWD_ERROR_NO_MEMORY;
+    }
+
+    uint32_t *buffers[SWD_GANG_MAX_TARGETS];
+    for (uint i = 0; i < count; i++) {
+        buffers[i] = &readback[i * SBA_BATCH_CHUNK_WORDS];
+    }
+
+    for (uint32_t done = 0; done < word_count; done += SBA_BATCH_CHUNK_WORDS) {
+        uint32_t n = word_count - done < SBA_BATCH_CHUNK_WORDS ? word_count - done
+                                                              : SBA_BATCH_CHUNK_WORDS;
+        rp2350_gang_read_mem_block(targets, count, addr + (done * 4), buffers, n, results);
+
+        for (uint i = 0; i < count; i++) {
+            if (results[i] != SWD_OK) {
+                continue;
+            }
+            for (uint32_t w = 0; w < n; w++) {
+                if (buffers[i][w] != code[done + w]) {
+                    swd_set_error(targets[i], SWD_ERROR_VERIFY,
+                                 "Verification failed at word %u: wrote 0x%08x, read 0x%08x",
+                                 done + w, code[done + w], buffers[i][w]);
+                    results[i] = SWD_ERROR_VERIFY;
+                    break;
+                }
+            }
+        }
+
+        // Stop early once every target has failed
+        bool any = false;
+        for (uint i = 0; i < count; i++) {
+            any |= (results[i] == SWD_OK);
+        }
+        if (!any) {
+            break;
+        }
+    }
+
+    free(readback);
+    return swd_gang_first_error(results, count);
+}
+
+swd_error_t swd_gang_execute(swd_target_t *const *targets, uint count, uint8_t hart_id,
+                             uint32_t entry_point, swd_error_t *results) {
+    if (!gang_valid(targets, count, results)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    // Halt if needed
+    for (uint i = 0; i < count; i++) {
+        if (results[i] != SWD_OK) {
+            continue;
+        }
+        if (!targets[i]) {
+            results[i] = SWD_ERROR_INVALID_PARAM;
+            continue;
+        }
+        swd_error_t err = rp2350_halt(targets[i], hart_id);
+        results[i] = (err == SWD_ERROR_ALREADY_HALTED) ? SWD_OK : err;
+    }
+
+    // Set PC
+    for (uint i = 0; i < count; i++) {
+        if (results[i] == SWD_OK) {
+            results[i] = rp2350_write_pc(targets[i], hart_id, entry_point);
+        }
+    }
+
+    // Verify PC
+    for (uint i = 0; i < count; i++) {
+        if (results[i] != SWD_OK) {
+            continue;
+        }
+        swd_result_t pc = rp2350_read_pc(targets[i], hart_id);
+        if (pc.error != SWD_OK || pc.value != entry_point) {
+            swd_set_error(targets[i], SWD_ERROR_VERIFY,
+                         "PC verification failed: expected 0x%08x, got 0x%08x",
+                         entry_point, pc.value);
+            results[i] = SWD_ERROR_VERIFY;
+        }
+    }
+
+    // Resume
+    for (uint i = 0; i < count; i++) {
+        if (results[i] == SWD_OK) {
+            results[i] = rp2350_resume(targets[i], hart_id);
+        }
+    }
+
+    return swd_gang_first_error(results, count);
+}
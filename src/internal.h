@@ -10,6 +10,8 @@
 #define PICO2_SWD_RISCV_INTERNAL_H
 
 #include "pico2-swd-riscv/types.h"
+#include "pico2-swd-riscv/gang.h"
+#include "pico2-swd-riscv/async.h"
 #include "hardware/pio.h"
 //==============================================================================
 // Debug Logging
@@ -37,6 +39,27 @@
 #define SWD_WARN(fmt, ...) ((void)0)
 #endif
 
+//==============================================================================
+// Statistics
+//==============================================================================
+
+#ifndef PICO2_SWD_STATS
+#define PICO2_SWD_STATS 0
+#endif
+
+// Compiled out entirely unless PICO2_SWD_STATS is set: no struct field, no
+// timer reads. SWD_STAT_START declares the timestamp SWD_STAT_LATENCY uses.
+#if PICO2_SWD_STATS
+#define SWD_STAT_ADD(target, field, n) ((target)->stats.field += (n))
+#define SWD_STAT_START(var) uint32_t var = time_us_32()
+#define SWD_STAT_LATENCY(target, op, start) swd_stats_latency((target), (op), (start))
+#else
+#define SWD_STAT_ADD(target, field, n) ((void)0)
+#define SWD_STAT_START(var) ((void)0)
+#define SWD_STAT_LATENCY(target, op, start) ((void)0)
+#endif
+#define SWD_STAT_INC(target, field) SWD_STAT_ADD(target, field, 1)
+
 //==============================================================================
 // SWD Protocol Constants
 //==============================================================================
@@ -44,6 +67,25 @@
 #define SWD_TURNAROUND_CYCLES 1
 #define SWD_IDLE_CYCLES 8
 
+// DP_CTRL_STAT bits
+#define CTRL_STAT_ORUNDETECT    (1u << 0)
+#define CTRL_STAT_STICKYORUN    (1u << 1)
+#define CTRL_STAT_STICKYCMP     (1u << 4)
+#define CTRL_STAT_STICKYERR     (1u << 5)
+#define CTRL_STAT_WDATAERR      (1u << 7)
+#define CTRL_STAT_CDBGPWRUPREQ  (1u << 28)
+#define CTRL_STAT_CDBGPWRUPACK  (1u << 29)
+#define CTRL_STAT_CSYSPWRUPREQ  (1u << 30)
+#define CTRL_STAT_CSYSPWRUPACK  (1u << 31)
+#define CTRL_STAT_PWRUPACK      (CTRL_STAT_CDBGPWRUPACK | CTRL_STAT_CSYSPWRUPACK)
+
+// DP_ABORT bits (SW-DP clears sticky flags here, not in CTRL_STAT)
+#define ABORT_DAPABORT          (1u << 0)
+#define ABORT_STKCMPCLR         (1u << 1)
+#define ABORT_STKERRCLR         (1u << 2)
+#define ABORT_WDERRCLR          (1u << 3)
+#define ABORT_ORUNERRCLR        (1u << 4)
+
 //==============================================================================
 // DAP State
 //==============================================================================
@@ -55,13 +97,157 @@ typedef struct {
     bool ctrlsel;
     uint32_t select_cache;  // Last DP_SELECT value written
 
+    // MEM-AP TAR shadow (RISC-V APB-AP; CSW is never left incrementing)
+    uint32_t tar_cache;
+    bool tar_valid;
+    bool csw_dirty;         // A failed block left CSW unknown; rewritten on next select
+
     // Power state
     bool powered;
+    bool orundetect;        // CTRL_STAT.ORUNDETECT set: data phase follows WAIT/FAULT
+
+    // Posted writes: DRW writes not yet confirmed through CTRL_STAT
+    uint32_t posted_count;
+    uint32_t posted_first;  // Address of the first unconfirmed write
+    uint32_t posted_last;   // Address of the last unconfirmed write
 
     // Configuration
     uint retry_count;
+    bool posted_writes;     // dap_write_mem32() skips the RDBUFF completion read
 } dap_state_t;
 
+//==============================================================================
+// SWD Transaction Batch
+//==============================================================================
+
+// Maximum queued operations before swd_batch_queue_*() flushes implicitly
+#define SWD_BATCH_MAX_OPS 64
+
+// Words per SBA chunk that fits one batch (count + 15 ops for a read), so
+// the chunk streams as a single run without implicit flushes
+#define SBA_BATCH_CHUNK_WORDS 48
+
+// FIFO words for the largest op (write): request cmd + byte, ACK cmd,
+// data cmd + word, parity cmd + bit
+#define SWD_OP_MAX_TX_WORDS 7
+// RX words for the largest op (read): ACK, data, parity
+#define SWD_OP_MAX_RX_WORDS 3
+
+/**
+ * @brief One queued DP/AP transaction
+ */
+typedef struct {
+    uint8_t request;    // SWD request byte (make_swd_request)
+    uint32_t value;     // Write data
+    uint32_t *dest;     // Read destination (NULL discards the value)
+} swd_op_t;
+
+/**
+ * @brief Progress of one op list through one state machine
+ */
+typedef struct {
+    const swd_op_t *ops;
+    uint count;
+    uint32_t tx[SWD_OP_MAX_TX_WORDS];
+    uint32_t rx[SWD_OP_MAX_RX_WORDS];
+    uint tx_len, tx_pos, rx_pos;
+    uint issued;        // Ops whose commands have been (or are being) pushed
+    uint done;          // Ops whose RX words have been consumed
+    bool stop;          // An op failed; issue nothing more
+    uint failed;        // Index of the failed op (count if none)
+    swd_error_t err;
+} op_stream_t;
+
+typedef struct {
+    swd_op_t ops[SWD_BATCH_MAX_OPS];
+    uint count;
+    uint flushed;       // Ops already executed by implicit flushes
+    bool active;
+    swd_error_t error;  // First error since swd_batch_begin()
+
+    // swd_batch_start() in progress: ops stream from poll calls
+    bool started;
+    bool dma_started;   // On the DMA channels rather than 'stream'
+    op_stream_t stream;
+
+    // What the queued ops may have changed behind the DAP/RP2350 shadows
+    bool select_dirty;      // A DP_SELECT write was queued
+    bool tar_dirty;         // TAR may have changed
+    bool dm_dirty;          // A shadowed DM register may have been written
+    bool tar_known;         // Last queued TAR write is 'tar'
+    uint32_t tar;
+} swd_batch_t;
+
+//==============================================================================
+// Asynchronous Requests
+//==============================================================================
+
+typedef struct {
+    swd_async_handle_t handle;
+    bool write;
+    bool cancelled;
+    uint32_t addr;
+    uint32_t *buffer;       // const for writes
+    uint32_t count;
+    uint32_t done;          // Words transferred
+    uint32_t chunk;         // Words in the chunk on the wire
+    uint32_t sbcs;          // SBCS read back by that chunk
+    swd_async_cb_t cb;
+    void *ctx;
+} swd_async_req_t;
+
+typedef struct {
+    swd_async_req_t queue[SWD_ASYNC_MAX_INFLIGHT];  // Oldest first
+    uint count;
+    bool running;           // queue[0] has a chunk on the wire
+    bool in_callback;       // A completion callback is running
+    swd_async_handle_t next_handle;
+    swd_async_handle_t wait_handle;     // Request swd_wait() is blocked on
+    swd_error_t wait_result;
+} swd_async_t;
+
+//==============================================================================
+// DMA Backend
+//==============================================================================
+
+// Ops encoded per DMA run, and the shortest stream worth the channel setup
+#define SWD_DMA_MAX_OPS 64
+#define SWD_DMA_MIN_OPS 8
+
+/**
+ * @brief DMA channels and buffers for streamed transactions
+ *
+ * tx_buf holds the prebuilt command/data words for one run, rx_buf
+ * receives the raw ACK/data words. Only the RX channel raises an
+ * interrupt: it finishes after the last transaction on the wire.
+ */
+typedef struct {
+    int tx_chan;
+    int rx_chan;
+    volatile bool busy;     // Cleared by the completion IRQ
+    uint32_t tx_buf[SWD_DMA_MAX_OPS * SWD_OP_MAX_TX_WORDS];
+    uint32_t rx_buf[SWD_DMA_MAX_OPS * SWD_OP_MAX_RX_WORDS];
+} swd_dma_t;
+
+//==============================================================================
+// Polling
+//==============================================================================
+
+/**
+ * @brief One wait in progress (see swd_poll_policy_t)
+ *
+ * Usage: swd_poll_begin(), then after each unmet check call
+ * swd_poll_again(), which delays per the policy and returns false at the
+ * deadline. swd_poll_end() records the wait in the target's counters.
+ */
+typedef struct {
+    swd_wait_t kind;
+    uint32_t polls;         // Unmet checks so far
+    uint32_t delay_us;      // Next backoff delay
+    uint64_t deadline;      // time_us_64() limit, set on the first unmet check
+    uint32_t timeout_us;    // From the policy; a caller may change it after begin
+} swd_poll_t;
+
 //==============================================================================
 // Per-Hart State
 //==============================================================================
@@ -72,16 +258,36 @@ typedef struct {
  * RP2350 has 2 RISC-V harts (hardware threads). Each hart maintains
  * independent execution state, registers, and cache.
  */
+// CSRs held by the register cache (listed in rp2350.c)
+#define RP2350_CACHED_CSRS 6
+
+// Trigger slots tracked per hart; Hazard3 on RP2350 has 4
+#define RP2350_MAX_TRIGGERS 8
+
 typedef struct {
     // Halt state
     bool halt_state_known;  // false after resume, true after halt/read status
     bool halted;            // true if hart is currently halted
 
-    // Register cache
-    bool cache_valid;       // true if cached values are current
-    uint32_t cached_pc;
+    // Register cache, write-back: dirty entries reach the hart before it
+    // runs again. One bit per register in each mask.
+    uint32_t gpr_valid;     // Holds the program's current value
+    uint32_t gpr_dirty;     // Written but not yet on the hart
     uint32_t cached_gprs[32];
-    uint64_t cache_timestamp;  // For LRU if needed
+    uint8_t csr_valid;
+    uint8_t csr_dirty;
+    uint32_t cached_csrs[RP2350_CACHED_CSRS];
+
+    // s0 borrowed as program buffer scratch; restored before resume
+    bool scratch_held;
+    uint32_t scratch_s0;    // The program's s0 while scratch_held
+
+    // Trigger module, probed on first use
+    bool triggers_probed;
+    uint8_t trigger_count;  // Usable mcontrol triggers
+    uint8_t trigger_used;   // One bit per trigger armed by this library
+    uint32_t trigger_tdata1[RP2350_MAX_TRIGGERS];
+    uint32_t trigger_addr[RP2350_MAX_TRIGGERS];
 } hart_state_t;
 
 //==============================================================================
@@ -90,10 +296,28 @@ typedef struct {
 
 #define RP2350_NUM_HARTS 2
 
+// Debug Module registers shadowed by the RP2350 layer
+#define RP2350_DM_DMCONTROL     (0x10 * 4)
+#define RP2350_DM_PROGBUF0      (0x20 * 4)
+#define RP2350_PROGBUF_WORDS    2
+
+// Host-side memory cache (see rp2350_enable_mem_cache)
+#define RP2350_MEM_LINES        8
+#define RP2350_MEM_LINE_WORDS   16
+
+typedef struct {
+    bool valid;
+    uint32_t base;          // Target address of words[0], line-aligned
+    uint16_t dirty;         // One bit per word written but not yet written back
+    uint32_t words[RP2350_MEM_LINE_WORDS];
+} mem_line_t;
+
 typedef struct {
     // Initialization state (shared across harts)
     bool initialized;
     bool sba_initialized;
+    bool sba_access8;       // SBCS.sbaccess8: native byte accesses
+    bool sba_access16;      // SBCS.sbaccess16: native halfword accesses
 
     // Per-hart state
     hart_state_t harts[RP2350_NUM_HARTS];
@@ -101,7 +325,26 @@ typedef struct {
     // Cache configuration (shared across harts)
     bool cache_enabled;
 
-    // Note: Breakpoint/trigger support removed - to be reimplemented later
+    // Last value written to DMCONTROL (hartsel + request bits)
+    uint32_t dmcontrol_cache;
+    bool dmcontrol_valid;
+
+    // Last values written to PROGBUF0..1
+    uint32_t progbuf_cache[RP2350_PROGBUF_WORDS];
+    bool progbuf_valid[RP2350_PROGBUF_WORDS];
+
+    // abstractauto.autoexecdata + aarpostincrement support (bulk GPR access)
+    bool autoexec_probed;
+    bool autoexec_ok;
+
+    // DMCONTROL.hasel + HAWINDOW support (group halt/resume)
+    bool hasel_probed;
+    bool hasel_ok;
+
+    // Memory cache, used only while every hart is halted
+    bool mem_cache_enabled;
+    mem_line_t mem_lines[RP2350_MEM_LINES];
+    uint mem_victim;        // Next line to replace, round robin
 } rp2350_state_t;
 
 //==============================================================================
@@ -115,6 +358,10 @@ typedef struct {
     uint pin_swclk;
     uint pin_swdio;
     uint freq_khz;
+    bool use_dma;           // Request DMA backend on connect
+    bool fast;              // probe_fast program (2 cycles per SWCLK)
+    bool fractional_clkdiv; // Allow a fractional clock divider
+    bool program_loaded;    // Holds a reference on the shared PIO program
     bool initialized;
 } pio_state_t;
 
@@ -129,6 +376,7 @@ struct swd_target {
     // Connection state
     bool connected;
     uint32_t idcode;
+    bool fast_attach;       // Poll rather than sleep; reuse a powered DP/active DM
 
     // Protocol layers
     dap_state_t dap;
@@ -141,17 +389,47 @@ struct swd_target {
 
     // Resource tracking
     bool resource_registered;
+
+    // Transaction queue (allocated on first swd_batch_begin())
+    swd_batch_t *batch;
+
+    // Asynchronous requests (allocated on first submission)
+    swd_async_t *async;
+
+    // DMA backend (allocated on connect when enabled, NULL otherwise)
+    swd_dma_t *dma;
+
+    // Wait loop timing and per-loop poll counters
+    swd_poll_policy_t poll_policy;
+    swd_wait_stats_t wait_stats[SWD_WAIT_COUNT];
+
+#if PICO2_SWD_STATS
+    // Protocol counters (swd_get_stats)
+    swd_stats_t stats;
+#endif
 };
 
 //==============================================================================
 // Global Resource Tracking
 //==============================================================================
 
+// Distinct SWD programs that can be resident on one PIO block (probe, probe_fast)
+#define SWD_PIO_PROGRAM_SLOTS 2
+
+// A PIO program shared by every target on one block
+typedef struct {
+    const pio_program_t *program;
+    uint offset;
+    uint refcount;          // Targets using it; removed from the block at 0
+} pio_program_ref_t;
+
 // Track which PIO/SM pairs are in use
 typedef struct {
     swd_target_t *pio0_sm_owners[4];
     swd_target_t *pio1_sm_owners[4];
     uint active_count;
+    pio_program_ref_t pio0_programs[SWD_PIO_PROGRAM_SLOTS];
+    pio_program_ref_t pio1_programs[SWD_PIO_PROGRAM_SLOTS];
 } resource_tracker_t;
 
 extern resource_tracker_t g_resources;
@@ -162,13 +440,29 @@ extern resource_tracker_t g_resources;
 
 // Error management
 void swd_set_error(swd_target_t *target, swd_error_t error, const char *detail, ...);
+
+// Wait loops
+void swd_poll_begin(swd_target_t *target, swd_poll_t *poll, swd_wait_t kind);
+bool swd_poll_again(swd_target_t *target, swd_poll_t *poll);
+void swd_poll_end(swd_target_t *target, swd_poll_t *poll, bool done);
 swd_error_t swd_ack_to_error(uint8_t ack);
 
+#if PICO2_SWD_STATS
+// Record one operation that began at time_us_32() == start
+void swd_stats_latency(swd_target_t *target, swd_latency_t op, uint32_t start);
+#endif
+
 // Resource management
 swd_error_t allocate_pio_sm(PIO *pio, uint *sm);
 void release_pio_sm(PIO pio, uint sm);
 bool register_target(swd_target_t *target, PIO pio, uint sm);
 void unregister_target(swd_target_t *target);
+swd_error_t acquire_pio_program(PIO pio, const pio_program_t *program, uint *offset);
+void release_pio_program(PIO pio, const pio_program_t *program);
+
+// Shared SWD program for the target's PIO variant (held from create to destroy)
+swd_error_t swd_pio_program_load(swd_target_t *target);
+void swd_pio_program_unload(swd_target_t *target);
 
 // Low-level SWD operations
 swd_error_t swd_io_raw(swd_target_t *target, uint8_t request, uint32_t *data, bool write);
@@ -181,8 +475,119 @@ swd_error_t swd_write_dp_raw(swd_target_t *target, uint8_t reg, uint32_t value);
 swd_error_t swd_read_ap_raw(swd_target_t *target, uint8_t reg, uint32_t *value);
 swd_error_t swd_write_ap_raw(swd_target_t *target, uint8_t reg, uint32_t value);
 
+// Streamed transactions: runs ops back-to-back through the PIO FIFOs and
+// returns the first error. *failed_op receives its index (count if none).
+// A parity error in a DMA run is the exception: the rest of the run was
+// acted on, and *failed_op is the last op the target accepted.
+swd_op_t swd_op_read(bool ap, uint8_t reg, uint32_t *dest);
+swd_op_t swd_op_write(bool ap, uint8_t reg, uint32_t value);
+swd_error_t swd_run_ops(swd_target_t *target, const swd_op_t *ops, uint count,
+                        uint *failed_op);
+
+// Non-blocking swd_batch_execute(). start() begins streaming the open batch
+// (on DMA when enabled); poll() moves a bounded slice of FIFO words and
+// returns true once done, with *result as swd_batch_execute() would give.
+// Implicit flushes while queuing, and WAIT recovery, still block.
+swd_error_t swd_batch_start(swd_target_t *target);
+bool swd_batch_poll(swd_target_t *target, swd_error_t *result);
+
 // DP/AP utilities
 uint8_t calculate_parity(uint32_t value);
 uint32_t make_dp_select_rp2350(uint8_t apsel, uint8_t bank, bool ctrlsel);
+swd_error_t dap_select_ap_bank(swd_target_t *target, uint8_t apsel, uint8_t bank);
+
+// Forget DP_SELECT, TAR and Debug Module shadows (after errors, line reset,
+// reconnect). The next access rewrites whatever it needs.
+void dap_invalidate_cache(swd_target_t *target);
+
+// Debug Module shadows (DMCONTROL, PROGBUF). Writes from outside the RP2350
+// layer that may reach a shadowed register must drop them: note_dm_write()
+// for a known address range, forget_dm_shadows() when TAR is unknown.
+void rp2350_note_dm_write(swd_target_t *target, uint32_t addr, uint32_t bytes);
+void rp2350_forget_dm_shadows(swd_target_t *target);
+
+// Drop a hart's cached registers, pending writes included
+static inline void rp2350_forget_regs(hart_state_t *hart) {
+    hart->gpr_valid = 0;
+    hart->gpr_dirty = 0;
+    hart->csr_valid = 0;
+    hart->csr_dirty = 0;
+}
+
+// Write pending register writes and s0 held as scratch to every halted hart
+// (before disconnecting, since halted harts may outlive the session)
+void rp2350_flush_regs(swd_target_t *target);
+
+// Write back cached memory overlapping [addr, addr + bytes) before a block
+// transfer bypasses the cache; drop those lines too if it will write there
+swd_error_t rp2350_mem_cache_sync(swd_target_t *target, uint32_t addr, uint32_t bytes,
+                                  bool drop);
+
+// SBA chunk of up to SBA_BATCH_CHUNK_WORDS in an open batch, for callers
+// that run the batch themselves; check SBCS with sba_chunk_status() after
+swd_error_t rp2350_sba_queue_chunk(swd_target_t *target, bool write, uint32_t addr,
+                                   uint32_t *buffer, uint32_t count, uint32_t *sbcs);
+swd_error_t rp2350_sba_chunk_status(swd_target_t *target, uint32_t sbcs, uint32_t addr);
+
+// What rp2350_call() saves before a call and restores after it
+typedef struct {
+    uint32_t regs[32];
+    uint32_t pc;
+    uint32_t dcsr;
+    uint32_t mstatus;
+    uint32_t trap_addr;
+    uint32_t trap_word;
+} rp2350_call_frame_t;
+
+// rp2350_call() in pieces, for callers that talk to the function while it
+// runs. enter saves into frame and resumes the hart (with sp replaced
+// unless 0); wait polls for the return trap; leave halts the hart if it is
+// still running and restores frame.
+swd_error_t rp2350_call_enter(swd_target_t *target, uint8_t hart_id, uint32_t func,
+                              const uint32_t *args, uint8_t nargs, uint32_t trap_addr,
+                              uint32_t sp, rp2350_call_frame_t *frame);
+swd_error_t rp2350_call_wait(swd_target_t *target, uint8_t hart_id, uint32_t timeout_ms);
+swd_error_t rp2350_call_leave(swd_target_t *target, uint8_t hart_id,
+                              const rp2350_call_frame_t *frame);
+
+// Drain and cancel outstanding async requests, then free them (on disconnect
+// and destroy). Refused with SWD_ERROR_RESOURCE_BUSY from inside a callback.
+swd_error_t swd_async_release(swd_target_t *target);
+
+//==============================================================================
+// Gang Operation
+//==============================================================================
+
+// Gang helpers take per-target results: targets whose entry is not SWD_OK
+// are skipped, and each participating entry is overwritten with its outcome.
+
+static inline swd_error_t swd_gang_first_error(const swd_error_t *results, uint count) {
+    for (uint i = 0; i < count; i++) {
+        if (results[i] != SWD_OK) {
+            return results[i];
+        }
+    }
+    return SWD_OK;
+}
+
+// swd_run_ops() on several targets at once, feeding their state machines
+// round-robin. Targets without overrun detection, or that got WAIT, finish
+// alone. failed_ops may be NULL.
+void swd_run_ops_gang(swd_target_t *const *targets, const swd_op_t *const *ops,
+                      const uint *counts, uint n, swd_error_t *errs, uint *failed_ops);
+
+// swd_batch_execute() for targets that each have an open batch
+swd_error_t swd_batch_execute_gang(swd_target_t *const *targets, uint n, swd_error_t *results);
+
+// rp2350_init() with the activation delays shared by all targets
+swd_error_t rp2350_gang_init(swd_target_t *const *targets, uint count, swd_error_t *results);
+
+// rp2350_write/read_mem_block() in interleaved SBA_BATCH_CHUNK_WORDS chunks
+swd_error_t rp2350_gang_write_mem_block(swd_target_t *const *targets, uint count, uint32_t addr,
+                                        const uint32_t *buffer, uint32_t words,
+                                        swd_error_t *results);
+swd_error_t rp2350_gang_read_mem_block(swd_target_t *const *targets, uint count, uint32_t addr,
+                                       uint32_t *const *buffers, uint32_t words,
+                                       swd_error_t *results);
 
 #endif // PICO2_SWD_RISCV_INTERNAL_H
@@ -0,0 +1,151 @@
+/**
+ * @file profile.c
+ * @brief Statistical PC sampling of running harts
+ *
+ * The halt window itself is rp2350_sample_pc(); this file paces the
+ * samples, alternates harts and keeps the histogram.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico2-swd-riscv/profile.h"
+#include "pico2-swd-riscv/rp2350.h"
+#include "pico2-swd-riscv/swd.h"
+#include "internal.h"
+#include "pico/stdlib.h"
+#include <stdlib.h>
+#include <string.h>
+
+//==============================================================================
+// Histogram
+//==============================================================================
+
+swd_error_t rp2350_profile_init(rp2350_profile_t *profile, uint32_t start, uint32_t end,
+                                uint32_t bucket_bytes) {
+    if (!profile || end <= start || bucket_bytes < 2 ||
+        (bucket_bytes & (bucket_bytes - 1)) != 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    memset(profile, 0, sizeof(*profile));
+    profile->base = start;
+    profile->bucket_shift = (uint32_t)__builtin_ctz(bucket_bytes);
+    profile->bucket_count = ((end - start - 1) >> profile->bucket_shift) + 1;
+
+    profile->buckets = calloc(profile->bucket_count, sizeof(uint32_t));
+    if (!profile->buckets) {
+        profile->bucket_count = 0;
+        return SWD_ERROR_NO_MEMORY;
+    }
+    return SWD_OK;
+}
+
+void rp2350_profile_free(rp2350_profile_t *profile) {
+    if (profile) {
+        free(profile->buckets);
+        profile->buckets = NULL;
+        profile->bucket_count = 0;
+    }
+}
+
+void rp2350_profile_reset(rp2350_profile_t *profile) {
+    if (!profile) {
+        return;
+    }
+
+    if (profile->buckets) {
+        memset(profile->buckets, 0, profile->bucket_count * sizeof(uint32_t));
+    }
+    profile->samples = 0;
+    profile->outside = 0;
+    profile->hart_samples[0] = profile->hart_samples[1] = 0;
+    profile->missed = 0;
+    profile->max_window_us = 0;
+    profile->total_window_us = 0;
+}
+
+static void profile_record(rp2350_profile_t *profile, uint8_t hart_id, uint32_t pc,
+                           uint32_t window_us) {
+    uint32_t bucket = (pc - profile->base) >> profile->bucket_shift;
+    if (pc >= profile->base && bucket < profile->bucket_count) {
+        profile->buckets[bucket]++;
+    } else {
+        profile->outside++;
+    }
+
+    profile->samples++;
+    profile->hart_samples[hart_id]++;
+    profile->total_window_us += window_us;
+    if (window_us > profile->max_window_us) {
+        profile->max_window_us = window_us;
+    }
+}
+
+//==============================================================================
+// Sampling Loop
+//==============================================================================
+
+swd_error_t rp2350_profile_run(swd_target_t *target, rp2350_profile_t *profile,
+                               uint32_t harts, uint32_t rate_hz, uint32_t duration_ms) {
+    if (!target || !profile || !profile->buckets ||
+        harts == 0 || (harts & ~RP2350_PROFILE_BOTH) != 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    uint32_t active = harts;
+    for (uint8_t h = 0; h < RP2350_NUM_HARTS; h++) {
+        if (rp2350_is_halted(target, h)) {
+            active &= ~(1u << h);
+        }
+    }
+
+    uint64_t period_us = rate_hz ? 1000000u / rate_hz : 0;
+    uint64_t now = time_us_64();
+    uint64_t end = now + (uint64_t)duration_ms * 1000u;
+    uint64_t next = now;
+    uint8_t hart_id = (active & RP2350_PROFILE_HART0) ? 0 : 1;
+
+    SWD_INFO("Profiling harts 0x%lx at %lu Hz for %lu ms\n", (unsigned long)active,
+             (unsigned long)rate_hz, (unsigned long)duration_ms);
+
+    while (active && now < end) {
+        if (next > now) {
+            sleep_us(next - now);
+        }
+
+        uint32_t pc = 0;
+        uint64_t start = time_us_64();
+        swd_error_t err = rp2350_sample_pc(target, hart_id, &pc);
+        now = time_us_64();
+
+        if (err == SWD_OK || err == SWD_ERROR_ALREADY_HALTED) {
+            profile_record(profile, hart_id, pc, (uint32_t)(now - start));
+        }
+        if (err == SWD_ERROR_ALREADY_HALTED) {
+            SWD_INFO("Hart %u halted during profiling at 0x%08lx\n", hart_id,
+                     (unsigned long)pc);
+            active &= ~(1u << hart_id);
+        } else if (err != SWD_OK) {
+            return err;
+        }
+
+        // Next hart in turn; the other one if both are still selected
+        if (active & (1u << (hart_id ^ 1))) {
+            hart_id ^= 1;
+        }
+
+        next += period_us;
+        if (period_us && next < now) {
+            uint64_t late = (now - next + period_us - 1) / period_us;
+            profile->missed += (uint32_t)late;
+            next += late * period_us;
+        }
+    }
+
+    return (active == harts) ? SWD_OK : SWD_ERROR_ALREADY_HALTED;
+}
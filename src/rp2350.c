@@ -11,7 +11,9 @@
 #include "pico2-swd-riscv/swd.h"
 #include "internal.h"
 #include "pico/stdlib.h"
+#include "hardware/sync.h"
 #include <stdio.h>
+#include <string.h>
 
 //==============================================================================
 // Debug Module Register Addresses
@@ -19,8 +21,11 @@
 
 #define DM_DMCONTROL   (0x10 * 4)
 #define DM_DMSTATUS    (0x11 * 4)
+#define DM_HAWINDOWSEL (0x14 * 4)
+#define DM_HAWINDOW    (0x15 * 4)
 #define DM_ABSTRACTCS  (0x16 * 4)
 #define DM_COMMAND     (0x17 * 4)
+#define DM_ABSTRACTAUTO (0x18 * 4)
 #define DM_DATA0       (0x04 * 4)
 #define DM_PROGBUF0    (0x20 * 4)
 #define DM_PROGBUF1    (0x21 * 4)
@@ -28,11 +33,45 @@
 #define DM_SBADDRESS0  (0x39 * 4)
 #define DM_SBDATA0     (0x3C * 4)
 
+// SBCS fields
+#define SBCS_SBACCESS8        (1u << 0)
+#define SBCS_SBACCESS16       (1u << 1)
+#define SBCS_SBREADONDATA     (1u << 15)
+#define SBCS_SBAUTOINCREMENT  (1u << 16)
+#define SBCS_SBACCESS_8       (0u << 17)
+#define SBCS_SBACCESS_16      (1u << 17)
+#define SBCS_SBACCESS_32      (2u << 17)
+#define SBCS_SBREADONADDR     (1u << 20)
+#define SBCS_SBBUSY           (1u << 21)
+#define SBCS_SBBUSYERROR      (1u << 22)
+#define SBCS_SBERROR_MASK     (7u << 12)
+
+// DMCONTROL / DMSTATUS fields used for hart groups
+#define DMCONTROL_HASEL       (1u << 26)
+#define DMSTATUS_ALLHALTED    (1u << 9)
+#define DMSTATUS_ALLRESUMEACK (1u << 17)
+
+// Configuration used by single-word accesses
+#define SBCS_DEFAULT          (SBCS_SBACCESS_32 | SBCS_SBREADONADDR)
+
+// RP2350 APB-AP bank 1 register controlling DM activation
+#define AP_BANK1_DM_CTRL      0x10
+
 //==============================================================================
 // Forward Declarations
 //==============================================================================
 
 static swd_error_t rp2350_init_sba(swd_target_t *target);
+static swd_error_t flush_regs(swd_target_t *target, uint8_t hart_id);
+static mem_line_t *mem_cache_line(swd_target_t *target, uint32_t addr, bool write,
+                                  swd_error_t *err);
+static swd_error_t mem_cache_release(swd_target_t *target);
+static swd_error_t sba_access_narrow(swd_target_t *target, bool write, uint32_t addr,
+                                     uint32_t bytes, uint32_t *value);
+static swd_error_t triggers_in_way(swd_target_t *target, uint8_t hart_id, uint32_t *mask);
+static swd_error_t triggers_arm(swd_target_t *target, uint8_t hart_id, uint32_t mask, bool arm);
+static swd_error_t triggers_rearm(swd_target_t *target, uint8_t hart_id, uint32_t mask,
+                                  swd_error_t err);
 
 //==============================================================================
 // Helper: Hart Validation and Selection
@@ -67,13 +106,95 @@ static inline uint32_t make_dmcontrol(uint8_t hart_id, bool haltreq,
     return dmcontrol;
 }
 
+/**
+ * @brief Write DMCONTROL and remember the value
+ */
+static swd_error_t write_dmcontrol(swd_target_t *target, uint32_t dmcontrol) {
+    swd_error_t err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    if (err == SWD_OK) {
+        target->rp2350.dmcontrol_cache = dmcontrol;
+        target->rp2350.dmcontrol_valid = true;
+    }
+    return err;
+}
+
+/**
+ * @brief Select a hart, skipping the write if it is already selected
+ *
+ * Only a plain selection (no request bits) is skipped; halt, resume and
+ * reset requests always go out through write_dmcontrol().
+ */
+static swd_error_t select_hart(swd_target_t *target, uint8_t hart_id) {
+    uint32_t dmcontrol = make_dmcontrol(hart_id, false, false, false);
+    if (target->rp2350.dmcontrol_valid && target->rp2350.dmcontrol_cache == dmcontrol) {
+        return SWD_OK;
+    }
+    return write_dmcontrol(target, dmcontrol);
+}
+
+//==============================================================================
+// Debug Module Shadows
+//==============================================================================
+
+static inline bool ranges_overlap(uint32_t a, uint32_t a_bytes, uint32_t b, uint32_t b_bytes) {
+    return a < b + b_bytes && b < a + a_bytes;
+}
+
+void rp2350_note_dm_write(swd_target_t *target, uint32_t addr, uint32_t bytes) {
+    if (ranges_overlap(addr, bytes, DM_DMCONTROL, 4)) {
+        target->rp2350.dmcontrol_valid = false;
+    }
+    for (uint i = 0; i < RP2350_PROGBUF_WORDS; i++) {
+        if (ranges_overlap(addr, bytes, DM_PROGBUF0 + (i * 4), 4)) {
+            target->rp2350.progbuf_valid[i] = false;
+        }
+    }
+}
+
+void rp2350_forget_dm_shadows(swd_target_t *target) {
+    target->rp2350.dmcontrol_valid = false;
+    for (uint i = 0; i < RP2350_PROGBUF_WORDS; i++) {
+        target->rp2350.progbuf_valid[i] = false;
+    }
+}
+
+/**
+ * @brief Write the program buffer, skipping words it already holds
+ */
+static swd_error_t write_progbuf(swd_target_t *target, const uint32_t *instructions, uint8_t count) {
+    rp2350_state_t *dm = &target->rp2350;
+
+    for (uint8_t i = 0; i < count; i++) {
+        bool shadowed = i < RP2350_PROGBUF_WORDS;
+        if (shadowed && dm->progbuf_valid[i] && dm->progbuf_cache[i] == instructions[i]) {
+            continue;
+        }
+
+        swd_error_t err = dap_write_mem32(target, DM_PROGBUF0 + (i * 4), instructions[i]);
+        if (err != SWD_OK) {
+            return err;
+        }
+
+        if (shadowed) {
+            dm->progbuf_cache[i] = instructions[i];
+            dm->progbuf_valid[i] = true;
+        }
+    }
+
+    return SWD_OK;
+}
+
 //==============================================================================
 // Helper: Wait for Abstract Command Completion
 //==============================================================================
 
 static swd_error_t wait_abstract_command(swd_target_t *target) {
-    for (int i = 0; i < 100; i++) {
+    swd_poll_t poll;
+    SWD_STAT_START(start);
+    swd_poll_begin(target, &poll, SWD_WAIT_ABSTRACT);
+    do {
         swd_result_t result = dap_read_mem32(target, DM_ABSTRACTCS);
+        SWD_STAT_INC(target, abstract_polls);
         if (result.error != SWD_OK) {
             return result.error;
         }
@@ -83,6 +204,8 @@ static swd_error_t wait_abstract_command(swd_target_t *target) {
         uint8_t cmderr = (abstractcs >> 8) & 0x7;
 
         if (!busy) {
+            swd_poll_end(target, &poll, true);
+            SWD_STAT_LATENCY(target, SWD_LATENCY_ABSTRACT, start);
             if (cmderr != 0) {
                 // Clear error
                 dap_write_mem32(target, DM_ABSTRACTCS, 0x00000700);
@@ -92,10 +215,9 @@ static swd_error_t wait_abstract_command(swd_target_t *target) {
             }
             return SWD_OK;
         }
+    } while (swd_poll_again(target, &poll));
 
-        sleep_us(100);
-    }
-
+    swd_poll_end(target, &poll, false);
     swd_set_error(target, SWD_ERROR_TIMEOUT, "Abstract command timeout");
     return SWD_ERROR_TIMEOUT;
 }
@@ -117,8 +239,10 @@ static swd_error_t wait_abstract_command(swd_target_t *target) {
 static swd_error_t poll_dmstatus_halted(swd_target_t *target, uint8_t hart_id,
                                          bool wait_for_halted) {
     hart_state_t *hart = &target->rp2350.harts[hart_id];
+    swd_poll_t poll;
 
-    for (int i = 0; i < 10; i++) {
+    swd_poll_begin(target, &poll, SWD_WAIT_HALT);
+    do {
         swd_result_t result = dap_read_mem32(target, DM_DMSTATUS);
         if (result.error != SWD_OK) {
             return result.error;
@@ -128,20 +252,21 @@ static swd_error_t poll_dmstatus_halted(swd_target_t *target, uint8_t hart_id,
         bool allrunning = (result.value >> 11) & 1;
 
         if (wait_for_halted && allhalted) {
+            swd_poll_end(target, &poll, true);
             hart->halted = true;
             hart->halt_state_known = true;
             return SWD_OK;
         }
 
         if (!wait_for_halted && allrunning) {
+            swd_poll_end(target, &poll, true);
             hart->halted = false;
             hart->halt_state_known = true;
             return SWD_OK;
         }
+    } while (swd_poll_again(target, &poll));
 
-        sleep_ms(10);
-    }
-
+    swd_poll_end(target, &poll, false);
     return SWD_ERROR_TIMEOUT;
 }
 
@@ -149,15 +274,16 @@ static swd_error_t poll_dmstatus_halted(swd_target_t *target, uint8_t hart_id,
 // Debug Module Initialization
 //==============================================================================
 
-swd_error_t rp2350_init(swd_target_t *target) {
-    if (!target || !target->connected) {
-        return SWD_ERROR_NOT_CONNECTED;
-    }
-
-    if (target->rp2350.initialized) {
-        return SWD_OK;  // Already initialized
-    }
+// DM activation handshake: reset, activate, configure. Each write needs
+// time to take effect before the next one.
+static const uint32_t dm_activation_sequence[] = {0x00000000, 0x00000001, 0x07FFFFC1};
+#define DM_ACTIVATION_STEPS (sizeof(dm_activation_sequence) / sizeof(dm_activation_sequence[0]))
+#define DM_ACTIVATION_DELAY_MS 50
 
+/**
+ * @brief Select the RISC-V APB-AP and point TAR at DMCONTROL
+ */
+static swd_error_t dm_init_begin(swd_target_t *target) {
     SWD_INFO("Initializing RP2350 Debug Module...\n");
 
     // Select RISC-V APB-AP, Bank 0
@@ -168,8 +294,7 @@ swd_error_t rp2350_init(swd_target_t *target) {
     }
 
     // Configure CSW for 32-bit word access
-    uint32_t csw = 0xA2000002;  // Standard CSW value
-    err = dap_write_ap(target, AP_RISCV, AP_CSW, csw);
+    err = dap_write_ap(target, AP_RISCV, AP_CSW, AP_CSW_DEFAULT);
     if (err != SWD_OK) {
         return err;
     }
@@ -180,70 +305,206 @@ swd_error_t rp2350_init(swd_target_t *target) {
         return err;
     }
 
-    // Switch to Bank 1 for DM control
-    uint32_t sel_bank1 = make_dp_select_rp2350(AP_RISCV, 1, true);
-    err = dap_write_dp(target, DP_SELECT, sel_bank1);
+    // DM activation control lives in bank 1; dap_write_ap() selects it
+    SWD_DEBUG("Performing DM activation handshake...\n");
+    return SWD_OK;
+}
+
+static swd_error_t dm_init_step(swd_target_t *target, uint step) {
+    swd_error_t err = dap_write_ap(target, AP_RISCV, AP_BANK1_DM_CTRL,
+                                   dm_activation_sequence[step]);
+    if (err != SWD_OK) {
+        return err;
+    }
+    dap_read_dp(target, DP_RDBUFF);
+    return SWD_OK;
+}
+
+// DM activation control reads this once the DM is up
+#define DM_CTRL_ACTIVE 0x04010001
+
+/**
+ * @brief Reset the RP2350 layer state for a DM that reported active
+ *
+ * @param warm The DM was already active, so this target's triggers are
+ *             still armed as it left them and their tracking is kept
+ */
+static swd_error_t dm_init_done(swd_target_t *target, bool warm) {
+    // Switch back to Bank 0
+    swd_error_t err = dap_select_ap_bank(target, AP_RISCV, 0);
     if (err != SWD_OK) {
         return err;
     }
 
-    // DM Activation Sequence
-    SWD_DEBUG("Performing DM activation handshake...\n");
+    SWD_INFO("Debug Module initialized successfully\n");
 
-    // Reset
-    err = dap_write_ap(target, AP_RISCV, AP_CSW, 0x00000000);
-    if (err != SWD_OK) return err;
-    dap_read_dp(target, DP_RDBUFF);
-    sleep_ms(50);
+    target->rp2350.initialized = true;
+    rp2350_forget_dm_shadows(target);
+    target->rp2350.autoexec_probed = false;
+    target->rp2350.hasel_probed = false;
+    rp2350_invalidate_mem_cache(target);
 
-    // Activate
-    err = dap_write_ap(target, AP_RISCV, AP_CSW, 0x00000001);
-    if (err != SWD_OK) return err;
-    dap_read_dp(target, DP_RDBUFF);
-    sleep_ms(50);
+    // Initialize per-hart state
+    for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
+        target->rp2350.harts[i].halt_state_known = false;
+        target->rp2350.harts[i].halted = false;
+        rp2350_forget_regs(&target->rp2350.harts[i]);
+        target->rp2350.harts[i].scratch_held = false;
+        if (!warm) {
+            target->rp2350.harts[i].triggers_probed = false;
+            target->rp2350.harts[i].trigger_used = 0;
+        }
+    }
 
-    // Configure
-    err = dap_write_ap(target, AP_RISCV, AP_CSW, 0x07FFFFC1);
-    if (err != SWD_OK) return err;
-    dap_read_dp(target, DP_RDBUFF);
-    sleep_ms(50);
+    // Initialize SBA
+    rp2350_init_sba(target);
+
+    return SWD_OK;
+}
 
+/**
+ * @brief Check the DM responded, then reset the RP2350 layer state
+ */
+static swd_error_t dm_init_finish(swd_target_t *target) {
     // Verify DM is responding
-    swd_read_ap_raw(target, AP_CSW, NULL);
-    swd_result_t status_result = dap_read_dp(target, DP_RDBUFF);
+    swd_result_t status_result = dap_read_ap(target, AP_RISCV, AP_BANK1_DM_CTRL);
     if (status_result.error != SWD_OK) {
         swd_set_error(target, status_result.error, "Failed to read DM status");
         return status_result.error;
     }
 
-    if (status_result.value != 0x04010001) {
+    if (status_result.value != DM_CTRL_ACTIVE) {
         swd_set_error(target, SWD_ERROR_INVALID_STATE,
-                     "Unexpected DM status: 0x%08x (expected 0x04010001)",
-                     status_result.value);
+                     "Unexpected DM status: 0x%08x (expected 0x%08x)",
+                     status_result.value, DM_CTRL_ACTIVE);
         return SWD_ERROR_INVALID_STATE;
     }
 
-    // Switch back to Bank 0
-    err = dap_write_dp(target, DP_SELECT, sel_bank0);
+    return dm_init_done(target, false);
+}
+
+/**
+ * @brief Fast attach: reuse an active DM, or activate it without fixed delays
+ *
+ * A DM that is already active is not reset, so halted harts stay halted.
+ * Otherwise the handshake runs back to back and DM_CTRL is polled until
+ * the DM reports active.
+ *
+ * @return SWD_OK if the DM is up; SWD_ERROR_TIMEOUT to fall back to the
+ *         timed handshake
+ */
+static swd_error_t dm_init_fast(swd_target_t *target) {
+    swd_result_t status = dap_read_ap(target, AP_RISCV, AP_BANK1_DM_CTRL);
+    if (status.error != SWD_OK) {
+        return status.error;
+    }
+    if (status.value == DM_CTRL_ACTIVE) {
+        SWD_INFO("Debug Module already active\n");
+        return dm_init_done(target, true);
+    }
+
+    for (uint step = 0; step < DM_ACTIVATION_STEPS; step++) {
+        swd_error_t err = dm_init_step(target, step);
+        if (err != SWD_OK) {
+            return err;
+        }
+    }
+
+    swd_poll_t poll;
+    swd_poll_begin(target, &poll, SWD_WAIT_POWER);
+    do {
+        status = dap_read_ap(target, AP_RISCV, AP_BANK1_DM_CTRL);
+        if (status.error != SWD_OK) {
+            return status.error;
+        }
+        if (status.value == DM_CTRL_ACTIVE) {
+            swd_poll_end(target, &poll, true);
+            return dm_init_done(target, false);
+        }
+    } while (swd_poll_again(target, &poll));
+
+    swd_poll_end(target, &poll, false);
+    SWD_WARN("DM not active after fast handshake (0x%08lx), retrying with delays\n",
+             (unsigned long)status.value);
+    return SWD_ERROR_TIMEOUT;
+}
+
+swd_error_t rp2350_init(swd_target_t *target) {
+    if (!target || !target->connected) {
+        return SWD_ERROR_NOT_CONNECTED;
+    }
+
+    if (target->rp2350.initialized) {
+        return SWD_OK;  // Already initialized
+    }
+
+    swd_error_t err = dm_init_begin(target);
     if (err != SWD_OK) {
         return err;
     }
 
-    SWD_INFO("Debug Module initialized successfully\n");
+    if (target->fast_attach) {
+        err = dm_init_fast(target);
+        if (err != SWD_ERROR_TIMEOUT) {
+            return err;
+        }
+    }
 
-    target->rp2350.initialized = true;
+    for (uint step = 0; step < DM_ACTIVATION_STEPS; step++) {
+        err = dm_init_step(target, step);
+        if (err != SWD_OK) {
+            return err;
+        }
+        sleep_ms(DM_ACTIVATION_DELAY_MS);
+    }
 
-    // Initialize per-hart state
-    for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
-        target->rp2350.harts[i].halt_state_known = false;
-        target->rp2350.harts[i].halted = false;
-        target->rp2350.harts[i].cache_valid = false;
+    return dm_init_finish(target);
+}
+
+swd_error_t rp2350_gang_init(swd_target_t *const *targets, uint count, swd_error_t *results) {
+    bool pending[SWD_GANG_MAX_TARGETS];
+
+    for (uint i = 0; i < count; i++) {
+        pending[i] = false;
+        if (results[i] != SWD_OK) {
+            continue;
+        }
+        if (!targets[i] || !targets[i]->connected) {
+            results[i] = SWD_ERROR_NOT_CONNECTED;
+        } else if (!targets[i]->rp2350.initialized) {
+            results[i] = dm_init_begin(targets[i]);
+            if (results[i] == SWD_OK && targets[i]->fast_attach) {
+                swd_error_t err = dm_init_fast(targets[i]);
+                results[i] = (err == SWD_ERROR_TIMEOUT) ? SWD_OK : err;
+                pending[i] = (err == SWD_ERROR_TIMEOUT);
+            } else {
+                pending[i] = (results[i] == SWD_OK);
+            }
+        }
     }
 
-    // Initialize SBA
-    rp2350_init_sba(target);
+    // Every target steps through the handshake together, sharing the delays
+    for (uint step = 0; step < DM_ACTIVATION_STEPS; step++) {
+        bool any = false;
+        for (uint i = 0; i < count; i++) {
+            if (pending[i]) {
+                results[i] = dm_init_step(targets[i], step);
+                pending[i] = (results[i] == SWD_OK);
+                any |= pending[i];
+            }
+        }
+        if (!any) {
+            break;
+        }
+        sleep_ms(DM_ACTIVATION_DELAY_MS);
+    }
 
-    return SWD_OK;
+    for (uint i = 0; i < count; i++) {
+        if (pending[i]) {
+            results[i] = dm_init_finish(targets[i]);
+        }
+    }
+    return swd_gang_first_error(results, count);
 }
 
 bool rp2350_is_initialized(const swd_target_t *target) {
@@ -274,18 +535,15 @@ static swd_error_t execute_progbuf_simple(swd_target_t *target, uint8_t hart_id,
     }
 
     // Select hart
-    uint32_t dmcontrol = make_dmcontrol(hart_id, false, false, false);
-    swd_error_t err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    swd_error_t err = select_hart(target, hart_id);
     if (err != SWD_OK) {
         return err;
     }
 
     // Write instructions to program buffer
-    for (uint8_t i = 0; i < count; i++) {
-        err = dap_write_mem32(target, DM_PROGBUF0 + (i * 4), instructions[i]);
-        if (err != SWD_OK) {
-            return err;
-        }
+    err = write_progbuf(target, instructions, count);
+    if (err != SWD_OK) {
+        return err;
     }
 
     // Execute progbuf without abstract command (just postexec with no transfer)
@@ -312,7 +570,13 @@ swd_error_t rp2350_execute_progbuf(swd_target_t *target, uint8_t hart_id,
         return SWD_ERROR_INVALID_PARAM;
     }
 
-    return execute_progbuf_simple(target, hart_id, instructions, count);
+    // The instructions see the registers as written, and may change any
+    swd_error_t err = flush_regs(target, hart_id);
+    if (err == SWD_OK) {
+        err = execute_progbuf_simple(target, hart_id, instructions, count);
+    }
+    rp2350_forget_regs(&target->rp2350.harts[hart_id]);
+    return err;
 }
 
 //==============================================================================
@@ -341,7 +605,7 @@ swd_error_t rp2350_halt(swd_target_t *target, uint8_t hart_id) {
 
     // Write DMCONTROL with hartsel, haltreq=1, dmactive=1
     uint32_t dmcontrol = make_dmcontrol(hart_id, true, false, false);
-    swd_error_t err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    swd_error_t err = write_dmcontrol(target, dmcontrol);
     if (err != SWD_OK) {
         return err;
     }
@@ -355,9 +619,10 @@ swd_error_t rp2350_halt(swd_target_t *target, uint8_t hart_id) {
 
     hart->halted = true;
     hart->halt_state_known = true;
+    hart->scratch_held = false;
 
     // Invalidate register cache
-    hart->cache_valid = false;
+    rp2350_forget_regs(hart);
 
     SWD_INFO("Hart %u halted\n", hart_id);
     return SWD_OK;
@@ -383,9 +648,25 @@ swd_error_t rp2350_resume(swd_target_t *target, uint8_t hart_id) {
 
     SWD_INFO("Resuming hart %u...\n", hart_id);
 
+    // A trigger on the instruction at dpc would fire again at once
+    uint32_t in_way;
+    swd_error_t err = triggers_in_way(target, hart_id, &in_way);
+    if (err == SWD_OK && in_way) {
+        err = rp2350_step(target, hart_id);
+    }
+    if (err == SWD_OK) {
+        err = mem_cache_release(target);
+    }
+    if (err == SWD_OK) {
+        err = flush_regs(target, hart_id);
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
     // Write DMCONTROL with hartsel, resumereq=1, dmactive=1
     uint32_t dmcontrol = make_dmcontrol(hart_id, false, true, false);
-    swd_error_t err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    err = write_dmcontrol(target, dmcontrol);
     if (err != SWD_OK) {
         return err;
     }
@@ -401,7 +682,7 @@ swd_error_t rp2350_resume(swd_target_t *target, uint8_t hart_id) {
     hart->halt_state_known = true;
 
     // Invalidate cache (hart is now running)
-    hart->cache_valid = false;
+    rp2350_forget_regs(hart);
 
     SWD_INFO("Hart %u resumed\n", hart_id);
     return SWD_OK;
@@ -417,24 +698,12 @@ static swd_error_t write_dcsr(swd_target_t *target, uint8_t hart_id, uint32_t va
     return rp2350_write_csr(target, hart_id, 0x7b0, value);  // DCSR = 0x7b0
 }
 
-swd_error_t rp2350_step(swd_target_t *target, uint8_t hart_id) {
-    if (!target || !target->rp2350.initialized) {
-        return SWD_ERROR_NOT_INITIALIZED;
-    }
-
-    if (!validate_hart_id(hart_id)) {
-        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
-        return SWD_ERROR_INVALID_PARAM;
-    }
-
+/**
+ * @brief One instruction with DCSR.step, triggers left as they are
+ */
+static swd_error_t step_once(swd_target_t *target, uint8_t hart_id) {
     hart_state_t *hart = &target->rp2350.harts[hart_id];
 
-    if (!hart->halted) {
-        return SWD_ERROR_NOT_HALTED;
-    }
-
-    SWD_INFO("Single-stepping hart %u...\n", hart_id);
-
     // Read current DCSR value via program buffer
     swd_result_t dcsr_result = read_dcsr(target, hart_id);
     if (dcsr_result.error != SWD_OK) {
@@ -452,17 +721,25 @@ swd_error_t rp2350_step(swd_target_t *target, uint8_t hart_id) {
         return err;
     }
 
+    // The stepped instruction must see the registers as written, and memory
+    err = mem_cache_release(target);
+    if (err == SWD_OK) {
+        err = flush_regs(target, hart_id);
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
     // Resume hart directly (will execute ONE instruction, then halt due to step bit)
     // Write DMCONTROL with hartsel and dmactive
-    uint32_t dmcontrol = make_dmcontrol(hart_id, false, false, false);
-    err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    err = select_hart(target, hart_id);
     if (err != SWD_OK) {
         return err;
     }
 
     // Set resumereq
-    dmcontrol = make_dmcontrol(hart_id, false, true, false);
-    err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    uint32_t dmcontrol = make_dmcontrol(hart_id, false, true, false);
+    err = write_dmcontrol(target, dmcontrol);
     if (err != SWD_OK) {
         return err;
     }
@@ -480,7 +757,7 @@ swd_error_t rp2350_step(swd_target_t *target, uint8_t hart_id) {
 
     hart->halted = true;
     hart->halt_state_known = true;
-    hart->cache_valid = false;
+    rp2350_forget_regs(hart);
 
     // Clear step bit for normal halted behavior
     err = write_dcsr(target, hart_id, dcsr_result.value);
@@ -492,6 +769,39 @@ swd_error_t rp2350_step(swd_target_t *target, uint8_t hart_id) {
     return err;
 }
 
+swd_error_t rp2350_step(swd_target_t *target, uint8_t hart_id) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+
+    if (!hart->halted) {
+        return SWD_ERROR_NOT_HALTED;
+    }
+
+    SWD_INFO("Single-stepping hart %u...\n", hart_id);
+
+    // Triggers that would stop the step before the instruction runs are
+    // disarmed for its duration
+    uint32_t in_way;
+    swd_error_t err = triggers_in_way(target, hart_id, &in_way);
+    if (err == SWD_OK && in_way) {
+        err = triggers_arm(target, hart_id, in_way, false);
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = step_once(target, hart_id);
+    return triggers_rearm(target, hart_id, in_way, err);
+}
+
 swd_error_t rp2350_reset(swd_target_t *target, uint8_t hart_id, bool halt_on_reset) {
     if (!target || !target->rp2350.initialized) {
         return SWD_ERROR_NOT_INITIALIZED;
@@ -506,10 +816,16 @@ swd_error_t rp2350_reset(swd_target_t *target, uint8_t hart_id, bool halt_on_res
 
     SWD_INFO("Resetting hart %u (halt=%d)...\n", hart_id, halt_on_reset);
 
+    // Writes made before the reset still land; the cache is stale after it
+    swd_error_t err = mem_cache_release(target);
+    if (err != SWD_OK) {
+        return err;
+    }
+
     // Step 1: Assert ndmreset with dmactive and hartsel
     uint32_t dmcontrol = make_dmcontrol(hart_id, halt_on_reset, false, true);
 
-    swd_error_t err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    err = write_dmcontrol(target, dmcontrol);
     if (err != SWD_OK) {
         return err;
     }
@@ -520,7 +836,7 @@ swd_error_t rp2350_reset(swd_target_t *target, uint8_t hart_id, bool halt_on_res
     // Step 3: Deassert ndmreset
     dmcontrol = make_dmcontrol(hart_id, halt_on_reset, false, false);
 
-    err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    err = write_dmcontrol(target, dmcontrol);
     if (err != SWD_OK) {
         return err;
     }
@@ -544,8 +860,13 @@ swd_error_t rp2350_reset(swd_target_t *target, uint8_t hart_id, bool halt_on_res
         SWD_INFO("Hart %u reset and running\n", hart_id);
     }
 
-    // Invalidate caches
-    hart->cache_valid = false;
+    // ndmreset reset both harts: pending register writes are dropped, and
+    // so are whatever s0 was holding and the armed triggers
+    for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
+        rp2350_forget_regs(&target->rp2350.harts[i]);
+        target->rp2350.harts[i].scratch_held = false;
+        target->rp2350.harts[i].trigger_used = 0;
+    }
 
     return SWD_OK;
 }
@@ -566,8 +887,7 @@ bool rp2350_is_halted(const swd_target_t *target, uint8_t hart_id) {
     }
 
     // Query from hardware - need to select the hart first
-    uint32_t dmcontrol = make_dmcontrol(hart_id, false, false, false);
-    swd_error_t err = dap_write_mem32((swd_target_t*)target, DM_DMCONTROL, dmcontrol);
+    swd_error_t err = select_hart((swd_target_t*)target, hart_id);
     if (err != SWD_OK) {
         return false;
     }
@@ -584,25 +904,227 @@ bool rp2350_is_halted(const swd_target_t *target, uint8_t hart_id) {
 }
 
 //==============================================================================
-// Register Access
+// Hart Groups
 //==============================================================================
 
-swd_result_t rp2350_read_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_num) {
-    swd_result_t result = {.error = SWD_ERROR_NOT_INITIALIZED, .value = 0};
-
-    if (!target || !target->rp2350.initialized) {
-        return result;
+/**
+ * @brief Probe DMCONTROL.hasel once
+ *
+ * hasel is WARL and reads back 0 where the hart array mask is missing.
+ * HAWINDOWSEL stays 0: both harts fit in the first 32-hart window.
+ */
+static bool hasel_supported(swd_target_t *target) {
+    rp2350_state_t *dm = &target->rp2350;
+    if (dm->hasel_probed) {
+        return dm->hasel_ok;
     }
 
-    if (!validate_hart_id(hart_id)) {
-        result.error = SWD_ERROR_INVALID_PARAM;
-        swd_set_error(target, result.error, "Invalid hart_id: %u", hart_id);
-        return result;
+    dm->hasel_probed = true;
+    dm->hasel_ok = false;
+    swd_error_t err = write_dmcontrol(target, make_dmcontrol(0, false, false, false) |
+                                      DMCONTROL_HASEL);
+    if (err == SWD_OK) {
+        swd_result_t result = dap_read_mem32(target, DM_DMCONTROL);
+        dm->hasel_ok = result.error == SWD_OK && (result.value & DMCONTROL_HASEL);
     }
+    if (dm->hasel_ok) {
+        dm->hasel_ok = dap_write_mem32(target, DM_HAWINDOWSEL, 0) == SWD_OK;
+    }
+    select_hart(target, 0);
 
-    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    SWD_INFO("Hart array mask %s\n", dm->hasel_ok ? "supported" : "not supported");
+    return dm->hasel_ok;
+}
 
-    if (!hart->halted) {
+/**
+ * @brief Send one halt or resume request to every hart in mask
+ */
+static swd_error_t group_request(swd_target_t *target, uint32_t mask, bool haltreq,
+                                 bool resumereq) {
+    swd_error_t err = dap_write_mem32(target, DM_HAWINDOW, mask);
+    if (err != SWD_OK) {
+        return err;
+    }
+    uint8_t first = (uint8_t)__builtin_ctz(mask);
+    return write_dmcontrol(target, make_dmcontrol(first, haltreq, resumereq, false) |
+                                   DMCONTROL_HASEL);
+}
+
+/**
+ * @brief Poll DMSTATUS until an all* bit covers the selected group
+ */
+static swd_error_t poll_group(swd_target_t *target, uint32_t bit) {
+    swd_poll_t poll;
+    swd_poll_begin(target, &poll, SWD_WAIT_HALT);
+    do {
+        swd_result_t result = dap_read_mem32(target, DM_DMSTATUS);
+        if (result.error != SWD_OK) {
+            return result.error;
+        }
+        if (result.value & bit) {
+            swd_poll_end(target, &poll, true);
+            return SWD_OK;
+        }
+    } while (swd_poll_again(target, &poll));
+
+    swd_poll_end(target, &poll, false);
+    return SWD_ERROR_TIMEOUT;
+}
+
+static swd_error_t check_hart_mask(swd_target_t *target, uint32_t mask) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (mask == 0 || (mask & ~((1u << RP2350_NUM_HARTS) - 1))) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart mask: 0x%lx",
+                      (unsigned long)mask);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+    return SWD_OK;
+}
+
+// Harts in mask whose known state differs from halted
+static uint32_t harts_to_change(const swd_target_t *target, uint32_t mask, bool halted) {
+    uint32_t pending = 0;
+    for (uint8_t h = 0; h < RP2350_NUM_HARTS; h++) {
+        const hart_state_t *hart = &target->rp2350.harts[h];
+        if ((mask & (1u << h)) && !(hart->halt_state_known && hart->halted == halted)) {
+            pending |= 1u << h;
+        }
+    }
+    return pending;
+}
+
+swd_error_t rp2350_halt_harts(swd_target_t *target, uint32_t mask) {
+    swd_error_t err = check_hart_mask(target, mask);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    uint32_t pending = harts_to_change(target, mask, true);
+    if (pending == 0) {
+        return SWD_OK;
+    }
+
+    // One hart, or no hart array: plain per-hart halts
+    if ((pending & (pending - 1)) == 0 || !hasel_supported(target)) {
+        for (uint8_t h = 0; h < RP2350_NUM_HARTS && err == SWD_OK; h++) {
+            if (pending & (1u << h)) {
+                err = rp2350_halt(target, h);
+            }
+        }
+        return (err == SWD_ERROR_ALREADY_HALTED) ? SWD_OK : err;
+    }
+
+    SWD_INFO("Halting harts 0x%lx...\n", (unsigned long)pending);
+    err = group_request(target, pending, true, false);
+    if (err == SWD_OK) {
+        err = poll_group(target, DMSTATUS_ALLHALTED);
+    }
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "Failed to halt harts 0x%lx", (unsigned long)pending);
+        return err;
+    }
+
+    for (uint8_t h = 0; h < RP2350_NUM_HARTS; h++) {
+        if (pending & (1u << h)) {
+            hart_state_t *hart = &target->rp2350.harts[h];
+            hart->halted = true;
+            hart->halt_state_known = true;
+            hart->scratch_held = false;
+            rp2350_forget_regs(hart);
+        }
+    }
+    return SWD_OK;
+}
+
+swd_error_t rp2350_resume_harts(swd_target_t *target, uint32_t mask) {
+    swd_error_t err = check_hart_mask(target, mask);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    uint32_t pending = harts_to_change(target, mask, false);
+    if (pending == 0) {
+        return SWD_OK;
+    }
+
+    if ((pending & (pending - 1)) == 0 || !hasel_supported(target)) {
+        for (uint8_t h = 0; h < RP2350_NUM_HARTS && err == SWD_OK; h++) {
+            if (pending & (1u << h)) {
+                err = rp2350_resume(target, h);
+            }
+        }
+        return err;
+    }
+
+    SWD_INFO("Resuming harts 0x%lx...\n", (unsigned long)pending);
+
+    // Per-hart preparation, as rp2350_resume() does it
+    for (uint8_t h = 0; h < RP2350_NUM_HARTS && err == SWD_OK; h++) {
+        if (pending & (1u << h)) {
+            uint32_t in_way;
+            err = triggers_in_way(target, h, &in_way);
+            if (err == SWD_OK && in_way) {
+                err = rp2350_step(target, h);
+            }
+        }
+    }
+    if (err == SWD_OK) {
+        err = mem_cache_release(target);
+    }
+    for (uint8_t h = 0; h < RP2350_NUM_HARTS && err == SWD_OK; h++) {
+        if (pending & (1u << h)) {
+            err = flush_regs(target, h);
+        }
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    // resumeack rather than allrunning: a hart that hits a breakpoint
+    // straight away still acknowledged the resume
+    err = group_request(target, pending, false, true);
+    if (err == SWD_OK) {
+        err = poll_group(target, DMSTATUS_ALLRESUMEACK);
+    }
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "Failed to resume harts 0x%lx", (unsigned long)pending);
+        return err;
+    }
+
+    for (uint8_t h = 0; h < RP2350_NUM_HARTS; h++) {
+        if (pending & (1u << h)) {
+            hart_state_t *hart = &target->rp2350.harts[h];
+            hart->halted = false;
+            hart->halt_state_known = true;
+            rp2350_forget_regs(hart);
+        }
+    }
+    return SWD_OK;
+}
+
+//==============================================================================
+// Register Access
+//==============================================================================
+
+swd_result_t rp2350_read_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_num) {
+    swd_result_t result = {.error = SWD_ERROR_NOT_INITIALIZED, .value = 0};
+
+    if (!target || !target->rp2350.initialized) {
+        return result;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        result.error = SWD_ERROR_INVALID_PARAM;
+        swd_set_error(target, result.error, "Invalid hart_id: %u", hart_id);
+        return result;
+    }
+
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+
+    if (!hart->halted) {
         result.error = SWD_ERROR_NOT_HALTED;
         swd_set_error(target, result.error, "Hart %u must be halted to read registers", hart_id);
         return result;
@@ -614,8 +1136,15 @@ swd_result_t rp2350_read_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_
         return result;
     }
 
+    // s0 is on loan to the CSR engine; the program's value is kept aside
+    if (reg_num == 8 && hart->scratch_held) {
+        result.value = hart->scratch_s0;
+        result.error = SWD_OK;
+        return result;
+    }
+
     // Check cache
-    if (target->rp2350.cache_enabled && hart->cache_valid) {
+    if (target->rp2350.cache_enabled && ((hart->gpr_valid >> reg_num) & 1)) {
         result.value = hart->cached_gprs[reg_num];
         result.error = SWD_OK;
         SWD_DEBUG("Read cached hart%u x%u = 0x%08lx\n", hart_id, (unsigned)reg_num, (unsigned long)result.value);
@@ -625,8 +1154,7 @@ swd_result_t rp2350_read_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_
     SWD_DEBUG("Reading hart%u x%u...\n", hart_id, reg_num);
 
     // Select hart
-    uint32_t dmcontrol = make_dmcontrol(hart_id, false, false, false);
-    result.error = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    result.error = select_hart(target, hart_id);
     if (result.error != SWD_OK) {
         return result;
     }
@@ -653,6 +1181,7 @@ swd_result_t rp2350_read_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_
         // Update cache
         if (target->rp2350.cache_enabled) {
             hart->cached_gprs[reg_num] = result.value;
+            hart->gpr_valid |= 1u << reg_num;
         }
         SWD_INFO("hart%u x%u = 0x%08lx\n", hart_id, (unsigned)reg_num, (unsigned long)result.value);
     }
@@ -660,35 +1189,13 @@ swd_result_t rp2350_read_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_
     return result;
 }
 
-swd_error_t rp2350_write_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_num, uint32_t value) {
-    if (!target || !target->rp2350.initialized) {
-        return SWD_ERROR_NOT_INITIALIZED;
-    }
-
-    if (!validate_hart_id(hart_id)) {
-        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
-        return SWD_ERROR_INVALID_PARAM;
-    }
-
-    hart_state_t *hart = &target->rp2350.harts[hart_id];
-
-    if (!hart->halted) {
-        swd_set_error(target, SWD_ERROR_NOT_HALTED,
-                     "Hart %u must be halted to write registers", hart_id);
-        return SWD_ERROR_NOT_HALTED;
-    }
-
-    if (reg_num >= 32) {
-        swd_set_error(target, SWD_ERROR_INVALID_PARAM,
-                     "Invalid register number: %u", reg_num);
-        return SWD_ERROR_INVALID_PARAM;
-    }
-
-    SWD_INFO("Writing hart%u x%u = 0x%08lx\n", hart_id, (unsigned)reg_num, (unsigned long)value);
-
+/**
+ * @brief Write one GPR on the hart itself
+ */
+static swd_error_t write_gpr(swd_target_t *target, uint8_t hart_id, uint8_t reg_num,
+                             uint32_t value) {
     // Select hart
-    uint32_t dmcontrol = make_dmcontrol(hart_id, false, false, false);
-    swd_error_t err = dap_write_mem32(target, DM_DMCONTROL, dmcontrol);
+    swd_error_t err = select_hart(target, hart_id);
     if (err != SWD_OK) {
         return err;
     }
@@ -712,19 +1219,17 @@ swd_error_t rp2350_write_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_
     }
 
     err = wait_abstract_command(target);
-    if (err == SWD_OK) {
-        // Update cache
-        if (target->rp2350.cache_enabled) {
-            hart->cached_gprs[reg_num] = value;
-        }
+    if (err == SWD_OK && reg_num == 8) {
+        // s0 now holds the program's value again
+        target->rp2350.harts[hart_id].scratch_held = false;
     }
 
     return err;
 }
 
-swd_error_t rp2350_read_all_regs(swd_target_t *target, uint8_t hart_id, uint32_t regs[32]) {
-    if (!target || !regs) {
-        return SWD_ERROR_INVALID_PARAM;
+swd_error_t rp2350_write_reg(swd_target_t *target, uint8_t hart_id, uint8_t reg_num, uint32_t value) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
     }
 
     if (!validate_hart_id(hart_id)) {
@@ -732,539 +1237,3553 @@ swd_error_t rp2350_read_all_regs(swd_target_t *target, uint8_t hart_id, uint32_t
         return SWD_ERROR_INVALID_PARAM;
     }
 
-    SWD_INFO("Reading all 32 registers from hart%u...\n", hart_id);
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
 
-    for (uint8_t i = 0; i < 32; i++) {
-        swd_result_t result = rp2350_read_reg(target, hart_id, i);
-        if (result.error != SWD_OK) {
-            return result.error;
-        }
-        regs[i] = result.value;
+    if (!hart->halted) {
+        swd_set_error(target, SWD_ERROR_NOT_HALTED,
+                     "Hart %u must be halted to write registers", hart_id);
+        return SWD_ERROR_NOT_HALTED;
     }
 
-    // Mark cache as valid
-    if (target->rp2350.cache_enabled) {
-        target->rp2350.harts[hart_id].cache_valid = true;
+    if (reg_num >= 32) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM,
+                     "Invalid register number: %u", reg_num);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    SWD_INFO("Writing hart%u x%u = 0x%08lx\n", hart_id, (unsigned)reg_num, (unsigned long)value);
+
+    if (!target->rp2350.cache_enabled) {
+        return write_gpr(target, hart_id, reg_num, value);
     }
 
+    // Held until the hart runs (flush_regs); x0 stays 0
+    if (reg_num != 0) {
+        hart->cached_gprs[reg_num] = value;
+        hart->gpr_dirty |= 1u << reg_num;
+    } else {
+        hart->cached_gprs[0] = 0;
+    }
+    hart->gpr_valid |= 1u << reg_num;
+    if (reg_num == 8 && hart->scratch_held) {
+        hart->scratch_s0 = value;
+    }
     return SWD_OK;
 }
 
 //==============================================================================
-// PC and CSR Access
+// Bulk Register Access
 //==============================================================================
 
-swd_result_t rp2350_read_pc(swd_target_t *target, uint8_t hart_id) {
-    return rp2350_read_csr(target, hart_id, 0x7b1);  // DPC = 0x7b1
-}
-
-swd_error_t rp2350_write_pc(swd_target_t *target, uint8_t hart_id, uint32_t pc) {
-    return rp2350_write_csr(target, hart_id, 0x7b1, pc);  // DPC = 0x7b1
+// Access-register command for a GPR, with regno advancing after each transfer
+static inline uint32_t gpr_command_postinc(uint8_t reg_num, bool write) {
+    uint32_t command = 0;
+    command |= (0x1000 + reg_num) << 0;   // regno
+    if (write) command |= (1 << 16);       // write
+    command |= (1 << 17);                  // transfer
+    command |= (1 << 19);                  // aarpostincrement
+    command |= (2 << 20);                  // aarsize=32-bit
+    return command;
 }
 
-swd_result_t rp2350_read_csr(swd_target_t *target, uint8_t hart_id, uint16_t csr_addr) {
-    swd_result_t result = {.error = SWD_ERROR_NOT_INITIALIZED, .value = 0};
-
-    if (!target || !target->rp2350.initialized) {
-        return result;
-    }
-
-    if (!validate_hart_id(hart_id)) {
-        result.error = SWD_ERROR_INVALID_PARAM;
-        swd_set_error(target, result.error, "Invalid hart_id: %u", hart_id);
-        return result;
-    }
-
-    const hart_state_t *hart = &target->rp2350.harts[hart_id];
-
-    if (!hart->halted) {
-        result.error = SWD_ERROR_NOT_HALTED;
-        return result;
+/**
+ * @brief Check (once) whether abstractauto.autoexecdata[0] is implemented
+ *
+ * The field is WARL, so an unimplemented bit reads back as 0.
+ */
+static bool autoexec_supported(swd_target_t *target) {
+    rp2350_state_t *dm = &target->rp2350;
+    if (dm->autoexec_probed) {
+        return dm->autoexec_ok;
     }
 
-    // RP2350 doesn't support abstract CSR access, use program buffer
-    // Save s0 (x8) first
-    swd_result_t saved_s0 = rp2350_read_reg(target, hart_id, 8);
-    if (saved_s0.error != SWD_OK) {
-        return saved_s0;
+    swd_result_t result = {.error = dap_write_mem32(target, DM_ABSTRACTAUTO, 1), .value = 0};
+    if (result.error == SWD_OK) {
+        result = dap_read_mem32(target, DM_ABSTRACTAUTO);
     }
-
-    // Build CSR read instruction: csrr s0, csr_addr
-    uint32_t csr_inst = 0x00002473 | (csr_addr << 20);  // csrr s0, csr
-
-    const uint32_t progbuf[] = {
-        csr_inst,       // csrr s0, <csr>
-        0x00100073      // ebreak
-    };
-
-    result.error = execute_progbuf_simple(target, hart_id, progbuf, 2);
+    dap_write_mem32(target, DM_ABSTRACTAUTO, 0);
     if (result.error != SWD_OK) {
-        rp2350_write_reg(target, hart_id, 8, saved_s0.value);
-        return result;
+        return false;  // Not cached: try again next time
     }
 
-    // Read s0 to get CSR value
-    result = rp2350_read_reg(target, hart_id, 8);
-
-    // Restore s0
-    rp2350_write_reg(target, hart_id, 8, saved_s0.value);
+    dm->autoexec_ok = result.value & 1;
+    dm->autoexec_probed = true;
+    SWD_DEBUG("abstractauto autoexecdata %ssupported\n", dm->autoexec_ok ? "" : "not ");
+    return dm->autoexec_ok;
+}
 
-    return result;
+/**
+ * @brief Queue "abstractauto = 0" and an ABSTRACTCS read in the open batch
+ */
+static void queue_autoexec_end(swd_target_t *target, uint32_t *abstractcs) {
+    swd_batch_queue_write(target, true, AP_TAR, DM_ABSTRACTAUTO);
+    swd_batch_queue_write(target, true, AP_DRW, 0);
+    swd_batch_queue_write(target, true, AP_TAR, DM_ABSTRACTCS);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_read(target, false, DP_RDBUFF, abstractcs);
 }
 
-swd_error_t rp2350_write_csr(swd_target_t *target, uint8_t hart_id, uint16_t csr_addr, uint32_t value) {
-    if (!target || !target->rp2350.initialized) {
-        return SWD_ERROR_NOT_INITIALIZED;
+/**
+ * @brief Check ABSTRACTCS after an autoexec run
+ *
+ * A command still running is waited for; cmderr (including "busy" from
+ * touching DATA0 too early) clears the error and fails the run.
+ */
+static swd_error_t check_autoexec_end(swd_target_t *target, uint32_t abstractcs) {
+    if (((abstractcs >> 12) & 1) || ((abstractcs >> 8) & 0x7)) {
+        return wait_abstract_command(target);
     }
+    return SWD_OK;
+}
 
-    if (!validate_hart_id(hart_id)) {
-        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
-        return SWD_ERROR_INVALID_PARAM;
+/**
+ * @brief Read x0-x31 with one command and autoexec on DATA0
+ *
+ * The first command reads x0 and leaves regno at x1. With autoexecdata
+ * set, every DATA0 read returns the current register and re-runs the
+ * command for the next one. AP reads are posted, so DRW read i returns
+ * the value fetched by read i-1.
+ */
+static swd_error_t autoexec_read_gprs(swd_target_t *target, uint32_t regs[32]) {
+    swd_error_t err = dap_write_mem32(target, DM_COMMAND, gpr_command_postinc(0, false));
+    if (err == SWD_OK) {
+        err = wait_abstract_command(target);
+        if (err == SWD_ERROR_ABSTRACT_CMD) {
+            target->rp2350.autoexec_ok = false;  // No aarpostincrement
+        }
+    }
+    if (err != SWD_OK) {
+        return err;
     }
 
-    const hart_state_t *hart = &target->rp2350.harts[hart_id];
-
-    if (!hart->halted) {
-        return SWD_ERROR_NOT_HALTED;
+    err = swd_batch_begin(target);
+    if (err != SWD_OK) {
+        return err;
     }
 
-    // RP2350 doesn't support abstract CSR access, use program buffer
-    // Save s0 (x8) first
-    swd_result_t saved_s0 = rp2350_read_reg(target, hart_id, 8);
-    if (saved_s0.error != SWD_OK) {
-        return saved_s0.error;
+    uint32_t abstractcs = 0;
+    swd_batch_queue_write(target, true, AP_TAR, DM_ABSTRACTAUTO);
+    swd_batch_queue_write(target, true, AP_DRW, 1);
+    swd_batch_queue_write(target, true, AP_TAR, DM_DATA0);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);  // Fetches x0, runs x1
+    for (uint i = 1; i <= 30; i++) {
+        swd_batch_queue_read(target, true, AP_DRW, &regs[i - 1]);  // Fetches xi, runs xi+1
     }
+    swd_batch_queue_read(target, false, DP_RDBUFF, &regs[30]);
 
-    swd_error_t err = SWD_OK;
+    // Stop autoexec before the last DATA0 read so it starts nothing
+    queue_autoexec_end(target, &abstractcs);
+    swd_batch_queue_write(target, true, AP_TAR, DM_DATA0);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_read(target, false, DP_RDBUFF, &regs[31]);
 
-    // Write value to s0
-    err = rp2350_write_reg(target, hart_id, 8, value);
+    err = swd_batch_execute(target);
     if (err != SWD_OK) {
-        goto err_handler;
+        dap_write_mem32(target, DM_ABSTRACTAUTO, 0);
+        return err;
     }
 
-    // Build CSR write instruction: csrw csr_addr, s0
-    uint32_t csr_inst = 0x00041073 | (csr_addr << 20);  // csrw csr, s0
-
-    const uint32_t progbuf[] = {
-        csr_inst,       // csrw <csr>, s0
-        0x00100073      // ebreak
-    };
-
-    err = execute_progbuf_simple(target, hart_id, progbuf, 2);
-
-err_handler:
-    // Restore s0 regardless of result
-    rp2350_write_reg(target, hart_id, 8, saved_s0.value);
-
+    err = check_autoexec_end(target, abstractcs);
+    if (err == SWD_OK && ((abstractcs >> 12) & 1)) {
+        // The x31 transfer was still running when DATA0 was read
+        swd_result_t last = dap_read_mem32(target, DM_DATA0);
+        regs[31] = last.value;
+        err = last.error;
+    }
     return err;
 }
-
-//==============================================================================
-// Cache Management
-//==============================================================================
-
+/**
+ * @brief Write x1-x31 with one command and autoexec on DATA0
+ *
+ * The first command writes x1 and leaves regno at x2; each following
+ * DATA0 write re-runs it for the next register.
+ */
+static swd_error_t autoexec_write_gprs(swd_target_t *target, const uint32_t regs[32]) {
+    swd_error_t err = dap_write_mem32(target, DM_DATA0, regs[1]);
+    if (err == SWD_OK) {
+        err = dap_write_mem32(target, DM_COMMAND, gpr_command_postinc(1, true));
+    }
+    if (err == SWD_OK) {
+        err = wait_abstract_command(target);
+        if (err == SWD_ERROR_ABSTRACT_CMD) {
+            target->rp2350.autoexec_ok = false;  // No aarpostincrement
+        }
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = swd_batch_begin(target);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    uint32_t abstractcs = 0;
+    swd_batch_queue_write(target, true, AP_TAR, DM_ABSTRACTAUTO);
+    swd_batch_queue_write(target, true, AP_DRW, 1);
+    swd_batch_queue_write(target, true, AP_TAR, DM_DATA0);
+    for (uint i = 2; i < 32; i++) {
+        swd_batch_queue_write(target, true, AP_DRW, regs[i]);
+    }
+    queue_autoexec_end(target, &abstractcs);
+
+    err = swd_batch_execute(target);
+    if (err != SWD_OK) {
+        dap_write_mem32(target, DM_ABSTRACTAUTO, 0);
+        return err;
+    }
+
+    return check_autoexec_end(target, abstractcs);
+}
+
+/**
+ * @brief Common checks for the bulk register functions
+ */
+static swd_error_t check_bulk_access(swd_target_t *target, uint8_t hart_id, const void *regs) {
+    if (!target || !regs) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.harts[hart_id].halted) {
+        swd_set_error(target, SWD_ERROR_NOT_HALTED,
+                     "Hart %u must be halted to access registers", hart_id);
+        return SWD_ERROR_NOT_HALTED;
+    }
+
+    return select_hart(target, hart_id);
+}
+
+swd_error_t rp2350_read_all_regs(swd_target_t *target, uint8_t hart_id, uint32_t regs[32]) {
+    swd_error_t err = check_bulk_access(target, hart_id, regs);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+
+    if (target->rp2350.cache_enabled && hart->gpr_valid == 0xFFFFFFFF) {
+        for (uint8_t i = 0; i < 32; i++) {
+            regs[i] = hart->cached_gprs[i];
+        }
+        if (hart->scratch_held) {
+            regs[8] = hart->scratch_s0;
+        }
+        return SWD_OK;
+    }
+
+    SWD_INFO("Reading all 32 registers from hart%u...\n", hart_id);
+
+    err = SWD_ERROR_ABSTRACT_CMD;
+    if (autoexec_supported(target)) {
+        err = autoexec_read_gprs(target, regs);
+        if (err != SWD_OK && err != SWD_ERROR_ABSTRACT_CMD) {
+            return err;
+        }
+    }
+
+    // Fallback: one command per register
+    if (err != SWD_OK) {
+        for (uint8_t i = 0; i < 32; i++) {
+            swd_result_t result = rp2350_read_reg(target, hart_id, i);
+            if (result.error != SWD_OK) {
+                return result.error;
+            }
+            regs[i] = result.value;
+        }
+    }
+
+    if (hart->scratch_held) {
+        regs[8] = hart->scratch_s0;
+    }
+
+    // Pending writes are newer than what the hart holds
+    if (target->rp2350.cache_enabled) {
+        for (uint8_t i = 0; i < 32; i++) {
+            if ((hart->gpr_dirty >> i) & 1) {
+                regs[i] = hart->cached_gprs[i];
+            } else {
+                hart->cached_gprs[i] = regs[i];
+            }
+        }
+        hart->gpr_valid = 0xFFFFFFFF;
+    }
+
+    return SWD_OK;
+}
+
+/**
+ * @brief Write x1-x31 on the hart itself
+ */
+static swd_error_t write_gprs(swd_target_t *target, uint8_t hart_id, const uint32_t regs[32]) {
+    swd_error_t err = SWD_ERROR_ABSTRACT_CMD;
+    if (autoexec_supported(target)) {
+        err = autoexec_write_gprs(target, regs);
+        if (err != SWD_OK && err != SWD_ERROR_ABSTRACT_CMD) {
+            return err;
+        }
+    }
+
+    // Fallback: one command per register
+    if (err != SWD_OK) {
+        for (uint8_t i = 1; i < 32; i++) {
+            err = write_gpr(target, hart_id, i, regs[i]);
+            if (err != SWD_OK) {
+                return err;
+            }
+        }
+    }
+
+    target->rp2350.harts[hart_id].scratch_held = false;
+    return SWD_OK;
+}
+
+swd_error_t rp2350_write_all_regs(swd_target_t *target, uint8_t hart_id, const uint32_t regs[32]) {
+    swd_error_t err = check_bulk_access(target, hart_id, regs);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+
+    SWD_INFO("Writing x1-x31 on hart%u...\n", hart_id);
+
+    if (!target->rp2350.cache_enabled) {
+        return write_gprs(target, hart_id, regs);
+    }
+
+    // Held until the hart runs (flush_regs)
+    hart->cached_gprs[0] = 0;
+    for (uint8_t i = 1; i < 32; i++) {
+        hart->cached_gprs[i] = regs[i];
+    }
+    hart->gpr_valid = 0xFFFFFFFF;
+    hart->gpr_dirty = 0xFFFFFFFE;
+    if (hart->scratch_held) {
+        hart->scratch_s0 = regs[8];
+    }
+    return SWD_OK;
+}
+
+//==============================================================================
+// PC and CSR Access
+//==============================================================================
+
+swd_result_t rp2350_read_pc(swd_target_t *target, uint8_t hart_id) {
+    return rp2350_read_csr(target, hart_id, 0x7b1);  // DPC = 0x7b1
+}
+
+swd_error_t rp2350_write_pc(swd_target_t *target, uint8_t hart_id, uint32_t pc) {
+    return rp2350_write_csr(target, hart_id, 0x7b1, pc);  // DPC = 0x7b1
+}
+
+//==============================================================================
+// CSR Access via Program Buffer
+//==============================================================================
+//
+// RP2350 doesn't support abstract CSR access, so CSRs go through s0 and the
+// program buffer. s0 is saved once per halted session (claim_scratch) and
+// written back before the hart runs again (restore_scratch), rather than
+// around every access. A CSR write is then a single command (transfer
+// DATA0 -> s0, postexec "csrw"); a list of reads costs one command per CSR
+// plus one, since each command can fetch the previous result.
+
+#define CMD_TRANSFER_S0  ((1u << 17) | (2u << 20) | 0x1008)  // transfer s0, 32-bit
+#define CMD_AR_WRITE     (1u << 16)
+#define CMD_POSTEXEC     (1u << 18)
+
+static inline uint32_t csrr_s0(uint16_t csr_addr) {
+    return 0x00002473 | ((uint32_t)csr_addr << 20);  // csrr s0, csr
+}
+
+static inline uint32_t csrw_s0(uint16_t csr_addr) {
+    return 0x00041073 | ((uint32_t)csr_addr << 20);  // csrw csr, s0
+}
+
+/**
+ * @brief Write COMMAND and wait for it to complete
+ */
+static swd_error_t run_command(swd_target_t *target, uint32_t command) {
+    swd_error_t err = dap_write_mem32(target, DM_COMMAND, command);
+    if (err != SWD_OK) {
+        return err;
+    }
+    return wait_abstract_command(target);
+}
+
+/**
+ * @brief Take s0 as scratch for the rest of the halted session
+ */
+static swd_error_t claim_scratch(swd_target_t *target, uint8_t hart_id) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (hart->scratch_held) {
+        return SWD_OK;
+    }
+
+    swd_result_t s0 = rp2350_read_reg(target, hart_id, 8);
+    if (s0.error != SWD_OK) {
+        return s0.error;
+    }
+
+    hart->scratch_s0 = s0.value;
+    hart->scratch_held = true;
+    return SWD_OK;
+}
+
+/**
+ * @brief Put the program's s0 back (no-op if s0 was not borrowed)
+ */
+static swd_error_t restore_scratch(swd_target_t *target, uint8_t hart_id) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (!hart->scratch_held) {
+        return SWD_OK;
+    }
+
+    // write_gpr() drops scratch_held once s0 is written
+    swd_error_t err = write_gpr(target, hart_id, 8, hart->scratch_s0);
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "Failed to restore s0 on hart %u", hart_id);
+    }
+    return err;
+}
+
+/**
+ * @brief Common checks for CSR access
+ */
+static swd_error_t csr_check(swd_target_t *target, uint8_t hart_id) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.harts[hart_id].halted) {
+        return SWD_ERROR_NOT_HALTED;
+    }
+
+    return SWD_OK;
+}
+
+/**
+ * @brief Setup for CSR access through the program buffer
+ */
+static swd_error_t csr_begin(swd_target_t *target, uint8_t hart_id) {
+    swd_error_t err = claim_scratch(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    return select_hart(target, hart_id);
+}
+
+/**
+ * @brief Read a list of CSRs from the hart itself
+ */
+static swd_error_t read_csrs(swd_target_t *target, uint8_t hart_id,
+                             const uint16_t *csr_addrs, uint32_t *values, uint32_t count) {
+    swd_error_t err = csr_begin(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    // First CSR into s0
+    uint32_t progbuf[] = {csrr_s0(csr_addrs[0]), 0x00100073};  // ebreak
+    err = write_progbuf(target, progbuf, 2);
+    if (err == SWD_OK) {
+        err = run_command(target, CMD_POSTEXEC);
+    }
+
+    // Each command moves the previous CSR from s0 to DATA0, then runs the
+    // program buffer again for the next one
+    for (uint32_t i = 1; i < count && err == SWD_OK; i++) {
+        progbuf[0] = csrr_s0(csr_addrs[i]);
+        err = write_progbuf(target, progbuf, 1);
+        if (err == SWD_OK) {
+            err = run_command(target, CMD_TRANSFER_S0 | CMD_POSTEXEC);
+        }
+        if (err == SWD_OK) {
+            swd_result_t data0 = dap_read_mem32(target, DM_DATA0);
+            values[i - 1] = data0.value;
+            err = data0.error;
+        }
+    }
+
+    // Collect the last one
+    if (err == SWD_OK) {
+        err = run_command(target, CMD_TRANSFER_S0);
+    }
+    if (err == SWD_OK) {
+        swd_result_t data0 = dap_read_mem32(target, DM_DATA0);
+        values[count - 1] = data0.value;
+        err = data0.error;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Write one CSR on the hart itself
+ */
+static swd_error_t write_csr(swd_target_t *target, uint8_t hart_id, uint16_t csr_addr,
+                             uint32_t value) {
+    swd_error_t err = csr_begin(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    // DATA0 -> s0, then csrw <csr>, s0
+    const uint32_t progbuf[] = {csrw_s0(csr_addr), 0x00100073};  // ebreak
+    err = write_progbuf(target, progbuf, 2);
+    if (err == SWD_OK) {
+        err = dap_write_mem32(target, DM_DATA0, value);
+    }
+    if (err == SWD_OK) {
+        err = run_command(target, CMD_TRANSFER_S0 | CMD_AR_WRITE | CMD_POSTEXEC);
+    }
+
+    return err;
+}
+
+// CSRs the register cache holds. None of them changes while the hart is
+// halted (dcsr.nmip aside).
+static const uint16_t cached_csr_addrs[RP2350_CACHED_CSRS] = {
+    0x7b1,  // dpc
+    0x7b0,  // dcsr
+    0x300,  // mstatus
+    0x305,  // mtvec
+    0x341,  // mepc
+    0x342,  // mcause
+};
+
+// Uncached CSRs fetched per read_csrs() call when serving a list
+#define CSR_MISS_BATCH 8
+
+static int cached_csr_slot(uint16_t csr_addr) {
+    for (int i = 0; i < RP2350_CACHED_CSRS; i++) {
+        if (cached_csr_addrs[i] == csr_addr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+swd_error_t rp2350_read_csrs(swd_target_t *target, uint8_t hart_id,
+                             const uint16_t *csr_addrs, uint32_t *values, uint32_t count) {
+    if (target && (!csr_addrs || !values)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    swd_error_t err = csr_check(target, hart_id);
+    if (err != SWD_OK || count == 0) {
+        return err;
+    }
+
+    if (!target->rp2350.cache_enabled) {
+        return read_csrs(target, hart_id, csr_addrs, values, count);
+    }
+
+    // Serve cached CSRs; read the others from the hart a batch at a time
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    uint32_t i = 0;
+    while (i < count) {
+        uint16_t miss_addrs[CSR_MISS_BATCH];
+        uint32_t miss_index[CSR_MISS_BATCH];
+        uint32_t misses = 0;
+
+        for (; i < count && misses < CSR_MISS_BATCH; i++) {
+            int slot = cached_csr_slot(csr_addrs[i]);
+            if (slot >= 0 && ((hart->csr_valid >> slot) & 1)) {
+                values[i] = hart->cached_csrs[slot];
+            } else {
+                miss_addrs[misses] = csr_addrs[i];
+                miss_index[misses++] = i;
+            }
+        }
+        if (misses == 0) {
+            break;
+        }
+
+        uint32_t fetched[CSR_MISS_BATCH];
+        err = read_csrs(target, hart_id, miss_addrs, fetched, misses);
+        if (err != SWD_OK) {
+            return err;
+        }
+
+        for (uint32_t m = 0; m < misses; m++) {
+            values[miss_index[m]] = fetched[m];
+            int slot = cached_csr_slot(miss_addrs[m]);
+            if (slot >= 0) {
+                hart->cached_csrs[slot] = fetched[m];
+                hart->csr_valid |= 1u << slot;
+            }
+        }
+    }
+
+    return SWD_OK;
+}
+
+swd_result_t rp2350_read_csr(swd_target_t *target, uint8_t hart_id, uint16_t csr_addr) {
+    swd_result_t result = {.error = SWD_OK, .value = 0};
+    result.error = rp2350_read_csrs(target, hart_id, &csr_addr, &result.value, 1);
+    return result;
+}
+
+swd_error_t rp2350_write_csr(swd_target_t *target, uint8_t hart_id, uint16_t csr_addr, uint32_t value) {
+    swd_error_t err = csr_check(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    int slot = target->rp2350.cache_enabled ? cached_csr_slot(csr_addr) : -1;
+    if (slot < 0) {
+        return write_csr(target, hart_id, csr_addr, value);
+    }
+
+    // Held until the hart runs (flush_regs)
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    hart->cached_csrs[slot] = value;
+    hart->csr_valid |= 1u << slot;
+    hart->csr_dirty |= 1u << slot;
+    return SWD_OK;
+}
+
+//==============================================================================
+// Cache Management
+//==============================================================================
+
+// Dirty GPRs above which one autoexec run over x1-x31 beats a command each
+#define GPR_BULK_FLUSH_MIN 6
+
+/**
+ * @brief Put pending register writes and the borrowed s0 on the hart
+ *
+ * CSRs go first since they borrow s0, and are then dropped from the cache:
+ * their WARL fields may not hold what was written. The program's s0 joins
+ * the dirty GPRs.
+ */
+static swd_error_t flush_regs(swd_target_t *target, uint8_t hart_id) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (!hart->halted) {
+        return SWD_OK;
+    }
+
+    if (!target->rp2350.cache_enabled) {
+        return restore_scratch(target, hart_id);
+    }
+
+    swd_error_t err = SWD_OK;
+    for (uint i = 0; i < RP2350_CACHED_CSRS && err == SWD_OK; i++) {
+        if ((hart->csr_dirty >> i) & 1) {
+            err = write_csr(target, hart_id, cached_csr_addrs[i], hart->cached_csrs[i]);
+            if (err == SWD_OK) {
+                hart->csr_dirty &= ~(1u << i);
+                hart->csr_valid &= ~(1u << i);
+            }
+        }
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    if (hart->scratch_held) {
+        hart->cached_gprs[8] = hart->scratch_s0;
+        hart->gpr_valid |= 1u << 8;
+        hart->gpr_dirty |= 1u << 8;
+        hart->scratch_held = false;
+    }
+
+    if (hart->gpr_dirty == 0) {
+        return SWD_OK;
+    }
+
+    SWD_DEBUG("Flushing dirty GPRs 0x%08lx on hart%u\n", (unsigned long)hart->gpr_dirty, hart_id);
+
+    if (__builtin_popcount(hart->gpr_dirty) > GPR_BULK_FLUSH_MIN &&
+        (hart->gpr_valid | 1) == 0xFFFFFFFF) {
+        err = select_hart(target, hart_id);
+        if (err == SWD_OK) {
+            err = write_gprs(target, hart_id, hart->cached_gprs);
+        }
+        if (err == SWD_OK) {
+            hart->gpr_dirty = 0;
+        }
+        return err;
+    }
+
+    for (uint8_t i = 1; i < 32 && err == SWD_OK; i++) {
+        if ((hart->gpr_dirty >> i) & 1) {
+            err = write_gpr(target, hart_id, i, hart->cached_gprs[i]);
+            if (err == SWD_OK) {
+                hart->gpr_dirty &= ~(1u << i);
+            }
+        }
+    }
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "Failed to write back registers on hart %u", hart_id);
+    }
+    return err;
+}
+
+void rp2350_flush_regs(swd_target_t *target) {
+    if (!target->rp2350.initialized) {
+        return;
+    }
+    for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
+        flush_regs(target, i);
+    }
+}
+
 void rp2350_invalidate_cache(swd_target_t *target, uint8_t hart_id) {
     if (target && validate_hart_id(hart_id)) {
-        target->rp2350.harts[hart_id].cache_valid = false;
+        // Pending writes still reach the hart
+        if (target->rp2350.initialized) {
+            flush_regs(target, hart_id);
+        }
+        rp2350_forget_regs(&target->rp2350.harts[hart_id]);
+    }
+}
+
+void rp2350_enable_cache(swd_target_t *target, bool enable) {
+    if (target) {
+        if (!enable) {
+            // Write back and invalidate all hart caches
+            rp2350_flush_regs(target);
+            for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
+                rp2350_forget_regs(&target->rp2350.harts[i]);
+            }
+        }
+        target->rp2350.cache_enabled = enable;
+    }
+}
+
+//==============================================================================
+// System Bus Access (SBA) Initialization
+//==============================================================================
+
+static swd_error_t rp2350_init_sba(swd_target_t *target) {
+    SWD_INFO("Initializing System Bus Access...\n");
+
+    // Read SBCS
+    swd_result_t result = dap_read_mem32(target, DM_SBCS);
+    if (result.error != SWD_OK) {
+        return result.error;
+    }
+
+    // Check 32-bit support via sbasize field (bits [11:5])
+    // sbasize indicates address width; we check sbaccess support by attempting to set it
+    uint32_t sbasize = (result.value >> 5) & 0x7F;
+    if (sbasize == 0) {
+        SWD_WARN("SBA: No address width reported (sbasize=0)\n");
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    // Clear errors
+    uint8_t sberror = (result.value >> 12) & 0x7;
+    if (sberror != 0) {
+        uint32_t sbcs = result.value | (0x7 << 12);
+        dap_write_mem32(target, DM_SBCS, sbcs);
+    }
+
+    // Narrow accesses switch sbaccess per access and switch back after
+    target->rp2350.sba_access8 = (result.value & SBCS_SBACCESS8) != 0;
+    target->rp2350.sba_access16 = (result.value & SBCS_SBACCESS16) != 0;
+
+    // Configure: 32-bit, auto-read on address
+    swd_error_t err = dap_write_mem32(target, DM_SBCS, SBCS_DEFAULT);
+    if (err == SWD_OK) {
+        target->rp2350.sba_initialized = true;
+        SWD_INFO("SBA initialized\n");
+    }
+
+    return err;
+}
+
+//==============================================================================
+// Memory Access
+//==============================================================================
+
+swd_result_t rp2350_read_mem32(swd_target_t *target, uint32_t addr) {
+    swd_result_t result = {.error = SWD_ERROR_NOT_INITIALIZED, .value = 0};
+
+    if (!target || !target->rp2350.initialized) {
+        return result;
+    }
+
+    if (addr & 0x3) {
+        result.error = SWD_ERROR_ALIGNMENT;
+        return result;
+    }
+
+    mem_line_t *line = mem_cache_line(target, addr, false, &result.error);
+    if (line) {
+        result.value = line->words[(addr - line->base) / 4];
+        return result;
+    }
+    if (result.error != SWD_OK) {
+        return result;
+    }
+
+    SWD_STAT_START(start);
+
+    // Use SBA if available
+    if (target->rp2350.sba_initialized) {
+        // Write address
+        result.error = dap_write_mem32(target, DM_SBADDRESS0, addr);
+        if (result.error != SWD_OK) {
+            return result;
+        }
+
+        // Read data
+        result = dap_read_mem32(target, DM_SBDATA0);
+    } else {
+        // Fallback to DAP
+        result = dap_read_mem32(target, addr);
+    }
+
+    if (result.error == SWD_OK) {
+        SWD_STAT_ADD(target, bytes_read, 4);
+        SWD_STAT_LATENCY(target, SWD_LATENCY_MEM_READ, start);
+    }
+    return result;
+}
+
+swd_error_t rp2350_write_mem32(swd_target_t *target, uint32_t addr, uint32_t value) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (addr & 0x3) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    // Write-allocate: the line is filled once, then collects later writes
+    swd_error_t err;
+    mem_line_t *line = mem_cache_line(target, addr, true, &err);
+    if (line) {
+        uint32_t word = (addr - line->base) / 4;
+        line->words[word] = value;
+        line->dirty |= (uint16_t)(1u << word);
+        return SWD_OK;
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    SWD_STAT_START(start);
+
+    // Use SBA if available
+    if (target->rp2350.sba_initialized) {
+        err = dap_write_mem32(target, DM_SBADDRESS0, addr);
+        if (err == SWD_OK) {
+            err = dap_write_mem32(target, DM_SBDATA0, value);
+        }
+    } else {
+        err = dap_write_mem32(target, addr, value);
+    }
+
+    if (err == SWD_OK) {
+        SWD_STAT_ADD(target, bytes_written, 4);
+        SWD_STAT_LATENCY(target, SWD_LATENCY_MEM_WRITE, start);
+    }
+    return err;
+}
+
+static bool sba_narrow_supported(const swd_target_t *target, uint32_t bytes) {
+    return target->rp2350.sba_initialized &&
+           (bytes == 1 ? target->rp2350.sba_access8 : target->rp2350.sba_access16);
+}
+
+/**
+ * @brief 8- or 16-bit load: cache, native SBA access, or the whole word
+ */
+static swd_result_t read_narrow(swd_target_t *target, uint32_t addr, uint32_t bytes) {
+    swd_result_t result = {.error = SWD_ERROR_NOT_INITIALIZED, .value = 0};
+    if (!target->rp2350.initialized) {
+        return result;
+    }
+
+    uint32_t shift = (addr & 3) * 8;
+    uint32_t mask = (bytes == 1) ? 0xFF : 0xFFFF;
+
+    mem_line_t *line = mem_cache_line(target, addr, false, &result.error);
+    if (line) {
+        result.value = (line->words[(addr - line->base) / 4] >> shift) & mask;
+        return result;
+    }
+    if (result.error != SWD_OK) {
+        return result;
+    }
+
+    if (sba_narrow_supported(target, bytes)) {
+        result.error = sba_access_narrow(target, false, addr, bytes, &result.value);
+        return result;
+    }
+
+    // Read aligned word
+    result = rp2350_read_mem32(target, addr & ~3u);
+    if (result.error == SWD_OK) {
+        result.value = (result.value >> shift) & mask;
+    }
+    return result;
+}
+
+/**
+ * @brief 8- or 16-bit store: cache, native SBA access, or read-modify-write
+ */
+static swd_error_t write_narrow(swd_target_t *target, uint32_t addr, uint32_t bytes,
+                                uint32_t value) {
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    uint32_t shift = (addr & 3) * 8;
+    uint32_t mask = ((bytes == 1) ? 0xFFu : 0xFFFFu) << shift;
+
+    swd_error_t err;
+    mem_line_t *line = mem_cache_line(target, addr, true, &err);
+    if (line) {
+        uint32_t word = (addr - line->base) / 4;
+        line->words[word] = (line->words[word] & ~mask) | ((value << shift) & mask);
+        line->dirty |= (uint16_t)(1u << word);
+        return SWD_OK;
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    if (sba_narrow_supported(target, bytes)) {
+        return sba_access_narrow(target, true, addr, bytes, &value);
+    }
+
+    // Read-modify-write
+    uint32_t aligned_addr = addr & ~3u;
+    swd_result_t current = rp2350_read_mem32(target, aligned_addr);
+    if (current.error != SWD_OK) {
+        return current.error;
+    }
+
+    uint32_t new_value = (current.value & ~mask) | ((value << shift) & mask);
+    return rp2350_write_mem32(target, aligned_addr, new_value);
+}
+
+swd_result_t rp2350_read_mem16(swd_target_t *target, uint32_t addr) {
+    swd_result_t result = {.error = SWD_ERROR_INVALID_PARAM, .value = 0};
+
+    if (!target) {
+        return result;
+    }
+
+    if (addr & 0x1) {
+        result.error = SWD_ERROR_ALIGNMENT;
+        return result;
+    }
+
+    return read_narrow(target, addr, 2);
+}
+
+swd_error_t rp2350_write_mem16(swd_target_t *target, uint32_t addr, uint16_t value) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (addr & 0x1) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    return write_narrow(target, addr, 2, value);
+}
+
+swd_result_t rp2350_read_mem8(swd_target_t *target, uint32_t addr) {
+    swd_result_t result = {.error = SWD_ERROR_INVALID_PARAM, .value = 0};
+
+    if (!target) {
+        return result;
+    }
+
+    return read_narrow(target, addr, 1);
+}
+
+swd_error_t rp2350_write_mem8(swd_target_t *target, uint32_t addr, uint8_t value) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    return write_narrow(target, addr, 1, value);
+}
+
+//==============================================================================
+// SBA Block Transfers
+//==============================================================================
+
+// Words per chunk; SBA status is checked once at the end of each chunk
+#define SBA_CHUNK_WORDS 256
+
+/**
+ * @brief Queue a DM register write (TAR + DRW) in the open batch
+ *
+ * Queuing errors are sticky in the batch and reported by swd_batch_execute().
+ */
+static void queue_dm_write(swd_target_t *target, uint32_t reg, uint32_t value) {
+    swd_batch_queue_write(target, true, AP_TAR, reg);
+    swd_batch_queue_write(target, true, AP_DRW, value);
+}
+
+/**
+ * @brief Queue an SBCS read into *sbcs, leaving SBCS in its default mode
+ */
+static void sba_queue_finish(swd_target_t *target, uint32_t *sbcs) {
+    queue_dm_write(target, DM_SBCS, SBCS_DEFAULT);
+    swd_batch_queue_write(target, true, AP_TAR, DM_SBCS);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_read(target, false, DP_RDBUFF, sbcs);
+}
+
+static swd_error_t sba_check_status(swd_target_t *target, uint32_t sbcs, uint32_t addr) {
+    // The bus is much faster than SWD, so this rarely loops
+    if (sbcs & SBCS_SBBUSY) {
+        swd_poll_t poll;
+        swd_poll_begin(target, &poll, SWD_WAIT_SBA);
+        while ((sbcs & SBCS_SBBUSY) && swd_poll_again(target, &poll)) {
+            swd_result_t result = dap_read_mem32(target, DM_SBCS);
+            if (result.error != SWD_OK) {
+                return result.error;
+            }
+            sbcs = result.value;
+        }
+        swd_poll_end(target, &poll, !(sbcs & SBCS_SBBUSY));
+    }
+
+    if (sbcs & SBCS_SBBUSY) {
+        swd_set_error(target, SWD_ERROR_TIMEOUT, "SBA busy after access at 0x%08x", addr);
+        return SWD_ERROR_TIMEOUT;
+    }
+
+    if (sbcs & (SBCS_SBERROR_MASK | SBCS_SBBUSYERROR)) {
+        // Both fields are write-1-to-clear
+        dap_write_mem32(target, DM_SBCS, SBCS_DEFAULT | SBCS_SBERROR_MASK | SBCS_SBBUSYERROR);
+        swd_set_error(target, SWD_ERROR_BUS, "SBA error in access at 0x%08x (sberror=%lu%s)",
+                     addr, (unsigned long)((sbcs >> 12) & 0x7),
+                     (sbcs & SBCS_SBBUSYERROR) ? ", sbbusyerror" : "");
+        return SWD_ERROR_BUS;
+    }
+
+    return SWD_OK;
+}
+
+/**
+ * @brief Open a batch holding a read of up to SBA_CHUNK_WORDS
+ *
+ * sbreadonaddr fetches the first word, and every SBDATA0 read with
+ * sbreadondata fetches the next one (sbautoincrement advances the address).
+ * TAR stays on SBDATA0, so each word costs a single DRW read. DRW reads are
+ * posted: each returns the data of the previous one.
+ *
+ * The batch holds count + 15 ops. SBCS lands in *sbcs once it has run.
+ */
+static swd_error_t sba_queue_read_chunk(swd_target_t *target, uint32_t addr,
+                                        uint32_t *buffer, uint32_t count, uint32_t *sbcs) {
+    swd_error_t err = swd_batch_begin(target);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    if (count > 1) {
+        queue_dm_write(target, DM_SBCS,
+                           SBCS_DEFAULT | SBCS_SBAUTOINCREMENT | SBCS_SBREADONDATA);
+    } else {
+        queue_dm_write(target, DM_SBCS, SBCS_DEFAULT);
+    }
+    queue_dm_write(target, DM_SBADDRESS0, addr);
+    swd_batch_queue_write(target, true, AP_TAR, DM_SBDATA0);
+
+    if (count > 1) {
+        // SBDATA0 reads for words 0..count-2, each fetching the next word
+        swd_batch_queue_read(target, true, AP_DRW, NULL);
+        for (uint32_t i = 1; i < count - 1; i++) {
+            swd_batch_queue_read(target, true, AP_DRW, &buffer[i - 1]);
+        }
+        swd_batch_queue_read(target, false, DP_RDBUFF, &buffer[count - 2]);
+
+        // The last word must not trigger a fetch past the end
+        queue_dm_write(target, DM_SBCS, SBCS_DEFAULT);
+        swd_batch_queue_write(target, true, AP_TAR, DM_SBDATA0);
+    }
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_read(target, false, DP_RDBUFF, &buffer[count - 1]);
+
+    sba_queue_finish(target, sbcs);
+    return SWD_OK;
+}
+
+static swd_error_t sba_read_chunk(swd_target_t *target, uint32_t addr,
+                                  uint32_t *buffer, uint32_t count) {
+    uint32_t sbcs = 0;
+
+    SWD_STAT_START(start);
+    swd_error_t err = sba_queue_read_chunk(target, addr, buffer, count, &sbcs);
+    if (err == SWD_OK) {
+        err = swd_batch_execute(target);
+    }
+    if (err == SWD_OK) {
+        err = sba_check_status(target, sbcs, addr);
+    }
+    if (err == SWD_OK) {
+        SWD_STAT_ADD(target, bytes_read, count * 4);
+        SWD_STAT_LATENCY(target, SWD_LATENCY_MEM_READ, start);
+    }
+    return err;
+}
+
+/**
+ * @brief Open a batch holding a write of up to SBA_CHUNK_WORDS
+ *
+ * sbreadonaddr is off while the address is set, so no read is started;
+ * each SBDATA0 write performs a bus write and advances the address.
+ *
+ * The batch holds count + 10 ops. SBCS lands in *sbcs once it has run.
+ */
+static swd_error_t sba_queue_write_chunk(swd_target_t *target, uint32_t addr,
+                                         const uint32_t *buffer, uint32_t count,
+                                         uint32_t *sbcs) {
+    swd_error_t err = swd_batch_begin(target);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    queue_dm_write(target, DM_SBCS, SBCS_SBACCESS_32 | SBCS_SBAUTOINCREMENT);
+    queue_dm_write(target, DM_SBADDRESS0, addr);
+    swd_batch_queue_write(target, true, AP_TAR, DM_SBDATA0);
+    for (uint32_t i = 0; i < count; i++) {
+        swd_batch_queue_write(target, true, AP_DRW, buffer[i]);
+    }
+
+    sba_queue_finish(target, sbcs);
+    return SWD_OK;
+}
+
+static swd_error_t sba_write_chunk(swd_target_t *target, uint32_t addr,
+                                   const uint32_t *buffer, uint32_t count) {
+    uint32_t sbcs = 0;
+
+    SWD_STAT_START(start);
+    swd_error_t err = sba_queue_write_chunk(target, addr, buffer, count, &sbcs);
+    if (err == SWD_OK) {
+        err = swd_batch_execute(target);
+    }
+    if (err == SWD_OK) {
+        err = sba_check_status(target, sbcs, addr);
+    }
+    if (err == SWD_OK) {
+        SWD_STAT_ADD(target, bytes_written, count * 4);
+        SWD_STAT_LATENCY(target, SWD_LATENCY_MEM_WRITE, start);
+    }
+    return err;
+}
+
+/**
+ * @brief One 8- or 16-bit SBA access, in a single batch
+ *
+ * sbaccess is switched for this access only; sba_queue_finish() puts the
+ * 32-bit default back. At either width the data sits in the low bits of
+ * SBDATA0.
+ */
+static swd_error_t sba_access_narrow(swd_target_t *target, bool write, uint32_t addr,
+                                     uint32_t bytes, uint32_t *value) {
+    uint32_t sbaccess = (bytes == 1) ? SBCS_SBACCESS_8 : SBCS_SBACCESS_16;
+    uint32_t sbcs = 0;
+
+    SWD_STAT_START(start);
+    swd_error_t err = dap_select_ap_bank(target, AP_RISCV, 0);
+    if (err == SWD_OK) {
+        err = swd_batch_begin(target);
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    if (write) {
+        queue_dm_write(target, DM_SBCS, sbaccess);
+        queue_dm_write(target, DM_SBADDRESS0, addr);
+        queue_dm_write(target, DM_SBDATA0, *value);
+    } else {
+        queue_dm_write(target, DM_SBCS, sbaccess | SBCS_SBREADONADDR);
+        queue_dm_write(target, DM_SBADDRESS0, addr);
+        swd_batch_queue_write(target, true, AP_TAR, DM_SBDATA0);
+        swd_batch_queue_read(target, true, AP_DRW, NULL);
+        swd_batch_queue_read(target, false, DP_RDBUFF, value);
+    }
+    sba_queue_finish(target, &sbcs);
+
+    err = swd_batch_execute(target);
+    if (err == SWD_OK) {
+        err = sba_check_status(target, sbcs, addr);
+    }
+    if (err == SWD_OK && !write) {
+        *value &= (bytes == 1) ? 0xFF : 0xFFFF;
+    }
+    if (err == SWD_OK && write) {
+        SWD_STAT_ADD(target, bytes_written, bytes);
+        SWD_STAT_LATENCY(target, SWD_LATENCY_MEM_WRITE, start);
+    } else if (err == SWD_OK) {
+        SWD_STAT_ADD(target, bytes_read, bytes);
+        SWD_STAT_LATENCY(target, SWD_LATENCY_MEM_READ, start);
+    }
+    return err;
+}
+
+swd_error_t rp2350_sba_queue_chunk(swd_target_t *target, bool write, uint32_t addr,
+                                   uint32_t *buffer, uint32_t count, uint32_t *sbcs) {
+    return write ? sba_queue_write_chunk(target, addr, buffer, count, sbcs)
+                 : sba_queue_read_chunk(target, addr, buffer, count, sbcs);
+}
+
+swd_error_t rp2350_sba_chunk_status(swd_target_t *target, uint32_t sbcs, uint32_t addr) {
+    return sba_check_status(target, sbcs, addr);
+}
+
+swd_error_t rp2350_read_mem_block(swd_target_t *target, uint32_t addr,
+                                   uint32_t *buffer, uint32_t count) {
+    if (!target || !buffer) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!target->rp2350.sba_initialized) {
+        for (uint32_t i = 0; i < count; i++) {
+            swd_result_t result = rp2350_read_mem32(target, addr + (i * 4));
+            if (result.error != SWD_OK) {
+                return result.error;
+            }
+            buffer[i] = result.value;
+        }
+        return SWD_OK;
+    }
+
+    if (addr & 0x3) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    // Cached writes must reach the target before the block reads past them
+    swd_error_t err = rp2350_mem_cache_sync(target, addr, count * 4, false);
+    if (err == SWD_OK) {
+        err = dap_select_ap_bank(target, AP_RISCV, 0);
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    for (uint32_t done = 0; done < count; done += SBA_CHUNK_WORDS) {
+        uint32_t n = count - done < SBA_CHUNK_WORDS ? count - done : SBA_CHUNK_WORDS;
+        err = sba_read_chunk(target, addr + (done * 4), &buffer[done], n);
+        if (err != SWD_OK) {
+            return err;
+        }
+    }
+
+    return SWD_OK;
+}
+
+swd_error_t rp2350_write_mem_block(swd_target_t *target, uint32_t addr,
+                                    const uint32_t *buffer, uint32_t count) {
+    if (!target || !buffer) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!target->rp2350.sba_initialized) {
+        for (uint32_t i = 0; i < count; i++) {
+            swd_error_t err = rp2350_write_mem32(target, addr + (i * 4), buffer[i]);
+            if (err != SWD_OK) {
+                return err;
+            }
+        }
+        return dap_sync_posted(target);
+    }
+
+    if (addr & 0x3) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    // The block bypasses the cache; cached writes land first, then its lines go
+    swd_error_t err = rp2350_mem_cache_sync(target, addr, count * 4, true);
+    if (err == SWD_OK) {
+        err = dap_select_ap_bank(target, AP_RISCV, 0);
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    for (uint32_t done = 0; done < count; done += SBA_CHUNK_WORDS) {
+        uint32_t n = count - done < SBA_CHUNK_WORDS ? count - done : SBA_CHUNK_WORDS;
+        err = sba_write_chunk(target, addr + (done * 4), &buffer[done], n);
+        if (err != SWD_OK) {
+            return err;
+        }
+    }
+
+    return SWD_OK;
+}
+
+//==============================================================================
+// Byte-Granular Transfers
+//==============================================================================
+
+// Words staged at a time when the caller's buffer is not word-aligned
+#define BYTES_BOUNCE_WORDS 64
+
+/**
+ * @brief Read len bytes (an unaligned head or tail) with 8/16-bit accesses
+ */
+static swd_error_t read_edge(swd_target_t *target, uint32_t addr, uint8_t *buffer,
+                             uint32_t len) {
+    while (len > 0) {
+        uint32_t n = ((addr & 1) || len == 1) ? 1 : 2;
+        swd_result_t result = read_narrow(target, addr, n);
+        if (result.error != SWD_OK) {
+            return result.error;
+        }
+        memcpy(buffer, &result.value, n);
+        addr += n;
+        buffer += n;
+        len -= n;
+    }
+    return SWD_OK;
+}
+
+/**
+ * @brief Write len bytes (an unaligned head or tail) with 8/16-bit accesses
+ */
+static swd_error_t write_edge(swd_target_t *target, uint32_t addr, const uint8_t *buffer,
+                              uint32_t len) {
+    while (len > 0) {
+        uint32_t n = ((addr & 1) || len == 1) ? 1 : 2;
+        uint32_t value = 0;
+        memcpy(&value, buffer, n);
+        swd_error_t err = write_narrow(target, addr, n, value);
+        if (err != SWD_OK) {
+            return err;
+        }
+        addr += n;
+        buffer += n;
+        len -= n;
+    }
+    return SWD_OK;
+}
+
+static inline uint32_t head_bytes(uint32_t addr, uint32_t len) {
+    uint32_t to_boundary = (4 - (addr & 3)) & 3;
+    return len < to_boundary ? len : to_boundary;
+}
+
+swd_error_t rp2350_read_bytes(swd_target_t *target, uint32_t addr,
+                              uint8_t *buffer, uint32_t len) {
+    if (!target || (!buffer && len > 0)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    uint32_t head = head_bytes(addr, len);
+    uint32_t words = (len - head) / 4;
+    uint32_t body = words * 4;
+
+    swd_error_t err = read_edge(target, addr, buffer, head);
+    if (err != SWD_OK) {
+        return err;
+    }
+    addr += head;
+    buffer += head;
+
+    // Body: straight into the buffer when it is word-aligned
+    if (((uintptr_t)buffer & 3) == 0) {
+        err = words ? rp2350_read_mem_block(target, addr, (uint32_t *)buffer, words) : SWD_OK;
+    } else {
+        uint32_t bounce[BYTES_BOUNCE_WORDS];
+        for (uint32_t done = 0; done < words && err == SWD_OK; done += BYTES_BOUNCE_WORDS) {
+            uint32_t n = words - done < BYTES_BOUNCE_WORDS ? words - done : BYTES_BOUNCE_WORDS;
+            err = rp2350_read_mem_block(target, addr + (done * 4), bounce, n);
+            memcpy(buffer + (done * 4), bounce, n * 4);
+        }
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    return read_edge(target, addr + body, buffer + body, len - head - body);
+}
+
+swd_error_t rp2350_write_bytes(swd_target_t *target, uint32_t addr,
+                               const uint8_t *buffer, uint32_t len) {
+    if (!target || (!buffer && len > 0)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    uint32_t head = head_bytes(addr, len);
+    uint32_t words = (len - head) / 4;
+    uint32_t body = words * 4;
+
+    swd_error_t err = write_edge(target, addr, buffer, head);
+    if (err != SWD_OK) {
+        return err;
+    }
+    addr += head;
+    buffer += head;
+
+    // Body: straight from the buffer when it is word-aligned
+    if (((uintptr_t)buffer & 3) == 0) {
+        err = words ? rp2350_write_mem_block(target, addr, (const uint32_t *)buffer, words)
+                    : SWD_OK;
+    } else {
+        uint32_t bounce[BYTES_BOUNCE_WORDS];
+        for (uint32_t done = 0; done < words && err == SWD_OK; done += BYTES_BOUNCE_WORDS) {
+            uint32_t n = words - done < BYTES_BOUNCE_WORDS ? words - done : BYTES_BOUNCE_WORDS;
+            memcpy(bounce, buffer + (done * 4), n * 4);
+            err = rp2350_write_mem_block(target, addr + (done * 4), bounce, n);
+        }
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    return write_edge(target, addr + body, buffer + body, len - head - body);
+}
+
+//==============================================================================
+// Memory Cache
+//==============================================================================
+
+#define MEM_LINE_BYTES (RP2350_MEM_LINE_WORDS * 4)
+
+// What the memory cache may hold. Everything else (peripherals, SIO, PPB,
+// the XIP control and uncached aliases) always goes to the target.
+static const struct {
+    uint32_t base;
+    uint32_t size;
+    bool writable;
+} mem_cache_regions[] = {
+    {0x00000000, 0x00008000, false},    // Boot ROM
+    {0x10000000, 0x04000000, false},    // XIP flash, cached window
+    {0x20000000, 0x00082000, true},     // SRAM0-9
+};
+
+static bool all_harts_halted(const swd_target_t *target) {
+    for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
+        const hart_state_t *hart = &target->rp2350.harts[i];
+        if (!hart->halt_state_known || !hart->halted) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static mem_line_t *mem_cache_find(swd_target_t *target, uint32_t base) {
+    for (uint i = 0; i < RP2350_MEM_LINES; i++) {
+        mem_line_t *line = &target->rp2350.mem_lines[i];
+        if (line->valid && line->base == base) {
+            return line;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Write a line's dirty words back, one SBA block per run of them
+ */
+static swd_error_t mem_line_writeback(swd_target_t *target, mem_line_t *line) {
+    if (!line->valid || !line->dirty) {
+        return SWD_OK;
+    }
+
+    swd_error_t err = dap_select_ap_bank(target, AP_RISCV, 0);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    uint32_t i = 0;
+    while (i < RP2350_MEM_LINE_WORDS) {
+        if (!(line->dirty & (1u << i))) {
+            i++;
+            continue;
+        }
+        uint32_t start = i;
+        while (i < RP2350_MEM_LINE_WORDS && (line->dirty & (1u << i))) {
+            i++;
+        }
+        err = sba_write_chunk(target, line->base + (start * 4), &line->words[start], i - start);
+        if (err != SWD_OK) {
+            return err;
+        }
+    }
+
+    line->dirty = 0;
+    return SWD_OK;
+}
+
+/**
+ * @brief Get the cache line holding addr, filling it on a miss
+ *
+ * @return The line, or NULL if addr is not to be cached (or the fill
+ *         failed, with *err set)
+ */
+static mem_line_t *mem_cache_line(swd_target_t *target, uint32_t addr, bool write,
+                                  swd_error_t *err) {
+    *err = SWD_OK;
+
+    rp2350_state_t *rp = &target->rp2350;
+    if (!rp->mem_cache_enabled || !rp->sba_initialized || !all_harts_halted(target)) {
+        return NULL;
+    }
+
+    uint32_t base = addr & ~(uint32_t)(MEM_LINE_BYTES - 1);
+    mem_line_t *line = mem_cache_find(target, base);
+
+    bool cacheable = false, writable = false;
+    for (uint i = 0; i < sizeof(mem_cache_regions) / sizeof(mem_cache_regions[0]); i++) {
+        if (base - mem_cache_regions[i].base < mem_cache_regions[i].size) {
+            cacheable = true;
+            writable = mem_cache_regions[i].writable;
+            break;
+        }
+    }
+
+    if (!cacheable) {
+        return NULL;
+    }
+    if (write && !writable) {
+        // The target decides what a write here does; refetch afterwards
+        if (line) {
+            line->valid = false;
+        }
+        return NULL;
+    }
+    if (line) {
+        return line;
+    }
+
+    // Miss: prefer an empty line, else replace round robin
+    line = NULL;
+    for (uint i = 0; i < RP2350_MEM_LINES && !line; i++) {
+        if (!rp->mem_lines[i].valid) {
+            line = &rp->mem_lines[i];
+        }
+    }
+    if (!line) {
+        line = &rp->mem_lines[rp->mem_victim];
+        rp->mem_victim = (rp->mem_victim + 1) % RP2350_MEM_LINES;
+
+        *err = mem_line_writeback(target, line);
+        if (*err != SWD_OK) {
+            return NULL;
+        }
+        line->valid = false;
+    }
+
+    *err = dap_select_ap_bank(target, AP_RISCV, 0);
+    if (*err == SWD_OK) {
+        *err = sba_read_chunk(target, base, line->words, RP2350_MEM_LINE_WORDS);
+    }
+    if (*err != SWD_OK) {
+        return NULL;
+    }
+
+    line->valid = true;
+    line->base = base;
+    line->dirty = 0;
+    return line;
+}
+
+swd_error_t rp2350_mem_cache_sync(swd_target_t *target, uint32_t addr, uint32_t bytes,
+                                  bool drop) {
+    for (uint i = 0; i < RP2350_MEM_LINES; i++) {
+        mem_line_t *line = &target->rp2350.mem_lines[i];
+        if (!line->valid || !ranges_overlap(addr, bytes, line->base, MEM_LINE_BYTES)) {
+            continue;
+        }
+
+        swd_error_t err = mem_line_writeback(target, line);
+        if (err != SWD_OK) {
+            return err;
+        }
+        if (drop) {
+            line->valid = false;
+        }
+    }
+    return SWD_OK;
+}
+
+/**
+ * @brief Write back and empty the cache before the harts run
+ *
+ * Lines that could not be written back stay cached, so a retry can still
+ * write them.
+ */
+static swd_error_t mem_cache_release(swd_target_t *target) {
+    swd_error_t first = SWD_OK;
+    for (uint i = 0; i < RP2350_MEM_LINES; i++) {
+        mem_line_t *line = &target->rp2350.mem_lines[i];
+        swd_error_t err = mem_line_writeback(target, line);
+        if (err == SWD_OK) {
+            line->valid = false;
+        } else if (first == SWD_OK) {
+            first = err;
+        }
+    }
+    return first;
+}
+
+swd_error_t rp2350_enable_mem_cache(swd_target_t *target, bool enable) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!enable) {
+        swd_error_t err = mem_cache_release(target);
+        if (err != SWD_OK) {
+            return err;
+        }
+    }
+
+    target->rp2350.mem_cache_enabled = enable;
+    return SWD_OK;
+}
+
+swd_error_t rp2350_flush_mem_cache(swd_target_t *target) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    for (uint i = 0; i < RP2350_MEM_LINES; i++) {
+        swd_error_t err = mem_line_writeback(target, &target->rp2350.mem_lines[i]);
+        if (err != SWD_OK) {
+            return err;
+        }
+    }
+    return SWD_OK;
+}
+
+void rp2350_invalidate_mem_cache(swd_target_t *target) {
+    if (target) {
+        for (uint i = 0; i < RP2350_MEM_LINES; i++) {
+            target->rp2350.mem_lines[i].valid = false;
+        }
+    }
+}
+
+//==============================================================================
+// Gang Block Transfers
+//==============================================================================
+
+/**
+ * @brief Check a gang block transfer and pick which targets can use SBA
+ *
+ * Targets without SBA are left out of *sba and handled one at a time.
+ * Cached memory the block overlaps is synced as for a single target.
+ */
+static void gang_block_begin(swd_target_t *const *targets, uint count, uint32_t addr,
+                             uint32_t words, bool write, bool have_buffers,
+                             swd_error_t *results, bool *sba) {
+    for (uint i = 0; i < count; i++) {
+        sba[i] = false;
+        if (results[i] != SWD_OK) {
+            continue;
+        }
+        if (!targets[i] || !have_buffers) {
+            results[i] = SWD_ERROR_INVALID_PARAM;
+        } else if (!targets[i]->rp2350.initialized) {
+            results[i] = SWD_ERROR_NOT_INITIALIZED;
+        } else if (targets[i]->rp2350.sba_initialized) {
+            if (addr & 0x3) {
+                results[i] = SWD_ERROR_ALIGNMENT;
+            } else {
+                results[i] = rp2350_mem_cache_sync(targets[i], addr, words * 4, write);
+                if (results[i] == SWD_OK) {
+                    results[i] = dap_select_ap_bank(targets[i], AP_RISCV, 0);
+                }
+                sba[i] = (results[i] == SWD_OK);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run one gang chunk whose batches are open, then check SBA status
+ */
+static void gang_chunk_finish(swd_target_t *const *targets, uint count, uint32_t addr,
+                              bool write, uint32_t words, const uint32_t *sbcs,
+                              swd_error_t *step, swd_error_t *results, bool *sba) {
+    swd_batch_execute_gang(targets, count, step);
+
+    for (uint i = 0; i < count; i++) {
+        if (!sba[i]) {
+            continue;
+        }
+        if (step[i] == SWD_OK) {
+            step[i] = sba_check_status(targets[i], sbcs[i], addr);
+        }
+        if (step[i] != SWD_OK) {
+            results[i] = step[i];
+            sba[i] = false;
+        } else if (write) {
+            SWD_STAT_ADD(targets[i], bytes_written, words * 4);
+        } else {
+            SWD_STAT_ADD(targets[i], bytes_read, words * 4);
+        }
+    }
+}
+
+swd_error_t rp2350_gang_write_mem_block(swd_target_t *const *targets, uint count, uint32_t addr,
+                                        const uint32_t *buffer, uint32_t words,
+                                        swd_error_t *results) {
+    bool sba[SWD_GANG_MAX_TARGETS];
+    uint32_t sbcs[SWD_GANG_MAX_TARGETS];
+    swd_error_t step[SWD_GANG_MAX_TARGETS];
+
+    gang_block_begin(targets, count, addr, words, true, buffer != NULL, results, sba);
+
+    for (uint32_t done = 0; done < words; done += SBA_BATCH_CHUNK_WORDS) {
+        uint32_t n = words - done < SBA_BATCH_CHUNK_WORDS ? words - done : SBA_BATCH_CHUNK_WORDS;
+        uint32_t chunk_addr = addr + (done * 4);
+
+        // Targets outside the SBA set sit this chunk out
+        for (uint i = 0; i < count; i++) {
+            step[i] = sba[i] ? sba_queue_write_chunk(targets[i], chunk_addr, &buffer[done],
+                                                     n, &sbcs[i])
+                             : SWD_ERROR_INVALID_STATE;
+        }
+        gang_chunk_finish(targets, count, chunk_addr, true, n, sbcs, step, results, sba);
+    }
+
+    for (uint i = 0; i < count; i++) {
+        if (results[i] == SWD_OK && !targets[i]->rp2350.sba_initialized) {
+            results[i] = rp2350_write_mem_block(targets[i], addr, buffer, words);
+        }
+    }
+
+    return swd_gang_first_error(results, count);
+}
+
+swd_error_t rp2350_gang_read_mem_block(swd_target_t *const *targets, uint count, uint32_t addr,
+                                       uint32_t *const *buffers, uint32_t words,
+                                       swd_error_t *results) {
+    bool sba[SWD_GANG_MAX_TARGETS];
+    uint32_t sbcs[SWD_GANG_MAX_TARGETS];
+    swd_error_t step[SWD_GANG_MAX_TARGETS];
+
+    gang_block_begin(targets, count, addr, words, false, buffers != NULL, results, sba);
+    for (uint i = 0; i < count; i++) {
+        if (results[i] == SWD_OK && !buffers[i]) {
+            results[i] = SWD_ERROR_INVALID_PARAM;
+            sba[i] = false;
+        }
+    }
+
+    for (uint32_t done = 0; done < words; done += SBA_BATCH_CHUNK_WORDS) {
+        uint32_t n = words - done < SBA_BATCH_CHUNK_WORDS ? words - done : SBA_BATCH_CHUNK_WORDS;
+        uint32_t chunk_addr = addr + (done * 4);
+
+        for (uint i = 0; i < count; i++) {
+            step[i] = sba[i] ? sba_queue_read_chunk(targets[i], chunk_addr, &buffers[i][done],
+                                                    n, &sbcs[i])
+                             : SWD_ERROR_INVALID_STATE;
+        }
+        gang_chunk_finish(targets, count, chunk_addr, false, n, sbcs, step, results, sba);
+    }
+
+    for (uint i = 0; i < count; i++) {
+        if (results[i] == SWD_OK && !targets[i]->rp2350.sba_initialized) {
+            results[i] = rp2350_read_mem_block(targets[i], addr, buffers[i], words);
+        }
+    }
+
+    return swd_gang_first_error(results, count);
+}
+
+//==============================================================================
+// Code Execution
+//==============================================================================
+
+// CRC-32 (IEEE, reflected) over a1 words at a0, returned in a0, bit by bit
+static const uint32_t crc32_routine[] = {
+    0xedb88637,  //  0: lui  a2, 0xedb88
+    0x32060613,  //  4: addi a2, a2, 0x320      a2 = 0xEDB88320
+    0xfff00693,  //  8: li   a3, -1             crc
+    0x02058c63,  // 12: beqz a1, 68
+    0x00052703,  // 16: lw   a4, 0(a0)
+    0x00e6c6b3,  // 20: xor  a3, a3, a4
+    0x02000793,  // 24: li   a5, 32
+    0x0016f293,  // 28: andi t0, a3, 1
+    0x0016d693,  // 32: srli a3, a3, 1
+    0x405002b3,  // 36: neg  t0, t0
+    0x00c2f2b3,  // 40: and  t0, t0, a2
+    0x0056c6b3,  // 44: xor  a3, a3, t0
+    0xfff78793,  // 48: addi a5, a5, -1
+    0xfe0794e3,  // 52: bnez a5, 28
+    0x00450513,  // 56: addi a0, a0, 4
+    0xfff58593,  // 60: addi a1, a1, -1
+    0xfcdff06f,  // 64: j    12
+    0xfff6c513,  // 68: not  a0, a3
+    0x00008067,  // 72: ret
+};
+
+#define CRC32_ROUTINE_WORDS (sizeof(crc32_routine) / sizeof(crc32_routine[0]))
+
+// Words read back per block when verifying
+#define VERIFY_CHUNK_WORDS 64
+
+static uint32_t crc32_words(const uint32_t *words, uint32_t count) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < count; i++) {
+        crc ^= words[i];
+        for (uint bit = 0; bit < 32; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static swd_error_t verify_readback(swd_target_t *target, uint32_t addr,
+                                   const uint32_t *code, uint32_t word_count) {
+    uint32_t readback[VERIFY_CHUNK_WORDS];
+
+    for (uint32_t done = 0; done < word_count; done += VERIFY_CHUNK_WORDS) {
+        uint32_t n = word_count - done < VERIFY_CHUNK_WORDS ? word_count - done : VERIFY_CHUNK_WORDS;
+        swd_error_t err = rp2350_read_mem_block(target, addr + (done * 4), readback, n);
+        if (err != SWD_OK) {
+            return err;
+        }
+
+        for (uint32_t i = 0; i < n; i++) {
+            if (readback[i] != code[done + i]) {
+                swd_set_error(target, SWD_ERROR_VERIFY,
+                             "Verification failed at word %u: wrote 0x%08x, read 0x%08x",
+                             done + i, code[done + i], readback[i]);
+                return SWD_ERROR_VERIFY;
+            }
+        }
+    }
+    return SWD_OK;
+}
+
+/**
+ * @brief Have the hart CRC the image, using the 80 bytes after it
+ */
+static swd_error_t verify_crc(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                              const uint32_t *code, uint32_t word_count) {
+    uint32_t routine_addr = addr + (word_count * 4);
+    uint32_t trap_addr = routine_addr + sizeof(crc32_routine);
+
+    uint32_t saved[CRC32_ROUTINE_WORDS];
+    swd_error_t err = rp2350_read_mem_block(target, routine_addr, saved, CRC32_ROUTINE_WORDS);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    err = rp2350_write_mem_block(target, routine_addr, crc32_routine, CRC32_ROUTINE_WORDS);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    // About 45 cycles per byte; allow for a slow system clock
+    const uint32_t args[2] = {addr, word_count};
+    swd_result_t crc = rp2350_call(target, hart_id, routine_addr, args, 2, trap_addr,
+                                   100 + (word_count / 64));
+
+    err = rp2350_write_mem_block(target, routine_addr, saved, CRC32_ROUTINE_WORDS);
+    if (crc.error != SWD_OK) {
+        return crc.error;
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    uint32_t expected = crc32_words(code, word_count);
+    if (crc.value != expected) {
+        swd_set_error(target, SWD_ERROR_VERIFY,
+                     "CRC mismatch over %u words at 0x%08x: expected 0x%08x, target 0x%08x",
+                     word_count, addr, expected, crc.value);
+        return SWD_ERROR_VERIFY;
+    }
+    return SWD_OK;
+}
+
+swd_error_t rp2350_upload_image(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                                const uint32_t *code, uint32_t word_count,
+                                rp2350_verify_t verify) {
+    if (!target || !code || word_count == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (addr & 0x3) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    SWD_INFO("Uploading %lu words to 0x%08lx...\n", (unsigned long)word_count, (unsigned long)addr);
+
+    swd_error_t err = rp2350_write_mem_block(target, addr, code, word_count);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    switch (verify) {
+    case RP2350_VERIFY_NONE:
+        break;
+    case RP2350_VERIFY_READBACK:
+        err = verify_readback(target, addr, code, word_count);
+        break;
+    case RP2350_VERIFY_CRC:
+        err = verify_crc(target, hart_id, addr, code, word_count);
+        break;
+    default:
+        err = SWD_ERROR_INVALID_PARAM;
+        break;
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    SWD_INFO("Code upload complete\n");
+    return SWD_OK;
+}
+
+swd_error_t rp2350_upload_code(swd_target_t *target, uint32_t addr,
+                                const uint32_t *code, uint32_t word_count) {
+    return rp2350_upload_image(target, 0, addr, code, word_count, RP2350_VERIFY_READBACK);
+}
+
+swd_error_t rp2350_execute_image(swd_target_t *target, uint8_t hart_id, uint32_t entry_point,
+                                 const uint32_t *code, uint32_t word_count,
+                                 rp2350_verify_t verify) {
+    if (!target || !code) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    SWD_INFO("Executing code on hart%u at 0x%08lx (%lu words)...\n", hart_id, (unsigned long)entry_point, (unsigned long)word_count);
+
+    // Halt if needed (CRC verification runs on the hart)
+    bool was_halted = target->rp2350.harts[hart_id].halted;
+    if (!was_halted) {
+        swd_error_t err = rp2350_halt(target, hart_id);
+        if (err != SWD_OK && err != SWD_ERROR_ALREADY_HALTED) {
+            return err;
+        }
+    }
+
+    // Upload code
+    swd_error_t err = rp2350_upload_image(target, hart_id, entry_point, code, word_count, verify);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    // Set PC
+    err = rp2350_write_pc(target, hart_id, entry_point);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    // Verify PC
+    swd_result_t pc = rp2350_read_pc(target, hart_id);
+    if (pc.error != SWD_OK || pc.value != entry_point) {
+        swd_set_error(target, SWD_ERROR_VERIFY,
+                     "PC verification failed: expected 0x%08x, got 0x%08x",
+                     entry_point, pc.value);
+        return SWD_ERROR_VERIFY;
+    }
+
+    // Resume
+    err = rp2350_resume(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    SWD_INFO("Code execution started on hart%u\n", hart_id);
+    return SWD_OK;
+}
+
+swd_error_t rp2350_execute_code(swd_target_t *target, uint8_t hart_id, uint32_t entry_point,
+                                 const uint32_t *code, uint32_t word_count) {
+    return rp2350_execute_image(target, hart_id, entry_point, code, word_count,
+                                RP2350_VERIFY_READBACK);
+}
+
+//==============================================================================
+// Incremental Image Sync
+//==============================================================================
+
+// FNV-1a over a1 words at a0, one hash per a2-word page (the last may be
+// shorter), stored from a3 onwards
+static const uint32_t page_hash_routine[] = {
+    0x010003b7,  //  0: lui  t2, 0x01000
+    0x19338393,  //  4: addi t2, t2, 0x193      FNV prime
+    0x04058063,  //  8: beqz a1, 72             page:
+    0x811ca2b7,  // 12: lui  t0, 0x811ca
+    0xdc528293,  // 16: addi t0, t0, -571       h = 0x811C9DC5
+    0x00060313,  // 20: mv   t1, a2
+    0x00c5f463,  // 24: bgeu a1, a2, 32
+    0x00058313,  // 28: mv   t1, a1             short last page
+    0x406585b3,  // 32: sub  a1, a1, t1
+    0x00052703,  // 36: lw   a4, 0(a0)          word:
+    0x00e2c2b3,  // 40: xor  t0, t0, a4
+    0x027282b3,  // 44: mul  t0, t0, t2
+    0x00450513,  // 48: addi a0, a0, 4
+    0xfff30313,  // 52: addi t1, t1, -1
+    0xfe0316e3,  // 56: bnez t1, 36
+    0x0056a023,  // 60: sw   t0, 0(a3)
+    0x00468693,  // 64: addi a3, a3, 4
+    0xfc5ff06f,  // 68: j    8
+    0x00008067,  // 72: ret
+};
+
+#define PAGE_HASH_ROUTINE_WORDS (sizeof(page_hash_routine) / sizeof(page_hash_routine[0]))
+
+// Pages hashed per call; bounds the work area and the host buffers
+#define SYNC_BATCH_PAGES 64
+
+// Routine, return trap, then one hash per page of a batch
+#define SYNC_TRAP_OFFSET  (PAGE_HASH_ROUTINE_WORDS * 4)
+#define SYNC_HASH_OFFSET  (SYNC_TRAP_OFFSET + 4)
+#define SYNC_WORK_WORDS   (PAGE_HASH_ROUTINE_WORDS + 1 + SYNC_BATCH_PAGES)
+
+static uint32_t page_hash(const uint32_t *words, uint32_t count) {
+    uint32_t h = 0x811C9DC5;
+    for (uint32_t i = 0; i < count; i++) {
+        h = (h ^ words[i]) * 0x01000193;
+    }
+    return h;
+}
+
+/**
+ * @brief Hash the words of one batch on the hart
+ *
+ * hashes receives one entry per page, in address order.
+ */
+static swd_error_t sync_hash_batch(swd_target_t *target, uint8_t hart_id, uint32_t work,
+                                   uint32_t addr, uint32_t words, uint32_t *hashes) {
+    uint32_t pages = (words + RP2350_SYNC_PAGE_WORDS - 1) / RP2350_SYNC_PAGE_WORDS;
+
+    // A few cycles per word: a full batch takes well under a millisecond
+    const uint32_t args[4] = {addr, words, RP2350_SYNC_PAGE_WORDS, work + SYNC_HASH_OFFSET};
+    swd_result_t result = rp2350_call(target, hart_id, work, args, 4, work + SYNC_TRAP_OFFSET,
+                                      100);
+    if (result.error != SWD_OK) {
+        return result.error;
+    }
+
+    return rp2350_read_mem_block(target, work + SYNC_HASH_OFFSET, hashes, pages);
+}
+
+/**
+ * @brief Bring one batch in line with the image
+ *
+ * Runs of differing pages are written in one block each, then the batch
+ * is hashed again to confirm them.
+ */
+static swd_error_t sync_batch(swd_target_t *target, uint8_t hart_id, uint32_t work,
+                              uint32_t addr, const uint32_t *image, uint32_t words,
+                              uint32_t *written) {
+    uint32_t hashes[SYNC_BATCH_PAGES];
+    bool differs[SYNC_BATCH_PAGES];
+    uint32_t pages = (words + RP2350_SYNC_PAGE_WORDS - 1) / RP2350_SYNC_PAGE_WORDS;
+
+    swd_error_t err = sync_hash_batch(target, hart_id, work, addr, words, hashes);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    uint32_t dirty = 0;
+    for (uint32_t page = 0; page < pages; page++) {
+        uint32_t first = page * RP2350_SYNC_PAGE_WORDS;
+        uint32_t n = words - first < RP2350_SYNC_PAGE_WORDS ? words - first : RP2350_SYNC_PAGE_WORDS;
+        differs[page] = hashes[page] != page_hash(&image[first], n);
+        dirty += differs[page];
+    }
+    if (dirty == 0) {
+        return SWD_OK;
+    }
+
+    for (uint32_t page = 0; page < pages;) {
+        if (!differs[page]) {
+            page++;
+            continue;
+        }
+
+        uint32_t end = page;
+        while (end < pages && differs[end]) {
+            end++;
+        }
+
+        uint32_t first = page * RP2350_SYNC_PAGE_WORDS;
+        uint32_t last = end * RP2350_SYNC_PAGE_WORDS < words ? end * RP2350_SYNC_PAGE_WORDS : words;
+        err = rp2350_write_mem_block(target, addr + (first * 4), &image[first], last - first);
+        if (err != SWD_OK) {
+            return err;
+        }
+        page = end;
+    }
+    *written += dirty;
+
+    err = sync_hash_batch(target, hart_id, work, addr, words, hashes);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    for (uint32_t page = 0; page < pages; page++) {
+        uint32_t first = page * RP2350_SYNC_PAGE_WORDS;
+        uint32_t n = words - first < RP2350_SYNC_PAGE_WORDS ? words - first : RP2350_SYNC_PAGE_WORDS;
+        if (hashes[page] != page_hash(&image[first], n)) {
+            swd_set_error(target, SWD_ERROR_VERIFY,
+                         "Page at 0x%08x still differs after upload", addr + (first * 4));
+            return SWD_ERROR_VERIFY;
+        }
+    }
+    return SWD_OK;
+}
+
+swd_result_t rp2350_sync_image(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                               const uint32_t *image, uint32_t word_count) {
+    swd_result_t result = {.error = SWD_OK, .value = 0};
+
+    if (!target || !image || word_count == 0) {
+        result.error = SWD_ERROR_INVALID_PARAM;
+        return result;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        result.error = SWD_ERROR_INVALID_PARAM;
+        return result;
+    }
+
+    if (addr & 0x3) {
+        result.error = SWD_ERROR_ALIGNMENT;
+        return result;
+    }
+
+    uint32_t total_pages = (word_count + RP2350_SYNC_PAGE_WORDS - 1) / RP2350_SYNC_PAGE_WORDS;
+    uint32_t batch_pages = total_pages < SYNC_BATCH_PAGES ? total_pages : SYNC_BATCH_PAGES;
+    uint32_t work = addr + (word_count * 4);
+    uint32_t work_words = PAGE_HASH_ROUTINE_WORDS + 1 + batch_pages;
+
+    SWD_INFO("Syncing %lu pages at 0x%08lx...\n", (unsigned long)total_pages,
+             (unsigned long)addr);
+
+    uint32_t saved[SYNC_WORK_WORDS];
+    result.error = rp2350_read_mem_block(target, work, saved, work_words);
+    if (result.error != SWD_OK) {
+        return result;
+    }
+
+    result.error = rp2350_write_mem_block(target, work, page_hash_routine,
+                                          PAGE_HASH_ROUTINE_WORDS);
+
+    uint32_t batch_words = SYNC_BATCH_PAGES * RP2350_SYNC_PAGE_WORDS;
+    for (uint32_t done = 0; result.error == SWD_OK && done < word_count; done += batch_words) {
+        uint32_t n = word_count - done < batch_words ? word_count - done : batch_words;
+        result.error = sync_batch(target, hart_id, work, addr + (done * 4), &image[done], n,
+                                  &result.value);
+    }
+
+    swd_error_t err = rp2350_write_mem_block(target, work, saved, work_words);
+    if (result.error == SWD_OK) {
+        result.error = err;
+    }
+
+    if (result.error == SWD_OK) {
+        SWD_INFO("Sync complete: %lu of %lu pages uploaded\n", (unsigned long)result.value,
+                 (unsigned long)total_pages);
+    }
+    return result;
+}
+
+//==============================================================================
+// Target Function Calls
+//==============================================================================
+
+#define CSR_MSTATUS       0x300
+#define MSTATUS_MIE       (1u << 3)
+#define DCSR_EBREAKM      (1u << 15)
+#define DCSR_STEP         (1u << 2)
+#define INSN_EBREAK       0x00100073
+
+swd_error_t rp2350_call_wait(swd_target_t *target, uint8_t hart_id, uint32_t timeout_ms) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+
+    swd_error_t err = select_hart(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    swd_poll_t poll;
+    swd_poll_begin(target, &poll, SWD_WAIT_CALL);
+    poll.timeout_us = timeout_ms * 1000;
+    do {
+        swd_result_t result = dap_read_mem32(target, DM_DMSTATUS);
+        if (result.error != SWD_OK) {
+            return result.error;
+        }
+        if ((result.value >> 9) & 1) {  // allhalted
+            swd_poll_end(target, &poll, true);
+            hart->halted = true;
+            hart->halt_state_known = true;
+            rp2350_forget_regs(hart);
+            hart->scratch_held = false;
+            return SWD_OK;
+        }
+    } while (swd_poll_again(target, &poll));
+
+    swd_poll_end(target, &poll, false);
+    return SWD_ERROR_TIMEOUT;
+}
+
+swd_error_t rp2350_call_enter(swd_target_t *target, uint8_t hart_id, uint32_t func,
+                              const uint32_t *args, uint8_t nargs, uint32_t trap_addr,
+                              uint32_t sp, rp2350_call_frame_t *frame) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id) || nargs > 8 || (nargs > 0 && !args) || !frame) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if ((func & 0x1) || (trap_addr & 0x3) || (sp & 0xF)) {
+        return SWD_ERROR_ALIGNMENT;
+    }
+
+    if (!target->rp2350.harts[hart_id].halted) {
+        swd_set_error(target, SWD_ERROR_NOT_HALTED, "Hart %u must be halted to call a function",
+                     hart_id);
+        return SWD_ERROR_NOT_HALTED;
+    }
+
+    SWD_INFO("Calling 0x%08lx on hart%u...\n", (unsigned long)func, hart_id);
+
+    // Save what the call disturbs. CSRs first: rp2350_read_all_regs()
+    // reports the program's s0 even while the CSR engine borrows it.
+    swd_result_t dcsr = read_dcsr(target, hart_id);
+    swd_result_t mstatus = rp2350_read_csr(target, hart_id, CSR_MSTATUS);
+    swd_result_t pc = rp2350_read_pc(target, hart_id);
+    swd_result_t trap = rp2350_read_mem32(target, trap_addr);
+    swd_error_t err = rp2350_read_all_regs(target, hart_id, frame->regs);
+    if (err == SWD_OK) {
+        err = dcsr.error != SWD_OK ? dcsr.error :
+              mstatus.error != SWD_OK ? mstatus.error :
+              pc.error != SWD_OK ? pc.error : trap.error;
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    frame->dcsr = dcsr.value;
+    frame->mstatus = mstatus.value;
+    frame->pc = pc.value;
+    frame->trap_addr = trap_addr;
+    frame->trap_word = trap.value;
+
+    uint32_t call_regs[32];
+    memcpy(call_regs, frame->regs, sizeof(call_regs));
+    call_regs[1] = trap_addr;  // ra
+    if (sp) {
+        call_regs[2] = sp;
+    }
+    for (uint i = 0; i < nargs; i++) {
+        call_regs[10 + i] = args[i];
+    }
+
+    // ebreak in M-mode must enter debug mode rather than trap
+    err = rp2350_write_mem32(target, trap_addr, INSN_EBREAK);
+    if (err == SWD_OK) {
+        err = rp2350_write_csr(target, hart_id, CSR_MSTATUS, mstatus.value & ~MSTATUS_MIE);
+    }
+    if (err == SWD_OK) {
+        err = write_dcsr(target, hart_id, (dcsr.value | DCSR_EBREAKM) & ~DCSR_STEP);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_pc(target, hart_id, func);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_all_regs(target, hart_id, call_regs);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_resume(target, hart_id);
+    }
+    if (err != SWD_OK) {
+        rp2350_call_leave(target, hart_id, frame);
+    }
+    return err;
+}
+
+swd_error_t rp2350_call_leave(swd_target_t *target, uint8_t hart_id,
+                              const rp2350_call_frame_t *frame) {
+    if (!target->rp2350.harts[hart_id].halted) {
+        swd_error_t err = rp2350_halt(target, hart_id);
+        if (err != SWD_OK && err != SWD_ERROR_ALREADY_HALTED) {
+            return err;
+        }
+    }
+
+    // Put everything back, even after a failure
+    swd_error_t err = rp2350_write_all_regs(target, hart_id, frame->regs);
+    if (err == SWD_OK) {
+        err = rp2350_write_pc(target, hart_id, frame->pc);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_csr(target, hart_id, CSR_MSTATUS, frame->mstatus);
+    }
+    if (err == SWD_OK) {
+        err = write_dcsr(target, hart_id, frame->dcsr);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_mem32(target, frame->trap_addr, frame->trap_word);
+    }
+    return err;
+}
+
+swd_result_t rp2350_call(swd_target_t *target, uint8_t hart_id, uint32_t func,
+                         const uint32_t *args, uint8_t nargs, uint32_t trap_addr,
+                         uint32_t timeout_ms) {
+    swd_result_t result = {.error = SWD_OK, .value = 0};
+
+    rp2350_call_frame_t frame;
+    result.error = rp2350_call_enter(target, hart_id, func, args, nargs, trap_addr, 0, &frame);
+    if (result.error != SWD_OK) {
+        return result;
+    }
+
+    swd_error_t err = rp2350_call_wait(target, hart_id, timeout_ms);
+    if (err == SWD_OK) {
+        result = rp2350_read_reg(target, hart_id, 10);  // a0
+    } else {
+        result.error = err;
+        if (err == SWD_ERROR_TIMEOUT) {
+            swd_set_error(target, err, "Call to 0x%08x on hart %u did not return within %u ms",
+                         func, hart_id, timeout_ms);
+        }
+    }
+
+    err = rp2350_call_leave(target, hart_id, &frame);
+    if (result.error == SWD_OK) {
+        result.error = err;
+    }
+
+    return result;
+}
+
+//==============================================================================
+// Triggers
+//==============================================================================
+
+#define CSR_TSELECT 0x7a0
+#define CSR_TDATA1  0x7a1
+#define CSR_TDATA2  0x7a2
+
+// tdata1 as mcontrol (type 2): equal match, enter Debug Mode, M and U mode
+#define MCONTROL_TYPE       (2u << 28)
+#define MCONTROL_DMODE      (1u << 27)
+#define MCONTROL_ACTION     (0xFu << 12)
+#define MCONTROL_ACTION_DM  (1u << 12)
+#define MCONTROL_MATCH      (0xFu << 7)
+#define MCONTROL_M          (1u << 6)
+#define MCONTROL_U          (1u << 3)
+#define MCONTROL_EXECUTE    (1u << 2)
+#define MCONTROL_STORE      (1u << 1)
+#define MCONTROL_LOAD       (1u << 0)
+
+#define MCONTROL_BASE (MCONTROL_TYPE | MCONTROL_DMODE | MCONTROL_ACTION_DM | \
+                       MCONTROL_M | MCONTROL_U)
+
+// Fields that must read back as written for the trigger to do what was asked
+#define MCONTROL_CHECK (MCONTROL_ACTION | MCONTROL_MATCH | MCONTROL_M | \
+                        MCONTROL_EXECUTE | MCONTROL_STORE | MCONTROL_LOAD)
+
+static swd_error_t check_trigger_hart(swd_target_t *target, uint8_t hart_id) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.harts[hart_id].halted) {
+        return SWD_ERROR_NOT_HALTED;
+    }
+    return SWD_OK;
+}
+
+/**
+ * @brief Count the mcontrol triggers once per hart
+ *
+ * tselect is WARL: a value past the last trigger does not read back. A
+ * hart without a trigger module faults the first CSR access.
+ */
+static swd_error_t probe_triggers(swd_target_t *target, uint8_t hart_id) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (hart->triggers_probed) {
+        return SWD_OK;
+    }
+
+    uint8_t count = 0;
+    swd_error_t err = SWD_OK;
+    while (count < RP2350_MAX_TRIGGERS) {
+        err = rp2350_write_csr(target, hart_id, CSR_TSELECT, count);
+        swd_result_t sel = {.error = err};
+        if (err == SWD_OK) {
+            sel = rp2350_read_csr(target, hart_id, CSR_TSELECT);
+        }
+        if (sel.error != SWD_OK || sel.value != count) {
+            err = sel.error;
+            break;
+        }
+
+        swd_result_t tdata1 = rp2350_read_csr(target, hart_id, CSR_TDATA1);
+        if (tdata1.error != SWD_OK || (tdata1.value >> 28) != 2) {
+            err = tdata1.error;
+            break;
+        }
+        count++;
+    }
+
+    if (err == SWD_ERROR_ABSTRACT_CMD) {
+        err = SWD_OK;
+    }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    hart->trigger_count = count;
+    hart->triggers_probed = true;
+    SWD_INFO("Hart %u: %u triggers\n", hart_id, count);
+    return SWD_OK;
+}
+
+static swd_error_t write_trigger(swd_target_t *target, uint8_t hart_id, uint8_t index,
+                                 uint32_t tdata1, uint32_t tdata2) {
+    swd_error_t err = rp2350_write_csr(target, hart_id, CSR_TSELECT, index);
+    if (err == SWD_OK) {
+        // Disarmed while tdata2 changes
+        err = rp2350_write_csr(target, hart_id, CSR_TDATA1, 0);
+    }
+    if (err == SWD_OK && tdata1) {
+        err = rp2350_write_csr(target, hart_id, CSR_TDATA2, tdata2);
+        if (err == SWD_OK) {
+            err = rp2350_write_csr(target, hart_id, CSR_TDATA1, tdata1);
+        }
+    }
+    return err;
+}
+
+static swd_result_t alloc_trigger(swd_target_t *target, uint8_t hart_id, uint32_t tdata1,
+                                  uint32_t addr) {
+    swd_result_t result = {.error = check_trigger_hart(target, hart_id), .value = 0};
+    if (result.error == SWD_OK) {
+        result.error = probe_triggers(target, hart_id);
+    }
+    if (result.error != SWD_OK) {
+        return result;
+    }
+
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    uint8_t index = 0;
+    while (index < hart->trigger_count && (hart->trigger_used & (1u << index))) {
+        index++;
+    }
+    if (index == hart->trigger_count) {
+        swd_set_error(target, SWD_ERROR_RESOURCE_BUSY, "All %u triggers on hart %u in use",
+                      hart->trigger_count, hart_id);
+        result.error = SWD_ERROR_RESOURCE_BUSY;
+        return result;
+    }
+
+    result.error = write_trigger(target, hart_id, index, tdata1, addr);
+    swd_result_t readback = {.error = result.error};
+    if (result.error == SWD_OK) {
+        readback = rp2350_read_csr(target, hart_id, CSR_TDATA1);
+        result.error = readback.error;
+    }
+    if (result.error != SWD_OK) {
+        return result;
+    }
+
+    // WARL fields drop what the trigger cannot do (load/store on Hazard3)
+    if ((readback.value & MCONTROL_CHECK) != (tdata1 & MCONTROL_CHECK)) {
+        write_trigger(target, hart_id, index, 0, 0);
+        swd_set_error(target, SWD_ERROR_INVALID_CONFIG,
+                      "Trigger %u on hart %u cannot match 0x%08lx (reads back 0x%08lx)",
+                      index, hart_id, (unsigned long)tdata1, (unsigned long)readback.value);
+        result.error = SWD_ERROR_INVALID_CONFIG;
+        return result;
+    }
+
+    hart->trigger_used |= 1u << index;
+    hart->trigger_tdata1[index] = tdata1;
+    hart->trigger_addr[index] = addr;
+    result.value = index;
+    return result;
+}
+
+/**
+ * @brief Armed triggers that would fire before the next instruction completes
+ *
+ * Execute triggers on the current PC, and every load/store trigger since
+ * the access address is not known in advance.
+ */
+static swd_error_t triggers_in_way(swd_target_t *target, uint8_t hart_id, uint32_t *mask) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    *mask = 0;
+    if (!hart->trigger_used) {
+        return SWD_OK;
+    }
+
+    swd_result_t pc = rp2350_read_pc(target, hart_id);
+    if (pc.error != SWD_OK) {
+        return pc.error;
+    }
+
+    for (uint8_t i = 0; i < hart->trigger_count; i++) {
+        uint32_t tdata1 = hart->trigger_tdata1[i];
+        if (!(hart->trigger_used & (1u << i))) {
+            continue;
+        }
+        if ((tdata1 & (MCONTROL_LOAD | MCONTROL_STORE)) ||
+            hart->trigger_addr[i] == pc.value) {
+            *mask |= 1u << i;
+        }
+    }
+    return SWD_OK;
+}
+
+static swd_error_t triggers_arm(swd_target_t *target, uint8_t hart_id, uint32_t mask, bool arm) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    swd_error_t err = SWD_OK;
+    for (uint8_t i = 0; i < hart->trigger_count && err == SWD_OK; i++) {
+        if (mask & (1u << i)) {
+            err = write_trigger(target, hart_id, i, arm ? hart->trigger_tdata1[i] : 0,
+                                hart->trigger_addr[i]);
+        }
+    }
+    return err;
+}
+
+/**
+ * @brief Re-arm triggers disarmed around a step or trace and pass its error on
+ *
+ * A hart that is no longer known halted cannot take the CSR writes, so
+ * the triggers are released instead: they are already disarmed on the
+ * hart, and their slots must not stay marked as armed.
+ */
+static swd_error_t triggers_rearm(swd_target_t *target, uint8_t hart_id, uint32_t mask,
+                                  swd_error_t err) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (!mask) {
+        return err;
+    }
+
+    if (hart->halted) {
+        swd_error_t arm_err = triggers_arm(target, hart_id, mask, true);
+        return err == SWD_OK ? arm_err : err;
+    }
+
+    if (err == SWD_OK) {
+        err = SWD_ERROR_NOT_HALTED;
+    }
+    hart->trigger_used &= ~mask;
+    swd_set_error(target, err, "Hart %u not known halted (%s): triggers 0x%02lx released",
+                  hart_id, swd_error_string(err), (unsigned long)mask);
+    return err;
+}
+
+swd_result_t rp2350_trigger_count(swd_target_t *target, uint8_t hart_id) {
+    swd_result_t result = {.error = check_trigger_hart(target, hart_id), .value = 0};
+    if (result.error == SWD_OK) {
+        result.error = probe_triggers(target, hart_id);
+    }
+    if (result.error == SWD_OK) {
+        result.value = target->rp2350.harts[hart_id].trigger_count;
+    }
+    return result;
+}
+
+swd_result_t rp2350_set_breakpoint(swd_target_t *target, uint8_t hart_id, uint32_t addr) {
+    if (addr & 1) {
+        swd_result_t result = {.error = SWD_ERROR_ALIGNMENT, .value = 0};
+        return result;
+    }
+    return alloc_trigger(target, hart_id, MCONTROL_BASE | MCONTROL_EXECUTE, addr);
+}
+
+swd_result_t rp2350_set_watchpoint(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                                   rp2350_watch_t kind) {
+    uint32_t match = 0;
+    if (kind & RP2350_WATCH_LOAD) {
+        match |= MCONTROL_LOAD;
+    }
+    if (kind & RP2350_WATCH_STORE) {
+        match |= MCONTROL_STORE;
+    }
+    if (!match || (kind & ~RP2350_WATCH_ACCESS)) {
+        swd_result_t result = {.error = SWD_ERROR_INVALID_PARAM, .value = 0};
+        return result;
+    }
+    return alloc_trigger(target, hart_id, MCONTROL_BASE | match, addr);
+}
+
+swd_error_t rp2350_clear_trigger(swd_target_t *target, uint8_t hart_id, uint32_t index) {
+    swd_error_t err = check_trigger_hart(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (index >= hart->trigger_count || !(hart->trigger_used & (1u << index))) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Trigger %lu on hart %u not set",
+                      (unsigned long)index, hart_id);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    err = write_trigger(target, hart_id, (uint8_t)index, 0, 0);
+    if (err == SWD_OK) {
+        hart->trigger_used &= ~(1u << index);
+    }
+    return err;
+}
+
+swd_error_t rp2350_clear_triggers(swd_target_t *target, uint8_t hart_id) {
+    swd_error_t err = check_trigger_hart(target, hart_id);
+    if (err == SWD_OK) {
+        err = probe_triggers(target, hart_id);
+    }
+
+    // Every slot, including any left armed by an earlier session
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    for (uint8_t i = 0; i < hart->trigger_count && err == SWD_OK; i++) {
+        err = write_trigger(target, hart_id, i, 0, 0);
+    }
+    if (err == SWD_OK) {
+        hart->trigger_used = 0;
+    }
+    return err;
+}
+
+swd_error_t rp2350_wait_halt(swd_target_t *target, uint8_t hart_id, uint32_t timeout_ms) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (target->rp2350.harts[hart_id].halted) {
+        return SWD_OK;
     }
+    return rp2350_call_wait(target, hart_id, timeout_ms);
 }
 
-void rp2350_enable_cache(swd_target_t *target, bool enable) {
-    if (target) {
-        target->rp2350.cache_enabled = enable;
-        if (!enable) {
-            // Invalidate all hart caches
-            for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
-                target->rp2350.harts[i].cache_valid = false;
-            }
+swd_error_t rp2350_run_until(swd_target_t *target, uint8_t hart_id, uint32_t addr,
+                             uint32_t timeout_ms) {
+    swd_error_t err = check_trigger_hart(target, hart_id);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    swd_result_t pc = rp2350_read_pc(target, hart_id);
+    if (pc.error != SWD_OK || pc.value == addr) {
+        return pc.error;
+    }
+
+    swd_result_t bp = rp2350_set_breakpoint(target, hart_id, addr);
+    if (bp.error != SWD_OK) {
+        return bp.error;
+    }
+
+    SWD_INFO("Running hart %u to 0x%08lx\n", hart_id, (unsigned long)addr);
+    err = rp2350_resume(target, hart_id);
+    if (err == SWD_OK) {
+        err = rp2350_call_wait(target, hart_id, timeout_ms);
+        if (err == SWD_ERROR_TIMEOUT) {
+            swd_set_error(target, err, "Hart %u did not reach 0x%08lx in %lu ms", hart_id,
+                          (unsigned long)addr, (unsigned long)timeout_ms);
+            rp2350_halt(target, hart_id);
+        }
+    }
+
+    // The breakpoint can only be disarmed on a halted hart; if resume or
+    // the wait failed, try to halt it first
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (!hart->halted) {
+        rp2350_halt(target, hart_id);
+    }
+    swd_error_t clear_err = hart->halted ? rp2350_clear_trigger(target, hart_id, bp.value)
+                                         : SWD_ERROR_NOT_HALTED;
+    if (clear_err != SWD_OK) {
+        // Still armed on the hart until rp2350_clear_triggers(), but no
+        // longer taken
+        hart->trigger_used &= ~(1u << bp.value);
+        if (err == SWD_OK) {
+            err = clear_err;
         }
     }
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    pc = rp2350_read_pc(target, hart_id);
+    if (pc.error == SWD_OK && pc.value != addr) {
+        swd_set_error(target, SWD_ERROR_ALREADY_HALTED,
+                      "Hart %u stopped at 0x%08lx before reaching 0x%08lx", hart_id,
+                      (unsigned long)pc.value, (unsigned long)addr);
+        return SWD_ERROR_ALREADY_HALTED;
+    }
+    return pc.error;
 }
 
 //==============================================================================
-// System Bus Access (SBA) Initialization
+// Instruction Tracing
 //==============================================================================
 
-static swd_error_t rp2350_init_sba(swd_target_t *target) {
-    SWD_INFO("Initializing System Bus Access...\n");
+// Host-side instruction fetch cache, one per trace: direct-mapped by word
+#define TRACE_FETCH_WORDS 64
+
+typedef struct {
+    uint32_t tag[TRACE_FETCH_WORDS];    // Word address | 1, 0 = empty
+    uint32_t word[TRACE_FETCH_WORDS];
+    uint32_t hits;
+    uint32_t misses;
+} fetch_cache_t;
+
+static swd_error_t fetch_word(swd_target_t *target, fetch_cache_t *cache, uint32_t addr,
+                              uint32_t *word) {
+    uint32_t slot = (addr >> 2) % TRACE_FETCH_WORDS;
+    if (cache->tag[slot] == (addr | 1)) {
+        cache->hits++;
+        *word = cache->word[slot];
+        return SWD_OK;
+    }
 
-    // Read SBCS
-    swd_result_t result = dap_read_mem32(target, DM_SBCS);
+    swd_result_t result = rp2350_read_mem32(target, addr);
     if (result.error != SWD_OK) {
         return result.error;
     }
+    cache->misses++;
+    cache->tag[slot] = addr | 1;
+    cache->word[slot] = result.value;
+    *word = result.value;
+    return SWD_OK;
+}
 
-    // Check 32-bit support via sbasize field (bits [11:5])
-    // sbasize indicates address width; we check sbaccess support by attempting to set it
-    uint32_t sbasize = (result.value >> 5) & 0x7F;
-    if (sbasize == 0) {
-        SWD_WARN("SBA: No address width reported (sbasize=0)\n");
-        return SWD_ERROR_INVALID_STATE;
+/**
+ * @brief Instruction word at pc, which may be halfword-aligned (RVC)
+ */
+static swd_error_t fetch_insn(swd_target_t *target, fetch_cache_t *cache, uint32_t pc,
+                              uint32_t *insn) {
+    uint32_t lo;
+    swd_error_t err = fetch_word(target, cache, pc & ~3u, &lo);
+    if (err != SWD_OK || (pc & 2) == 0) {
+        *insn = lo;
+        return err;
     }
 
-    // Clear errors
-    uint8_t sberror = (result.value >> 12) & 0x7;
-    if (sberror != 0) {
-        uint32_t sbcs = result.value | (0x7 << 12);
-        dap_write_mem32(target, DM_SBCS, sbcs);
+    // A compressed instruction ends here; do not touch the next word
+    lo >>= 16;
+    if ((lo & 3) != 3) {
+        *insn = lo;
+        return SWD_OK;
     }
 
-    // Configure: 32-bit, auto-read on address
-    uint32_t sbcs = 0;
-    sbcs |= (2 << 17);  // sbaccess = 32-bit
-    sbcs |= (1 << 20);  // sbreadonaddr
+    uint32_t hi;
+    err = fetch_word(target, cache, (pc & ~3u) + 4, &hi);
+    *insn = lo | (hi << 16);
+    return err;
+}
 
-    swd_error_t err = dap_write_mem32(target, DM_SBCS, sbcs);
-    if (err == SWD_OK) {
-        target->rp2350.sba_initialized = true;
-        SWD_INFO("SBA initialized\n");
+int rp2350_trace(swd_target_t *target, uint8_t hart_id, uint32_t max_instructions,
+                 trace_callback_t callback, void *user_data,
+                 bool capture_regs) {
+    if (!target || !callback) {
+        return -SWD_ERROR_INVALID_PARAM;
     }
 
-    return err;
+    if (!target->rp2350.initialized) {
+        return -SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        return -SWD_ERROR_INVALID_PARAM;
+    }
+
+    // Ensure hart is halted before we start
+    if (!target->rp2350.harts[hart_id].halted) {
+        swd_error_t err = rp2350_halt(target, hart_id);
+        if (err != SWD_OK && err != SWD_ERROR_ALREADY_HALTED) {
+            return -err;
+        }
+    }
+
+    fetch_cache_t fetch = {0};
+    uint32_t count = 0;
+    bool unlimited = (max_instructions == 0);
+
+    SWD_INFO("Starting instruction trace on hart%u (max=%lu, capture_regs=%d)...\n",
+             hart_id, (unsigned long)max_instructions, capture_regs);
+
+    while (unlimited || count < max_instructions) {
+        trace_record_t record = {0};
+
+        // Read PC
+        swd_result_t pc_result = rp2350_read_pc(target, hart_id);
+        if (pc_result.error != SWD_OK) {
+            SWD_INFO("Trace stopped: failed to read PC\n");
+            return count > 0 ? (int)count : -pc_result.error;
+        }
+        record.pc = pc_result.value;
+
+        // Read instruction at PC (code does not change while tracing)
+        swd_error_t inst_err = fetch_insn(target, &fetch, record.pc, &record.instruction);
+        if (inst_err != SWD_OK) {
+            SWD_INFO("Trace stopped: failed to read instruction at 0x%08lx\n", (unsigned long)record.pc);
+            return count > 0 ? (int)count : -inst_err;
+        }
+
+        // Optional: Capture all registers
+        if (capture_regs) {
+            swd_error_t err = rp2350_read_all_regs(target, hart_id, record.regs);
+            if (err != SWD_OK) {
+                SWD_INFO("Trace stopped: failed to read registers\n");
+                return count > 0 ? (int)count : -err;
+            }
+        }
+
+        // Count this instruction as traced
+        count++;
+
+        // Call user callback
+        if (!callback(&record, user_data)) {
+            SWD_INFO("Trace stopped by callback after %lu instructions\n", (unsigned long)count);
+            break;
+        }
+
+        // Execute one instruction
+        swd_error_t err = rp2350_step(target, hart_id);
+        if (err != SWD_OK) {
+            SWD_INFO("Trace stopped: step failed\n");
+            return count > 0 ? (int)count : -err;
+        }
+    }
+
+    SWD_INFO("Trace completed: %lu instructions\n", (unsigned long)count);
+    return (int)count;
 }
 
-//==============================================================================
-// Memory Access
-//==============================================================================
+// DCSR/DPC CSR numbers and DCSR.step
+#define CSR_DCSR       0x7b0
+#define CSR_DPC        0x7b1
+#define DCSR_STEP      (1u << 2)
 
-swd_result_t rp2350_read_mem32(swd_target_t *target, uint32_t addr) {
-    swd_result_t result = {.error = SWD_ERROR_NOT_INITIALIZED, .value = 0};
+/**
+ * @brief Step once with DCSR.step already set and return the new PC
+ *
+ * A single batch puts s0 back, resumes, then fetches s0 (the program's
+ * value, kept as scratch again) and DPC via "csrr s0, dpc" in the program
+ * buffer. The hart halts again long before the next SWD transaction, so
+ * the commands rarely find it running. Their success is what shows the
+ * halt; only if they fail with cmderr 4 (neither ran) are they repeated
+ * once DMSTATUS shows the halt.
+ */
+static swd_error_t trace_step(swd_target_t *target, uint8_t hart_id, uint32_t *pc) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
 
-    if (!target || !target->rp2350.initialized) {
-        return result;
+    const uint32_t progbuf[] = {csrr_s0(CSR_DPC), 0x00100073};  // ebreak
+    swd_error_t err = mem_cache_release(target);
+
+    // Pending register writes go first; a held s0 alone goes in the batch
+    if (err == SWD_OK && (hart->gpr_dirty || hart->csr_dirty)) {
+        err = flush_regs(target, hart_id);
+    }
+    if (err == SWD_OK) {
+        err = write_progbuf(target, progbuf, 2);
+    }
+    if (err == SWD_OK) {
+        err = dap_select_ap_bank(target, AP_RISCV, 0);
+    }
+    if (err == SWD_OK) {
+        err = swd_batch_begin(target);
+    }
+    if (err != SWD_OK) {
+        return err;
     }
 
-    if (addr & 0x3) {
-        result.error = SWD_ERROR_ALIGNMENT;
-        return result;
+    uint32_t new_s0 = 0, dpc = 0, abstractcs = 0;
+
+    if (hart->scratch_held) {
+        queue_dm_write(target, DM_DATA0, hart->scratch_s0);
+        queue_dm_write(target, DM_COMMAND, CMD_TRANSFER_S0 | CMD_AR_WRITE);
+    }
+    queue_dm_write(target, DM_DMCONTROL, make_dmcontrol(hart_id, false, true, false));
+
+    // s0 -> DATA0, then s0 = dpc
+    queue_dm_write(target, DM_COMMAND, CMD_TRANSFER_S0 | CMD_POSTEXEC);
+    swd_batch_queue_write(target, true, AP_TAR, DM_DATA0);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_read(target, false, DP_RDBUFF, &new_s0);
+
+    // dpc (in s0) -> DATA0
+    queue_dm_write(target, DM_COMMAND, CMD_TRANSFER_S0);
+    swd_batch_queue_write(target, true, AP_TAR, DM_DATA0);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_write(target, true, AP_TAR, DM_ABSTRACTCS);
+    swd_batch_queue_read(target, true, AP_DRW, &dpc);
+    swd_batch_queue_read(target, false, DP_RDBUFF, &abstractcs);
+
+    err = swd_batch_execute(target);
+
+    // s0 was written back before the resume
+    hart->scratch_held = false;
+    rp2350_forget_regs(hart);
+    hart->halted = false;
+    hart->halt_state_known = true;
+    if (err != SWD_OK) {
+        hart->halt_state_known = false;
+        return err;
     }
 
-    // Use SBA if available
-    if (target->rp2350.sba_initialized) {
-        // Write address
-        result.error = dap_write_mem32(target, DM_SBADDRESS0, addr);
-        if (result.error != SWD_OK) {
-            return result;
+    uint8_t cmderr = (abstractcs >> 8) & 0x7;
+    bool busy = (abstractcs >> 12) & 1;
+
+    // Abstract commands only succeed on a halted hart, whatever the
+    // DMSTATUS read straight after the resume showed
+    if (cmderr == 0 && !busy) {
+        hart->halted = true;
+        hart->scratch_s0 = new_s0;
+        hart->scratch_held = true;
+        *pc = dpc;
+        return SWD_OK;
+    }
+
+    // cmderr 4: the hart was still running, so neither command ran
+    if (busy || cmderr != 4) {
+        if (!busy) {
+            dap_write_mem32(target, DM_ABSTRACTCS, 0x00000700);
         }
+        swd_set_error(target, SWD_ERROR_ABSTRACT_CMD,
+                     "Trace step DPC fetch failed (abstractcs=0x%08lx)",
+                     (unsigned long)abstractcs);
+        return SWD_ERROR_ABSTRACT_CMD;
+    }
+    dap_write_mem32(target, DM_ABSTRACTCS, 0x00000700);
 
-        // Read data
-        result = dap_read_mem32(target, DM_SBDATA0);
-    } else {
-        // Fallback to DAP
-        result = dap_read_mem32(target, addr);
+    err = poll_dmstatus_halted(target, hart_id, true);
+    if (err != SWD_OK) {
+        swd_set_error(target, err, "Step did not halt");
+        return err;
     }
 
-    return result;
+    err = run_command(target, CMD_TRANSFER_S0 | CMD_POSTEXEC);
+    swd_result_t data0 = {.error = err, .value = 0};
+    if (err == SWD_OK) {
+        data0 = dap_read_mem32(target, DM_DATA0);
+    }
+    if (data0.error != SWD_OK) {
+        return data0.error;
+    }
+    hart->scratch_s0 = data0.value;
+    hart->scratch_held = true;
+
+    err = run_command(target, CMD_TRANSFER_S0);
+    if (err == SWD_OK) {
+        data0 = dap_read_mem32(target, DM_DATA0);
+        *pc = data0.value;
+        err = data0.error;
+    }
+    return err;
 }
 
-swd_error_t rp2350_write_mem32(swd_target_t *target, uint32_t addr, uint32_t value) {
-    if (!target || !target->rp2350.initialized) {
-        return SWD_ERROR_NOT_INITIALIZED;
+static bool trace_ring_push(trace_ring_t *ring, uint32_t pc, uint32_t instruction) {
+    if (ring->head - ring->tail >= ring->capacity) {
+        if (!ring->overwrite) {
+            return false;
+        }
+        // Only with no concurrent consumer: tail is the consumer's otherwise
+        ring->tail++;
+        ring->dropped++;
     }
 
-    if (addr & 0x3) {
-        return SWD_ERROR_ALIGNMENT;
+    trace_entry_t *entry = &ring->entries[ring->head % ring->capacity];
+    entry->pc = pc;
+    entry->instruction = instruction;
+    __dmb();  // Fill the slot before publishing it
+    ring->head++;
+    return true;
+}
+
+bool rp2350_trace_ring_pop(trace_ring_t *ring, trace_entry_t *entry) {
+    if (!ring || !entry || ring->head == ring->tail) {
+        return false;
     }
 
-    // Use SBA if available
-    if (target->rp2350.sba_initialized) {
-        swd_error_t err = dap_write_mem32(target, DM_SBADDRESS0, addr);
-        if (err != SWD_OK) {
-            return err;
+    __dmb();  // Read the slot only after seeing it published
+    *entry = ring->entries[ring->tail % ring->capacity];
+    __dmb();  // Finish reading the slot before handing it back
+    ring->tail++;
+    return true;
+}
+
+int rp2350_trace_stream(swd_target_t *target, uint8_t hart_id, uint32_t max_instructions,
+                        trace_ring_t *ring) {
+    if (!target || !ring || !ring->entries || ring->capacity == 0) {
+        return -SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return -SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    if (!validate_hart_id(hart_id)) {
+        return -SWD_ERROR_INVALID_PARAM;
+    }
+
+    // With neither a limit nor a full ring to stop at, the trace would never end
+    if (max_instructions == 0 && ring->overwrite) {
+        return -SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.harts[hart_id].halted) {
+        swd_error_t err = rp2350_halt(target, hart_id);
+        if (err != SWD_OK && err != SWD_ERROR_ALREADY_HALTED) {
+            return -err;
         }
+    }
 
-        return dap_write_mem32(target, DM_SBDATA0, value);
-    } else {
-        return dap_write_mem32(target, addr, value);
+    // trace_step() resumes directly, so every trigger would fire on the
+    // instruction it guards; they are disarmed for the whole trace
+    uint32_t armed = target->rp2350.harts[hart_id].trigger_used;
+    swd_error_t err = triggers_arm(target, hart_id, armed, false);
+    if (err != SWD_OK) {
+        return -err;
     }
-}
 
-swd_result_t rp2350_read_mem16(swd_target_t *target, uint32_t addr) {
-    swd_result_t result = {.error = SWD_ERROR_NOT_INITIALIZED, .value = 0};
+    // Single-step mode for the whole trace
+    swd_result_t dcsr = read_dcsr(target, hart_id);
+    err = dcsr.error;
+    if (err == SWD_OK) {
+        err = write_dcsr(target, hart_id, dcsr.value | DCSR_STEP);
+    }
+    if (err != SWD_OK) {
+        return -triggers_rearm(target, hart_id, armed, err);
+    }
+
+    swd_result_t pc = rp2350_read_pc(target, hart_id);
+    err = pc.error;
+
+    fetch_cache_t fetch = {0};
+    uint32_t count = 0;
+    bool unlimited = (max_instructions == 0);
+
+    SWD_INFO("Starting streamed trace on hart%u (max=%lu)...\n",
+             hart_id, (unsigned long)max_instructions);
+
+    while (err == SWD_OK && (unlimited || count < max_instructions)) {
+        uint32_t insn;
+        err = fetch_insn(target, &fetch, pc.value, &insn);
+        if (err != SWD_OK) {
+            break;
+        }
 
-    if (!target) {
-        return result;
-    }
+        if (!trace_ring_push(ring, pc.value, insn)) {
+            break;  // Ring full
+        }
+        count++;
 
-    if (addr & 0x1) {
-        result.error = SWD_ERROR_ALIGNMENT;
-        return result;
+        if (!unlimited && count == max_instructions) {
+            break;  // Leave the hart at the last traced instruction
+        }
+
+        err = trace_step(target, hart_id, &pc.value);
     }
 
-    // Read aligned word
-    uint32_t aligned_addr = addr & ~3;
-    result = rp2350_read_mem32(target, aligned_addr);
-    if (result.error != SWD_OK) {
-        return result;
+    // Leave step mode and re-arm the triggers; the hart stays halted
+    swd_error_t restore_err = write_dcsr(target, hart_id, dcsr.value);
+    if (err == SWD_OK) {
+        err = restore_err;
     }
+    err = triggers_rearm(target, hart_id, armed, err);
 
-    // Extract halfword
-    uint32_t offset = addr & 3;
-    if (offset == 0) {
-        result.value = result.value & 0xFFFF;
-    } else {
-        result.value = (result.value >> 16) & 0xFFFF;
+    if (err != SWD_OK) {
+        SWD_INFO("Streamed trace stopped after %lu instructions: %s\n",
+                 (unsigned long)count, swd_error_string(err));
+        return count > 0 ? (int)count : -(int)err;
     }
 
-    return result;
+    SWD_INFO("Streamed trace completed: %lu instructions\n", (unsigned long)count);
+    return (int)count;
 }
 
-swd_error_t rp2350_write_mem16(swd_target_t *target, uint32_t addr, uint16_t value) {
-    if (!target) {
-        return SWD_ERROR_INVALID_PARAM;
-    }
+//==============================================================================
+// Compact Trace
+//==============================================================================
 
-    if (addr & 0x1) {
-        return SWD_ERROR_ALIGNMENT;
-    }
+#define GPR_ALL_WRITABLE 0xFFFFFFFEu   // x1-x31
 
-    // Read-modify-write
-    uint32_t aligned_addr = addr & ~3;
-    swd_result_t current = rp2350_read_mem32(target, aligned_addr);
-    if (current.error != SWD_OK) {
-        return current.error;
-    }
+// Registers written above which one bulk read beats reading them one by one
+#define TRACE_BULK_MIN 4
 
-    uint32_t offset = addr & 3;
-    uint32_t new_value;
-    if (offset == 0) {
-        new_value = (current.value & 0xFFFF0000) | value;
-    } else {
-        new_value = (current.value & 0x0000FFFF) | ((uint32_t)value << 16);
+/**
+ * @brief GPRs an instruction can write
+ *
+ * Decodes rd for RV32 and the C/Zcb compressed forms. Anything not
+ * recognised (Zcmp push/pop among them) may write every register.
+ */
+static uint32_t insn_written_regs(uint32_t insn) {
+    uint32_t rd = (insn >> 7) & 0x1F;
+    uint32_t mask;
+
+    if ((insn & 3) == 3) {
+        switch (insn & 0x7F) {
+            case 0x23:  // STORE
+            case 0x63:  // BRANCH
+            case 0x0F:  // MISC-MEM
+                return 0;
+            case 0x37:  // LUI
+            case 0x17:  // AUIPC
+            case 0x6F:  // JAL
+            case 0x67:  // JALR
+            case 0x03:  // LOAD
+            case 0x13:  // OP-IMM
+            case 0x33:  // OP
+            case 0x2F:  // AMO
+            case 0x0B:  // custom-0 (Xh3bextm)
+            case 0x73:  // SYSTEM: CSR ops write rd; ecall/ebreak/mret have rd = 0
+                mask = 1u << rd;
+                break;
+            default:
+                return GPR_ALL_WRITABLE;
+        }
+        return mask & GPR_ALL_WRITABLE;
     }
 
-    return rp2350_write_mem32(target, aligned_addr, new_value);
-}
+    uint32_t funct3 = (insn >> 13) & 7;
+    uint32_t rd_low = 8 + ((insn >> 2) & 7);    // rd' in bits 4:2
+    uint32_t rd_high = 8 + ((insn >> 7) & 7);   // rd'/rs1' in bits 9:7
+    uint32_t rs2 = (insn >> 2) & 0x1F;
+    bool bit12 = (insn >> 12) & 1;
 
-swd_result_t rp2350_read_mem8(swd_target_t *target, uint32_t addr) {
-    swd_result_t result = rp2350_read_mem32(target, addr & ~3);
-    if (result.error == SWD_OK) {
-        uint32_t offset = addr & 3;
-        result.value = (result.value >> (offset * 8)) & 0xFF;
+    switch (((insn & 3) << 3) | funct3) {
+        case (0 << 3) | 0:  // c.addi4spn
+        case (0 << 3) | 2:  // c.lw
+            mask = 1u << rd_low;
+            break;
+        case (0 << 3) | 4:  // Zcb: c.lbu, c.lhu, c.lh write rd'; c.sb, c.sh do not
+            mask = (((insn >> 10) & 7) <= 1) ? 1u << rd_low : 0;
+            break;
+        case (0 << 3) | 6:  // c.sw
+        case (1 << 3) | 5:  // c.j
+        case (1 << 3) | 6:  // c.beqz
+        case (1 << 3) | 7:  // c.bnez
+        case (2 << 3) | 6:  // c.swsp
+            return 0;
+        case (1 << 3) | 0:  // c.addi
+        case (1 << 3) | 2:  // c.li
+        case (1 << 3) | 3:  // c.lui, c.addi16sp
+        case (2 << 3) | 0:  // c.slli
+        case (2 << 3) | 2:  // c.lwsp
+            mask = 1u << rd;
+            break;
+        case (1 << 3) | 1:  // c.jal
+            mask = 1u << 1;
+            break;
+        case (1 << 3) | 4:  // c.srli ... c.and, Zcb c.zext/c.not/c.mul
+            mask = 1u << rd_high;
+            break;
+        case (2 << 3) | 4:
+            if (rs2 != 0) {
+                mask = 1u << rd;            // c.mv, c.add
+            } else if (bit12 && rd != 0) {
+                mask = 1u << 1;             // c.jalr
+            } else {
+                return 0;                   // c.jr, c.ebreak
+            }
+            break;
+        default:
+            return GPR_ALL_WRITABLE;
     }
-    return result;
+    return mask & GPR_ALL_WRITABLE;
 }
 
-swd_error_t rp2350_write_mem8(swd_target_t *target, uint32_t addr, uint8_t value) {
-    uint32_t aligned_addr = addr & ~3;
-    swd_result_t current = rp2350_read_mem32(target, aligned_addr);
-    if (current.error != SWD_OK) {
-        return current.error;
+/**
+ * @brief Read the registers in mask into regs
+ */
+static swd_error_t trace_read_regs(swd_target_t *target, uint8_t hart_id, uint32_t mask,
+                                   uint32_t regs[32], trace_compact_t *trace) {
+    if ((uint32_t)__builtin_popcount(mask) > TRACE_BULK_MIN) {
+        trace->reg_reads += 31;
+        return rp2350_read_all_regs(target, hart_id, regs);
     }
 
-    uint32_t offset = addr & 3;
-    uint32_t mask = ~(0xFF << (offset * 8));
-    uint32_t new_value = (current.value & mask) | ((uint32_t)value << (offset * 8));
-
-    return rp2350_write_mem32(target, aligned_addr, new_value);
+    for (uint8_t r = 1; r < 32; r++) {
+        if (mask & (1u << r)) {
+            swd_result_t result = rp2350_read_reg(target, hart_id, r);
+            if (result.error != SWD_OK) {
+                return result.error;
+            }
+            regs[r] = result.value;
+            trace->reg_reads++;
+        }
+    }
+    return SWD_OK;
 }
 
-swd_error_t rp2350_read_mem_block(swd_target_t *target, uint32_t addr,
-                                   uint32_t *buffer, uint32_t count) {
-    if (!target || !buffer) {
-        return SWD_ERROR_INVALID_PARAM;
+int rp2350_trace_compact(swd_target_t *target, uint8_t hart_id, uint32_t max_instructions,
+                         trace_compact_t *trace) {
+    if (!target || !trace || !trace->records || trace->record_capacity == 0 ||
+        trace->regs > TRACE_REGS_RD ||
+        (trace->regs != TRACE_REGS_NONE && !trace->values && trace->value_capacity > 0)) {
+        return -SWD_ERROR_INVALID_PARAM;
     }
 
-    for (uint32_t i = 0; i < count; i++) {
-        swd_result_t result = rp2350_read_mem32(target, addr + (i * 4));
-        if (result.error != SWD_OK) {
-            return result.error;
-        }
-        buffer[i] = result.value;
+    if (!target->rp2350.initialized) {
+        return -SWD_ERROR_NOT_INITIALIZED;
     }
 
-    return SWD_OK;
-}
-
-swd_error_t rp2350_write_mem_block(swd_target_t *target, uint32_t addr,
-                                    const uint32_t *buffer, uint32_t count) {
-    if (!target || !buffer) {
-        return SWD_ERROR_INVALID_PARAM;
+    if (!validate_hart_id(hart_id)) {
+        return -SWD_ERROR_INVALID_PARAM;
     }
 
-    for (uint32_t i = 0; i < count; i++) {
-        swd_error_t err = rp2350_write_mem32(target, addr + (i * 4), buffer[i]);
-        if (err != SWD_OK) {
-            return err;
+    if (!target->rp2350.harts[hart_id].halted) {
+        swd_error_t err = rp2350_halt(target, hart_id);
+        if (err != SWD_OK && err != SWD_ERROR_ALREADY_HALTED) {
+            return -err;
         }
     }
 
-    return SWD_OK;
-}
+    trace->record_count = 0;
+    trace->value_count = 0;
+    trace->fetch_hits = 0;
+    trace->fetch_misses = 0;
+    trace->reg_reads = 0;
 
-//==============================================================================
-// Code Execution
-//==============================================================================
+    // trace_step() resumes directly, so every trigger would fire on the
+    // instruction it guards; they are disarmed for the whole trace
+    uint32_t armed = target->rp2350.harts[hart_id].trigger_used;
+    swd_error_t err = triggers_arm(target, hart_id, armed, false);
+    if (err != SWD_OK) {
+        return -err;
+    }
 
-swd_error_t rp2350_upload_code(swd_target_t *target, uint32_t addr,
-                                const uint32_t *code, uint32_t word_count) {
-    if (!target || !code || word_count == 0) {
-        return SWD_ERROR_INVALID_PARAM;
+    // Single-step mode for the whole trace
+    swd_result_t dcsr = read_dcsr(target, hart_id);
+    err = dcsr.error;
+    if (err == SWD_OK) {
+        err = write_dcsr(target, hart_id, dcsr.value | DCSR_STEP);
+    }
+    if (err != SWD_OK) {
+        return -triggers_rearm(target, hart_id, armed, err);
     }
 
-    if (addr & 0x3) {
-        return SWD_ERROR_ALIGNMENT;
+    swd_result_t pc = rp2350_read_pc(target, hart_id);
+    err = pc.error;
+
+    uint32_t regs[32] = {0};
+    if (err == SWD_OK && trace->regs != TRACE_REGS_NONE) {
+        err = trace_read_regs(target, hart_id, GPR_ALL_WRITABLE, regs, trace);
+        memcpy(trace->initial_regs, regs, sizeof(regs));
     }
 
-    SWD_INFO("Uploading %lu words to 0x%08lx...\n", (unsigned long)word_count, (unsigned long)addr);
+    fetch_cache_t fetch = {0};
+    uint32_t count = 0;
+    uint32_t prev_insn = 0;
+    uint32_t limit = max_instructions ? max_instructions : trace->record_capacity;
+    if (limit > trace->record_capacity) {
+        limit = trace->record_capacity;
+    }
 
-    // Write code
-    for (uint32_t i = 0; i < word_count; i++) {
-        swd_error_t err = rp2350_write_mem32(target, addr + (i * 4), code[i]);
-        if (err != SWD_OK) {
-            return err;
+    SWD_INFO("Starting compact trace on hart%u (max=%lu, regs=%d)...\n",
+             hart_id, (unsigned long)limit, trace->regs);
+
+    while (err == SWD_OK && count < limit) {
+        trace_delta_t *record = &trace->records[count];
+        record->changed = 0;
+        record->value_index = trace->value_count;
+
+        // What the previous step wrote; regs[] holds the values before it
+        if (count > 0 && trace->regs != TRACE_REGS_NONE) {
+            uint32_t mask = (trace->regs == TRACE_REGS_ALL) ? GPR_ALL_WRITABLE
+                                                            : insn_written_regs(prev_insn);
+            uint32_t now[32];
+            memcpy(now, regs, sizeof(now));
+            err = trace_read_regs(target, hart_id, mask, now, trace);
+            if (err != SWD_OK) {
+                break;
+            }
+
+            uint32_t changed = 0;
+            for (uint8_t r = 1; r < 32; r++) {
+                if (now[r] != regs[r]) {
+                    changed |= 1u << r;
+                }
+            }
+            uint32_t n = (uint32_t)__builtin_popcount(changed);
+            if (trace->value_count + n > trace->value_capacity) {
+                break;  // Value storage full
+            }
+            for (uint8_t r = 1; r < 32; r++) {
+                if (changed & (1u << r)) {
+                    trace->values[trace->value_count++] = now[r];
+                }
+            }
+            record->changed = changed;
+            memcpy(regs, now, sizeof(regs));
         }
 
-        // Verify
-        swd_result_t readback = rp2350_read_mem32(target, addr + (i * 4));
-        if (readback.error != SWD_OK) {
-            return readback.error;
+        record->pc = pc.value;
+        err = fetch_insn(target, &fetch, pc.value, &record->instruction);
+        if (err != SWD_OK) {
+            break;
         }
+        prev_insn = record->instruction;
+        count++;
+        trace->record_count = count;
 
-        if (readback.value != code[i]) {
-            swd_set_error(target, SWD_ERROR_VERIFY,
-                         "Verification failed at word %u: wrote 0x%08x, read 0x%08x",
-                         i, code[i], readback.value);
-            return SWD_ERROR_VERIFY;
+        if (count == limit) {
+            break;  // Leave the hart at the last traced instruction
         }
+
+        err = trace_step(target, hart_id, &pc.value);
     }
 
-    SWD_INFO("Code upload complete\n");
-    return SWD_OK;
-}
+    trace->fetch_hits = fetch.hits;
+    trace->fetch_misses = fetch.misses;
 
-swd_error_t rp2350_execute_code(swd_target_t *target, uint8_t hart_id, uint32_t entry_point,
-                                 const uint32_t *code, uint32_t word_count) {
-    if (!target || !code) {
-        return SWD_ERROR_INVALID_PARAM;
+    // Leave step mode and re-arm the triggers; the hart stays halted
+    swd_error_t restore_err = write_dcsr(target, hart_id, dcsr.value);
+    if (err == SWD_OK) {
+        err = restore_err;
     }
+    err = triggers_rearm(target, hart_id, armed, err);
 
-    if (!validate_hart_id(hart_id)) {
-        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
-        return SWD_ERROR_INVALID_PARAM;
+    if (err != SWD_OK) {
+        SWD_INFO("Compact trace stopped after %lu instructions: %s\n",
+                 (unsigned long)count, swd_error_string(err));
+        return count > 0 ? (int)count : -(int)err;
     }
 
-    SWD_INFO("Executing code on hart%u at 0x%08lx (%lu words)...\n", hart_id, (unsigned long)entry_point, (unsigned long)word_count);
+    SWD_INFO("Compact trace completed: %lu instructions, %lu values, %lu fetch misses\n",
+             (unsigned long)count, (unsigned long)trace->value_count,
+             (unsigned long)fetch.misses);
+    return (int)count;
+}
 
-    // Upload code
-    swd_error_t err = rp2350_upload_code(target, entry_point, code, word_count);
-    if (err != SWD_OK) {
-        return err;
+void rp2350_trace_apply(const trace_compact_t *trace, uint32_t index, uint32_t regs[32]) {
+    if (!trace || !regs || index >= trace->record_count) {
+        return;
     }
 
-    // Halt if needed
-    bool was_halted = target->rp2350.harts[hart_id].halted;
-    if (!was_halted) {
-        err = rp2350_halt(target, hart_id);
-        if (err != SWD_OK && err != SWD_ERROR_ALREADY_HALTED) {
-            return err;
+    const trace_delta_t *record = &trace->records[index];
+    uint32_t v = record->value_index;
+    for (uint8_t r = 1; r < 32; r++) {
+        if (record->changed & (1u << r)) {
+            regs[r] = trace->values[v++];
         }
     }
+}
 
-    // Set PC
-    err = rp2350_write_pc(target, hart_id, entry_point);
+//==============================================================================
+// PC Sampling
+//==============================================================================
+
+/**
+ * @brief Queue a DM register read (TAR, DRW, RDBUFF) into *value
+ */
+static void queue_dm_read(swd_target_t *target, uint32_t reg, uint32_t *value) {
+    swd_batch_queue_write(target, true, AP_TAR, reg);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_read(target, false, DP_RDBUFF, value);
+}
+
+/**
+ * @brief Finish a sample: put s0 back and (unless the hart stopped on its
+ * own) resume, in one batch
+ */
+static swd_error_t sample_leave(swd_target_t *target, uint8_t hart_id, uint32_t s0,
+                                bool resume) {
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    uint32_t abstractcs = 0;
+
+    swd_error_t err = swd_batch_begin(target);
     if (err != SWD_OK) {
         return err;
     }
-
-    // Verify PC
-    swd_result_t pc = rp2350_read_pc(target, hart_id);
-    if (pc.error != SWD_OK || pc.value != entry_point) {
-        swd_set_error(target, SWD_ERROR_VERIFY,
-                     "PC verification failed: expected 0x%08x, got 0x%08x",
-                     entry_point, pc.value);
-        return SWD_ERROR_VERIFY;
+    queue_dm_write(target, DM_DATA0, s0);
+    queue_dm_write(target, DM_COMMAND, CMD_TRANSFER_S0 | CMD_AR_WRITE);
+    if (resume) {
+        queue_dm_write(target, DM_DMCONTROL, make_dmcontrol(hart_id, false, true, false));
     }
+    queue_dm_read(target, DM_ABSTRACTCS, &abstractcs);
+    err = swd_batch_execute(target);
 
-    // Resume
-    err = rp2350_resume(target, hart_id);
+    rp2350_forget_regs(hart);
+    hart->scratch_held = false;
+    hart->halted = !resume;
+    hart->halt_state_known = (err == SWD_OK);
     if (err != SWD_OK) {
         return err;
     }
 
-    SWD_INFO("Code execution started on hart%u\n", hart_id);
+    if (resume) {
+        // Batches forget DMCONTROL; this one selected hart_id
+        target->rp2350.dmcontrol_cache = make_dmcontrol(hart_id, false, true, false);
+        target->rp2350.dmcontrol_valid = true;
+    }
+
+    if ((abstractcs >> 8) & 0x7) {
+        dap_write_mem32(target, DM_ABSTRACTCS, 0x00000700);
+        hart->halt_state_known = false;
+        swd_set_error(target, SWD_ERROR_ABSTRACT_CMD,
+                     "s0 restore after PC sample failed on hart %u (abstractcs=0x%08lx)",
+                     hart_id, (unsigned long)abstractcs);
+        return SWD_ERROR_ABSTRACT_CMD;
+    }
     return SWD_OK;
 }
 
-//==============================================================================
-// Instruction Tracing
-//==============================================================================
-
-int rp2350_trace(swd_target_t *target, uint8_t hart_id, uint32_t max_instructions,
-                 trace_callback_t callback, void *user_data,
-                 bool capture_regs) {
-    if (!target || !callback) {
-        return -SWD_ERROR_INVALID_PARAM;
+swd_error_t rp2350_sample_pc(swd_target_t *target, uint8_t hart_id, uint32_t *pc) {
+    if (!target || !target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
     }
 
-    if (!target->rp2350.initialized) {
-        return -SWD_ERROR_NOT_INITIALIZED;
+    if (!validate_hart_id(hart_id) || !pc) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM, "Invalid hart_id: %u", hart_id);
+        return SWD_ERROR_INVALID_PARAM;
     }
 
-    if (!validate_hart_id(hart_id)) {
-        return -SWD_ERROR_INVALID_PARAM;
+    hart_state_t *hart = &target->rp2350.harts[hart_id];
+    if (hart->halt_state_known && hart->halted) {
+        return SWD_ERROR_ALREADY_HALTED;
     }
 
-    // Ensure hart is halted before we start
-    if (!target->rp2350.harts[hart_id].halted) {
-        swd_error_t err = rp2350_halt(target, hart_id);
-        if (err != SWD_OK && err != SWD_ERROR_ALREADY_HALTED) {
-            return -err;
-        }
+    const uint32_t progbuf[] = {csrr_s0(CSR_DPC), 0x00100073};  // ebreak
+    swd_error_t err = write_progbuf(target, progbuf, 2);
+    if (err == SWD_OK) {
+        err = dap_select_ap_bank(target, AP_RISCV, 0);
+    }
+    if (err == SWD_OK) {
+        err = swd_batch_begin(target);
+    }
+    if (err != SWD_OK) {
+        return err;
     }
 
-    uint32_t count = 0;
-    bool unlimited = (max_instructions == 0);
-
-    SWD_INFO("Starting instruction trace on hart%u (max=%lu, capture_regs=%d)...\n",
-             hart_id, (unsigned long)max_instructions, capture_regs);
+    // DMSTATUS before the halt request tells whether the hart had stopped
+    // by itself (it is then left halted)
+    rp2350_state_t *dm = &target->rp2350;
+    if (!dm->dmcontrol_valid || (dm->dmcontrol_cache & DMCONTROL_HASEL) ||
+        ((dm->dmcontrol_cache >> 16) & 0x3FF) != hart_id) {
+        queue_dm_write(target, DM_DMCONTROL, make_dmcontrol(hart_id, false, false, false));
+    }
+    uint32_t dmstatus = 0, s0 = 0, dpc = 0, abstractcs = 0;
+    queue_dm_read(target, DM_DMSTATUS, &dmstatus);
+    queue_dm_write(target, DM_DMCONTROL, make_dmcontrol(hart_id, true, false, false));
+
+    // s0 -> DATA0, then s0 = dpc; dpc -> DATA0 (as in trace_step)
+    queue_dm_write(target, DM_COMMAND, CMD_TRANSFER_S0 | CMD_POSTEXEC);
+    queue_dm_read(target, DM_DATA0, &s0);
+    queue_dm_write(target, DM_COMMAND, CMD_TRANSFER_S0);
+    swd_batch_queue_write(target, true, AP_TAR, DM_DATA0);
+    swd_batch_queue_read(target, true, AP_DRW, NULL);
+    swd_batch_queue_write(target, true, AP_TAR, DM_ABSTRACTCS);
+    swd_batch_queue_read(target, true, AP_DRW, &dpc);
+    swd_batch_queue_read(target, false, DP_RDBUFF, &abstractcs);
+
+    err = swd_batch_execute(target);
+    if (err != SWD_OK) {
+        hart->halt_state_known = false;
+        rp2350_forget_regs(hart);
+        return err;
+    }
 
-    while (unlimited || count < max_instructions) {
-        trace_record_t record = {0};
+    uint8_t cmderr = (abstractcs >> 8) & 0x7;
+    bool busy = (abstractcs >> 12) & 1;
 
-        // Read PC
-        swd_result_t pc_result = rp2350_read_pc(target, hart_id);
-        if (pc_result.error != SWD_OK) {
-            SWD_INFO("Trace stopped: failed to read PC\n");
-            return count > 0 ? (int)count : -pc_result.error;
+    // cmderr 4: the halt had not taken effect yet, so neither command ran
+    if (busy || cmderr != 0) {
+        if (busy || cmderr != 4) {
+            if (!busy) {
+                dap_write_mem32(target, DM_ABSTRACTCS, 0x00000700);
+            }
+            hart->halt_state_known = false;
+            swd_set_error(target, SWD_ERROR_ABSTRACT_CMD,
+                         "PC sample on hart %u failed (abstractcs=0x%08lx)",
+                         hart_id, (unsigned long)abstractcs);
+            return SWD_ERROR_ABSTRACT_CMD;
         }
-        record.pc = pc_result.value;
+        dap_write_mem32(target, DM_ABSTRACTCS, 0x00000700);
 
-        // Read instruction at PC
-        swd_result_t inst_result = rp2350_read_mem32(target, record.pc);
-        if (inst_result.error != SWD_OK) {
-            SWD_INFO("Trace stopped: failed to read instruction at 0x%08lx\n", (unsigned long)record.pc);
-            return count > 0 ? (int)count : -inst_result.error;
+        err = poll_dmstatus_halted(target, hart_id, true);
+        if (err != SWD_OK) {
+            // Never halted: withdraw the request
+            write_dmcontrol(target, make_dmcontrol(hart_id, false, false, false));
+            hart->halt_state_known = false;
+            swd_set_error(target, err, "Hart %u did not halt for PC sample", hart_id);
+            return err;
         }
-        record.instruction = inst_result.value;
 
-        // Optional: Capture all registers
-        if (capture_regs) {
-            swd_error_t err = rp2350_read_all_regs(target, hart_id, record.regs);
-            if (err != SWD_OK) {
-                SWD_INFO("Trace stopped: failed to read registers\n");
-                return count > 0 ? (int)count : -err;
-            }
+        err = run_command(target, CMD_TRANSFER_S0 | CMD_POSTEXEC);
+        swd_result_t data0 = {.error = err, .value = 0};
+        if (err == SWD_OK) {
+            data0 = dap_read_mem32(target, DM_DATA0);
         }
-
-        // Count this instruction as traced
-        count++;
-
-        // Call user callback
-        if (!callback(&record, user_data)) {
-            SWD_INFO("Trace stopped by callback after %lu instructions\n", (unsigned long)count);
-            break;
+        if (data0.error != SWD_OK) {
+            hart->halt_state_known = false;
+            return data0.error;
+        }
+        s0 = data0.value;
+        err = run_command(target, CMD_TRANSFER_S0);
+        if (err == SWD_OK) {
+            data0 = dap_read_mem32(target, DM_DATA0);
+            err = data0.error;
+            dpc = data0.value;
         }
-
-        // Execute one instruction
-        swd_error_t err = rp2350_step(target, hart_id);
         if (err != SWD_OK) {
-            SWD_INFO("Trace stopped: step failed\n");
-            return count > 0 ? (int)count : -err;
+            // s0 now holds dpc; put the program's value back and resume
+            sample_leave(target, hart_id, s0, true);
+            return err;
         }
     }
 
-    SWD_INFO("Trace completed: %lu instructions\n", (unsigned long)count);
-    return (int)count;
+    bool halted_before = (dmstatus >> 9) & 1;  // allhalted
+    err = sample_leave(target, hart_id, s0, !halted_before);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    *pc = dpc;
+    return halted_before ? SWD_ERROR_ALREADY_HALTED : SWD_OK;
 }
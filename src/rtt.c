@@ -0,0 +1,385 @@
+/**
+ * @file rtt.c
+ * @brief SEGGER-RTT compatible ring buffers over SBA
+ *
+ * Control block layout (all words little-endian):
+ *
+ *   +0   char acID[16]            "SEGGER RTT"
+ *   +16  int  MaxNumUpBuffers
+ *   +20  int  MaxNumDownBuffers
+ *   +24  descriptor aUp[MaxNumUpBuffers]
+ *        descriptor aDown[MaxNumDownBuffers]
+ *
+ * Each descriptor is sName, pBuffer, SizeOfBuffer, WrOff, RdOff, Flags.
+ * The writer of a ring owns WrOff and the reader owns RdOff, so the host
+ * only ever writes RdOff of up rings and WrOff of down rings, always after
+ * the data itself.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico2-swd-riscv/rtt.h"
+#include "pico2-swd-riscv/rp2350.h"
+#include "pico2-swd-riscv/swd.h"
+#include "internal.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char rtt_id[] = "SEGGER RTT";
+
+#define RTT_ID_WORDS     3      // Words holding the ID and its terminator
+#define RTT_HEADER_BYTES 24     // acID + the two channel counts
+#define RTT_DESC_WORDS   6
+#define RTT_DESC_BYTES   (RTT_DESC_WORDS * 4)
+#define RTT_MAX_DECLARED 32     // Larger channel counts are taken as a false match
+#define RTT_SCAN_WORDS   256    // 1 KB per scan read
+
+// Descriptor word indices
+#define DESC_NAME   0
+#define DESC_BUFFER 1
+#define DESC_SIZE   2
+#define DESC_WROFF  3
+#define DESC_RDOFF  4
+#define DESC_FLAGS  5
+
+static uint32_t min_u32(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+//==============================================================================
+// Descriptors
+//==============================================================================
+
+static uint32_t desc_addr(const rp2350_rtt_t *rtt, bool up, uint32_t index) {
+    uint32_t first = rtt->cb_addr + RTT_HEADER_BYTES;
+    if (!up) {
+        first += rtt->max_up * RTT_DESC_BYTES;
+    }
+    return first + index * RTT_DESC_BYTES;
+}
+
+static void desc_parse(rp2350_rtt_channel_t *ch, const uint32_t *words) {
+    ch->buffer = words[DESC_BUFFER];
+    ch->size = words[DESC_SIZE];
+    ch->flags = words[DESC_FLAGS];
+}
+
+/**
+ * @brief Read count consecutive descriptors in one block
+ *
+ * words receives the raw descriptors for the ring offsets.
+ */
+static swd_error_t desc_read(swd_target_t *target, rp2350_rtt_t *rtt, bool up,
+                             uint32_t first, uint32_t count, uint32_t *words) {
+    swd_error_t err = rp2350_read_mem_block(target, desc_addr(rtt, up, first), words,
+                                            count * RTT_DESC_WORDS);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    rp2350_rtt_channel_t *channels = up ? rtt->up : rtt->down;
+    for (uint32_t i = 0; i < count; i++) {
+        desc_parse(&channels[first + i], &words[i * RTT_DESC_WORDS]);
+    }
+    return SWD_OK;
+}
+
+static void read_name(swd_target_t *target, rp2350_rtt_channel_t *ch, uint32_t addr) {
+    if (addr == 0 ||
+        rp2350_read_bytes(target, addr, (uint8_t *)ch->name, RP2350_RTT_NAME_LEN) != SWD_OK) {
+        ch->name[0] = '\0';
+    }
+    ch->name[RP2350_RTT_NAME_LEN - 1] = '\0';
+}
+
+/**
+ * @brief Check the offsets the target left in a descriptor
+ *
+ * An unconfigured ring (size 0) is reported as valid and empty.
+ */
+static swd_error_t check_offsets(swd_target_t *target, const rp2350_rtt_channel_t *ch,
+                                 uint32_t wr, uint32_t rd) {
+    if (ch->size == 0 || ch->buffer == 0) {
+        return SWD_OK;
+    }
+    if (wr >= ch->size || rd >= ch->size) {
+        swd_set_error(target, SWD_ERROR_INVALID_STATE,
+                      "RTT ring at 0x%08lx: WrOff %lu / RdOff %lu outside size %lu",
+                      (unsigned long)ch->desc_addr, (unsigned long)wr,
+                      (unsigned long)rd, (unsigned long)ch->size);
+        return SWD_ERROR_INVALID_STATE;
+    }
+    return SWD_OK;
+}
+
+//==============================================================================
+// Control Block
+//==============================================================================
+
+/**
+ * @brief Validate a candidate control block and load its channels
+ */
+static swd_error_t rtt_attach(swd_target_t *target, rp2350_rtt_t *rtt, uint32_t addr) {
+    uint32_t counts[2];
+    swd_error_t err = rp2350_read_mem_block(target, addr + 16, counts, 2);
+    if (err != SWD_OK) {
+        return err;
+    }
+    if (counts[0] == 0 || counts[0] > RTT_MAX_DECLARED || counts[1] > RTT_MAX_DECLARED) {
+        return SWD_ERROR_VERIFY;
+    }
+
+    memset(rtt, 0, sizeof(*rtt));
+    rtt->cb_addr = addr;
+    rtt->max_up = counts[0];
+    rtt->max_down = counts[1];
+    rtt->num_up = min_u32(rtt->max_up, RP2350_RTT_MAX_CHANNELS);
+    rtt->num_down = min_u32(rtt->max_down, RP2350_RTT_MAX_CHANNELS);
+
+    for (uint32_t i = 0; i < rtt->num_up; i++) {
+        rtt->up[i].desc_addr = desc_addr(rtt, true, i);
+    }
+    for (uint32_t i = 0; i < rtt->num_down; i++) {
+        rtt->down[i].desc_addr = desc_addr(rtt, false, i);
+    }
+
+    uint32_t words[RP2350_RTT_MAX_CHANNELS * RTT_DESC_WORDS];
+    err = desc_read(target, rtt, true, 0, rtt->num_up, words);
+    for (uint32_t i = 0; i < rtt->num_up && err == SWD_OK; i++) {
+        read_name(target, &rtt->up[i], words[i * RTT_DESC_WORDS + DESC_NAME]);
+    }
+    if (err == SWD_OK && rtt->num_down) {
+        err = desc_read(target, rtt, false, 0, rtt->num_down, words);
+        for (uint32_t i = 0; i < rtt->num_down && err == SWD_OK; i++) {
+            read_name(target, &rtt->down[i], words[i * RTT_DESC_WORDS + DESC_NAME]);
+        }
+    }
+    return err;
+}
+
+swd_error_t rp2350_rtt_find(swd_target_t *target, rp2350_rtt_t *rtt,
+                            uint32_t start, uint32_t len) {
+    if (!target || !rtt || (start & 3) || len < RTT_HEADER_BYTES) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->rp2350.initialized) {
+        return SWD_ERROR_NOT_INITIALIZED;
+    }
+
+    uint32_t scan[RTT_SCAN_WORDS];
+    uint32_t total = len / 4;
+    uint32_t pos = 0;
+
+    // Consecutive reads overlap so an ID straddling two of them is still seen
+    while (pos + RTT_ID_WORDS <= total) {
+        uint32_t n = min_u32(total - pos, RTT_SCAN_WORDS);
+        swd_error_t err = rp2350_read_mem_block(target, start + pos * 4, scan, n);
+        if (err != SWD_OK) {
+            return err;
+        }
+
+        for (uint32_t i = 0; i + RTT_ID_WORDS <= n; i++) {
+            if (memcmp(&scan[i], rtt_id, sizeof(rtt_id)) != 0) {
+                continue;
+            }
+            uint32_t addr = start + (pos + i) * 4;
+            err = rtt_attach(target, rtt, addr);
+            if (err == SWD_OK) {
+                SWD_INFO("RTT control block at 0x%08lx: %lu up, %lu down\n",
+                         (unsigned long)addr, (unsigned long)rtt->max_up,
+                         (unsigned long)rtt->max_down);
+                return SWD_OK;
+            }
+            if (err != SWD_ERROR_VERIFY) {
+                return err;
+            }
+        }
+
+        if (pos + n >= total) {
+            break;
+        }
+        pos += n - (RTT_ID_WORDS - 1);
+    }
+
+    swd_set_error(target, SWD_ERROR_VERIFY, "No RTT control block in 0x%08lx-0x%08lx",
+                  (unsigned long)start, (unsigned long)(start + len));
+    return SWD_ERROR_VERIFY;
+}
+
+swd_error_t rp2350_rtt_refresh(swd_target_t *target, rp2350_rtt_t *rtt) {
+    if (!target || !rtt || rtt->num_up == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t words[RP2350_RTT_MAX_CHANNELS * RTT_DESC_WORDS];
+    swd_error_t err = desc_read(target, rtt, true, 0, rtt->num_up, words);
+    if (err == SWD_OK && rtt->num_down) {
+        err = desc_read(target, rtt, false, 0, rtt->num_down, words);
+    }
+    return err;
+}
+
+swd_error_t rp2350_rtt_set_mode(swd_target_t *target, rp2350_rtt_t *rtt,
+                                uint32_t channel, uint32_t mode) {
+    if (!target || !rtt || channel >= rtt->num_up || mode > RP2350_RTT_MODE_BLOCK) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    rp2350_rtt_channel_t *ch = &rtt->up[channel];
+    uint32_t flags_addr = ch->desc_addr + DESC_FLAGS * 4;
+    swd_result_t result = rp2350_read_mem32(target, flags_addr);
+    if (result.error != SWD_OK) {
+        return result.error;
+    }
+
+    ch->flags = (result.value & ~RP2350_RTT_MODE_MASK) | mode;
+    return rp2350_write_mem32(target, flags_addr, ch->flags);
+}
+
+//==============================================================================
+// Transfers
+//==============================================================================
+
+/**
+ * @brief Copy up to len pending bytes of an up ring into buffer
+ *
+ * Reads only [rd, wr), as one block or two when it wraps. RdOff is left
+ * alone so the caller can release just what was consumed.
+ */
+static swd_error_t up_fetch(swd_target_t *target, rp2350_rtt_t *rtt,
+                            const rp2350_rtt_channel_t *ch, uint32_t wr, uint32_t rd,
+                            uint8_t *buffer, uint32_t len, uint32_t *got) {
+    *got = 0;
+    if (ch->size == 0 || ch->buffer == 0 || wr == rd) {
+        return SWD_OK;
+    }
+
+    uint32_t avail = (wr > rd) ? wr - rd : ch->size - rd + wr;
+    if (avail == ch->size - 1) {
+        rtt->up_full++;
+    }
+
+    uint32_t n = min_u32(avail, len);
+    uint32_t first = min_u32(n, ch->size - rd);
+    swd_error_t err = rp2350_read_bytes(target, ch->buffer + rd, buffer, first);
+    if (err == SWD_OK && n > first) {
+        err = rp2350_read_bytes(target, ch->buffer, buffer + first, n - first);
+    }
+    if (err == SWD_OK) {
+        *got = n;
+    }
+    return err;
+}
+
+static swd_error_t up_release(swd_target_t *target, rp2350_rtt_t *rtt,
+                              const rp2350_rtt_channel_t *ch, uint32_t rd,
+                              uint32_t consumed) {
+    if (consumed == 0) {
+        return SWD_OK;
+    }
+    rtt->bytes_up += consumed;
+    return rp2350_write_mem32(target, ch->desc_addr + DESC_RDOFF * 4,
+                              (rd + consumed) % ch->size);
+}
+
+swd_error_t rp2350_rtt_read(swd_target_t *target, rp2350_rtt_t *rtt, uint32_t channel,
+                            uint8_t *buffer, uint32_t len, uint32_t *got) {
+    if (!target || !rtt || !got || channel >= rtt->num_up || (!buffer && len > 0)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    *got = 0;
+    uint32_t words[RTT_DESC_WORDS];
+    swd_error_t err = desc_read(target, rtt, true, channel, 1, words);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    const rp2350_rtt_channel_t *ch = &rtt->up[channel];
+    uint32_t wr = words[DESC_WROFF];
+    uint32_t rd = words[DESC_RDOFF];
+    err = check_offsets(target, ch, wr, rd);
+    if (err == SWD_OK) {
+        err = up_fetch(target, rtt, ch, wr, rd, buffer, len, got);
+    }
+    if (err == SWD_OK) {
+        err = up_release(target, rtt, ch, rd, *got);
+    }
+    return err;
+}
+
+swd_error_t rp2350_rtt_poll(swd_target_t *target, rp2350_rtt_t *rtt,
+                            uint8_t *buffer, uint32_t len,
+                            rp2350_rtt_handler_t handler, void *ctx) {
+    if (!target || !rtt || !buffer || len == 0 || !handler || rtt->num_up == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t words[RP2350_RTT_MAX_CHANNELS * RTT_DESC_WORDS];
+    swd_error_t err = desc_read(target, rtt, true, 0, rtt->num_up, words);
+
+    for (uint32_t i = 0; i < rtt->num_up && err == SWD_OK; i++) {
+        const rp2350_rtt_channel_t *ch = &rtt->up[i];
+        uint32_t wr = words[i * RTT_DESC_WORDS + DESC_WROFF];
+        uint32_t rd = words[i * RTT_DESC_WORDS + DESC_RDOFF];
+        uint32_t got;
+
+        err = check_offsets(target, ch, wr, rd);
+        if (err == SWD_OK) {
+            err = up_fetch(target, rtt, ch, wr, rd, buffer, len, &got);
+        }
+        if (err == SWD_OK && got) {
+            uint32_t consumed = min_u32(handler(i, buffer, got, ctx), got);
+            err = up_release(target, rtt, ch, rd, consumed);
+        }
+    }
+    return err;
+}
+
+swd_error_t rp2350_rtt_write(swd_target_t *target, rp2350_rtt_t *rtt, uint32_t channel,
+                             const uint8_t *data, uint32_t len, uint32_t *written) {
+    if (!target || !rtt || !written || channel >= rtt->num_down || (!data && len > 0)) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    *written = 0;
+    uint32_t words[RTT_DESC_WORDS];
+    swd_error_t err = desc_read(target, rtt, false, channel, 1, words);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    const rp2350_rtt_channel_t *ch = &rtt->down[channel];
+    uint32_t wr = words[DESC_WROFF];
+    uint32_t rd = words[DESC_RDOFF];
+    err = check_offsets(target, ch, wr, rd);
+    if (err != SWD_OK || ch->size == 0 || ch->buffer == 0 || len == 0) {
+        return err;
+    }
+
+    // One byte stays free so that a full ring differs from an empty one
+    uint32_t space = (rd > wr) ? rd - wr - 1 : ch->size - wr + rd - 1;
+    uint32_t n = min_u32(space, len);
+    if (n < len) {
+        rtt->down_full++;
+    }
+    if (n == 0) {
+        return SWD_OK;
+    }
+
+    uint32_t first = min_u32(n, ch->size - wr);
+    err = rp2350_write_bytes(target, ch->buffer + wr, data, first);
+    if (err == SWD_OK && n > first) {
+        err = rp2350_write_bytes(target, ch->buffer, data + first, n - first);
+    }
+    if (err == SWD_OK) {
+        err = rp2350_write_mem32(target, ch->desc_addr + DESC_WROFF * 4, (wr + n) % ch->size);
+    }
+    if (err == SWD_OK) {
+        *written = n;
+        rtt->bytes_down += n;
+    }
+    return err;
+}
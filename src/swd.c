@@ -51,6 +51,7 @@ static const char* error_strings[] = {
     [SWD_ERROR_BUS] = "Bus error",
     [SWD_ERROR_ALIGNMENT] = "Alignment error",
     [SWD_ERROR_VERIFY] = "Verification failed",
+    [SWD_ERROR_CANCELLED] = "Cancelled",
 };
 
 const char* swd_error_string(swd_error_t error) {
@@ -163,10 +164,58 @@ bool register_target(swd_target_t *target, PIO pio, uint sm) {
 void unregister_target(swd_target_t *target) {
     if (!target || !target->resource_registered) return;
 
+    swd_pio_program_unload(target);
     release_pio_sm(target->pio.pio, target->pio.sm);
     target->resource_registered = false;
 }
 
+static pio_program_ref_t *program_refs(PIO pio) {
+    if (pio == pio0) return g_resources.pio0_programs;
+    if (pio == pio1) return g_resources.pio1_programs;
+    return NULL;
+}
+
+swd_error_t acquire_pio_program(PIO pio, const pio_program_t *program, uint *offset) {
+    pio_program_ref_t *refs = program_refs(pio);
+    if (!refs) return SWD_ERROR_INVALID_PARAM;
+
+    pio_program_ref_t *unused = NULL;
+    for (uint i = 0; i < SWD_PIO_PROGRAM_SLOTS; i++) {
+        if (refs[i].refcount > 0 && refs[i].program == program) {
+            refs[i].refcount++;
+            *offset = refs[i].offset;
+            return SWD_OK;
+        }
+        if (refs[i].refcount == 0 && !unused) {
+            unused = &refs[i];
+        }
+    }
+
+    if (!unused || !pio_can_add_program(pio, program)) {
+        return SWD_ERROR_RESOURCE_BUSY;
+    }
+
+    unused->program = program;
+    unused->offset = pio_add_program(pio, program);
+    unused->refcount = 1;
+    *offset = unused->offset;
+    return SWD_OK;
+}
+
+void release_pio_program(PIO pio, const pio_program_t *program) {
+    pio_program_ref_t *refs = program_refs(pio);
+    if (!refs) return;
+
+    for (uint i = 0; i < SWD_PIO_PROGRAM_SLOTS; i++) {
+        if (refs[i].refcount > 0 && refs[i].program == program) {
+            if (--refs[i].refcount == 0) {
+                pio_remove_program(pio, program, refs[i].offset);
+            }
+            return;
+        }
+    }
+}
+
 swd_resource_info_t swd_get_resource_usage(void) {
     swd_resource_info_t info = {0};
     info.active_targets = g_resources.active_count;
@@ -176,6 +225,11 @@ swd_resource_info_t swd_get_resource_usage(void) {
         info.pio1_sm_used[i] = (g_resources.pio1_sm_owners[i] != NULL);
     }
 
+    for (uint i = 0; i < SWD_PIO_PROGRAM_SLOTS; i++) {
+        info.programs_loaded += (g_resources.pio0_programs[i].refcount > 0);
+        info.programs_loaded += (g_resources.pio1_programs[i].refcount > 0);
+    }
+
     return info;
 }
 
@@ -192,6 +246,17 @@ swd_config_t swd_config_default(void) {
         .freq_khz = 1000,
         .enable_caching = true,
         .retry_count = 5,
+        .use_dma = false,
+        .posted_writes = false,
+        .fast_pio = false,
+        .fractional_clkdiv = false,
+        .fast_attach = false,
+        .poll = {
+            .spin_polls = 2,
+            .backoff_min_us = 1,
+            .backoff_max_us = 1000,
+            .timeout_us = 200000,
+        },
     };
     return config;
 }
@@ -222,6 +287,9 @@ swd_target_t* swd_target_create(const swd_config_t *config) {
     target->pio.pin_swclk = config->pin_swclk;
     target->pio.pin_swdio = config->pin_swdio;
     target->pio.freq_khz = config->freq_khz;
+    target->pio.use_dma = config->use_dma;
+    target->pio.fast = config->fast_pio;
+    target->pio.fractional_clkdiv = config->fractional_clkdiv;
     target->pio.initialized = false;
 
     // Auto-allocate PIO/SM if requested
@@ -251,9 +319,25 @@ swd_target_t* swd_target_create(const swd_config_t *config) {
     }
     target->resource_registered = true;
 
+    // Load (or share) the PIO program now so connects don't pay for it
+    swd_error_t load_err = swd_pio_program_load(target);
+    if (load_err != SWD_OK) {
+        SWD_WARN("swd_target_create: no PIO%d instruction memory for SWD program\n",
+                 target->pio.pio == pio0 ? 0 : 1);
+        unregister_target(target);
+        free(target);
+        return NULL;
+    }
+
     // Initialize DAP state
     target->dap.powered = false;
     target->dap.retry_count = config->retry_count;
+    target->dap.posted_writes = config->posted_writes;
+    target->fast_attach = config->fast_attach;
+    target->poll_policy = config->poll;
+    if (target->poll_policy.timeout_us == 0) {
+        target->poll_policy = swd_config_default().poll;  // Zeroed config
+    }
     target->dap.current_apsel = 0xFF;  // Invalid, force first write
     target->dap.current_bank = 0xFF;
 
@@ -266,7 +350,7 @@ swd_target_t* swd_target_create(const swd_config_t *config) {
     for (uint8_t i = 0; i < RP2350_NUM_HARTS; i++) {
         target->rp2350.harts[i].halt_state_known = false;
         target->rp2350.harts[i].halted = false;
-        target->rp2350.harts[i].cache_valid = false;
+        rp2350_forget_regs(&target->rp2350.harts[i]);
     }
 
     SWD_INFO("Created target: PIO%d SM%d, pins SWCLK=%d SWDIO=%d\n",
@@ -279,6 +363,12 @@ swd_target_t* swd_target_create(const swd_config_t *config) {
 void swd_target_destroy(swd_target_t *target) {
     if (!target) return;
 
+    // Needs the PIO and DMA channel that swd_disconnect() releases
+    if (swd_async_release(target) != SWD_OK) {
+        SWD_WARN("Target not destroyed: called from an async callback\n");
+        return;
+    }
+
     // Disconnect if connected
     if (target->connected) {
         swd_disconnect(target);
@@ -290,6 +380,7 @@ void swd_target_destroy(swd_target_t *target) {
     SWD_INFO("Destroyed target: PIO%d SM%d\n",
              target->pio.pio == pio0 ? 0 : 1, target->pio.sm);
 
+    free(target->batch);
     free(target);
 }
 
@@ -345,5 +436,128 @@ uint32_t swd_get_frequency(const swd_target_t *target) {
     return target ? target->pio.freq_khz : 0;
 }
 
+//==============================================================================
+// Polling Policy
+//==============================================================================
+
+void swd_poll_begin(swd_target_t *target, swd_poll_t *poll, swd_wait_t kind) {
+    poll->kind = kind;
+    poll->polls = 0;
+    poll->delay_us = target->poll_policy.backoff_min_us;
+    poll->deadline = 0;
+    poll->timeout_us = target->poll_policy.timeout_us;
+}
+
+bool swd_poll_again(swd_target_t *target, swd_poll_t *poll) {
+    const swd_poll_policy_t *policy = &target->poll_policy;
+    uint64_t now = time_us_64();
+
+    if (poll->polls++ == 0) {
+        poll->deadline = now + poll->timeout_us;
+    } else if (now >= poll->deadline) {
+        return false;
+    }
+
+    if (poll->polls > policy->spin_polls && poll->delay_us > 0) {
+        uint64_t left = poll->deadline - now;
+        sleep_us(poll->delay_us < left ? poll->delay_us : left);
+
+        poll->delay_us *= 2;
+        if (poll->delay_us > policy->backoff_max_us) {
+            poll->delay_us = policy->backoff_max_us;
+        }
+    }
+
+    return true;
+}
+
+void swd_poll_end(swd_target_t *target, swd_poll_t *poll, bool done) {
+    swd_wait_stats_t *stats = &target->wait_stats[poll->kind];
+    uint32_t polls = poll->polls + (done ? 1 : 0);
+
+    stats->waits++;
+    stats->polls += polls;
+    if (polls > stats->max_polls) {
+        stats->max_polls = polls;
+    }
+    if (!done) {
+        stats->timeouts++;
+    }
+}
+
+swd_error_t swd_set_poll_policy(swd_target_t *target, const swd_poll_policy_t *policy) {
+    if (!target || !policy || policy->timeout_us == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    target->poll_policy = *policy;
+    return SWD_OK;
+}
+
+swd_error_t swd_get_wait_stats(const swd_target_t *target, swd_wait_t kind,
+                               swd_wait_stats_t *stats) {
+    if (!target || !stats || kind >= SWD_WAIT_COUNT) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    *stats = target->wait_stats[kind];
+    return SWD_OK;
+}
+
+void swd_reset_wait_stats(swd_target_t *target) {
+    if (target) {
+        memset(target->wait_stats, 0, sizeof(target->wait_stats));
+    }
+}
+
+//==============================================================================
+// Statistics
+//==============================================================================
+
+#if PICO2_SWD_STATS
+void swd_stats_latency(swd_target_t *target, swd_latency_t op, uint32_t start) {
+    swd_latency_stats_t *lat = &target->stats.latency[op];
+    uint32_t us = time_us_32() - start;
+
+    // Bucket b holds [2^(b-1), 2^b); 0 us lands in bucket 0
+    uint bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= SWD_LATENCY_BUCKETS) {
+        bucket = SWD_LATENCY_BUCKETS - 1;
+    }
+
+    if (lat->count == 0 || us < lat->min_us) {
+        lat->min_us = us;
+    }
+    if (us > lat->max_us) {
+        lat->max_us = us;
+    }
+    lat->count++;
+    lat->total_us += us;
+    lat->buckets[bucket]++;
+}
+#endif
+
+swd_error_t swd_get_stats(const swd_target_t *target, swd_stats_t *stats) {
+    if (!target || !stats) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+#if PICO2_SWD_STATS
+    *stats = target->stats;
+    return SWD_OK;
+#else
+    memset(stats, 0, sizeof(*stats));
+    return SWD_ERROR_INVALID_CONFIG;
+#endif
+}
+
+void swd_reset_stats(swd_target_t *target) {
+#if PICO2_SWD_STATS
+    if (target) {
+        memset(&target->stats, 0, sizeof(target->stats));
+    }
+#endif
+}
+
 // Note: swd_set_frequency() and swd_connect()/swd_disconnect()
 // will be implemented in swd_protocol.c along with PIO operations
@@ -8,13 +8,18 @@
 
 #include "pico2-swd-riscv/swd.h"
 #include "pico2-swd-riscv/dap.h"
+#include "pico2-swd-riscv/rp2350.h"
 #include "internal.h"
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
 #include "hardware/gpio.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "swd.pio.h"
 #include <stdio.h>
+#include <stdlib.h>
 
 //==============================================================================
 // PIO Commands
@@ -24,19 +29,52 @@ typedef enum {
     CMD_WRITE = 0,
     CMD_SKIP,
     CMD_TURNAROUND,
-    CMD_READ
+    CMD_READ,
+    CMD_COUNT
 } pio_cmd_t;
 
+/**
+ * @brief A PIO program implementing the command interface in swd.pio
+ */
+typedef struct {
+    const pio_program_t *program;
+    pio_sm_config (*default_config)(uint offset);
+    uint8_t cmd_offset[CMD_COUNT];  // Entry point of each command
+    uint8_t cycles_per_bit;         // PIO cycles per SWCLK period
+} pio_variant_t;
+
+static const pio_variant_t pio_variants[] = {
+    {
+        .program = &probe_program,
+        .default_config = probe_program_get_default_config,
+        .cmd_offset = {
+            [CMD_WRITE] = probe_offset_write_cmd,
+            [CMD_SKIP] = probe_offset_get_next_cmd,
+            [CMD_TURNAROUND] = probe_offset_turnaround_cmd,
+            [CMD_READ] = probe_offset_read_cmd,
+        },
+        .cycles_per_bit = 4,
+    },
+    {
+        .program = &probe_fast_program,
+        .default_config = probe_fast_program_get_default_config,
+        .cmd_offset = {
+            [CMD_WRITE] = probe_fast_offset_write_cmd,
+            [CMD_SKIP] = probe_fast_offset_get_next_cmd,
+            [CMD_TURNAROUND] = probe_fast_offset_turnaround_cmd,
+            [CMD_READ] = probe_fast_offset_read_cmd,
+        },
+        .cycles_per_bit = 2,
+    },
+};
+
+static inline const pio_variant_t *pio_variant(const swd_target_t *target) {
+    return &pio_variants[target->pio.fast ? 1 : 0];
+}
+
 static inline uint32_t format_pio_command(swd_target_t *target, uint bit_count,
                                            bool out_en, pio_cmd_t cmd) {
-    uint cmd_addr;
-    switch (cmd) {
-        case CMD_WRITE:      cmd_addr = target->pio.pio_offset + probe_offset_write_cmd; break;
-        case CMD_SKIP:       cmd_addr = target->pio.pio_offset + probe_offset_get_next_cmd; break;
-        case CMD_TURNAROUND: cmd_addr = target->pio.pio_offset + probe_offset_turnaround_cmd; break;
-        case CMD_READ:       cmd_addr = target->pio.pio_offset + probe_offset_read_cmd; break;
-        default:             cmd_addr = target->pio.pio_offset + probe_offset_get_next_cmd; break;
-    }
+    uint cmd_addr = target->pio.pio_offset + pio_variant(target)->cmd_offset[cmd];
     return ((bit_count - 1) & 0xff) | ((uint)out_en << 8) | (cmd_addr << 9);
 }
 
@@ -72,6 +110,31 @@ static inline void pio_write_bits(swd_target_t *target, uint bit_count, uint32_t
     SWD_DEBUG("  Write %d bits: 0x%08lx\n", bit_count, (unsigned long)data);
 }
 
+/**
+ * @brief Write a byte sequence LSB first, 32 bits per FIFO command
+ */
+static void pio_write_bytes(swd_target_t *target, const uint8_t *bytes, size_t len) {
+    for (size_t i = 0; i < len; i += 4) {
+        uint n = len - i < 4 ? len - i : 4;
+        uint32_t word = 0;
+        for (uint b = 0; b < n; b++) {
+            word |= (uint32_t)bytes[i + b] << (8 * b);
+        }
+        pio_write_bits(target, 8 * n, word);
+    }
+}
+
+/**
+ * @brief Clock out count copies of one bit value, 32 per FIFO command
+ */
+static void pio_write_repeated(swd_target_t *target, uint count, bool one) {
+    while (count > 0) {
+        uint n = count < 32 ? count : 32;
+        pio_write_bits(target, n, one ? 0xFFFFFFFFu : 0);
+        count -= n;
+    }
+}
+
 static inline uint32_t pio_read_bits(swd_target_t *target, uint bit_count) {
     pio_sm_put_blocking(target->pio.pio, target->pio.sm,
                        format_pio_command(target, bit_count, false, CMD_READ));
@@ -120,28 +183,38 @@ static uint8_t make_swd_request(bool APnDP, bool RnW, uint8_t addr) {
 void swd_send_idle_clocks(swd_target_t *target, uint count) {
     SWD_DEBUG("Sending %d idle clocks\n", count);
     pio_write_mode(target);
-    for (uint i = 0; i < count; i++) {
-        pio_write_bits(target, 1, 0);
-    }
+    pio_write_repeated(target, count, false);
 }
 
 void swd_line_reset(swd_target_t *target) {
     SWD_DEBUG("Line reset (>50 ones)\n");
     pio_write_mode(target);
-    for (uint i = 0; i < 56; i++) {
-        pio_write_bits(target, 1, 1);
-    }
+    pio_write_repeated(target, 56, true);
 }
 
 //==============================================================================
 // Core SWD Transaction
 //==============================================================================
 
-swd_error_t swd_io_raw(swd_target_t *target, uint8_t request, uint32_t *data, bool write) {
-    if (!target || !target->pio.initialized) {
-        return SWD_ERROR_INVALID_STATE;
+/**
+ * @brief Count one transaction and a non-OK ACK in the target's stats
+ */
+static inline void stat_ack(swd_target_t *target, uint8_t ack) {
+    SWD_STAT_INC(target, transactions);
+    if (ack == SWD_ACK_WAIT) {
+        SWD_STAT_INC(target, ack_wait);
+    } else if (ack == SWD_ACK_FAULT) {
+        SWD_STAT_INC(target, ack_fault);
+    } else if (ack != SWD_ACK_OK) {
+        SWD_STAT_INC(target, ack_error);
     }
+}
 
+/**
+ * @brief One transaction on the wire (swd_io_raw() without checks or stats)
+ */
+static swd_error_t swd_io_once(swd_target_t *target, uint8_t request, uint32_t *data,
+                               bool write) {
     // Send request packet
     pio_write_mode(target);
     pio_write_bits(target, 8, request);
@@ -177,7 +250,20 @@ swd_error_t swd_io_raw(swd_target_t *target, uint8_t request, uint32_t *data, bo
 
     // Handle non-OK ACK
     if (ack == SWD_ACK_WAIT || ack == SWD_ACK_FAULT) {
-        pio_turnaround(target, SWD_TURNAROUND_CYCLES);
+        if (target->dap.orundetect) {
+            // Overrun detection: the target expects a data phase anyway
+            if (write) {
+                pio_turnaround(target, SWD_TURNAROUND_CYCLES);
+                pio_write_bits(target, 32, 0);
+                pio_write_bits(target, 1, 0);
+            } else {
+                pio_read_bits(target, 32);
+                pio_read_bits(target, 1);
+                pio_turnaround(target, SWD_TURNAROUND_CYCLES);
+            }
+        } else {
+            pio_turnaround(target, SWD_TURNAROUND_CYCLES);
+        }
         return swd_ack_to_error(ack);
     }
 
@@ -191,66 +277,907 @@ swd_error_t swd_io_raw(swd_target_t *target, uint8_t request, uint32_t *data, bo
     return SWD_ERROR_PROTOCOL;
 }
 
+swd_error_t swd_io_raw(swd_target_t *target, uint8_t request, uint32_t *data, bool write) {
+    if (!target || !target->pio.initialized) {
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    SWD_STAT_START(start);
+    swd_error_t err = swd_io_once(target, request, data, write);
+    stat_ack(target, target->last_ack);
+    if (err == SWD_ERROR_PARITY) {
+        SWD_STAT_INC(target, parity_errors);
+    }
+    SWD_STAT_LATENCY(target, SWD_LATENCY_TRANSFER, start);
+    return err;
+}
+
+/**
+ * @brief Clear STICKYORUN after a WAIT while overrun detection is enabled
+ *
+ * ABORT writes are always accepted, so this cannot recurse into a WAIT.
+ */
+static void swd_clear_overrun(swd_target_t *target) {
+    uint32_t abort_bits = ABORT_ORUNERRCLR;
+    swd_io_raw(target, make_swd_request(false, false, DP_ABORT), &abort_bits, true);
+}
+
 //==============================================================================
 // DP/AP Register Access with Retry
 //==============================================================================
 
-swd_error_t swd_read_dp_raw(swd_target_t *target, uint8_t reg, uint32_t *value) {
-    uint8_t request = make_swd_request(false, true, reg);
+static swd_error_t swd_transfer_retry(swd_target_t *target, uint8_t request,
+                                      uint32_t *data, bool write) {
     swd_error_t err = SWD_ERROR_WAIT;  // Initialize to WAIT in case retry_count is 0
+    swd_poll_t poll;
 
+    swd_poll_begin(target, &poll, SWD_WAIT_ACK);
     for (uint retry = 0; retry < target->dap.retry_count; retry++) {
-        err = swd_io_raw(target, request, value, false);
+        if (retry > 0) {
+            SWD_STAT_INC(target, retries);
+        }
+        err = swd_io_raw(target, request, data, write);
         if (err != SWD_ERROR_WAIT) break;
-        sleep_us(100);
+        if (target->dap.orundetect) {
+            swd_clear_overrun(target);
+        }
+        if (retry + 1 == target->dap.retry_count) {
+            poll.polls++;  // Counted as an unmet check without waiting again
+            break;
+        }
+        if (!swd_poll_again(target, &poll)) break;
+    }
+
+    // Only transactions that saw WAIT are counted
+    if (poll.polls > 0) {
+        swd_poll_end(target, &poll, err != SWD_ERROR_WAIT);
     }
 
     return err;
 }
 
+swd_error_t swd_read_dp_raw(swd_target_t *target, uint8_t reg, uint32_t *value) {
+    return swd_transfer_retry(target, make_swd_request(false, true, reg), value, false);
+}
+
 swd_error_t swd_write_dp_raw(swd_target_t *target, uint8_t reg, uint32_t value) {
-    uint8_t request = make_swd_request(false, false, reg);
-    swd_error_t err = SWD_ERROR_WAIT;  // Initialize to WAIT in case retry_count is 0
+    return swd_transfer_retry(target, make_swd_request(false, false, reg), &value, true);
+}
 
-    for (uint retry = 0; retry < target->dap.retry_count; retry++) {
-        err = swd_io_raw(target, request, &value, true);
-        if (err != SWD_ERROR_WAIT) break;
-        sleep_us(100);
+swd_error_t swd_read_ap_raw(swd_target_t *target, uint8_t reg, uint32_t *value) {
+    return swd_transfer_retry(target, make_swd_request(true, true, reg), value, false);
+}
+
+swd_error_t swd_write_ap_raw(swd_target_t *target, uint8_t reg, uint32_t value) {
+    return swd_transfer_retry(target, make_swd_request(true, false, reg), &value, true);
+}
+
+//==============================================================================
+// Streamed Transactions
+//==============================================================================
+
+static inline bool op_is_read(const swd_op_t *op) {
+    return (op->request >> 2) & 1;
+}
+
+static inline uint op_rx_words(const swd_op_t *op) {
+    return op_is_read(op) ? 3 : 1;
+}
+
+swd_op_t swd_op_read(bool ap, uint8_t reg, uint32_t *dest) {
+    swd_op_t op = {.request = make_swd_request(ap, true, reg), .value = 0, .dest = dest};
+    return op;
+}
+
+swd_op_t swd_op_write(bool ap, uint8_t reg, uint32_t value) {
+    swd_op_t op = {.request = make_swd_request(ap, false, reg), .value = value, .dest = NULL};
+    return op;
+}
+
+/**
+ * @brief Encode one transaction as PIO FIFO words
+ *
+ * The data phase is emitted unconditionally. With overrun detection enabled
+ * the target expects it after WAIT/FAULT as well, so the stream can be built
+ * without looking at any ACK.
+ *
+ * Write: request, TA+ACK+TA (5 bits in), data, parity
+ * Read:  request, TA+ACK (4 bits in), data (32 in), parity+TA (2 bits in)
+ *
+ * @return Number of words written to words[]
+ */
+static uint encode_op(swd_target_t *target, const swd_op_t *op, uint32_t *words) {
+    uint n = 0;
+
+    words[n++] = format_pio_command(target, 8, true, CMD_WRITE);
+    words[n++] = op->request;
+
+    if (op_is_read(op)) {
+        words[n++] = format_pio_command(target, SWD_TURNAROUND_CYCLES + 3, false, CMD_READ);
+        words[n++] = format_pio_command(target, 32, false, CMD_READ);
+        words[n++] = format_pio_command(target, 1 + SWD_TURNAROUND_CYCLES, false, CMD_READ);
+    } else {
+        words[n++] = format_pio_command(target, 2 * SWD_TURNAROUND_CYCLES + 3, false, CMD_READ);
+        words[n++] = format_pio_command(target, 32, true, CMD_WRITE);
+        words[n++] = op->value;
+        words[n++] = format_pio_command(target, 1, true, CMD_WRITE);
+        words[n++] = calculate_parity(op->value);
     }
 
+    return n;
+}
+
+/**
+ * @brief Check ACK/parity of one transaction and store read data
+ *
+ * @param rx Raw RX FIFO words produced by encode_op()'s read commands
+ */
+static swd_error_t decode_op(swd_target_t *target, const swd_op_t *op, const uint32_t *rx) {
+    uint ack_bits = op_is_read(op) ? SWD_TURNAROUND_CYCLES + 3
+                                   : 2 * SWD_TURNAROUND_CYCLES + 3;
+    uint8_t ack = (rx[0] >> (32 - ack_bits) >> SWD_TURNAROUND_CYCLES) & 0x7;
+
+    target->last_ack = ack;
+    stat_ack(target, ack);
+    if (ack != SWD_ACK_OK) {
+        return swd_ack_to_error(ack);
+    }
+
+    if (op_is_read(op)) {
+        uint32_t value = rx[1];
+        uint8_t parity = (rx[2] >> (32 - (1 + SWD_TURNAROUND_CYCLES))) & 1;
+        if (calculate_parity(value) != parity) {
+            SWD_STAT_INC(target, parity_errors);
+            return SWD_ERROR_PARITY;
+        }
+        if (op->dest) {
+            *op->dest = value;
+        }
+    }
+
+    return SWD_OK;
+}
+
+static void op_stream_start(op_stream_t *s, const swd_op_t *ops, uint count) {
+    s->ops = ops;
+    s->count = count;
+    s->tx_len = s->tx_pos = s->rx_pos = 0;
+    s->issued = s->done = 0;
+    s->stop = false;
+    s->failed = count;
+    s->err = SWD_OK;
+}
+
+static inline bool op_stream_busy(const op_stream_t *s) {
+    return s->done < s->issued || (!s->stop && s->issued < s->count);
+}
+
+/**
+ * @brief Move at most one word each way between the host and the SM
+ *
+ * After the first failed transaction no further ops are issued (the
+ * target rejects them anyway once STICKYORUN/STICKYERR is set), but
+ * everything already pushed is drained to keep the PIO in step.
+ */
+static void op_stream_step(swd_target_t *target, op_stream_t *s) {
+    PIO pio = target->pio.pio;
+    uint sm = target->pio.sm;
+
+    if (s->tx_pos == s->tx_len && !s->stop && s->issued < s->count) {
+        s->tx_len = encode_op(target, &s->ops[s->issued++], s->tx);
+        s->tx_pos = 0;
+    }
+
+    if (s->tx_pos < s->tx_len && !pio_sm_is_tx_fifo_full(pio, sm)) {
+        pio_sm_put(pio, sm, s->tx[s->tx_pos++]);
+    }
+
+    if (!pio_sm_is_rx_fifo_empty(pio, sm)) {
+        s->rx[s->rx_pos++] = pio_sm_get(pio, sm);
+        if (s->rx_pos == op_rx_words(&s->ops[s->done])) {
+            if (!s->stop) {
+                s->err = decode_op(target, &s->ops[s->done], s->rx);
+                if (s->err != SWD_OK) {
+                    s->failed = s->done;
+                    s->stop = true;
+                }
+            }
+            s->rx_pos = 0;
+            s->done++;
+        }
+    }
+}
+
+/**
+ * @brief Stream ops through the state machine without draining between them
+ *
+ * TX is refilled while RX is emptied, so the SM only stalls when the host
+ * falls behind.
+ */
+static swd_error_t stream_ops(swd_target_t *target, const swd_op_t *ops, uint count,
+                              uint *failed_op) {
+    op_stream_t s;
+
+    op_stream_start(&s, ops, count);
+    while (op_stream_busy(&s)) {
+        op_stream_step(target, &s);
+    }
+
+    SWD_DEBUG("Streamed %u/%u transactions\n", s.done, count);
+    *failed_op = s.failed;
+    return s.err;
+}
+
+//==============================================================================
+// DMA Backend
+//==============================================================================
+
+// Targets with DMA channels claimed (the shared IRQ handler is installed
+// while this is non-zero)
+static uint dma_users = 0;
+
+// The handler runs on the core that connected; a run started from the
+// other core (the worker) sleeps in WFE there, so the SEV wakes it
+static inline void dma_irq_check(swd_target_t *target) {
+    if (target && target->dma && dma_channel_get_irq0_status(target->dma->rx_chan)) {
+        dma_channel_acknowledge_irq0(target->dma->rx_chan);
+        target->dma->busy = false;
+        __sev();
+    }
+}
+
+static void swd_dma_irq_handler(void) {
+    for (uint i = 0; i < 4; i++) {
+        dma_irq_check(g_resources.pio0_sm_owners[i]);
+        dma_irq_check(g_resources.pio1_sm_owners[i]);
+    }
+}
+
+/**
+ * @brief Claim DMA channels for a target
+ *
+ * Failure is not fatal: the target keeps streaming from the CPU.
+ */
+static void dma_init(swd_target_t *target) {
+    swd_dma_t *dma = calloc(1, sizeof(swd_dma_t));
+    if (!dma) {
+        SWD_WARN("DMA buffers unavailable, using CPU streaming\n");
+        return;
+    }
+
+    dma->tx_chan = dma_claim_unused_channel(false);
+    dma->rx_chan = dma_claim_unused_channel(false);
+    if (dma->tx_chan < 0 || dma->rx_chan < 0) {
+        if (dma->tx_chan >= 0) dma_channel_unclaim(dma->tx_chan);
+        if (dma->rx_chan >= 0) dma_channel_unclaim(dma->rx_chan);
+        free(dma);
+        SWD_WARN("No free DMA channels, using CPU streaming\n");
+        return;
+    }
+
+    if (dma_users++ == 0) {
+        irq_add_shared_handler(DMA_IRQ_0, swd_dma_irq_handler,
+                               PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+    }
+    dma_channel_set_irq0_enabled(dma->rx_chan, true);
+
+    target->dma = dma;
+    SWD_INFO("DMA backend: TX ch%d, RX ch%d\n", dma->tx_chan, dma->rx_chan);
+}
+
+static void dma_release(swd_target_t *target) {
+    swd_dma_t *dma = target->dma;
+    if (!dma) return;
+
+    dma_channel_set_irq0_enabled(dma->rx_chan, false);
+    dma_channel_abort(dma->tx_chan);
+    dma_channel_abort(dma->rx_chan);
+    dma_channel_unclaim(dma->tx_chan);
+    dma_channel_unclaim(dma->rx_chan);
+
+    if (--dma_users == 0) {
+        irq_remove_handler(DMA_IRQ_0, swd_dma_irq_handler);
+    }
+
+    target->dma = NULL;
+    free(dma);
+}
+
+/**
+ * @brief Start one prebuilt stream: tx_len words out, rx_len words back
+ *
+ * dma->busy is cleared by the RX channel's completion IRQ. The SM produces
+ * an RX word for every read command whatever the target answers, so the
+ * transfer always completes.
+ */
+static void dma_start(swd_target_t *target, uint tx_len, uint rx_len) {
+    swd_dma_t *dma = target->dma;
+    PIO pio = target->pio.pio;
+    uint sm = target->pio.sm;
+
+    dma_channel_config rx_cfg = dma_channel_get_default_config(dma->rx_chan);
+    channel_config_set_transfer_data_size(&rx_cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&rx_cfg, false);
+    channel_config_set_write_increment(&rx_cfg, true);
+    channel_config_set_dreq(&rx_cfg, pio_get_dreq(pio, sm, false));
+    dma_channel_configure(dma->rx_chan, &rx_cfg, dma->rx_buf, &pio->rxf[sm], rx_len, false);
+
+    dma_channel_config tx_cfg = dma_channel_get_default_config(dma->tx_chan);
+    channel_config_set_transfer_data_size(&tx_cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&tx_cfg, true);
+    channel_config_set_write_increment(&tx_cfg, false);
+    channel_config_set_dreq(&tx_cfg, pio_get_dreq(pio, sm, true));
+    dma_channel_configure(dma->tx_chan, &tx_cfg, &pio->txf[sm], dma->tx_buf, tx_len, false);
+
+    dma->busy = true;
+    dma_start_channel_mask((1u << dma->tx_chan) | (1u << dma->rx_chan));
+}
+
+/**
+ * @brief Encode up to SWD_DMA_MAX_OPS ops and start them on the channels
+ *
+ * Every op is sent, including any after a failure. After WAIT or FAULT
+ * the target rejects them while the sticky flag is set; a parity error
+ * sets no flag, so the target acts on the rest of the run.
+ */
+static void dma_start_ops(swd_target_t *target, const swd_op_t *ops, uint n) {
+    swd_dma_t *dma = target->dma;
+    uint tx_len = 0, rx_len = 0;
+
+    for (uint i = 0; i < n; i++) {
+        tx_len += encode_op(target, &ops[i], &dma->tx_buf[tx_len]);
+        rx_len += op_rx_words(&ops[i]);
+    }
+
+    dma_start(target, tx_len, rx_len);
+}
+
+/**
+ * @brief Decode a finished DMA run of n ops
+ *
+ * After a parity error the remaining ops were still acted on, so their
+ * ACKs and data are decoded too. *failed_op is then the last op the target
+ * accepted (the one before the first WAIT or FAULT, else the last op of
+ * the run) rather than the read that failed parity.
+ */
+static swd_error_t dma_finish_ops(swd_target_t *target, const swd_op_t *ops, uint n,
+                                  uint *failed_op) {
+    const uint32_t *rx = target->dma->rx_buf;
+    swd_error_t first = SWD_OK;
+
+    __compiler_memory_barrier();
+    for (uint i = 0; i < n; i++) {
+        swd_error_t err = decode_op(target, &ops[i], rx);
+        if (err != SWD_OK && err != SWD_ERROR_PARITY) {
+            *failed_op = first == SWD_OK ? i : i - 1;
+            return first == SWD_OK ? err : first;
+        }
+        if (err != SWD_OK && first == SWD_OK) {
+            first = err;
+        }
+        rx += op_rx_words(&ops[i]);
+    }
+
+    *failed_op = first == SWD_OK ? n : n - 1;
+    return first;
+}
+
+/**
+ * @brief DMA counterpart of stream_ops()
+ *
+ * The calling core sleeps in WFE until each run's completion IRQ, which
+ * may be taken on either core and always ends with SEV.
+ *
+ * Unlike the FIFO path, a parity error does not stop the ops after it in
+ * the same run; *failed_op reports how far the target got (see
+ * dma_finish_ops()).
+ */
+static swd_error_t dma_stream_ops(swd_target_t *target, const swd_op_t *ops, uint count,
+                                  uint *failed_op) {
+    *failed_op = count;
+
+    for (uint base = 0; base < count; base += SWD_DMA_MAX_OPS) {
+        uint n = count - base < SWD_DMA_MAX_OPS ? count - base : SWD_DMA_MAX_OPS;
+        uint failed;
+
+        dma_start_ops(target, &ops[base], n);
+        while (target->dma->busy) {
+            __wfe();
+        }
+
+        swd_error_t err = dma_finish_ops(target, &ops[base], n, &failed);
+        if (err != SWD_OK) {
+            *failed_op = base + failed;
+            return err;
+        }
+    }
+
+    SWD_DEBUG("DMA streamed %u transactions\n", count);
+    return SWD_OK;
+}
+
+swd_error_t swd_run_ops(swd_target_t *target, const swd_op_t *ops, uint count,
+                        uint *failed_op) {
+    uint failed = count;
+    swd_error_t err = SWD_OK;
+
+    if (!target || !target->pio.initialized) {
+        err = SWD_ERROR_INVALID_STATE;
+        goto out;
+    }
+
+    if (!target->dap.orundetect) {
+        // Without overrun detection a WAIT is not followed by a data phase,
+        // so every ACK has to be seen before the next request goes out
+        for (uint i = 0; i < count; i++) {
+            uint32_t value = ops[i].value;
+            bool write = !op_is_read(&ops[i]);
+            err = swd_transfer_retry(target, ops[i].request, &value, write);
+            if (err != SWD_OK) {
+                failed = i;
+                goto out;
+            }
+            if (!write && ops[i].dest) {
+                *ops[i].dest = value;
+            }
+        }
+        goto out;
+    }
+
+    SWD_STAT_START(t0);
+    uint start = 0;
+    uint attempts = 0;
+    swd_poll_t poll;
+    bool waiting = false;   // poll tracks the op at 'failed'
+    while (start < count) {
+        uint stream_failed;
+        uint remaining = count - start;
+        if (target->dma && remaining >= SWD_DMA_MIN_OPS) {
+            err = dma_stream_ops(target, ops + start, remaining, &stream_failed);
+        } else {
+            err = stream_ops(target, ops + start, remaining, &stream_failed);
+        }
+
+        // Retry from the op that got WAIT; ops after it were rejected
+        bool same_op = (err != SWD_OK) && (start + stream_failed == failed);
+        if (waiting && !(same_op && err == SWD_ERROR_WAIT)) {
+            swd_poll_end(target, &poll, true);  // The stalled op got through
+            waiting = false;
+        }
+        if (err == SWD_OK) {
+            break;
+        }
+
+        attempts = same_op ? attempts + 1 : 1;
+        failed = start + stream_failed;
+
+        if (err == SWD_ERROR_WAIT) {
+            swd_clear_overrun(target);
+            if (!waiting) {
+                swd_poll_begin(target, &poll, SWD_WAIT_ACK);
+                waiting = true;
+            }
+            if (attempts < target->dap.retry_count && swd_poll_again(target, &poll)) {
+                SWD_STAT_INC(target, retries);
+                start = failed;
+                continue;
+            }
+            if (attempts >= target->dap.retry_count) {
+                poll.polls++;  // Counted as an unmet check without waiting again
+            }
+            swd_poll_end(target, &poll, false);
+        } else if (err == SWD_ERROR_PROTOCOL) {
+            swd_line_reset(target);
+        }
+        goto out;
+    }
+    failed = count;
+    SWD_STAT_LATENCY(target, SWD_LATENCY_STREAM, t0);
+
+out:
+    if (err != SWD_OK) {
+        // Ops after the failure may or may not have reached the target
+        dap_invalidate_cache(target);
+    }
+    if (failed_op) {
+        *failed_op = failed;
+    }
     return err;
 }
 
-swd_error_t swd_read_ap_raw(swd_target_t *target, uint8_t reg, uint32_t *value) {
-    uint8_t request = make_swd_request(true, true, reg);
-    swd_error_t err = SWD_ERROR_WAIT;  // Initialize to WAIT in case retry_count is 0
+/**
+ * @brief Settle a stream that ran without swd_run_ops()'s retry loop
+ *
+ * A WAIT finishes the rest from the stalled op with swd_run_ops(); other
+ * errors get the same recovery swd_run_ops() applies.
+ */
+static swd_error_t stream_settle(swd_target_t *target, const swd_op_t *ops, uint count,
+                                 swd_error_t err, uint *failed_op) {
+    if (err == SWD_ERROR_WAIT) {
+        uint start = *failed_op;
+        swd_clear_overrun(target);
+        err = swd_run_ops(target, ops + start, count - start, failed_op);
+        *failed_op += start;
+    } else if (err != SWD_OK) {
+        if (err == SWD_ERROR_PROTOCOL) {
+            swd_line_reset(target);
+        }
+        dap_invalidate_cache(target);
+    }
+    return err;
+}
 
-    for (uint retry = 0; retry < target->dap.retry_count; retry++) {
-        err = swd_io_raw(target, request, value, false);
-        if (err != SWD_ERROR_WAIT) break;
-        sleep_us(100);
+void swd_run_ops_gang(swd_target_t *const *targets, const swd_op_t *const *ops,
+                      const uint *counts, uint n, swd_error_t *errs, uint *failed_ops) {
+    op_stream_t streams[SWD_GANG_MAX_TARGETS];
+    bool interleaved[SWD_GANG_MAX_TARGETS];
+    bool busy = false;
+
+    for (uint i = 0; i < n; i++) {
+        // Without overrun detection every ACK must be seen before the next
+        // request, which rules out keeping several SMs fed at once
+        interleaved[i] = targets[i] && targets[i]->pio.initialized &&
+                         targets[i]->dap.orundetect && counts[i] > 0;
+        if (interleaved[i]) {
+            op_stream_start(&streams[i], ops[i], counts[i]);
+            busy = true;
+        }
     }
 
+    // Round-robin one FIFO word per SM, so all links clock simultaneously
+    while (busy) {
+        busy = false;
+        for (uint i = 0; i < n; i++) {
+            if (interleaved[i] && op_stream_busy(&streams[i])) {
+                op_stream_step(targets[i], &streams[i]);
+                busy = true;
+            }
+        }
+    }
+
+    for (uint i = 0; i < n; i++) {
+        uint failed = counts[i];
+
+        if (!interleaved[i]) {
+            errs[i] = (counts[i] > 0) ? swd_run_ops(targets[i], ops[i], counts[i], &failed)
+                                      : SWD_OK;
+        } else {
+            // After WAIT this target finishes alone, from the op that stalled
+            failed = streams[i].failed;
+            errs[i] = stream_settle(targets[i], ops[i], counts[i], streams[i].err, &failed);
+        }
+
+        if (failed_ops) {
+            failed_ops[i] = failed;
+        }
+    }
+}
+
+//==============================================================================
+// Transaction Batching (public API)
+//==============================================================================
+
+swd_error_t swd_batch_begin(swd_target_t *target) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->pio.initialized) {
+        swd_set_error(target, SWD_ERROR_NOT_CONNECTED, "Batch requires an initialized PIO");
+        return SWD_ERROR_NOT_CONNECTED;
+    }
+
+    if (!target->batch) {
+        target->batch = calloc(1, sizeof(swd_batch_t));
+        if (!target->batch) {
+            swd_set_error(target, SWD_ERROR_NO_MEMORY, "Failed to allocate batch");
+            return SWD_ERROR_NO_MEMORY;
+        }
+    }
+
+    swd_batch_t *batch = target->batch;
+    if (batch->active) {
+        swd_set_error(target, SWD_ERROR_INVALID_STATE, "Batch already open");
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    batch->count = 0;
+    batch->flushed = 0;
+    batch->active = true;
+    batch->select_dirty = false;
+    batch->tar_dirty = false;
+    batch->dm_dirty = false;
+    batch->tar_known = false;
+    batch->error = SWD_OK;
+    return SWD_OK;
+}
+
+// Account for a run of the queued ops
+static void batch_flushed(swd_target_t *target, swd_error_t err, uint failed) {
+    swd_batch_t *batch = target->batch;
+
+    if (err == SWD_ERROR_PARITY) {
+        // A DMA run carries on past the bad read; failed is where it stopped
+        batch->error = err;
+        swd_set_error(target, err, "Batch parity error, ran through transaction %u "
+                     "(request 0x%02x)", batch->flushed + failed, batch->ops[failed].request);
+    } else if (err != SWD_OK) {
+        batch->error = err;
+        swd_set_error(target, err, "Batch transaction %u failed (request 0x%02x)",
+                     batch->flushed + failed, batch->ops[failed].request);
+    }
+
+    batch->flushed += batch->count;
+    batch->count = 0;
+}
+
+static swd_error_t batch_flush(swd_target_t *target) {
+    swd_batch_t *batch = target->batch;
+    swd_error_t err = SWD_OK;
+    uint failed = 0;
+
+    if (batch->error == SWD_OK && batch->count > 0) {
+        err = swd_run_ops(target, batch->ops, batch->count, &failed);
+    }
+
+    batch_flushed(target, err, failed);
+    return batch->error;
+}
+
+static swd_error_t batch_queue(swd_target_t *target, swd_op_t op) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    swd_batch_t *batch = target->batch;
+    if (!batch || !batch->active || batch->started) {
+        swd_set_error(target, SWD_ERROR_INVALID_STATE, "No batch open");
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    // Once something failed, the rest of the batch is dropped
+    if (batch->error != SWD_OK) {
+        return batch->error;
+    }
+
+    if (batch->count == SWD_BATCH_MAX_OPS) {
+        swd_error_t err = batch_flush(target);
+        if (err != SWD_OK) {
+            return err;
+        }
+    }
+
+    batch->ops[batch->count++] = op;
+    return SWD_OK;
+}
+
+swd_error_t swd_batch_queue_read(swd_target_t *target, bool ap, uint8_t reg, uint32_t *value) {
+    swd_error_t err = batch_queue(target, swd_op_read(ap, reg, value));
+    if (err == SWD_OK && ap && (reg & 0xC) == (AP_DRW & 0xC)) {
+        // DRW reads advance TAR when CSW.AddrInc is set
+        target->batch->tar_dirty = true;
+    }
     return err;
 }
 
-swd_error_t swd_write_ap_raw(swd_target_t *target, uint8_t reg, uint32_t value) {
-    uint8_t request = make_swd_request(true, false, reg);
-    swd_error_t err = SWD_ERROR_WAIT;  // Initialize to WAIT in case retry_count is 0
+/**
+ * @brief Track which DAP/RP2350 shadows a queued write may invalidate
+ *
+ * The batch does not know which AP or bank a raw AP write lands in, so
+ * this errs on the side of invalidating. Dropping a shadow at queue time
+ * rather than at execute time is safe: nothing re-arms it mid-batch.
+ */
+static void batch_note_write(swd_target_t *target, bool ap, uint8_t reg, uint32_t value) {
+    swd_batch_t *batch = target->batch;
+
+    if (!ap) {
+        if (reg == DP_SELECT) {
+            batch->select_dirty = true;
+        } else if (reg == DP_ABORT && (value & ABORT_DAPABORT)) {
+            batch->tar_dirty = true;
+        }
+        return;
+    }
 
-    for (uint retry = 0; retry < target->dap.retry_count; retry++) {
-        err = swd_io_raw(target, request, &value, true);
-        if (err != SWD_ERROR_WAIT) break;
-        sleep_us(100);
+    batch->tar_dirty = true;
+    switch (reg & 0xC) {
+        case AP_TAR & 0xC:
+            batch->tar = value;
+            batch->tar_known = true;
+            break;
+        case AP_DRW & 0xC:
+            if (!batch->tar_known || batch->select_dirty) {
+                batch->dm_dirty = true;
+            } else {
+                rp2350_note_dm_write(target, batch->tar, 4);
+            }
+            batch->tar_known = false;
+            break;
+        default:
+            // CSW, or a register in another bank
+            batch->tar_known = false;
+            if (batch->select_dirty) {
+                batch->dm_dirty = true;
+            }
+            break;
     }
+}
 
+swd_error_t swd_batch_queue_write(swd_target_t *target, bool ap, uint8_t reg, uint32_t value) {
+    swd_error_t err = batch_queue(target, swd_op_write(ap, reg, value));
+    if (err == SWD_OK) {
+        batch_note_write(target, ap, reg, value);
+    }
     return err;
 }
 
+// Close the batch: confirm posted writes and drop stale shadows
+static swd_error_t batch_close(swd_target_t *target, swd_error_t err) {
+    swd_batch_t *batch = target->batch;
+
+    batch->active = false;
+
+    // Batch boundary: confirm posted memory writes. A FAULT in the batch
+    // is most likely one of them failing, so report that instead.
+    if (target->dap.posted_count > 0 && (err == SWD_OK || err == SWD_ERROR_FAULT)) {
+        swd_error_t sync_err = dap_sync_posted(target);
+        if (sync_err != SWD_OK) {
+            err = sync_err;
+        }
+    }
+
+    // The DAP/RP2350 shadows no longer match what was written
+    if (batch->select_dirty) {
+        target->dap.current_apsel = 0xFF;
+        target->dap.current_bank = 0xFF;
+    }
+    if (batch->tar_dirty) {
+        target->dap.tar_valid = false;
+    }
+    if (batch->dm_dirty) {
+        rp2350_forget_dm_shadows(target);
+    }
+
+    return err;
+}
+
+swd_error_t swd_batch_execute(swd_target_t *target) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    swd_batch_t *batch = target->batch;
+    if (!batch || !batch->active || batch->started) {
+        swd_set_error(target, SWD_ERROR_INVALID_STATE, "No batch open");
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    return batch_close(target, batch_flush(target));
+}
+
+swd_error_t swd_batch_start(swd_target_t *target) {
+    swd_batch_t *batch = target->batch;
+    if (!batch || !batch->active || batch->started) {
+        swd_set_error(target, SWD_ERROR_INVALID_STATE, "No batch open");
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    batch->started = true;
+    batch->dma_started = false;
+
+    if (!target->dap.orundetect || batch->error != SWD_OK) {
+        // Every ACK must be seen before the next request: run it now
+        batch_flush(target);
+        op_stream_start(&batch->stream, batch->ops, 0);
+    } else if (target->dma && batch->count >= SWD_DMA_MIN_OPS) {
+        dma_start_ops(target, batch->ops, batch->count);
+        batch->dma_started = true;
+    } else {
+        op_stream_start(&batch->stream, batch->ops, batch->count);
+    }
+    return SWD_OK;
+}
+
+bool swd_batch_poll(swd_target_t *target, swd_error_t *result) {
+    swd_batch_t *batch = target->batch;
+    swd_error_t err;
+    uint failed;
+
+    if (batch->dma_started) {
+        if (target->dma->busy) {
+            return false;
+        }
+        err = dma_finish_ops(target, batch->ops, batch->count, &failed);
+    } else {
+        // A bounded slice per call: about two ops' worth of FIFO words
+        op_stream_t *s = &batch->stream;
+        for (uint i = 0; i < 2 * (SWD_OP_MAX_TX_WORDS + SWD_OP_MAX_RX_WORDS) &&
+                         op_stream_busy(s); i++) {
+            op_stream_step(target, s);
+        }
+        if (op_stream_busy(s)) {
+            return false;
+        }
+        err = s->err;
+        failed = s->failed;
+    }
+
+    err = stream_settle(target, batch->ops, batch->count, err, &failed);
+    batch_flushed(target, err, failed);
+    batch->started = false;
+    batch->dma_started = false;
+    *result = batch_close(target, batch->error);
+    return true;
+}
+
+swd_error_t swd_batch_execute_gang(swd_target_t *const *targets, uint n, swd_error_t *results) {
+    swd_target_t *run[SWD_GANG_MAX_TARGETS];
+    const swd_op_t *ops[SWD_GANG_MAX_TARGETS];
+    uint counts[SWD_GANG_MAX_TARGETS];
+    swd_error_t errs[SWD_GANG_MAX_TARGETS];
+    uint failed[SWD_GANG_MAX_TARGETS];
+    uint m = 0;
+
+    if (!targets || !results || n > SWD_GANG_MAX_TARGETS) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    // Targets that already failed earlier in the gang sequence sit out
+    for (uint i = 0; i < n; i++) {
+        if (results[i] != SWD_OK) {
+            continue;
+        }
+        swd_batch_t *batch = targets[i] ? targets[i]->batch : NULL;
+        if (!batch || !batch->active) {
+            results[i] = targets[i] ? SWD_ERROR_INVALID_STATE : SWD_ERROR_INVALID_PARAM;
+            continue;
+        }
+        if (batch->error == SWD_OK && batch->count > 0) {
+            run[m] = targets[i];
+            ops[m] = batch->ops;
+            counts[m] = batch->count;
+            m++;
+        }
+    }
+
+    swd_run_ops_gang(run, ops, counts, m, errs, failed);
+    for (uint j = 0; j < m; j++) {
+        batch_flushed(run[j], errs[j], failed[j]);
+    }
+
+    for (uint i = 0; i < n; i++) {
+        if (results[i] == SWD_OK) {
+            results[i] = batch_close(targets[i], targets[i]->batch->error);
+        }
+    }
+    return swd_gang_first_error(results, n);
+}
+
 //==============================================================================
 // PIO Initialization
 //==============================================================================
 
+swd_error_t swd_pio_program_load(swd_target_t *target) {
+    if (target->pio.program_loaded) {
+        return SWD_OK;
+    }
+
+    swd_error_t err = acquire_pio_program(target->pio.pio, pio_variant(target)->program,
+                                          &target->pio.pio_offset);
+    if (err == SWD_OK) {
+        target->pio.program_loaded = true;
+    }
+    return err;
+}
+
+void swd_pio_program_unload(swd_target_t *target) {
+    if (target->pio.program_loaded) {
+        release_pio_program(target->pio.pio, pio_variant(target)->program);
+        target->pio.program_loaded = false;
+    }
+}
+
 static swd_error_t init_pio(swd_target_t *target) {
     // Initialize GPIO pins
     gpio_init(target->pio.pin_swclk);
@@ -265,15 +1192,15 @@ static swd_error_t init_pio(swd_target_t *target) {
     gpio_set_function(target->pio.pin_swdio,
                      target->pio.pio == pio0 ? GPIO_FUNC_PIO0 : GPIO_FUNC_PIO1);
 
-    // Load PIO program
-    if (!pio_can_add_program(target->pio.pio, &probe_program)) {
-        return SWD_ERROR_RESOURCE_BUSY;
+    // Shared program, normally already loaded by swd_target_create()
+    const pio_variant_t *variant = pio_variant(target);
+    swd_error_t err = swd_pio_program_load(target);
+    if (err != SWD_OK) {
+        return err;
     }
 
-    target->pio.pio_offset = pio_add_program(target->pio.pio, &probe_program);
-
     // Configure state machine
-    pio_sm_config sm_config = probe_program_get_default_config(target->pio.pio_offset);
+    pio_sm_config sm_config = variant->default_config(target->pio.pio_offset);
 
     // Set pin mappings
     sm_config_set_sideset_pins(&sm_config, target->pio.pin_swclk);
@@ -300,10 +1227,15 @@ static swd_error_t init_pio(swd_target_t *target) {
 
     // Start SM
     pio_sm_exec(target->pio.pio, target->pio.sm,
-                target->pio.pio_offset + probe_offset_get_next_cmd);
+                target->pio.pio_offset + variant->cmd_offset[CMD_SKIP]);
     pio_sm_set_enabled(target->pio.pio, target->pio.sm, true);
 
     target->pio.initialized = true;
+
+    if (target->pio.use_dma && !target->dma) {
+        dma_init(target);
+    }
+
     return SWD_OK;
 }
 
@@ -316,18 +1248,188 @@ swd_error_t swd_set_frequency(swd_target_t *target, uint32_t freq_khz) {
         return SWD_ERROR_INVALID_PARAM;
     }
 
+    if (freq_khz == 0) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    // Divider in 1/256 steps, rounded up so SWCLK never exceeds the request
     uint32_t clk_sys_khz = clock_get_hz(clk_sys) / 1000;
-    uint32_t divider = (((clk_sys_khz + freq_khz - 1) / freq_khz) + 3) / 4;
+    uint64_t period = (uint64_t)freq_khz * pio_variant(target)->cycles_per_bit;
+    uint64_t div256 = ((uint64_t)clk_sys_khz * 256 + period - 1) / period;
 
-    if (divider < 1) divider = 1;
-    if (divider > 65535) divider = 65535;
+    if (!target->pio.fractional_clkdiv) div256 = (div256 + 255) & ~(uint64_t)255;
+    if (div256 < 256) div256 = 256;
+    if (div256 > 0xFFFFFF) div256 = 0xFFFF00;
 
-    pio_sm_set_clkdiv_int_frac(target->pio.pio, target->pio.sm, divider, 0);
+    pio_sm_set_clkdiv_int_frac(target->pio.pio, target->pio.sm, div256 >> 8, div256 & 0xFF);
     target->pio.freq_khz = freq_khz;
 
-    SWD_INFO("Set SWCLK to %lu kHz (sysclk %lu kHz, div %lu)\n",
-             (unsigned long)freq_khz, (unsigned long)clk_sys_khz, (unsigned long)divider);
+    SWD_INFO("Set SWCLK to %lu kHz (sysclk %lu kHz, div %lu+%lu/256, actual %lu kHz)\n",
+             (unsigned long)freq_khz, (unsigned long)clk_sys_khz,
+             (unsigned long)(div256 >> 8), (unsigned long)(div256 & 0xFF),
+             (unsigned long)(clk_sys_khz * 256 / (div256 * pio_variant(target)->cycles_per_bit)));
+
+    return SWD_OK;
+}
+
+//==============================================================================
+// Frequency Autotuning
+//==============================================================================
+
+// Checks per frequency step, and the step size (1/4 = 25%)
+#define AUTOTUNE_ROUNDS 8
+#define AUTOTUNE_STEP_DIV 4
+
+// TAR bit patterns; TAR[1:0] may be read-only on word-only APs
+static const uint32_t autotune_patterns[] = {
+    0xAAAAAAA8, 0x55555554, 0xFFFFFFFC, 0x00000000,
+    0xCCCCCCCC, 0x33333330, 0xF0F0F0F0, 0x0F0F0F0C,
+};
+#define AUTOTUNE_PATTERN_COUNT (sizeof(autotune_patterns) / sizeof(autotune_patterns[0]))
+
+/**
+ * @brief Check the link at the current SWCLK
+ *
+ * Every round reads IDCODE, then streams a write and read-back of each
+ * TAR pattern. Any ACK, parity or data mismatch fails the check.
+ */
+static bool autotune_link_ok(swd_target_t *target) {
+    swd_op_t ops[AUTOTUNE_PATTERN_COUNT * 3 + 1];
+    uint32_t readback[AUTOTUNE_PATTERN_COUNT];
+    uint32_t idcode = 0;
+    uint failed;
+
+    if (dap_select_ap_bank(target, AP_RISCV, 0) != SWD_OK) {
+        return false;
+    }
+
+    for (uint round = 0; round < AUTOTUNE_ROUNDS; round++) {
+        uint n = 0;
+        ops[n++] = swd_op_read(false, DP_IDCODE, &idcode);
+        for (uint i = 0; i < AUTOTUNE_PATTERN_COUNT; i++) {
+            ops[n++] = swd_op_write(true, AP_TAR, autotune_patterns[i]);
+            ops[n++] = swd_op_read(true, AP_TAR, NULL);
+            ops[n++] = swd_op_read(false, DP_RDBUFF, &readback[i]);
+        }
+
+        swd_error_t err = swd_run_ops(target, ops, n, &failed);
+        target->dap.tar_valid = false;
+        if (err != SWD_OK || idcode != target->idcode) {
+            return false;
+        }
+
+        for (uint i = 0; i < AUTOTUNE_PATTERN_COUNT; i++) {
+            if (readback[i] != autotune_patterns[i]) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get the link back after a failed step
+ *
+ * A line reset followed by an IDCODE read returns the DP to a known state;
+ * the sticky flags a garbled transaction may have set are then cleared.
+ */
+static bool autotune_recover(swd_target_t *target, uint32_t freq_khz) {
+    swd_set_frequency(target, freq_khz);
+    swd_line_reset(target);
+    swd_send_idle_clocks(target, SWD_IDLE_CYCLES);
+    dap_invalidate_cache(target);
+
+    uint32_t idcode = 0;
+    if (swd_read_dp_raw(target, DP_IDCODE, &idcode) != SWD_OK || idcode != target->idcode) {
+        return false;
+    }
+    return dap_clear_errors(target) == SWD_OK;
+}
+
+swd_error_t swd_autotune_frequency(swd_target_t *target, uint32_t max_khz, uint32_t *freq_khz) {
+    if (!target) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!target->connected) {
+        return SWD_ERROR_NOT_CONNECTED;
+    }
 
+    if (target->batch && target->batch->active) {
+        swd_set_error(target, SWD_ERROR_INVALID_STATE, "Autotune with a batch open");
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    uint32_t start_khz = target->pio.freq_khz;
+    if (max_khz < start_khz) {
+        swd_set_error(target, SWD_ERROR_INVALID_PARAM,
+                     "Autotune limit %lu kHz below current %lu kHz",
+                     (unsigned long)max_khz, (unsigned long)start_khz);
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    // Steps garble transactions on purpose; nothing may be left in flight
+    swd_error_t err = dap_sync_posted(target);
+    if (err != SWD_OK) {
+        return err;
+    }
+
+    if (!autotune_link_ok(target)) {
+        autotune_recover(target, start_khz);
+        swd_set_error(target, SWD_ERROR_PROTOCOL,
+                     "Link unreliable at starting frequency %lu kHz", (unsigned long)start_khz);
+        return SWD_ERROR_PROTOCOL;
+    }
+
+    uint32_t good_khz = start_khz;
+    bool hit_limit = false;
+
+    while (good_khz < max_khz) {
+        uint32_t step = good_khz / AUTOTUNE_STEP_DIV;
+        uint32_t next_khz = good_khz + (step ? step : 1);
+        if (next_khz > max_khz) {
+            next_khz = max_khz;
+        }
+
+        swd_set_frequency(target, next_khz);
+        if (!autotune_link_ok(target)) {
+            SWD_INFO("Autotune: %lu kHz failed\n", (unsigned long)next_khz);
+            hit_limit = true;
+            break;
+        }
+        good_khz = next_khz;
+    }
+
+    // Back off from the edge if one was found
+    uint32_t chosen_khz = good_khz;
+    if (hit_limit) {
+        chosen_khz -= chosen_khz / AUTOTUNE_STEP_DIV;
+        if (chosen_khz < start_khz) {
+            chosen_khz = start_khz;
+        }
+
+        if (!autotune_recover(target, chosen_khz)) {
+            autotune_recover(target, start_khz);
+            chosen_khz = start_khz;
+        }
+    }
+
+    swd_set_frequency(target, chosen_khz);
+    if (!autotune_link_ok(target)) {
+        if (chosen_khz == start_khz || !autotune_recover(target, start_khz)) {
+            swd_set_error(target, SWD_ERROR_PROTOCOL, "Link lost during autotune");
+            return SWD_ERROR_PROTOCOL;
+        }
+        chosen_khz = start_khz;
+    }
+
+    SWD_INFO("Autotune: highest passing %lu kHz, using %lu kHz\n",
+             (unsigned long)good_khz, (unsigned long)chosen_khz);
+
+    if (freq_khz) {
+        *freq_khz = chosen_khz;
+    }
     return SWD_OK;
 }
 
@@ -366,26 +1468,53 @@ swd_error_t swd_connect(swd_target_t *target) {
         0xff,0xff,0xff,0xff,0xff,0xff,0xff, 0xff, 0x00
     };
 
-    pio_write_mode(target);
+    // Fresh DP: no overrun detection until dap_power_up() enables it
+    target->dap.orundetect = false;
+    target->dap.posted_count = 0;
+    dap_invalidate_cache(target);
 
-    // Send JTAG->Dormant
-    SWD_DEBUG("Sending JTAG->Dormant sequence\n");
-    for (size_t i = 0; i < sizeof(seq_jtag_to_dormant); i++) {
-        pio_write_bits(target, 8, seq_jtag_to_dormant[i]);
+    // Fast attach: a DP still in SWD mode answers after a line reset, and
+    // needs no dormant wake-up
+    uint32_t idcode = 0;
+    err = SWD_ERROR_PROTOCOL;
+    if (target->fast_attach) {
+        swd_line_reset(target);
+        swd_send_idle_clocks(target, SWD_IDLE_CYCLES);
+        err = swd_read_dp_raw(target, DP_IDCODE, &idcode);
+        if (err == SWD_OK) {
+            SWD_INFO("DP already in SWD mode\n");
+        }
     }
 
-    // Send Dormant->SWD
-    SWD_DEBUG("Sending Dormant->SWD sequence\n");
-    for (size_t i = 0; i < sizeof(seq_dormant_to_swd); i++) {
-        pio_write_bits(target, 8, seq_dormant_to_swd[i]);
-    }
+    if (err != SWD_OK) {
+        pio_write_mode(target);
 
-    swd_send_idle_clocks(target, SWD_IDLE_CYCLES);
-    sleep_ms(1);
+        // Send JTAG->Dormant
+        SWD_DEBUG("Sending JTAG->Dormant sequence\n");
+        pio_write_bytes(target, seq_jtag_to_dormant, sizeof(seq_jtag_to_dormant));
+
+        // Send Dormant->SWD
+        SWD_DEBUG("Sending Dormant->SWD sequence\n");
+        pio_write_bytes(target, seq_dormant_to_swd, sizeof(seq_dormant_to_swd));
+
+        swd_send_idle_clocks(target, SWD_IDLE_CYCLES);
+
+        // Fast attach tries straight away and only falls back to the delay
+        // if the DP isn't answering yet
+        err = SWD_ERROR_PROTOCOL;
+        if (target->fast_attach) {
+            err = swd_read_dp_raw(target, DP_IDCODE, &idcode);
+        }
+        if (err != SWD_OK) {
+            if (target->fast_attach) {
+                swd_line_reset(target);
+                swd_send_idle_clocks(target, SWD_IDLE_CYCLES);
+            }
+            sleep_ms(1);
+            err = swd_read_dp_raw(target, DP_IDCODE, &idcode);
+        }
+    }
 
-    // Read IDCODE
-    uint32_t idcode = 0;
-    err = swd_read_dp_raw(target, DP_IDCODE, &idcode);
     if (err != SWD_OK) {
         swd_set_error(target, err, "Failed to read IDCODE");
         return err;
@@ -419,17 +1548,27 @@ swd_error_t swd_disconnect(swd_target_t *target) {
         return SWD_OK;  // Already disconnected
     }
 
+    // A chunk on the wire drains before any other traffic goes out
+    swd_error_t err = swd_async_release(target);
+    if (err != SWD_OK) {
+        return err;
+    }
+
     SWD_INFO("Disconnecting from target...\n");
 
-    // Power down
-    dap_power_down(target);
+    rp2350_flush_mem_cache(target);
+    rp2350_flush_regs(target);
+
+    // Power down, unless the next attach is meant to find it running
+    if (!target->fast_attach) {
+        dap_power_down(target);
+    }
 
     // Disable SM
     if (target->pio.initialized) {
         pio_sm_set_enabled(target->pio.pio, target->pio.sm, false);
 
-        // Remove PIO program
-        pio_remove_program(target->pio.pio, &probe_program, target->pio.pio_offset);
+        // The program stays loaded for other targets and the next connect
 
         // Deinitialize GPIO
         gpio_deinit(target->pio.pin_swclk);
@@ -440,9 +1579,12 @@ swd_error_t swd_disconnect(swd_target_t *target) {
         target->pio.initialized = false;
     }
 
+    dma_release(target);
+
     target->connected = false;
     target->rp2350.initialized = false;
     target->dap.powered = false;
+    target->dap.orundetect = false;
 
     SWD_INFO("Disconnected\n");
     return SWD_OK;
@@ -0,0 +1,178 @@
+/**
+ * @file worker.c
+ * @brief core1 worker fed through lock-free SPSC rings
+ *
+ * core0 is the only producer of requests and the only consumer of
+ * completions; core1 is the other side of both. Each index is written by
+ * one core only, and a barrier orders the slot contents before the index
+ * that publishes them. __sev() wakes the other core from __wfe().
+ *
+ * At most SWD_WORKER_QUEUE_DEPTH jobs are outstanding between submission
+ * and poll, so neither ring can overflow and core1 never has to wait for
+ * space.
+ *
+ * Copyright (c) 2025
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico2-swd-riscv/worker.h"
+#include "internal.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include <stdio.h>
+
+typedef struct {
+    swd_worker_fn_t fn;
+    swd_target_t *target;
+    void *arg;
+    uint32_t id;
+} worker_request_t;
+
+static struct {
+    worker_request_t requests[SWD_WORKER_QUEUE_DEPTH];
+    swd_completion_t completions[SWD_WORKER_QUEUE_DEPTH];
+    volatile uint32_t request_head;     // Written by core0
+    volatile uint32_t request_tail;     // Written by core1
+    volatile uint32_t completion_head;  // Written by core1
+    volatile uint32_t completion_tail;  // Written by core0
+    volatile bool stop;                 // core1 exits once the requests are drained
+    volatile bool running;              // core1 is in worker_main()
+    bool started;
+    uint32_t next_id;
+} worker;
+
+//==============================================================================
+// core1
+//==============================================================================
+
+static void worker_main(void) {
+    for (;;) {
+        uint32_t tail = worker.request_tail;
+        if (tail == worker.request_head) {
+            if (worker.stop) {
+                break;
+            }
+            __wfe();
+            continue;
+        }
+
+        __dmb();  // Read the slot only after seeing it published
+        worker_request_t req = worker.requests[tail % SWD_WORKER_QUEUE_DEPTH];
+        worker.request_tail = tail + 1;
+
+        swd_error_t err = req.fn(req.target, req.arg);
+
+        uint32_t head = worker.completion_head;
+        swd_completion_t *done = &worker.completions[head % SWD_WORKER_QUEUE_DEPTH];
+        done->id = req.id;
+        done->target = req.target;
+        done->arg = req.arg;
+        done->error = err;
+        __dmb();  // Fill the slot before publishing it
+        worker.completion_head = head + 1;
+        __sev();
+    }
+
+    __dmb();
+    worker.running = false;
+    __sev();
+
+    for (;;) {
+        __wfe();
+    }
+}
+
+//==============================================================================
+// Worker Control
+//==============================================================================
+
+swd_error_t swd_worker_start(void) {
+    if (worker.started) {
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    // Ring indices carry over, so unpolled completions from a previous run
+    // are kept
+    worker.stop = false;
+    worker.running = true;
+    __dmb();
+    multicore_launch_core1(worker_main);
+    worker.started = true;
+
+    SWD_INFO("SWD worker started on core1\n");
+    return SWD_OK;
+}
+
+void swd_worker_stop(void) {
+    if (!worker.started) {
+        return;
+    }
+
+    worker.stop = true;
+    __sev();
+    while (worker.running) {
+        __wfe();
+    }
+    multicore_reset_core1();
+    worker.started = false;
+
+    SWD_INFO("SWD worker stopped\n");
+}
+
+bool swd_worker_is_running(void) {
+    return worker.started;
+}
+
+//==============================================================================
+// Requests and Completions
+//==============================================================================
+
+swd_error_t swd_worker_submit(swd_target_t *target, swd_worker_fn_t fn, void *arg,
+                              uint32_t *id) {
+    if (!target || !fn) {
+        return SWD_ERROR_INVALID_PARAM;
+    }
+
+    if (!worker.started) {
+        return SWD_ERROR_INVALID_STATE;
+    }
+
+    uint32_t head = worker.request_head;
+    if (head - worker.completion_tail >= SWD_WORKER_QUEUE_DEPTH) {
+        return SWD_ERROR_RESOURCE_BUSY;
+    }
+
+    worker_request_t *req = &worker.requests[head % SWD_WORKER_QUEUE_DEPTH];
+    req->fn = fn;
+    req->target = target;
+    req->arg = arg;
+    req->id = worker.next_id++;
+    if (id) {
+        *id = req->id;
+    }
+
+    __dmb();  // Fill the slot before publishing it
+    worker.request_head = head + 1;
+    __sev();
+    return SWD_OK;
+}
+
+bool swd_worker_poll(swd_completion_t *completion) {
+    if (!completion) {
+        return false;
+    }
+
+    uint32_t tail = worker.completion_tail;
+    if (tail == worker.completion_head) {
+        return false;
+    }
+
+    __dmb();  // Read the slot only after seeing it published
+    *completion = worker.completions[tail % SWD_WORKER_QUEUE_DEPTH];
+    worker.completion_tail = tail + 1;
+    return true;
+}
+
+uint32_t swd_worker_pending(void) {
+    return worker.request_head - worker.completion_tail;
+}